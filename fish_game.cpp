@@ -6,7 +6,21 @@
 #include <cmath>
 #include "pthread.h"
 #include <atomic> 
+#include <thread>
+#include <chrono>
 #include <dirent.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cstdarg>
+#include <climits>
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 using namespace std;
 
 
@@ -17,14 +31,10 @@ using namespace std;
 */
 
 
-// ----- Static Declarations -----
+// The current time in seconds, for measuring (defined with the functions below).
+static double monotonic_time();
 
 
-// A thread friendly boolean indicator that all the data was loaded.
-static std::atomic_bool images_loaded = ATOMIC_VAR_INIT(false);
-static std::atomic_bool audio_loaded = ATOMIC_VAR_INIT(false);
-static int data_progress = 0;
-
 // ----- Basice Graphics classes -----
 
 
@@ -193,12 +203,22 @@ struct paths_stack
     bool is_left;
 };
 
+// A sound effect with its playback pitch and gain, variants of a sound share its clip.
+struct sound_variant
+{
+    // The clip in the sound effects store.
+    int clip;
+    float pitch;
+    float gain;
+};
+
 // Fish recipe.
 struct fish_profile
 {
     // - Basic properties.
     
-    Image fish_image;
+    // Points to the animation, which may be loaded only after the profile is created (with the world bundle).
+    Image* fish_image;
     int* fish_image_frames_amount;
     string fish_type;
     frame collision_frame;
@@ -225,8 +245,8 @@ struct fish_profile
     paths_stack* paths_stacks;    
 
     // - Sounds.
-    Sound sound_eat;
-    Sound sound_sting;
+    sound_variant sound_eat;
+    sound_variant sound_sting;
 
     // - Flags
     
@@ -234,2076 +254,10385 @@ struct fish_profile
     float proportion;   
 };
 
+// The header of the assets pack file.
+struct pack_header
+{
+    // Always "FPAK".
+    char magic[4];
+    
+    // The layout version of the pack, a pack with another version is ignored.
+    uint32_t version;
+    
+    // How many entries there are in the table of contents, which follows the header.
+    uint32_t entries_amount;
+    
+    uint32_t padding;
+};
+
+// The game progress, the save file is a single record. Written to the save file as is.
+struct save_record
+{
+    // Always "FSAV".
+    char magic[4];
+    
+    // The layout version of the record, a record with another version is ignored.
+    uint32_t version;
+    
+    // To what world the user has reached.
+    int32_t world_checkpoint;
+    
+    // The checksum of the fields above (see Save::checksum()), a record which doesn't match it is ignored.
+    uint32_t checksum;
+};
+
+// An entry in the table of contents of the assets pack. Written to the pack file as is.
+struct pack_entry
+{
+    // The hash of the source file path, the key of the entry.
+    uint64_t name_hash;
+    
+    // The hash of the source file content. If the source file was changed, the entry is no longer valid.
+    uint64_t source_hash;
+    
+    // Where the pixels of the entry start in the pack file, and how many bytes are stored there.
+    uint64_t offset;
+    uint64_t stored_size;
+    
+    // The size of the pixels after decompression (equals stored_size if not compressed).
+    uint64_t pixels_size;
+    
+    // The decoded image properties.
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    int32_t frames_amount;
+    
+    // 1 if the stored pixels are compressed.
+    int32_t is_compressed;
+    
+    int32_t padding;
+};
+
+// A frame of a gif file, as described in the file (the pixels are decoded separately).
+struct gif_frame
+{
+    // The frame rectangle within the gif canvas.
+    int x;
+    int y;
+    int width;
+    int height;
+    bool is_interlaced;
+    
+    // The colors of the frame (the local table, or the global table of the gif).
+    const unsigned char* palette;
+    int palette_size;
+    
+    // The transparent color index, -1 if none.
+    int transparent_index;
+    
+    // What to do with the frame area before drawing the next frame (0-1 keep, 2 clear, 3 restore the previous).
+    int disposal;
+    
+    // Where the compressed pixels start in the file.
+    int min_code_size;
+    size_t data_offset;
+    
+    // The decoded color indexes, in file row order.
+    unsigned char* indexes;
+};
+
 // Declare the images struct.
 struct images_refrences 
 {
-    int count = 16;
-    
     int my_fish_image_frames_amount;
     Image my_fish_image;
-    const char* path_my_fish;
     
     int fish1_image_frames_amount;
     Image fish1_image;
-    const char* path_fish1;
     
     int fish2_image_frames_amount;
     Image fish2_image;
-    const char* path_fish2;
     
     int fish3_image_frames_amount;
     Image fish3_image;
-    const char* path_fish3;
     
     int fish4_image_frames_amount;
     Image fish4_image;
-    const char* path_fish4;
     
     int fish5_image_frames_amount;
     Image fish5_image;
-    const char* path_fish5;
     
     int fish6_image_frames_amount;
     Image fish6_image;
-    const char* path_fish6;
     
     int fish7_image_frames_amount;
     Image fish7_image;
-    const char* path_fish7;
     
     int fish8_image_frames_amount;
     Image fish8_image;
-    const char* path_fish8;
     
     int fish9_image_frames_amount;
     Image fish9_image;
-    const char* path_fish9;
     
     int fish10_image_frames_amount;
     Image fish10_image;
-    const char* path_fish10;
     
     int fish11_image_frames_amount;
     Image fish11_image;
-    const char* path_fish11;
     
     int crab1_image_frames_amount;
     Image crab1_image;
-    const char* path_crab1;
     
     int crab2_image_frames_amount;
     Image crab2_image;
-    const char* path_crab2;
     
     int jeflly_fish1_image_frames_amount;
     Image jelly_fish1_image;
-    const char* path_jelly_fish1;
     
     int jeflly_fish2_image_frames_amount;
     Image jelly_fish2_image;
-    const char* path_jelly_fish2;
 };
 
 // Declare the Audio struct.
 struct audio_refrences 
 {
-    // Soundtrack equals 1, all the mini-sounds are altogether 1.
-    int count = 5;
+    // The music tracks of the music player.
+    int music_main_theme;
     
-    Sound music_main_theme;
-    const char* path_music_main_theme;
+    int music_world1;
     
-    Sound music_world1;
-    const char* path_music_world1;
+    int music_world2;
     
-    Sound music_world2;
-    const char* path_music_world2;
+    int music_world3;
     
-    Sound music_world3;
-    const char* path_music_world3;
+    // The sound effects (clips of the sound effects store), their variants are played with a different pitch and gain.
+    int sound_eat;
     
-    Sound sound_eat;
-    const char* path_sound_eat;
+    int sound_sting1;
+};
+
+// Declare the textures struct (the menus, windows and worlds backgrounds).
+struct textures_refrences
+{
+    Texture2D main_menu;
+    Texture2D campain_button;
+    Texture2D about_button;
+    Texture2D about_window;
+    Texture2D about_close_button;
+    
+    Texture2D campain_welcome_window1;
+    Texture2D campain_welcome_window2;
+    Texture2D campain_welcome_window3;
+    Texture2D campain_welcome_window4;
+    Texture2D campain_welcome_window5;
+    Texture2D campain_welcome_window6;
+    Texture2D campain_welcome_window7;
+    
+    Texture2D map;
+    Texture2D world1_button;
+    Texture2D world2_button;
+    Texture2D world3_button;
+    
+    Texture2D victory;
+    Texture2D defeat;
+    Texture2D back_to_map_button;
+    Texture2D exit_welcome_window_button;
+    Texture2D pause_window;
+    Texture2D resume_game_button;
+    Texture2D pause_button;
+    
+    Texture2D world1;
+    Texture2D world1_welcome_window;
+    
+    Texture2D world2;
+    Texture2D world2_welcome_window;
+    
+    Texture2D world3;
+    Texture2D world3_welcome_window;
+};
+
+// A measured part of the startup (a phase, or the loading of a single asset).
+struct trace_entry
+{
+    // What was measured (a literal or a path constant, never freed).
+    const char* name;
+    const char* category;
     
-    Sound sound_eat_lower;
-    const char* path_sound_eat_lower;
+    // The number of the thread which did it, the main thread is 0.
+    int thread;
     
-    Sound sound_sting1;
-    const char* path_sound_sting1;
+    // Seconds since the tracer was created.
+    double start_time;
+    double end_time;
     
-    Sound sound_sting1_lower;
-    const char* path_sound_sting1_lower;
+    // The size of the data which was produced (decoded pixels or samples), 0 if not relevant.
+    uint64_t bytes;
+};
+
+// The kinds of assets the loader can decode.
+enum AssetType
+{
+    ASSET_ANIMATION,
+    ASSET_TEXTURE,
+    ASSET_SOUND
 };
 
+// The groups of assets which are loaded together (flags, an asset can belong to several bundles).
+enum AssetBundle
+{
+    BUNDLE_CORE = 1,
+    BUNDLE_CAMPAIN_INTRO = 2,
+    BUNDLE_WORLD1 = 4,
+    BUNDLE_WORLD2 = 8,
+    BUNDLE_WORLD3 = 16
+};
 
-// ----- Advanced Grahphics Classes -----
+// The priorities of the sound effects, a sound can take the voice of a lower priority sound.
+enum SoundPriority
+{
+    SOUND_PRIORITY_LOW,
+    SOUND_PRIORITY_NORMAL,
+    SOUND_PRIORITY_HIGH
+};
 
+// A sound effect, compressed as IMA-ADPCM blocks.
+struct sfx_clip
+{
+    const char* name;
+    
+    // The amount of mono samples, and the blocks which hold them.
+    int frames_amount;
+    int blocks_amount;
+    unsigned char* blocks;
+    
+    // The signal to noise ratio of the compression, in dB.
+    float snr;
+};
 
-// Declare on cells before grid entity (Resolves the deadlock of Cell includes GridEntity and GridEntity includes Cell).
-class Cell;
+// The position of a decoder in a clip.
+struct adpcm_state
+{
+    int clip;
+    int frame;
+    int predictor;
+    int step_index;
+};
 
+// Need to declare for the asset job struct.
+class AssetLoader;
 
-class GridEntity : public Entity
+// A single asset to decode on a worker thread, and finish (upload) on the main thread.
+struct asset_job
 {
-    /*
-        An entity inside a grid.
-    */
+    AssetType type;
+    const char* path;
     
-    protected:
+    // The loader which owns the job.
+    AssetLoader* loader;
     
-        // The frame of the entity as a rectangle.
-        // Important: In the code, the location, size, scale and rotation of the entity might be changed outside the scope of the class,
-        //            therefore rectangular_frame might not be up to date. Please call get_updated_rectangular_frame when using rectangular_frame.
-        // Important: The frame rectangle considers 0 rotation!
-        Rectangle rectangular_frame;
-        
-        // The frame properties for collision detection. 
-        // Important: the properites relates to the original dimensions of the gif file itself, not to the received size.
-        // Therfore, it is very important to call set_original_size() when the texture is initialized.
-        frame collision_frame;
-        
-        // The maximum amount of cells the entity can be contained in. Note that if scale has no limit, might be inside all the cells of the grid.
-        int max_cells_within;
-        
-        // The amount of cells currently within.
-        int current_amount_of_cells_within;
-        
-        // Grid entities usually interact with each other (on collision for instance). Dynamic cast for "instance of" check, is inefficient and not recommended. Thefore, simply save the entity type as a string.
-        string entity_type;
+    // The weight of the job in the progress, the size of the source file.
+    uint64_t weight;
+    
+    // Where the loaded asset is stored, depends on the type (Image*, Texture2D* or Sound*).
+    void* target;
+    int* frames_amount;
+    
+    // The decoded data, handed from the worker to the main thread.
+    Image image;
+    sfx_clip clip;
+    uint64_t source_hash;
+    bool is_packed;
+    
+    // The AssetBundle flags of the bundles which need the asset.
+    unsigned int bundles;
+    
+    // Set on the main thread, when the job is handed to the workers and when it is finished.
+    bool is_submitted;
+    bool is_completed;
+    
+    // The next job in the completion queue.
+    std::atomic<asset_job*> next;
+};
 
-    public:
+// A sound effect requested by the gameplay for the current frame.
+struct sound_request
+{
+    // The clip in the sound effects store.
+    int clip;
+    
+    // Requests of the same clip by the same group are merged (the type of the fish).
+    string group;
+    
+    // How to play the sound.
+    float pitch;
+    float gain;
+    
+    // Where the sound comes from (in the world), and its SoundPriority.
+    Location location;
+    int priority;
+};
 
-        // The array of cells, as pointers, that the entity is currently within.
-        // cell_within is public due to the "referencing each other" conflic of Cell and GridEntity. The cells that the entity is within, directly manipulates cells_witihn from outside this class.
-        Cell** cells_within;
+// How the ticks of a frame are simulated.
+enum SimMode
+{
+    // The fish of the main menu and map background wander (my fish is not simulated).
+    SIM_MODE_BACKGROUND,
+    
+    // Nothing moves, the gifs keep playing (the pause, welcome, victory and defeat windows).
+    SIM_MODE_ANIMATE,
+    
+    // The world is played.
+    SIM_MODE_WORLD
+};
 
-    public:
+// The events of the simulation, handled by the main thread.
+enum SimEvent
+{
+    SIM_EVENT_VICTORY,
+    SIM_EVENT_DEFEAT
+};
 
-        // Constructor.
-        GridEntity(string new_entity_type, frame new_collision_frame, Location new_location, Size new_size, float new_scale, float new_max_scale, int new_rotation, int new_max_cells_within, Cell** new_cells_within) : Entity(new_location, new_size, new_scale, new_max_scale, new_rotation)
-        {
-            // The collision frame properties.
-            collision_frame = new_collision_frame;
-            
-            // Save the maximum amount of cells might be within.
-            max_cells_within = new_max_cells_within;
-            
-            // Create the cells array. Its length is exactly max_cells_within.
-            cells_within = new_cells_within;
-            
-            // Not on the grid yet on initialization.
-            current_amount_of_cells_within = 0;
+// The load of the simulation which the quality governor can lower (see QualityGovernor).
+struct sim_quality
+{
+    // The fish out of the camera view move to their next gif frame once in this many ticks.
+    int offscreen_frame_interval;
+    
+    // The part of the max population which is kept in the world (the fish which swim in from the margins), and in the background of the menus.
+    float world_population_ratio;
+    float background_population_ratio;
+};
 
-            // The type of the entity as a string.
-            entity_type = new_entity_type;
-        }
-        
-        // Defalut constructor.
-        GridEntity() : Entity()
-        {
-            max_cells_within = 0;
-            cells_within = NULL;
-            current_amount_of_cells_within = 0;
-            entity_type = "entity";
-        }
-        
-        // The function receives the size of the texture and updates the collision frame size.
-        void set_original_size(Size original_size)
-        {
-            collision_frame.width = (int) (collision_frame.width * ((float) size.width / original_size.width));
-            collision_frame.x_offset = (int) (collision_frame.x_offset * ((float) size.width / original_size.width));
-            
-            collision_frame.height = (int) (collision_frame.height * ((float) size.height / original_size.height));
-            collision_frame.y_offset = (int) (collision_frame.y_offset * ((float) size.height / original_size.height));
-        }
+// The phases of a frame, measured by the quality governor.
+enum FramePhase
+{
+    FRAME_PHASE_UPDATE,
+    FRAME_PHASE_DRAW,
+    
+    // Waiting for the display (EndDrawing()), not part of the cost of the frame.
+    FRAME_PHASE_DISPLAY,
+    
+    // Waiting for the ticks of the simulation thread.
+    FRAME_PHASE_SIMULATION_WAIT,
+    FRAME_PHASES_AMOUNT
+};
 
-        // The function returns the rectangular frame of the entity as a rectangle (NOT CONSIDERING ROTATION).
-        Rectangle get_updated_rectangular_frame()
-        {
-            // Calculate the frame considering the scale of the entity.
-            rectangular_frame = {location.x - ((sqrt(scale) * size.width) / 2), location.y - ((sqrt(scale) * size.height) / 2), sqrt(scale) * size.width, sqrt(scale) * size.height};
+// The phases of a tick, measured by the macro benchmark and the frame profiler (see Simulation::measure_phases()).
+enum TickPhase
+{
+    // The previous locations, the boundaries, the turbo and the input of my fish.
+    TICK_PHASE_MY_FISH,
+    TICK_PHASE_EATEN,
+    TICK_PHASE_RELEASE,
+    TICK_PHASE_MOVE,
+    
+    // The grid refresh of the moved fish (measured inside the move).
+    TICK_PHASE_GRID,
+    TICK_PHASE_COLLISIONS,
+    TICK_PHASE_CAMERA,
+    
+    // The next gif frames and the end of the game.
+    TICK_PHASE_FRAMES,
+    TICK_PHASE_REWIND,
+    TICK_PHASE_SNAPSHOT,
+    TICK_PHASES_AMOUNT
+};
 
-            // Return the frame as rectangle.
-            return rectangular_frame;
-        }
-        
-        // The function returns the collision frame rectangle.
-        Rectangle get_updated_collision_frame()
-        {
-            // Calculate the collision frame rectangle.
-            Rectangle collision_frame_rectangle = {location.x + (sqrt(scale) * collision_frame.x_offset) - ((sqrt(scale) * collision_frame.width) / 2), location.y + (sqrt(scale) * collision_frame.y_offset) - ((sqrt(scale) * collision_frame.height) / 2), sqrt(scale) * collision_frame.width, sqrt(scale) * collision_frame.height};
-            
-            // Return the rectangle.
-            return collision_frame_rectangle;
-        }
-        
-        // The function mirrors the collision frame on the y axis.
-        void flip_collision_frame_horizontal()
-        {
-            collision_frame.x_offset *= -1;
-        }
-        
-        // The function returns the rectangular frame of the entity as a rectangle (NOT CONSIDERING ROTATION) Twice the size!
-        Rectangle get_updated_rectangular_frame_triple_size()
-        {
-            // Calculate the frame considering the scale of the entity.
-            Rectangle doubled_frame = {location.x - (float) (sqrt(scale) * size.width * 1.5), location.y - (float) (sqrt(scale) * size.height * 1.5), sqrt(scale) * size.width * 3, sqrt(scale) * size.height * 3};
+// The phases of a frame on the main thread, measured by the frame profiler (see FrameProfiler).
+enum ProfilePhase
+{
+    PROFILE_PHASE_INPUT,
+    PROFILE_PHASE_UPDATE,
+    PROFILE_PHASE_DRAW,
+    
+    // Waiting for the display (EndDrawing()).
+    PROFILE_PHASE_DISPLAY,
+    PROFILE_PHASE_SIMULATION_WAIT,
+    PROFILE_PHASES_AMOUNT
+};
 
-            // Return the frame as rectangle.
-            return doubled_frame;
-        }
+// The input of a frame, gathered by the main thread for the simulation.
+struct sim_input
+{
+    // The arrow keys which are held.
+    bool is_right_down;
+    bool is_left_down;
+    bool is_up_down;
+    bool is_down_down;
+    
+    // The current gesture, and where the first touch is on the screen.
+    int gesture;
+    Location touch_location;
+};
 
-        // The function returns the rectangular frame of the entity as a rectangle (NOT CONSIDERING ROTATION) 0.8 the size!
-        Rectangle get_updated_rectangular_frame_lower_size()
-        {
-            // Calculate the frame considering the scale of the entity.
-            Rectangle doubled_frame = {location.x - (float) ((sqrt(scale) * size.width) * 0.8 / 2), location.y - (float) ((sqrt(scale) * size.height) * 0.8 / 2), (float) (sqrt(scale) * size.width * 0.8), (float) (sqrt(scale) * size.height * 0.8)};
+// The input of a frame, read once by the main thread (see read_frame_input() and InputRecorder).
+struct frame_input
+{
+    // The mouse (or the first touch), and if its button was pressed or released.
+    Vector2 mouse_point;
+    bool is_mouse_pressed;
+    bool is_mouse_released;
+    
+    // The arrow keys, and the key which rewinds (see Rewind).
+    bool is_right_down;
+    bool is_left_down;
+    bool is_up_down;
+    bool is_down_down;
+    bool is_rewind_down;
+    
+    // The current gesture, where the first touch is on the screen, and how many touches there are.
+    int gesture;
+    Location touch_location;
+    int touch_count;
+    
+    // If the game is in the foreground, and if the user did something (see is_input_event()).
+    bool is_focused;
+    bool is_input_event;
+    
+    // The frame profiler was toggled (not recorded, it can be toggled while a recording is replayed).
+    bool is_profiler_toggled;
+};
 
-            // Return the frame as rectangle.
-            return doubled_frame;
-        }
+// What the input recorder does (see InputRecorder).
+enum RecorderMode
+{
+    RECORDER_OFF,
+    RECORDER_RECORD,
+    RECORDER_REPLAY
+};
 
-        // The function returns the array of cells that the entity is currently within.
-        Cell** get_cells_within() { return cells_within; }
+// The flags of a recorded frame (see recorded_frame).
+enum RecordedFlag
+{
+    RECORDED_RIGHT_DOWN = 1,
+    RECORDED_LEFT_DOWN = 2,
+    RECORDED_UP_DOWN = 4,
+    RECORDED_DOWN_DOWN = 8,
+    RECORDED_REWIND_DOWN = 16,
+    RECORDED_MOUSE_PRESSED = 32,
+    RECORDED_MOUSE_RELEASED = 64,
+    RECORDED_FOCUSED = 128,
+    RECORDED_INPUT_EVENT = 256,
+    
+    // The world which was selected on the map was loaded on the frame (it is entered).
+    RECORDED_WORLD_LOADED = 512
+};
 
-        // The function returns the amount of cells curretnly within.
-        int get_amount_of_cells_within() { return current_amount_of_cells_within; }
-        
-        string get_entity_type() { return entity_type; }
-        
-        // The function resets the array indicating the cells in which the entity is currently in.
-        void reset_cells_within() { current_amount_of_cells_within = 0;}
-        
-        // The function is being called when a cell was added to cells_within.
-        void cell_within_was_added() { current_amount_of_cells_within++; }
-        
-        // A GridEntity object might want to handle collision in its original class and not as an GridEntity.
-        virtual void handle_collision(GridEntity* colided_with_entity) {}
+// The header of an input recording (see InputRecorder).
+struct recording_header
+{
+    // Always "FREC".
+    char magic[4];
+    
+    // The layout version of the recording, a recording with another version is not replayed.
+    uint32_t version;
+    
+    // The seed of rand(), the world checkpoint of the save, and the screen which was played.
+    uint32_t seed;
+    int32_t world_checkpoint;
+    int32_t screen_width;
+    int32_t screen_height;
+};
+
+// A frame of an input recording (see InputRecorder).
+struct recorded_frame
+{
+    // The keys and the buttons (RecordedFlag), and the gesture.
+    uint16_t flags;
+    uint16_t gesture;
+    
+    // The mouse and the first touch, in pixels of the screen.
+    int16_t mouse_x;
+    int16_t mouse_y;
+    int16_t touch_x;
+    int16_t touch_y;
+    
+    // How many touches there were, and how many ticks the frame ran.
+    uint8_t touch_count;
+    uint8_t ticks;
+    
+    // The quality the next ticks run with (see sim_quality).
+    uint8_t offscreen_frame_interval;
+    uint8_t padding;
+    float world_population_ratio;
+    float background_population_ratio;
+    
+    // The checksum of the state of the world after the frame (see WorldState::capture_state()).
+    uint32_t checksum;
 };
 
+// Need to declare for the gif snapshot struct.
+class MyGif;
 
-class Cell
+// How to draw a gif, taken at the end of the ticks of a frame.
+struct gif_snapshot
 {
-    /*
-        A cell of a grid.
-    */
+    MyGif* gif;
     
-    private:
-        
-        // The maximum amount of enetities the current cell can contain.
-        int max_entities;
-        
-        // The current amount of entities within the cell.
-        int entities_counter;
-        
-        // All the entities within the current cell, as pointers.
-        GridEntity** entities;
-        
-    public:
-        
-        // Constructor.
-        Cell(int new_max_entities, GridEntity** new_entities)
-        {
-            // Set the maximum amount of entities the cell can contain.
-            max_entities = new_max_entities;
-            
-            // Initialize the entities array with the size of max_entities.
-            entities = new_entities;
-            
-            // Currently there are 0 entities in the cell.
-            entities_counter = 0;
-        }
-        
-        // Default constructor.
-        Cell()
-        {
-            max_entities = 0;
-            entities = NULL;
+    // The location on the last tick, and on the one before it.
+    Location location;
+    Location previous_location;
+    bool is_previous_location_set;
+    
+    Size size;
+    float scale;
+    float rotation;
+    int frame;
+    Color tint;
+    bool is_flip_horizontal;
+    bool is_flip_vertical;
+    
+    // For debugging.
+    Rectangle collision_frame;
+};
+
+// The scenes of the game (the order of the scene profiles).
+enum Scene
+{
+    SCENE_MAIN_MENU,
+    SCENE_MAP,
+    SCENE_WORLD1,
+    SCENE_WORLD2,
+    SCENE_WORLD3,
+    SCENES_AMOUNT
+};
+
+// What a scene needs while it is the current scene.
+struct scene_profile
+{
+    const char* name;
+    
+    // The asset bundles (AssetBundle flags), and the music track.
+    unsigned int bundles;
+    int music_track;
+};
+
+// The state of a fish, as it is kept in a world state (see WorldState). Written to the world state file as is.
+struct fish_state
+{
+    int32_t x;
+    int32_t y;
+    float scale;
+    float speed_x;
+    float speed_y;
+    int32_t original_speed_x;
+    int32_t original_speed_y;
+    
+    // The current stunt (a jelly fish sting).
+    int32_t current_stunt_frames_left;
+    float stunt_size_decrease_per_frame;
+    
+    // The gif.
+    int32_t current_frame;
+    Color tint;
+    uint8_t is_moving_right;
+    uint8_t is_flip_horizontal;
+    uint8_t is_flip_vertical;
+    uint8_t is_eaten;
+};
+
+// The state of a wandering fish, and where it came from (its profile in the fish network, and the paths stack of the profile).
+struct wander_fish_state
+{
+    fish_state fish;
+    int16_t profile_index;
+    int16_t profile_paths_stack_index;
+    
+    // The current path, and its index in the paths stack.
+    int32_t paths_stack_index;
+    fish_path current_path;
+    int32_t current_path_original_frames_amount;
+};
+
+// The state of my fish.
+struct my_fish_state
+{
+    fish_state fish;
+    int32_t turbo_duration_frames_left;
+    int32_t turbo_reload_frames_left;
+};
+
+// The header of a world state, followed by the state of my fish and the states of the fish of the network.
+struct world_state_header
+{
+    // Always "FWLD".
+    char magic[4];
+    
+    // The layout version of the world state, a state with another version is ignored.
+    uint32_t version;
+    
+    // The world, and how many fish follow the state of my fish.
+    int32_t world_number;
+    int32_t fish_amount;
+    
+    // The random numbers generator of the fish network.
+    uint64_t random_state;
+    
+    // The camera (the offset belongs to the screen).
+    float camera_target_x;
+    float camera_target_y;
+    float camera_zoom;
+    
+    // How many numbers describe the cells of the grid, they follow the states of the fish (see Grid::save_cells()).
+    int32_t grid_entries_amount;
+    
+    // The checksum of everything which follows the header (see WorldState).
+    uint32_t checksum;
+    
+    uint32_t padding;
+};
+
+// A tick in the history of the rewind (see Rewind), where it is and which keyframe it is encoded against (its own tick for a keyframe).
+struct rewind_entry
+{
+    size_t offset;
+    size_t size;
+    long keyframe_tick;
+};
+
+// The header of a compiled world pack (see WorldPack), followed by its tables: the fish profiles, the paths stacks, the paths and the strings.
+struct world_pack_header
+{
+    // Always "FWPK".
+    char magic[4];
+    
+    // The layout version of the pack, a pack with another version is compiled again.
+    uint32_t version;
+    
+    // The hash of the text source the pack was compiled from, a pack of a changed source is compiled again.
+    uint64_t source_hash;
+    
+    // The world, its size (0 for the size of its background), its population and its grid.
+    int32_t world_number;
+    int32_t world_width;
+    int32_t world_height;
+    int32_t population;
+    int32_t grid_columns;
+    int32_t grid_rows;
+    
+    // The paths of the background and of the welcome window (offsets in the strings).
+    int32_t background;
+    int32_t welcome_window;
+    
+    // The sizes of the tables.
+    int32_t profiles_amount;
+    int32_t stacks_amount;
+    int32_t paths_amount;
+    int32_t strings_size;
+    
+    // The checksum of the tables (see Save::checksum()).
+    uint32_t checksum;
+    
+    uint32_t padding;
+};
+
+// What a coordinate of a world pack is relative to, it is known only when the world is created.
+enum WorldAnchor
+{
+    // The coordinate as it is.
+    WORLD_ANCHOR_NONE,
+    
+    // Beyond the left edge of the world, where the fish are released (minus the x coordinate offset).
+    WORLD_ANCHOR_LEFT,
+    
+    // Beyond the right edge of the world (its width plus the x coordinate offset).
+    WORLD_ANCHOR_RIGHT,
+    
+    // The bottom of the world (its height).
+    WORLD_ANCHOR_BOTTOM,
+    
+    // Right above the world, the fish is hidden (minus the height of its animation).
+    WORLD_ANCHOR_ABOVE
+};
+
+// A fish profile in a world pack (see fish_profile), the strings are offsets in the strings of the pack.
+struct world_pack_profile
+{
+    int32_t animation;
+    int32_t fish_type;
+    frame collision_frame;
+    int32_t width;
+    int32_t height;
+    float max_scaling;
+    float min_speed_x;
+    float max_speed_x;
+    float min_speed_y;
+    float max_speed_y;
+    int32_t min_frames_per_path;
+    int32_t max_frames_per_path;
+    float can_eat_ratio;
+    float cant_eat_ratio;
+    float proportion;
+    
+    // The names of the sounds (see WorldCatalog).
+    int32_t sound_eat;
+    int32_t sound_sting;
+    
+    // Its paths stacks in the stacks of the pack.
+    int32_t first_stack;
+    int32_t stacks_amount;
+    
+    uint8_t is_sting_proof;
+    uint8_t is_facing_left_on_startup;
+    uint8_t is_randomize_initial_scale;
+    
+    // Loaded on the set-up of the world, otherwise it is an available fish.
+    uint8_t is_on_startup;
+};
+
+// A paths stack in a world pack (see paths_stack), a coordinate is relative to its anchor (WorldAnchor).
+struct world_pack_stack
+{
+    int32_t initial_x;
+    int32_t initial_y;
+    int32_t initial_y_coordinate;
+    uint8_t initial_x_anchor;
+    uint8_t initial_y_anchor;
+    uint8_t initial_y_coordinate_anchor;
+    uint8_t is_left;
+    uint8_t is_repeat;
+    uint8_t is_initial_location;
+    uint8_t is_initial_y_coordinate;
+    uint8_t is_randomize_x_coordinate;
+    
+    // Its paths in the paths of the pack.
+    int32_t first_path;
+    int32_t paths_amount;
+};
+
+// The parameters of a synthetic world (see WorldGenerator).
+struct synthetic_world_settings
+{
+    // The numbers are drawn from the seed, the same settings always make the same world.
+    uint64_t seed;
+    
+    // The population, the size of the world and its grid.
+    int population;
+    int width;
+    int height;
+    int grid_columns;
+    int grid_rows;
+    
+    // How many species, drawn from the profiles of the base pack.
+    int species_amount;
+    
+    // The spread of the sizes, a species is the size of its base profile scaled within it.
+    float min_scale;
+    float max_scale;
+    
+    // The share of the species which are jelly fish, and of the other species which zigzag instead of wandering across.
+    float jelly_fish_ratio;
+    float zigzag_ratio;
+};
+
+// A gameplay scenario of the macro benchmark (see MacroBenchmark).
+struct benchmark_scenario
+{
+    const char* name;
+    
+    // The world which is played, or 0 for a synthetic world made from world 3 (see WorldGenerator).
+    int world_number;
+    
+    // The synthetic world: its population, the share of the jelly fish species and the spread of the sizes.
+    int population;
+    float jelly_fish_ratio;
+    float min_scale;
+    float max_scale;
+    
+    // The scale of my fish, as a part of the scale which wins (0 keeps the scale it starts with).
+    float my_fish_scale_ratio;
+    
+    // How far out of the world the fish are released, as a part of the width of the world (0 for the margin of the game).
+    float margin_ratio;
+};
+
+// The statistics of something a benchmark measured, a scenario phase or a function, in the unit of the benchmark an operation (see BenchmarkResults).
+struct benchmark_result
+{
+    char name[96];
+    
+    // How many operations a sample has.
+    int operations;
+    
+    // The statistics of the samples.
+    double min;
+    double median;
+    double mean;
+    double p99;
+    double deviation;
+};
+
+// The functions measured by the micro benchmark (see MicroBenchmark).
+enum MicroCase
+{
+    MICRO_GRID_ADD_ENTITY,
+    MICRO_GRID_REFRESH_ENTITY,
+    MICRO_CELL_REMOVE_ENTITY,
+    MICRO_COLLISION_FRAME,
+    MICRO_HANDLE_COLLISION,
+    MICRO_EAT,
+    MICRO_MOVE_TOWARDS,
+    MICRO_WANDER_MOVE,
+    MICRO_LOAD_AVAILABLE_FISH,
+    MICRO_SAVE_DECRYPT,
+    MICRO_SAVE_CHECKSUM,
+    MICRO_CASES_AMOUNT
+};
+
+
+// ----- Basic Technical Classes -----
+
+
+template <typename T>
+class EventQueue
+{
+    /*
+        A lock free queue of events from one thread to another (the simulation thread to the main thread).
+        
+        Notes:
+            - A ring with a single producer and a single consumer, push() and pop() never allocate and never wait.
+            - The producer and the consumer may change threads between frames, as long as the handover is synchronized (Simulation::wait()).
+            - When the ring is full the event is dropped, and counted.
+    */
+    
+    private:
+    
+        // The ring, one slot is always empty (tells a full ring from an empty one).
+        int capacity;
+        T* events;
+        
+        // The consumer pops at the first index, the producer pushes at the end index.
+        std::atomic<int> first;
+        std::atomic<int> end;
+        
+        // How many events were dropped, counted by the producer.
+        long dropped_amount;
+    
+    public:
+    
+        // Constructor.
+        EventQueue(int new_capacity)
+        {
+            capacity = new_capacity + 1;
+            events = new T[capacity];
+            first.store(0);
+            end.store(0);
+            dropped_amount = 0;
+        }
+        
+        // The function adds an event, returns false if the queue is full (producer only).
+        bool push(const T& event)
+        {
+            int current_end = end.load(std::memory_order_relaxed);
+            int next_end = (current_end + 1) % capacity;
+            
+            if (next_end == first.load(std::memory_order_acquire)) { dropped_amount++; return false; }
+            
+            events[current_end] = event;
+            end.store(next_end, std::memory_order_release);
+            
+            return true;
+        }
+        
+        // The function takes the next event, returns false if there is none (consumer only).
+        bool pop(T* event)
+        {
+            int current_first = first.load(std::memory_order_relaxed);
+            
+            if (current_first == end.load(std::memory_order_acquire)) { return false; }
+            
+            *event = events[current_first];
+            first.store((current_first + 1) % capacity, std::memory_order_release);
+            
+            return true;
+        }
+        
+        // Getters.
+        long get_dropped_amount() { return dropped_amount; }
+};
+
+
+class Random
+{
+    /*
+        A small random numbers generator (xorshift64*), its whole state is a single number.
+        
+        Notes:
+            - Every fish network has a generator of its own, so a world is saved and restored with the numbers it is going to draw (see WorldState).
+            - next() returns a non negative int, like rand().
+    */
+    
+    private:
+    
+        // The state, never 0.
+        uint64_t state;
+    
+    public:
+    
+        // Constructor.
+        Random(uint64_t seed) { set_state(seed); }
+        
+        // Default Constructor.
+        Random() { state = DEFAULT_STATE; }
+        
+        // The function returns the next number (31 bits).
+        int next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            
+            return (int) ((state * 2685821657736338717ULL) >> 33);
+        }
+        
+        // Getters and setters of the state.
+        uint64_t get_state() { return state; }
+        void set_state(uint64_t new_state) { state = (new_state != 0) ? new_state : DEFAULT_STATE; }
+    
+    private:
+    
+        // The state of a generator which wasn't seeded (xorshift never leaves 0).
+        static const uint64_t DEFAULT_STATE = 0x9E3779B97F4A7C15ULL;
+};
+
+
+// ----- Advanced Grahphics Classes -----
+
+
+// Declare on cells before grid entity (Resolves the deadlock of Cell includes GridEntity and GridEntity includes Cell).
+class Cell;
+
+
+class GridEntity : public Entity
+{
+    /*
+        An entity inside a grid.
+    */
+    
+    protected:
+    
+        // The frame of the entity as a rectangle.
+        // Important: In the code, the location, size, scale and rotation of the entity might be changed outside the scope of the class,
+        //            therefore rectangular_frame might not be up to date. Please call get_updated_rectangular_frame when using rectangular_frame.
+        // Important: The frame rectangle considers 0 rotation!
+        Rectangle rectangular_frame;
+        
+        // The frame properties for collision detection. 
+        // Important: the properites relates to the original dimensions of the gif file itself, not to the received size.
+        // Therfore, it is very important to call set_original_size() when the texture is initialized.
+        frame collision_frame;
+        
+        // The maximum amount of cells the entity can be contained in. Note that if scale has no limit, might be inside all the cells of the grid.
+        int max_cells_within;
+        
+        // The amount of cells currently within.
+        int current_amount_of_cells_within;
+        
+        // Grid entities usually interact with each other (on collision for instance). Dynamic cast for "instance of" check, is inefficient and not recommended. Thefore, simply save the entity type as a string.
+        string entity_type;
+        
+        // The index of the entity in a world state, the cells are saved by it (see Grid::save_cells()).
+        int state_index;
+
+    public:
+
+        // The array of cells, as pointers, that the entity is currently within.
+        // cell_within is public due to the "referencing each other" conflic of Cell and GridEntity. The cells that the entity is within, directly manipulates cells_witihn from outside this class.
+        Cell** cells_within;
+
+    public:
+
+        // Constructor.
+        GridEntity(string new_entity_type, frame new_collision_frame, Location new_location, Size new_size, float new_scale, float new_max_scale, int new_rotation, int new_max_cells_within, Cell** new_cells_within) : Entity(new_location, new_size, new_scale, new_max_scale, new_rotation)
+        {
+            // The collision frame properties.
+            collision_frame = new_collision_frame;
+            
+            // Save the maximum amount of cells might be within.
+            max_cells_within = new_max_cells_within;
+            
+            // Create the cells array. Its length is exactly max_cells_within.
+            cells_within = new_cells_within;
+            
+            // Not on the grid yet on initialization.
+            current_amount_of_cells_within = 0;
+
+            // The type of the entity as a string.
+            entity_type = new_entity_type;
+            
+            state_index = -1;
+        }
+        
+        // Defalut constructor.
+        GridEntity() : Entity()
+        {
+            max_cells_within = 0;
+            cells_within = NULL;
+            current_amount_of_cells_within = 0;
+            entity_type = "entity";
+            state_index = -1;
+        }
+        
+        // The function receives the size of the texture and updates the collision frame size.
+        void set_original_size(Size original_size)
+        {
+            collision_frame.width = (int) (collision_frame.width * ((float) size.width / original_size.width));
+            collision_frame.x_offset = (int) (collision_frame.x_offset * ((float) size.width / original_size.width));
+            
+            collision_frame.height = (int) (collision_frame.height * ((float) size.height / original_size.height));
+            collision_frame.y_offset = (int) (collision_frame.y_offset * ((float) size.height / original_size.height));
+        }
+
+        // The function returns the rectangular frame of the entity as a rectangle (NOT CONSIDERING ROTATION).
+        Rectangle get_updated_rectangular_frame()
+        {
+            // Calculate the frame considering the scale of the entity.
+            rectangular_frame = {location.x - ((sqrt(scale) * size.width) / 2), location.y - ((sqrt(scale) * size.height) / 2), sqrt(scale) * size.width, sqrt(scale) * size.height};
+
+            // Return the frame as rectangle.
+            return rectangular_frame;
+        }
+        
+        // The function returns the collision frame rectangle.
+        Rectangle get_updated_collision_frame()
+        {
+            // Calculate the collision frame rectangle.
+            Rectangle collision_frame_rectangle = {location.x + (sqrt(scale) * collision_frame.x_offset) - ((sqrt(scale) * collision_frame.width) / 2), location.y + (sqrt(scale) * collision_frame.y_offset) - ((sqrt(scale) * collision_frame.height) / 2), sqrt(scale) * collision_frame.width, sqrt(scale) * collision_frame.height};
+            
+            // Return the rectangle.
+            return collision_frame_rectangle;
+        }
+        
+        // The function mirrors the collision frame on the y axis.
+        void flip_collision_frame_horizontal()
+        {
+            collision_frame.x_offset *= -1;
+        }
+        
+        // The function returns the rectangular frame of the entity as a rectangle (NOT CONSIDERING ROTATION) Twice the size!
+        Rectangle get_updated_rectangular_frame_triple_size()
+        {
+            // Calculate the frame considering the scale of the entity.
+            Rectangle doubled_frame = {location.x - (float) (sqrt(scale) * size.width * 1.5), location.y - (float) (sqrt(scale) * size.height * 1.5), sqrt(scale) * size.width * 3, sqrt(scale) * size.height * 3};
+
+            // Return the frame as rectangle.
+            return doubled_frame;
+        }
+
+        // The function returns the rectangular frame of the entity as a rectangle (NOT CONSIDERING ROTATION) 0.8 the size!
+        Rectangle get_updated_rectangular_frame_lower_size()
+        {
+            // Calculate the frame considering the scale of the entity.
+            Rectangle doubled_frame = {location.x - (float) ((sqrt(scale) * size.width) * 0.8 / 2), location.y - (float) ((sqrt(scale) * size.height) * 0.8 / 2), (float) (sqrt(scale) * size.width * 0.8), (float) (sqrt(scale) * size.height * 0.8)};
+
+            // Return the frame as rectangle.
+            return doubled_frame;
+        }
+
+        // The function returns the array of cells that the entity is currently within.
+        Cell** get_cells_within() { return cells_within; }
+
+        // The function returns the amount of cells curretnly within.
+        int get_amount_of_cells_within() { return current_amount_of_cells_within; }
+        
+        // Returns how many cells the entity can be within (the length of cells_within).
+        int get_max_cells_within() { return max_cells_within; }
+        
+        string get_entity_type() { return entity_type; }
+        
+        // Getter and setter of the index in a world state.
+        int get_state_index() { return state_index; }
+        void set_state_index(int new_state_index) { state_index = new_state_index; }
+        
+        // The function resets the array indicating the cells in which the entity is currently in.
+        void reset_cells_within() { current_amount_of_cells_within = 0;}
+        
+        // The function is being called when a cell was added to cells_within.
+        void cell_within_was_added() { current_amount_of_cells_within++; }
+        
+        // A GridEntity object might want to handle collision in its original class and not as an GridEntity.
+        virtual void handle_collision(GridEntity* colided_with_entity) {}
+};
+
+
+class Cell
+{
+    /*
+        A cell of a grid.
+    */
+    
+    private:
+        
+        // The maximum amount of enetities the current cell can contain.
+        int max_entities;
+        
+        // The current amount of entities within the cell.
+        int entities_counter;
+        
+        // All the entities within the current cell, as pointers.
+        GridEntity** entities;
+        
+    public:
+        
+        // Constructor.
+        Cell(int new_max_entities, GridEntity** new_entities)
+        {
+            // Set the maximum amount of entities the cell can contain.
+            max_entities = new_max_entities;
+            
+            // Initialize the entities array with the size of max_entities.
+            entities = new_entities;
+            
+            // Currently there are 0 entities in the cell.
+            entities_counter = 0;
+        }
+        
+        // Default constructor.
+        Cell()
+        {
+            max_entities = 0;
+            entities = NULL;
             entities_counter=0;
         }
         
-        // Clears the current cell.
-        void reset()
+        // Clears the current cell.
+        void reset()
+        {
+            entities_counter = 0;
+        }
+        
+        // Add new entity to the cell.
+        void add_entity(GridEntity* new_entity)
+        {
+            // Add the entity to the cell.
+            entities[entities_counter] = new_entity;
+            entities_counter += 1;
+
+            // Add the cell to the entity.
+            new_entity -> cells_within[new_entity -> get_amount_of_cells_within()] = this;
+            new_entity -> cell_within_was_added();
+        }
+        
+        // Remove received entity from the cell.
+        void remove_entity(GridEntity* entity_to_remove)
+        {
+            // Find the received entity in the entities array.
+            for (int i = 0; i < entities_counter; i++)
+            {
+                // Check if the current entity is the entity to remove.
+                if (entity_to_remove == entities[i])
+                {
+                    // Overide the current entity with the entity at the end of the array.
+                    entities[i] = entities[entities_counter - 1];
+                    
+                    // Free the entity at the end of the array.
+                    entities_counter -= 1;
+                    
+                    // That's it.
+                    break;
+                }
+            }
+        }
+        
+        // The function returns the current amount of entities in the cell.
+        int get_entities_counter() { return entities_counter; }
+        
+        // The function returns all the entities in the cell.
+        GridEntity** get_entities() { return entities; }
+};
+
+
+class Grid
+{
+    /*
+        The grid reduces significantly the amount of collision checks in the world.
+    */
+    
+    private:
+        
+        // The maximum amount of entities a cell can contain.
+        int cell_maximum_amount_of_entities;
+        
+        // The amount of columns in the grid.
+        int columns_amount;
+        
+        // The amount of rows in the grid.
+        int rows_amount;
+        
+        // The width of the grid in pixels.
+        int width_pixels;
+        
+        // The height of the grid in pixels.
+        int height_pixels;
+        
+        // The width of each cell in pixels.
+        int cell_width_pixels;
+        
+        // The height of each cell in pixels.
+        int cell_height_pixels;
+        
+        // An 2d matrix with the cells of the grid, as pointers.
+        Cell*** cells;
+      
+    public:
+    
+        // Counstructor.
+        Grid(int new_columns_amount, int new_rows_amount, int new_cell_maximum_amount_of_entities, int new_width_pixels, int new_height_pixels)
+        {
+            // Set the amount of rows and columns.
+            columns_amount = new_columns_amount;
+            rows_amount = new_rows_amount;
+            
+            // Set the width of the grid in pixels.
+            width_pixels = new_width_pixels;
+            height_pixels = new_height_pixels;
+            
+            // Calculate and save the amount of pixels each cell covers.
+            cell_width_pixels = width_pixels / columns_amount;
+            cell_height_pixels = height_pixels / rows_amount;
+            
+            // Save the maximum amount of entites a single cell can contain.
+            cell_maximum_amount_of_entities = new_cell_maximum_amount_of_entities;
+              
+            // Declare the cells matrix.
+            cells = new Cell**[rows_amount];
+            for(int i = 0; i < rows_amount; i++)
+                cells[i] = new Cell*[columns_amount];
+            
+            // Create the cells of the grid.
+            for (int row_index = 0; row_index < rows_amount; row_index++)
+            {
+                for (int column_index = 0; column_index < columns_amount; column_index++)
+                {
+                    cells[row_index][column_index] = new Cell(cell_maximum_amount_of_entities, new GridEntity*[cell_maximum_amount_of_entities]);
+                }
+            }
+        }
+        
+        // Default Constructor.
+        Grid()
+        {
+            cell_maximum_amount_of_entities = 0;
+            columns_amount = 0;
+            rows_amount = 0;
+            width_pixels = 0;
+            height_pixels = 0;
+            cell_width_pixels = 0;
+            cell_height_pixels = 0;
+        }
+        
+        // Reset the grid.
+        void reset() 
+        {
+            // Iterate over the cells in the grid.
+            for (int row_index = 0; row_index < rows_amount; row_index++)
+                for (int col_index = 0; col_index < columns_amount; col_index++)
+                    cells[row_index][col_index] -> reset();
+        }
+        
+        // The function receives an entity and refresh it location on the grid.
+        void refresh_entity(GridEntity* entity_to_refresh)
+        {
+            // Remove it from the grid.
+            remove_entity(entity_to_refresh);
+            
+            // Add it to the grid.
+            add_entity(entity_to_refresh);
+        }
+        
+        // The function receives an entity and adds it to the grid.
+        void add_entity(GridEntity* new_entity)
+        {
+            /*
+                The rectangles are not rotated. 
+                This fact means that a rectangle is within a cell, if and only if the cell is between the y axis boundaries of the rectangle, as well as the x axis boundaries.
+            */
+			
+            // Get the location and size of the entity.
+            Location location = new_entity -> get_location();
+            Size size = new_entity -> get_size();
+            float scale = new_entity -> get_scale();
+           
+            // Calculate the x boundaries.
+            int x_boundary_left = location.x - ((sqrt(scale) * size.width) / 2);
+            int x_boundary_right = x_boundary_left + (sqrt(scale) * size.width);
+            
+            // Calculate the y boundaries.
+            int y_boundary_top = location.y - ((sqrt(scale) * size.height) / 2);
+            int y_boundary_bottom = y_boundary_top + (sqrt(scale) * size.height);
+            
+            // Find the left and right columns indexes boundaries.
+            int left_column_index_boundary = (int) floor( (double) x_boundary_left / cell_width_pixels);
+            int right_column_index_boundary = (int) floor( (double) x_boundary_right / cell_width_pixels);
+            
+            // Find the top and bottom rows indexes boundaries.
+            int top_row_index_boundary = (int) floor( (double) y_boundary_top / cell_height_pixels);
+            int bottom_row_index_boundary = (int) floor( (double) y_boundary_bottom / cell_height_pixels);
+            
+            // Don't care if outside the grid.
+            if (top_row_index_boundary >= rows_amount) { top_row_index_boundary = rows_amount - 1; }
+            else if (top_row_index_boundary < 0) { top_row_index_boundary = 0; }
+            
+            if (bottom_row_index_boundary < 0) { bottom_row_index_boundary = 0; }
+            else if (bottom_row_index_boundary >= rows_amount) { bottom_row_index_boundary = rows_amount - 1; }
+            
+            if (left_column_index_boundary < 0) { left_column_index_boundary = 0; }
+            else if (left_column_index_boundary >= columns_amount) { left_column_index_boundary = columns_amount - 1; }
+            
+            if (right_column_index_boundary >= columns_amount) { right_column_index_boundary = columns_amount - 1; }
+            else if (right_column_index_boundary < 0) { right_column_index_boundary = 0; }
+
+            // Add the entity to all the cells within those boundaries.
+            for (int row_index = top_row_index_boundary; row_index <= bottom_row_index_boundary; row_index++)
+            {
+                for(int col_index = left_column_index_boundary; col_index <= right_column_index_boundary; col_index++)
+                {
+                    // Add the entity to the current cell (also adds the cell to the current entity).
+                    cells[row_index][col_index] -> add_entity(new_entity);
+                }
+            }
+        }
+        
+        // The function removes an entity from the grid.
+        void remove_entity(GridEntity* entity_to_remove)
+        {
+            // How many cells the entity is currently within.
+            int amount_of_cells_within = entity_to_remove -> get_amount_of_cells_within();
+            
+            // Get the list of cells that the entity is currently within.
+            Cell** cells_within = entity_to_remove -> get_cells_within();
+
+            // Iterate over the cells within.
+            for (int i = 0; i < amount_of_cells_within; i++)
+            {
+                cells_within[i] -> remove_entity(entity_to_remove);
+            }
+            
+            // Reset the cells within of the entity to remove.
+            entity_to_remove -> reset_cells_within();
+        }
+        
+        // Getters.
+
+        // The function returns the amount of columns.
+        int get_columns_amount() { return columns_amount; }
+        
+        // The function returns the amount of rows.
+        int get_rows_amount() { return rows_amount; }
+        
+        // Getters.
+        int get_width_pixels() { return width_pixels; }
+        int get_height_pixels() { return height_pixels; }
+        int get_cell_width_pixels() { return cell_width_pixels; }
+        int get_cell_height_pixels() { return cell_height_pixels; }
+        
+        // Returns the cells matrix.
+        Cell*** get_cells() { return cells; }
+        
+        // The function saves the entities of every cell in their order (the order of the collision checks) by their state indexes, every cell
+        // is its entities amount followed by their indexes. Returns how many numbers were saved, or -1 if they don't fit (see WorldState).
+        int save_cells(int32_t* entries, int max_entries)
+        {
+            int entries_amount = 0;
+            
+            for (int row_index = 0; row_index < rows_amount; row_index++)
+            {
+                for (int col_index = 0; col_index < columns_amount; col_index++)
+                {
+                    Cell* cell = cells[row_index][col_index];
+                    if (entries_amount + 1 + cell -> get_entities_counter() > max_entries) { return -1; }
+                    
+                    entries[entries_amount++] = cell -> get_entities_counter();
+                    for (int i = 0; i < cell -> get_entities_counter(); i++) { entries[entries_amount++] = cell -> get_entities()[i] -> get_state_index(); }
+                }
+            }
+            
+            return entries_amount;
+        }
+        
+        // The function puts the entities back in the cells in the saved order, entities[i] has the state index i. Returns false if the saved
+        // cells don't match the grid, or put an entity in more cells than it can be within (the grid is left empty).
+        bool load_cells(const int32_t* entries, int entries_amount, GridEntity** entities, int entities_amount)
+        {
+            reset();
+            for (int i = 0; i < entities_amount; i++) { entities[i] -> reset_cells_within(); }
+            
+            int entry_index = 0;
+            
+            for (int row_index = 0; row_index < rows_amount; row_index++)
+            {
+                for (int col_index = 0; col_index < columns_amount; col_index++)
+                {
+                    if (entry_index >= entries_amount) { reset(); return false; }
+                    
+                    int cell_entities_amount = entries[entry_index++];
+                    if (cell_entities_amount < 0 || cell_entities_amount > cell_maximum_amount_of_entities || entry_index + cell_entities_amount > entries_amount) { reset(); return false; }
+                    
+                    for (int i = 0; i < cell_entities_amount; i++)
+                    {
+                        int state_index = entries[entry_index++];
+                        if (state_index < 0 || state_index >= entities_amount) { reset(); return false; }
+                        if (entities[state_index] -> get_amount_of_cells_within() >= entities[state_index] -> get_max_cells_within()) { reset(); return false; }
+                        
+                        cells[row_index][col_index] -> add_entity(entities[state_index]);
+                    }
+                }
+            }
+            
+            return entry_index == entries_amount;
+        }
+        
+        // Returns how many cells there are.
+        int get_cells_amount() { return rows_amount * columns_amount; }
+};
+
+
+class MyGif: public GridEntity
+{
+    /*
+        Load a gif to the screen.
+        
+        Notes:
+            - The gif is loaded as a texture, and manipulated as a texture.
+            - The gif is moved by the simulation thread, the texture is created and updated by the main thread when the gif is drawn (from a snapshot). Only the drawn frames are uploaded.
+            - A gif removed by the simulation thread is retired, its texture is unloaded by the main thread (Simulation::unload_retired_gifs()).
+            - The gif doesn't have to be on a grid, an almost identical MyGif class is spared due to unnecessary code overload. Simply the value of max_cells_within can be ignored and the array    
+              cells_within should be nothing but a null pointer.
+    */
+    
+    protected:
+    
+        // An optional attribute, if true on intialization, the gif originaly facing left. Indicates to flip it horizontaly to face right on startup.
+        bool is_facing_left_on_startup;
+        
+        // If true, flips the gif horizontally.
+        bool is_flip_horizontal;
+        
+        // If true, flips the gif vertically.
+        bool is_flip_vertical;
+        
+        // When the gif is loaded, this variable contains the amount of frames this gif has.
+        int* frames_amount;
+        
+        // Pointing on the current frame of the gif that is being displayed.
+        int current_frame = 0;
+        
+        // The gif as image.
+        Image my_gif_image;
+
+        // The gif as texture, and the frame which is on it (main thread only).
+        Texture2D my_gif_texture;
+        int uploaded_frame;
+        
+        // The tint of the gif.
+        Color tint;
+        
+        // The location on the previous tick, the gif is drawn between it and the current location.
+        Location previous_location;
+        bool is_previous_location_set;
+    
+    public:
+    
+        // The queue of the retired gifs, set by the simulation (NULL when the gifs are not simulated on a thread of their own).
+        static EventQueue<MyGif*>* retired_gifs;
+        
+        // Constructor.
+        MyGif(Image new_my_gif_image, int* new_frames_amount, frame new_collision_frame, string new_entity_type, Location new_location, Size new_size, float new_scale, float new_max_scale, int new_rotation, bool new_is_facing_left_on_startup, int new_max_cells_within, Cell** new_cells_within) : GridEntity(new_entity_type, new_collision_frame, new_location, new_size, new_scale, new_max_scale, new_rotation, new_max_cells_within, new_cells_within)
+        {
+            // Save the image of the gif.
+            my_gif_image = new_my_gif_image;
+            
+            // Save the frames amount instance.
+            frames_amount = new_frames_amount;
+            
+            // True if the gif faces left originaly.
+            is_facing_left_on_startup = new_is_facing_left_on_startup;
+            
+            // Set the texture on initialization to face right.
+            if (is_facing_left_on_startup) { is_flip_horizontal = true; }
+            else { is_flip_horizontal = false; }
+
+            // Do not flip the texture verticaly on initialization.
+            is_flip_vertical = false;           
+
+            // The texture is created when the gif is first drawn.
+            my_gif_texture.id = 0;
+            uploaded_frame = -1;
+            
+            // Set the collision frame to match the current size.
+            set_original_size(Size(my_gif_image.width, my_gif_image.height));
+            
+            // Set the tint to white.
+            tint = WHITE;
+            
+            // Drawn at its location until the first tick.
+            is_previous_location_set = false;
+        }
+        
+        // Default Constructor.
+        MyGif() : GridEntity()
+        {
+            is_facing_left_on_startup = false;
+            is_flip_horizontal = false;
+            is_flip_vertical = false;
+            is_previous_location_set = false;
+            my_gif_texture.id = 0;
+            uploaded_frame = -1;
+        }
+        
+        // Flipping manipulations
+        void flip_horizontal() {is_facing_left_on_startup ? is_flip_horizontal = false : is_flip_horizontal = true;}
+        void flip_vertical() {is_flip_vertical = true;}
+        void unflip_horizontal() {is_facing_left_on_startup ? is_flip_horizontal = true : is_flip_horizontal = false;}
+        void unflip_vertical() {is_flip_vertical = false;}
+        
+        // Change the tint of the gif.
+        void update_tint(Color new_tint) { tint = new_tint; }
+        
+        // The function saves the location before a tick moves the gif.
+        void save_previous_location() { previous_location = location; is_previous_location_set = true; }
+        
+        // The gif jumped to a new location, it shouldn't be drawn moving there.
+        void forget_previous_location() { is_previous_location_set = false; }
+        
+        // The function Prepare the next frame of the gif (the texture is updated when the frame is drawn).
+        void set_next_frame()
+        {
+            // Point on the next frame.
+            current_frame++;
+            
+            // Reset the current frame index if currently displaying the last frame of the gif.
+            if (current_frame >= *frames_amount) { current_frame = 0; }
+        }
+        
+        // The function saves how to draw the gif as it is now (simulation thread).
+        void take_snapshot(gif_snapshot* snapshot)
+        {
+            snapshot -> gif = this;
+            snapshot -> location = location;
+            snapshot -> previous_location = previous_location;
+            snapshot -> is_previous_location_set = is_previous_location_set;
+            snapshot -> size = size;
+            snapshot -> scale = scale;
+            snapshot -> rotation = rotation;
+            snapshot -> frame = current_frame;
+            snapshot -> tint = tint;
+            snapshot -> is_flip_horizontal = is_flip_horizontal;
+            snapshot -> is_flip_vertical = is_flip_vertical;
+            snapshot -> collision_frame = get_updated_collision_frame();
+        }
+        
+        // The function draws the gif as it was in the snapshot, alpha is how far the frame is between the previous tick and the last one (main thread).
+        void draw_snapshot(gif_snapshot& snapshot, float alpha)
+        {
+            // Put the frame of the snapshot on the texture.
+            upload_frame(snapshot.frame);
+            
+            // -1 cause flip, 1 do not flips.
+            float flip_width = 1, flip_height = 1;
+            
+            // Check if required flipping.
+            if (snapshot.is_flip_horizontal) {flip_width = -1;}
+            if (snapshot.is_flip_vertical) {flip_height = -1;}
+            
+            // Crop the gif (we don't want to crop any gif, so just take its original frame).
+            Rectangle source = {0, 0, flip_width * my_gif_texture.width, flip_height * my_gif_texture.height};
+            
+            // The location between the previous tick and the last one.
+            float drawn_x = (float) snapshot.location.x;
+            float drawn_y = (float) snapshot.location.y;
+            if (snapshot.is_previous_location_set)
+            {
+                drawn_x = snapshot.previous_location.x + (snapshot.location.x - snapshot.previous_location.x) * alpha;
+                drawn_y = snapshot.previous_location.y + (snapshot.location.y - snapshot.previous_location.y) * alpha;
+            }
+            
+            // Where to draw the gif. The input location is where to put the center on the screen.
+            Rectangle destination = {drawn_x, drawn_y, (float) floor(sqrt(snapshot.scale) * snapshot.size.width), (float) floor(sqrt(snapshot.scale) * snapshot.size.height)};
+            
+            // We want the gif to be rotated in relation to its center, and we want that the inputed location in the destination rectangle will be the center.
+            Vector2 center = {(sqrt(snapshot.scale) * snapshot.size.width) / 2, (sqrt(snapshot.scale) * snapshot.size.height) / 2};
+            
+            // Draw the frame of the gif properly.
+            DrawTexturePro(my_gif_texture, source, destination, center, snapshot.rotation, snapshot.tint);
+        }
+
+        // The function removes the gif from the screen (main thread).
+        void delete_gif()
+        {
+            // Remove the texture.
+            if (my_gif_texture.id != 0) { UnloadTexture(my_gif_texture); }
+            my_gif_texture.id = 0;
+            uploaded_frame = -1;
+        }
+        
+        // The function removes the gif from the screen, from the simulation thread (the texture is unloaded by the main thread, once the gif is not drawn anymore).
+        void retire_gif()
+        {
+            if (retired_gifs == NULL) { delete_gif(); }
+            else if (!retired_gifs -> push(this)) { TraceLog(LOG_WARNING, "Too many retired gifs, a texture is not unloaded"); }
+        }
+        
+        // Returns the center location of the gif.
+        Location get_location() {return location;}
+    
+    private:
+    
+        // The function puts a frame on the texture, the texture is created on the first time (main thread).
+        void upload_frame(int frame)
+        {
+            // Create the texture instance.
+            if (my_gif_texture.id == 0) { my_gif_texture = LoadTextureFromImage(my_gif_image); uploaded_frame = 0; }
+            
+            if (frame == uploaded_frame) { return; }
+            
+            // Get memory offset position for the frame data in image.data.
+            int frame_data_offset = my_gif_image.width * my_gif_image.height * 4 * frame;
+            
+            // Update GPU texture data with the frame image data.
+            UpdateTexture(my_gif_texture, ((unsigned char *) my_gif_image.data) + frame_data_offset);
+            uploaded_frame = frame;
+        }
+};
+
+EventQueue<MyGif*>* MyGif::retired_gifs = NULL;
+
+
+// ----- Game Classes -----
+
+
+class SfxStore
+{
+    /*
+        Keeps the sound effects compressed, and decodes them on the voices while they play.
+        
+        Notes:
+            - The effects are kept as IMA-ADPCM blocks (4 bits per mono sample), a quarter of 16 bit PCM and a sixteenth of a raylib sound (which is converted to the 32 bit stereo format of the device).
+            - Every voice is an audio stream with a callback, the audio thread decodes the playing clip straight into the stream.
+            - A voice is handed to the audio thread with an atomic state, a clip can be started on a playing voice (it is picked up on the next callback).
+            - The clips are encoded on the asset workers (encode()), which also measure the signal to noise ratio of every clip, report() logs it with the memory.
+            - The callbacks can't receive an argument, so only one store can play at a time.
+    */
+    
+    public:
+    
+        // The format of the clips.
+        static const int SAMPLE_RATE = 44100;
+        static const int BLOCK_BYTES = 256;
+        static const int BLOCK_FRAMES = 505;
+        
+        // The callbacks are written for up to 8 voices.
+        static const int MAX_VOICES = 8;
+    
+    private:
+    
+        // The clips.
+        int max_clips;
+        int clips_amount;
+        sfx_clip* clips;
+        
+        // The voices, the state of a voice is 0 when it is free, the clip + 1 when a clip was started on it, and -1 while it plays.
+        int voices_amount;
+        AudioStream* voices;
+        std::atomic<int>* voices_states;
+        
+        // The decoding position of every voice, used by the audio thread only.
+        adpcm_state* decoders;
+        
+        // The store which the callbacks decode from.
+        static SfxStore* playing_store;
+    
+    public:
+    
+        // Constructor, the audio device must be initialized.
+        SfxStore(int new_max_clips, int new_voices_amount)
+        {
+            // Create the clips array.
+            max_clips = new_max_clips;
+            clips_amount = 0;
+            clips = new sfx_clip[max_clips];
+            
+            // Create the voices, every voice is a mono 16 bit stream which is filled by its callback.
+            voices_amount = min(new_voices_amount, (int) MAX_VOICES);
+            voices = new AudioStream[voices_amount];
+            voices_states = new std::atomic<int>[voices_amount];
+            decoders = new adpcm_state[voices_amount];
+            
+            AudioCallback callbacks[MAX_VOICES] = {&voice_callback<0>, &voice_callback<1>, &voice_callback<2>, &voice_callback<3>, &voice_callback<4>, &voice_callback<5>, &voice_callback<6>, &voice_callback<7>};
+            
+            playing_store = this;
+            
+            for (int i = 0; i < voices_amount; i++)
+            {
+                voices_states[i].store(0);
+                decoders[i].clip = -1;
+                voices[i] = LoadAudioStream(SAMPLE_RATE, 16, 1);
+                SetAudioStreamCallback(voices[i], callbacks[i]);
+            }
+        }
+        
+        // The function encodes a decoded sound into a clip (any format, converted to mono at the sample rate of the store), safe to call from any thread.
+        static sfx_clip encode(Wave wave, const char* name)
+        {
+            sfx_clip clip = { name, 0, 0, NULL, 0 };
+            if (wave.data == NULL || wave.frameCount == 0) { return clip; }
+            
+            Wave mono = WaveCopy(wave);
+            WaveFormat(&mono, SAMPLE_RATE, 16, 1);
+            short* samples = (short*) mono.data;
+            
+            clip.frames_amount = (int) mono.frameCount;
+            clip.blocks_amount = (clip.frames_amount + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+            clip.blocks = new unsigned char[clip.blocks_amount * BLOCK_BYTES];
+            memset(clip.blocks, 0, clip.blocks_amount * BLOCK_BYTES);
+            
+            // The step index carries on between the blocks, the predictor restarts from the real sample on every block.
+            int predictor = 0;
+            int step_index = 0;
+            
+            for (int block_index = 0; block_index < clip.blocks_amount; block_index++)
+            {
+                unsigned char* block = clip.blocks + block_index * BLOCK_BYTES;
+                int first_frame = block_index * BLOCK_FRAMES;
+                
+                // The block header: the first sample and the step index.
+                predictor = samples[first_frame];
+                block[0] = (unsigned char) (predictor & 0xFF);
+                block[1] = (unsigned char) ((predictor >> 8) & 0xFF);
+                block[2] = (unsigned char) step_index;
+                block[3] = 0;
+                
+                // The rest of the samples, two in a byte (the low half first).
+                for (int i = 1; i < BLOCK_FRAMES; i++)
+                {
+                    int sample = (first_frame + i < clip.frames_amount) ? samples[first_frame + i] : 0;
+                    int nibble = encode_sample(sample, &predictor, &step_index);
+                    block[4 + (i - 1) / 2] |= (unsigned char) (nibble << (((i - 1) % 2) * 4));
+                }
+            }
+            
+            // Measure the quality, the decoded clip against the original samples.
+            adpcm_state state = { 0, 0, 0, 0 };
+            double signal_power = 0;
+            double noise_power = 0;
+            for (int i = 0; i < clip.frames_amount; i++)
+            {
+                double error = decode_next(clip, &state) - samples[i];
+                signal_power += (double) samples[i] * samples[i];
+                noise_power += error * error;
+            }
+            clip.snr = (noise_power > 0) ? (float) (10 * log10(signal_power / noise_power)) : 99;
+            
+            UnloadWave(mono);
+            
+            return clip;
+        }
+        
+        // The function adds an encoded clip, returns its number for play().
+        int add_clip(sfx_clip clip)
+        {
+            if (clips_amount >= max_clips) { TraceLog(LOG_ERROR, "Too many sound effects, %s is skipped", clip.name); delete[] clip.blocks; return -1; }
+            
+            clips[clips_amount] = clip;
+            clips_amount++;
+            
+            return clips_amount - 1;
+        }
+        
+        // The function starts a clip on a voice (replaces the clip which plays on it).
+        void play(int voice, int clip, float pitch, float gain)
+        {
+            if (clip < 0 || clip >= clips_amount || clips[clip].blocks == NULL) { return; }
+            
+            SetAudioStreamPitch(voices[voice], pitch);
+            SetAudioStreamVolume(voices[voice], gain);
+            
+            // Hand the clip to the audio thread.
+            voices_states[voice].store(clip + 1, std::memory_order_release);
+            if (!IsAudioStreamPlaying(voices[voice])) { PlayAudioStream(voices[voice]); }
+        }
+        
+        // Returns true if a clip plays on the voice.
+        bool is_voice_playing(int voice) { return voices_states[voice].load(std::memory_order_acquire) != 0; }
+        
+        // The function stops a voice.
+        void stop(int voice)
+        {
+            voices_states[voice].store(0, std::memory_order_release);
+            StopAudioStream(voices[voice]);
+        }
+        
+        // The function stops the streams of the voices which finished their clips, so the device doesn't mix their silence.
+        void stop_idle_voices()
+        {
+            for (int i = 0; i < voices_amount; i++)
+            {
+                if (!is_voice_playing(i) && IsAudioStreamPlaying(voices[i])) { StopAudioStream(voices[i]); }
+            }
+        }
+        
+        // The function logs the memory of the clips compared to 16 bit PCM and to raylib sounds, and their quality.
+        void report()
+        {
+            uint64_t adpcm_bytes = 0;
+            uint64_t pcm_bytes = 0;
+            
+            for (int i = 0; i < clips_amount; i++)
+            {
+                adpcm_bytes += (uint64_t) clips[i].blocks_amount * BLOCK_BYTES;
+                pcm_bytes += (uint64_t) clips[i].frames_amount * 2;
+                TraceLog(LOG_INFO, "SFX store: %s, %d frames, %d bytes (16 bit PCM %d bytes), SNR %.1f dB", clips[i].name, clips[i].frames_amount, clips[i].blocks_amount * BLOCK_BYTES, clips[i].frames_amount * 2, clips[i].snr);
+            }
+            
+            TraceLog(LOG_INFO, "SFX store: %d clips, %llu bytes, 16 bit PCM %llu bytes, raylib sounds %llu bytes", clips_amount, (unsigned long long) adpcm_bytes, (unsigned long long) pcm_bytes, (unsigned long long) pcm_bytes * 4);
+        }
+        
+        // The function closes the voices and the clips.
+        void unload()
+        {
+            for (int i = 0; i < voices_amount; i++) { stop(i); UnloadAudioStream(voices[i]); }
+            playing_store = NULL;
+            
+            for (int i = 0; i < clips_amount; i++) { delete[] clips[i].blocks; clips[i].blocks = NULL; }
+            clips_amount = 0;
+        }
+        
+        // Getters.
+        int get_voices_amount() { return voices_amount; }
+    
+    private:
+    
+        // The callback of a voice (one function per voice, the callbacks have no argument).
+        template <int voice>
+        static void voice_callback(void* buffer, unsigned int frames)
+        {
+            if (playing_store == NULL) { memset(buffer, 0, frames * sizeof(short)); return; }
+            
+            playing_store -> fill_voice(voice, (short*) buffer, frames);
+        }
+        
+        // The function decodes the clip of a voice into its stream, called by the audio thread.
+        void fill_voice(int voice, short* samples, unsigned int frames)
+        {
+            adpcm_state& state = decoders[voice];
+            int voice_state = voices_states[voice].load(std::memory_order_acquire);
+            
+            // A new clip was started on the voice.
+            if (voice_state > 0)
+            {
+                state.clip = voice_state - 1;
+                state.frame = 0;
+                voices_states[voice].compare_exchange_strong(voice_state, -1);
+            }
+            
+            // The voice was stopped.
+            else if (voice_state == 0) { state.clip = -1; }
+            
+            unsigned int i = 0;
+            
+            if (state.clip != -1)
+            {
+                sfx_clip& clip = clips[state.clip];
+                for (; i < frames && state.frame < clip.frames_amount; i++) { samples[i] = (short) decode_next(clip, &state); }
+                
+                // The clip is over, free the voice (unless another clip was started on it meanwhile).
+                if (state.frame >= clip.frames_amount)
+                {
+                    state.clip = -1;
+                    int playing_state = -1;
+                    voices_states[voice].compare_exchange_strong(playing_state, 0);
+                }
+            }
+            
+            // Silence after the clip.
+            for (; i < frames; i++) { samples[i] = 0; }
+        }
+        
+        // The function decodes the next sample of a clip.
+        static int decode_next(sfx_clip& clip, adpcm_state* state)
+        {
+            unsigned char* block = clip.blocks + (state -> frame / BLOCK_FRAMES) * BLOCK_BYTES;
+            int index_in_block = state -> frame % BLOCK_FRAMES;
+            state -> frame++;
+            
+            // The first sample of a block is in its header.
+            if (index_in_block == 0)
+            {
+                state -> predictor = (short) (block[0] | (block[1] << 8));
+                state -> step_index = block[2];
+                return state -> predictor;
+            }
+            
+            int nibble = (block[4 + (index_in_block - 1) / 2] >> (((index_in_block - 1) % 2) * 4)) & 0xF;
+            return decode_sample(nibble, &state -> predictor, &state -> step_index);
+        }
+        
+        // The function finds the 4 bit code closest to the sample, and updates the state as the decoder will.
+        static int encode_sample(int sample, int* predictor, int* step_index)
+        {
+            int step = get_step(*step_index);
+            int difference = sample - *predictor;
+            int nibble = 0;
+            
+            if (difference < 0) { nibble = 8; difference = -difference; }
+            if (difference >= step) { nibble |= 4; difference -= step; }
+            if (difference >= step / 2) { nibble |= 2; difference -= step / 2; }
+            if (difference >= step / 4) { nibble |= 1; }
+            
+            decode_sample(nibble, predictor, step_index);
+            
+            return nibble;
+        }
+        
+        // The function decodes a 4 bit code, updates the state and returns the sample.
+        static int decode_sample(int nibble, int* predictor, int* step_index)
+        {
+            static const int INDEX_TABLE[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+            
+            int step = get_step(*step_index);
+            int delta = step >> 3;
+            if (nibble & 4) { delta += step; }
+            if (nibble & 2) { delta += step >> 1; }
+            if (nibble & 1) { delta += step >> 2; }
+            
+            if (nibble & 8) { *predictor -= delta; }
+            else { *predictor += delta; }
+            
+            *predictor = max(-32768, min(32767, *predictor));
+            *step_index = max(0, min(88, *step_index + INDEX_TABLE[nibble]));
+            
+            return *predictor;
+        }
+        
+        // Returns the quantization step of a step index.
+        static int get_step(int step_index)
+        {
+            static const int STEP_TABLE[89] = {7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+            
+            return STEP_TABLE[step_index];
+        }
+};
+
+// The store which the voice callbacks decode from.
+SfxStore* SfxStore::playing_store = NULL;
+
+
+class SfxMixer
+{
+    /*
+        Plays the sound effects requested by the gameplay, once a frame.
+        
+        Notes:
+            - The gameplay only requests sounds (with a location and a priority), the requests are played by play_requests() at the end of the frame.
+            - The requests come from the simulation thread, they are handed to the main thread in a lock free queue (merged when they are played).
+            - The requests of the same clip by the same group (the fish type) are merged, one eat sound per species per frame. A clip which was already started on the frame is not started again for another group.
+            - Requests farther than the hearing distance from the listener (the camera) are culled.
+            - The sounds play on the voices of the sound effects store, a request can take the voice of a lower priority sound, otherwise it is dropped.
+            - The counters compare how many sounds were requested to how many were actually played.
+    */
+    
+    private:
+    
+        // The store which plays the clips.
+        SfxStore* store;
+        
+        // The requests which were not played yet, pushed by the simulation thread.
+        EventQueue<sound_request> pending_requests;
+        
+        // The requests of the current frame.
+        int max_requests;
+        int requests_amount;
+        sound_request* requests;
+        
+        // What plays on the voices.
+        int max_voices;
+        int* voices_clips;
+        int* voices_priorities;
+        bool* is_voice_played_on_frame;
+        
+        // The listener location and how far it can hear.
+        Location listener;
+        float hearing_distance;
+        
+        // How many sounds were played on the last frame.
+        int frame_played;
+        
+        // Total counters.
+        long total_requested;
+        long total_merged;
+        long total_culled;
+        long total_dropped;
+        long total_played;
+    
+    public:
+    
+        // Constructor, up to 16 times the played requests can be pending (a frame has several ticks).
+        SfxMixer(SfxStore* new_store, int new_max_requests) : pending_requests(new_max_requests * 16)
+        {
+            store = new_store;
+            
+            // Create the requests array.
+            max_requests = new_max_requests;
+            requests_amount = 0;
+            requests = new sound_request[max_requests];
+            
+            // Create the voices arrays.
+            max_voices = store -> get_voices_amount();
+            voices_clips = new int[max_voices];
+            voices_priorities = new int[max_voices];
+            is_voice_played_on_frame = new bool[max_voices];
+            for (int i = 0; i < max_voices; i++) { voices_clips[i] = -1; voices_priorities[i] = 0; is_voice_played_on_frame[i] = false; }
+            
+            // Hears everything until a listener is set.
+            listener = Location(0, 0);
+            hearing_distance = -1;
+            
+            frame_played = 0;
+            total_requested = 0;
+            total_merged = 0;
+            total_culled = 0;
+            total_dropped = 0;
+            total_played = 0;
+        }
+        
+        // The function requests a sound for the current frame (the simulation thread).
+        void request(sound_variant sound, string group, Location location, int priority)
+        {
+            // The clip is not loaded.
+            if (sound.clip == -1) { return; }
+            
+            sound_request new_request;
+            new_request.clip = sound.clip;
+            new_request.pitch = sound.pitch;
+            new_request.gain = sound.gain;
+            new_request.group = group;
+            new_request.location = location;
+            new_request.priority = priority;
+            
+            // Counted as dropped when the frame is played (the queue counts).
+            pending_requests.push(new_request);
+        }
+        
+        // The function sets the location of the listener, and the distance it can hear (negative to hear everything).
+        void set_listener(Location new_listener, float new_hearing_distance)
+        {
+            listener = new_listener;
+            hearing_distance = new_hearing_distance;
+        }
+        
+        // The function plays the requests of the frame, should be called once a frame (the main thread).
+        void play_requests()
+        {
+            // Take the requests which were pushed since the previous frame.
+            sound_request pending_request;
+            while (pending_requests.pop(&pending_request)) { add_request(pending_request); }
+            
+            frame_played = 0;
+            for (int i = 0; i < max_voices; i++) { is_voice_played_on_frame[i] = false; }
+            
+            // Sort the requests by priority (few requests, insertion sort).
+            for (int i = 1; i < requests_amount; i++)
+            {
+                sound_request current_request = requests[i];
+                int j = i - 1;
+                while (j >= 0 && requests[j].priority < current_request.priority) { requests[j + 1] = requests[j]; j--; }
+                requests[j + 1] = current_request;
+            }
+            
+            for (int i = 0; i < requests_amount; i++)
+            {
+                // Too far from the listener.
+                if (hearing_distance >= 0)
+                {
+                    float distance_x = requests[i].location.x - listener.x;
+                    float distance_y = requests[i].location.y - listener.y;
+                    if (distance_x * distance_x + distance_y * distance_y > hearing_distance * hearing_distance) { total_culled++; continue; }
+                }
+                
+                // The clip was already started on this frame (requested by another group).
+                if (is_played_on_frame(requests[i].clip)) { total_merged++; continue; }
+                
+                int voice = find_voice(requests[i]);
+                
+                // No voice available.
+                if (voice == -1) { total_dropped++; continue; }
+                
+                voices_clips[voice] = requests[i].clip;
+                voices_priorities[voice] = requests[i].priority;
+                is_voice_played_on_frame[voice] = true;
+                store -> play(voice, requests[i].clip, requests[i].pitch, requests[i].gain);
+                
+                total_played++;
+                frame_played++;
+            }
+            
+            requests_amount = 0;
+            
+            store -> stop_idle_voices();
+        }
+        
+        // The function stops all the voices, and clears the requests.
+        void stop_all()
+        {
+            for (int i = 0; i < max_voices; i++) { store -> stop(i); }
+            
+            sound_request pending_request;
+            while (pending_requests.pop(&pending_request)) {}
+            
+            requests_amount = 0;
+        }
+        
+        // The function logs the counters.
+        void report()
+        {
+            TraceLog(LOG_INFO, "SFX: requested %ld, merged %ld, culled %ld, dropped %ld, played %ld", total_requested + pending_requests.get_dropped_amount(), total_merged, total_culled, total_dropped + pending_requests.get_dropped_amount(), total_played);
+        }
+        
+        // Getters.
+        int get_frame_played() { return frame_played; }
+        long get_total_requested() { return total_requested; }
+        long get_total_played() { return total_played; }
+    
+    private:
+    
+        // The function adds a request to the requests of the frame, merged with a request of the same clip by the same group.
+        void add_request(sound_request& new_request)
+        {
+            total_requested++;
+            
+            // Merge with a request of the same clip by the same group, the higher priority is kept.
+            for (int i = 0; i < requests_amount; i++)
+            {
+                if (requests[i].clip == new_request.clip && requests[i].group == new_request.group)
+                {
+                    if (new_request.priority > requests[i].priority) { requests[i] = new_request; }
+                    total_merged++;
+                    return;
+                }
+            }
+            
+            // Too many different requests in one frame.
+            if (requests_amount >= max_requests) { total_dropped++; return; }
+            
+            requests[requests_amount] = new_request;
+            requests_amount++;
+        }
+        
+        // Returns true if the clip was started on this frame.
+        bool is_played_on_frame(int clip)
+        {
+            for (int i = 0; i < max_voices; i++)
+            {
+                if (is_voice_played_on_frame[i] && voices_clips[i] == clip) { return true; }
+            }
+            
+            return false;
+        }
+        
+        // The function returns the voice to play the request on, -1 if there is none.
+        int find_voice(sound_request& current_request)
+        {
+            int lowest_voice = -1;
+            
+            for (int i = 0; i < max_voices; i++)
+            {
+                // A free voice.
+                if (!store -> is_voice_playing(i)) { return i; }
+                
+                if (lowest_voice == -1 || voices_priorities[i] < voices_priorities[lowest_voice]) { lowest_voice = i; }
+            }
+            
+            // Take the voice of a lower priority sound.
+            if (lowest_voice != -1 && voices_priorities[lowest_voice] < current_request.priority) { return lowest_voice; }
+            
+            return -1;
+        }
+};
+
+
+// Need to declare for the Fish class.
+class FishNetwork;
+
+
+class Fish : public MyGif
+{
+    /*
+        Represents a fish.
+    */
+    
+    protected:
+        
+        // How many frames elapsed in a second.
+        int fps;
+
+        // The type of the fish.
+        string fish_type;
+        
+        // The speed of the fish on the x and y axes, pixels/frame;
+        float speed_x, speed_y;
+        
+        // The location boundaries of the fish.
+        int left_boundary, right_boundary, top_boundary, bottom_boundary;
+        
+        // Indicating if the fish is out of bounds.
+        bool is_fish_out_of_bounds;
+        
+        // Indicates on the moving direction of the fish on the x axis.
+        bool is_moving_right;
+        
+        // Indicating that the fish was eaten.
+        bool is_eaten;
+        
+        // How much the fish grows after eating another fish.
+        float eat_grow_ratio;
+        
+        // Can eat fish that are <can_eat_ratio> my size and greater.
+        float can_eat_ratio;
+        
+        // Can't eat fish that are <cant_eat_ratio> and less my size.
+        float cant_eat_ratio;
+        
+        // If true the fish can't get stinged.
+        bool is_sting_proof;
+        
+        // How many frames left for the current stunt to over.
+        int current_stunt_frames_left;
+        
+        // How much size decreases each frame from the current stunt.
+        float stunt_size_decrease_per_frame;
+
+        // The original speed of the fish (for when the speed is temporarly changed).
+        int original_speed_x;
+        int original_speed_y;
+        
+        // Sounds, played through the sound effects mixer.
+        sound_variant sound_eat;
+        sound_variant sound_sting;
+        SfxMixer* sfx_mixer;
+       
+    public:
+        
+        // Counstructor.
+        Fish(int new_fps, Image new_my_fish_image, int* new_frames_amount, frame new_collision_frame, string new_fish_type, bool new_is_sting_proof, Location new_location, Size new_size, float new_speed_x, float new_speed_y, int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, float new_scale, float new_max_scale, float new_eat_grow_ratio, float new_can_eat_ratio, float new_cant_eat_ratio, float new_rotation, bool new_is_facing_left_on_startup, int new_max_cells_within, Cell** new_cells_within, sound_variant new_sound_eat, sound_variant new_sound_sting, SfxMixer* new_sfx_mixer) : MyGif(new_my_fish_image, new_frames_amount, new_collision_frame, "Fish", new_location, new_size, new_scale, new_max_scale, new_rotation, new_is_facing_left_on_startup, new_max_cells_within, new_cells_within)
+        {
+            // How many frames are there per second.
+            fps = new_fps;
+            
+            // Save the type of the fish.
+            fish_type = new_fish_type;
+            
+            // Set the speed of the fish.
+            speed_x = new_speed_x;
+            speed_y = new_speed_y;
+            
+            // Set the boundaries of the fish.
+            left_boundary = new_left_boundary;
+            right_boundary = new_right_boundary;
+            top_boundary = new_top_boundary;
+            bottom_boundary = new_bottom_boundary;
+            
+            // Set false in initialization. Update accurate value on the first move call.
+            is_fish_out_of_bounds = false;
+            
+            // Set the moving direction.
+            is_moving_right = (is_facing_left_on_startup) ? false: true;
+            
+            // The fish is not eaten on startup.
+            is_eaten = false;
+            
+            // The ratio of eating and growing.
+            eat_grow_ratio = new_eat_grow_ratio;
+            
+            // The ratio of fish size can eat.
+            can_eat_ratio = new_can_eat_ratio;
+            
+            // The ratio of fish size can't eat.
+            cant_eat_ratio = new_cant_eat_ratio;
+            
+            // Stunt properties.
+            is_sting_proof = new_is_sting_proof;
+            current_stunt_frames_left = 0;
+            stunt_size_decrease_per_frame = 0;
+            
+            // Sounds.
+            sound_eat = new_sound_eat;
+            sound_sting = new_sound_sting;
+            sfx_mixer = new_sfx_mixer;
+        }
+
+        // Default Constructor.
+        Fish() : MyGif()
+        {
+            fish_type = "none";
+            speed_x = 1;
+            speed_y = 1;
+            left_boundary = 0;
+            right_boundary = 0;
+            top_boundary = 1;
+            bottom_boundary = 1;
+            is_fish_out_of_bounds = false;
+            is_eaten = false;
+            sfx_mixer = NULL;
+        }
+
+        // Apply movements (including boundaries check).
+        void move_left(float ratio) 
+        {
+            if (location.x - (int)(ratio * speed_x) < left_boundary) { location.x = left_boundary; boundary_exceed(); is_fish_out_of_bounds = true; }
+            else { location.x -= (int)floor(ratio * speed_x + 0.5); flip_horizontal(); }
+            
+            if (is_moving_right) { flip_collision_frame_horizontal(); }
+            is_moving_right = false;
+        }
+        
+        void move_right(float ratio) 
+        {
+            if (location.x + (int) (ratio * speed_x) > right_boundary) { location.x = right_boundary; boundary_exceed(); is_fish_out_of_bounds = true;}
+            else { location.x += (int)floor(ratio * speed_x + 0.5); unflip_horizontal(); }
+            
+            if (!is_moving_right) { flip_collision_frame_horizontal(); }
+            is_moving_right = true;
+        }
+        
+        void move_up(float ratio) 
+        {
+            if (location.y - (int)(ratio * speed_y) < top_boundary) { location.y = top_boundary; boundary_exceed(); is_fish_out_of_bounds = true;}
+            else { location.y -= (int)floor(ratio * speed_y + 0.5); }
+        }
+        
+        void move_down(float ratio) 
+        {
+            if (location.y + (int)(ratio * speed_y) > bottom_boundary) { location.y = bottom_boundary; boundary_exceed(); is_fish_out_of_bounds = true;}
+            else { location.y += (int)floor(ratio * speed_y + 0.5); }
+        }
+        
+        // The function causes the fish a jelly fish stunt.
+        virtual void jelly_fish_stunt(float stunt_power)
+        {
+            // Sting proof.
+            if (is_sting_proof) { return; }
+            
+            // Currently in a stunt, can't be stunt again.
+            if (current_stunt_frames_left > 0) { return; }
+            
+            // Play sting sound.
+            play_sound(sound_sting);
+            
+            // Stunt.
+            current_stunt_frames_left = (int) floor(stunt_power * fps);
+            
+            // Calculate how much scale decreases each frame.
+            stunt_size_decrease_per_frame = (((scale - 1) / 4) * stunt_power) / current_stunt_frames_left;
+            
+            // Save the current speed and stunt.
+            original_speed_x = speed_x;
+            original_speed_y = speed_y;
+            speed_x = 0;
+            speed_y = 0;
+        }
+        
+        // Update the stunt for the current frame.
+        void update_stunt()
+        {
+            // If currently finished stun.
+            if (current_stunt_frames_left == 1)
+            {
+                // If the scale is not big enough, the fish is dead.
+                if (scale < 1.2) { eaten(); return; }
+                
+                // Restore the speed of the fish.
+                speed_x = original_speed_x;
+                speed_y = original_speed_y;
+                update_tint(WHITE);
+                current_stunt_frames_left--;
+            }
+            
+            // Move to the next frame.
+            if (current_stunt_frames_left > 0) 
+            {
+                current_stunt_frames_left--;
+                
+                // Update the tint for sting effect.
+                if (current_stunt_frames_left % 2 == 1) { tint = BLUE; }
+                else { tint = WHITE; }
+                
+                // Decrease the size.
+                scale -= stunt_size_decrease_per_frame;
+            }
+        }
+        
+        // The function receives new boundaries, and sets them as the new boundaries of the fish.
+        void update_boundaries(int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, bool is_consider_size)
+        {
+            // Note: the boundaries are compared to the current location of the fish, which considers its center. Therefore the precise boundary would be calculated with half the current dimentions of the fish.
+            if (is_consider_size)
+            {
+                left_boundary = new_left_boundary - (int) floor(sqrt(scale) * size.width / 2);
+                right_boundary = new_right_boundary + (int) ceil(sqrt(scale) * size.width / 2);
+                top_boundary = new_top_boundary - (int) floor(sqrt(scale) * size.height / 2);
+                bottom_boundary = new_bottom_boundary + (int) ceil(sqrt(scale) * size.height / 2);
+            }
+            
+            else
+            {
+                left_boundary = new_left_boundary;
+                right_boundary = new_right_boundary;
+                top_boundary = new_top_boundary;
+                bottom_boundary = new_bottom_boundary;
+            }
+        }
+        
+        // The function is being called when the fish is out of bounds.
+        void boundary_exceed() { if (fish_type != "my fish") { retire_gif(); } }
+        
+        // Returns true if the fish is out of bounds.
+        bool get_is_fish_out_of_bounds() { return is_fish_out_of_bounds; }
+        
+        // Getters.
+        Size get_size() { return size; }
+        string get_fish_type() { return fish_type; }
+        bool get_is_eaten() { return is_eaten; }
+        
+        // The function deletes the fish from the world.
+        // If the gif is not a part of a network, it is required to manualy remove it from the grid.
+        void delete_fish()
+        {
+            // delete_gif();
+        }
+        
+        // The function receives the amount of pixels were eaten by the fish (simply calculation of width, height and scale of the eaten entity), and increases the size of the fish.
+        bool eat (int pixels)
+        {
+            // Cannot eat, already max size.
+            if (scale == max_scale) { return false; }
+            
+            // Play eating sound.
+            play_sound(sound_eat);
+            
+            // Use the ratio to decide how much of the recieved pixels to digest.
+            pixels = (int) floor(pixels * eat_grow_ratio);
+            
+            // How many pixels are required to increase the width and the height by 1 pixel (the 4 is for the corners).
+            int current_pixels_for_loop = (int) floor((2 * size.width * sqrt(scale)) + (2 * size.height * sqrt(scale)) + 4);
+            
+            // How many full loops can be added.
+            int full_loops_counter = 0;
+            
+            // Count the full loops available, and update the left pixels.
+            while (pixels > current_pixels_for_loop)
+            {
+                pixels -= current_pixels_for_loop;
+                current_pixels_for_loop += 4;
+                full_loops_counter += 1;
+            }
+            
+            // The new scale is the current width + the added pixels / the original width of the fish.
+            float new_scale = (float) pow(((size.width * sqrt(scale)) + full_loops_counter + ( (double) pixels / current_pixels_for_loop) ) / size.width, 2);
+            if (new_scale > max_scale) { scale = max_scale; }
+            else { scale = new_scale; }
+            
+            // Scaled up.
+            return true;
+        }
+        
+        // The function is being called when the fish is getting eaten.
+        void eaten()
+        {
+            // Indicate that the fish is getting eaten.
+            is_eaten = true;
+        }
+        
+        // The function requests the sound from the mixer, the sounds of my fish have a higher priority.
+        void play_sound(sound_variant sound)
+        {
+            if (sfx_mixer == NULL) { return; }
+            
+            sfx_mixer -> request(sound, fish_type, location, (fish_type == "my fish") ? SOUND_PRIORITY_HIGH : SOUND_PRIORITY_NORMAL);
+        }
+        
+        // The function saves the state of the fish (see WorldState).
+        void save_state(fish_state* state)
+        {
+            state -> x = location.x;
+            state -> y = location.y;
+            state -> scale = scale;
+            state -> speed_x = speed_x;
+            state -> speed_y = speed_y;
+            state -> original_speed_x = original_speed_x;
+            state -> original_speed_y = original_speed_y;
+            state -> current_stunt_frames_left = current_stunt_frames_left;
+            state -> stunt_size_decrease_per_frame = stunt_size_decrease_per_frame;
+            state -> current_frame = current_frame;
+            state -> tint = tint;
+            state -> is_moving_right = is_moving_right;
+            state -> is_flip_horizontal = is_flip_horizontal;
+            state -> is_flip_vertical = is_flip_vertical;
+            state -> is_eaten = is_eaten;
+        }
+        
+        // The function restores a saved state of the fish (it jumps there, it isn't drawn moving).
+        void load_state(const fish_state* state)
+        {
+            location = Location(state -> x, state -> y);
+            forget_previous_location();
+            scale = state -> scale;
+            speed_x = state -> speed_x;
+            speed_y = state -> speed_y;
+            original_speed_x = state -> original_speed_x;
+            original_speed_y = state -> original_speed_y;
+            current_stunt_frames_left = state -> current_stunt_frames_left;
+            stunt_size_decrease_per_frame = state -> stunt_size_decrease_per_frame;
+            current_frame = (*frames_amount > 0) ? state -> current_frame % *frames_amount : 0;
+            tint = state -> tint;
+            is_flip_horizontal = state -> is_flip_horizontal;
+            is_flip_vertical = state -> is_flip_vertical;
+            is_eaten = state -> is_eaten;
+            
+            // The collision frame is mirrored whenever the direction changes.
+            if ((bool) state -> is_moving_right != is_moving_right) { flip_collision_frame_horizontal(); }
+            is_moving_right = state -> is_moving_right;
+        }
+        
+        // Eat ratio getters.
+        float get_can_eat_ratio() { return can_eat_ratio; }
+        float get_cant_eat_ratio() { return cant_eat_ratio; }
+        
+        // The function handles a collision between the fish and another GridEntity (Note that a collision between two entities is called only once).
+        void handle_collision(GridEntity* collided_with_entity)
+        {
+            // It's a collision of two fish.
+            if (collided_with_entity -> get_entity_type() == "Fish")
+            {   
+                // There is no canibalism in fish-hood.
+                if (fish_type == ((Fish*) collided_with_entity) -> get_fish_type())
+                {
+                    // Ignore the collision.
+                    return;
+                }
+                
+                // - Handle My Fish and Jelly Fish Collision -
+                
+                if (((Fish*) collided_with_entity) -> get_fish_type().rfind("Jelly Fish", 0) == 0)
+                {
+                    jelly_fish_stunt(((Fish*) collided_with_entity) -> scale);
+                    return;
+                }
+                
+                else if (fish_type.rfind("Jelly Fish", 0) == 0)
+                {
+                    ((Fish*) collided_with_entity) -> jelly_fish_stunt(scale);
+                    return;
+                }
+                
+                // - Handle Classic Fish Collision -
+                
+                // The size in width of the current fish.
+                int my_size = (int) floor(size.width * size.height * scale);
+            
+                // The size in width of the received fish.
+                int other_size = (int) floor(collided_with_entity -> get_size().width * collided_with_entity -> get_size().height * collided_with_entity -> get_scale());
+
+                // Check if the current fish can eat the other one.
+                if (my_size > other_size * can_eat_ratio && (my_size < other_size * cant_eat_ratio || fish_type == "my fish" || ((Fish*) collided_with_entity) -> get_fish_type() == "my fish"))
+                {
+                    // Try to eat, if ate, update eaten.
+                    if (eat(other_size)) { ((Fish*) collided_with_entity) -> eaten(); }
+                }
+                
+                // Check if the other fish can eat the current one.
+                else if (other_size > my_size * ((Fish*) collided_with_entity) -> get_can_eat_ratio() && (other_size < my_size * ((Fish*) collided_with_entity) -> get_cant_eat_ratio() || fish_type == "my fish" || ((Fish*) collided_with_entity) -> get_fish_type() == "my fish"))
+                {
+                    // Try to eat, if ate, update eaten.
+                    if (((Fish*)collided_with_entity) -> eat(my_size)) { eaten(); }
+                }
+            }           
+        }
+};
+
+
+class MyFish : public Fish
+{
+    /*
+        Represents the fish of the user.
+    */
+    
+    protected:
+        
+        // The speed multiplier when turbo is on.
+        float turbo;
+        
+        // How many frames the turbo last.
+        int turbo_duration_frames;
+        
+        // How many frames left till the end of the current turbo.
+        int turbo_duration_frames_left;
+        
+        // How many frames last to finish the turbo reloading.
+        int turbo_reload_frames_left;
+        
+        // How many frames it takes to revive the turbo.
+        int turbo_reload_frames;
+    
+        // When my fish reach that scale, victory.
+        float required_scale;
+        
+        // Where on the screen to draw the scale widget.
+        Location scale_widget_location;
+        
+        // The size of the scale widget.
+        Size scale_widget_size;
+        
+        // The stroke of the scale widget.
+        int scale_widget_stroke;
+        
+        // Where on the screen to draw the scale widget.
+        Location turbo_widget_location;
+        
+        // The size of the scale widget.
+        Size turbo_widget_size;
+        
+        // The stroke of the scale widget.
+        int turbo_widget_stroke;
+        
+        // Data relevant for resetting.
+        Location startup_location;
+        float original_scale;
+        
+    public:
+    
+        // Constructor.
+        MyFish(int new_fps, Image new_my_fish_image, int* new_frames_amount, frame new_collision_frame, bool new_is_sting_proof, Location new_location, Size new_size, int new_speed_x, int new_speed_y, int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, float new_scale, float new_required_scale, float new_eat_grow_ratio, float new_can_eat_ratio, float new_cant_eat_ratio, float new_rotation, bool new_is_facing_left_on_startup, int new_max_cells_within, Cell** new_cells_within, Location new_scale_widget_location, Size new_scale_sidget_size, int new_scale_widget_stroke, float new_turbo, int new_turbo_duration_frames, int new_turbo_reload_frames, Location new_turbo_widget_location, Size new_turbo_widget_size, int new_turbo_widget_stroke, sound_variant new_sound_eat, sound_variant new_sound_sting, SfxMixer* new_sfx_mixer) : Fish(new_fps, new_my_fish_image, new_frames_amount, new_collision_frame, "my fish", new_is_sting_proof, new_location, new_size, new_speed_x, new_speed_y, new_left_boundary, new_right_boundary, new_top_boundary, new_bottom_boundary, new_scale, new_required_scale, new_eat_grow_ratio, new_can_eat_ratio, new_cant_eat_ratio, new_rotation, new_is_facing_left_on_startup, new_max_cells_within, new_cells_within, new_sound_eat, new_sound_sting, new_sfx_mixer)
+        {
+            // Initialize my fish properties.
+            fps = new_fps;
+            current_stunt_frames_left = 0;
+            required_scale = new_required_scale;
+            scale_widget_location.set_location(new_scale_widget_location);
+            scale_widget_size = new_scale_sidget_size;
+            scale_widget_stroke = new_scale_widget_stroke;
+            turbo = new_turbo;
+            turbo_duration_frames = new_turbo_duration_frames;
+            turbo_duration_frames_left = 0;
+            turbo_reload_frames = new_turbo_reload_frames;
+            turbo_reload_frames_left = 0;
+            turbo_widget_location = new_turbo_widget_location;
+            turbo_widget_size = new_turbo_widget_size;
+            turbo_widget_stroke = new_turbo_widget_stroke;
+            
+            // Properties relevant for resetting.
+            startup_location = new_location;
+            original_scale = new_scale;
+        }
+        
+        // Default Constructor.
+        MyFish() : Fish()
+        {
+            
+        }
+        
+        // Resets the fish to its initial properties.
+        void reset()
+        {
+            current_stunt_frames_left = 0;
+            turbo_duration_frames_left = 0;
+            turbo_reload_frames_left = 0;
+            location.set_location(startup_location);
+            forget_previous_location();
+            scale = original_scale;
+            
+            // A world which was lost is played again.
+            is_eaten = false;
+        }
+        
+        // The function moves the fish towards the received destination.
+        void move_towards(Location destination)
+        {
+            float new_y;
+            float displacement_x = destination.x - location.x;
+            float displacement_y = destination.y - location.y;
+            
+            // If the distance is less than the speed, set the destination as the new location.
+            if (sqrt(pow(displacement_x, 2) + pow(displacement_y, 2)) < speed_x)
+            {
+                if (destination.x > location.x) { move_right(((float)destination.x - location.x) / speed_x); }
+                else { move_left((float)(location.x - destination.x) / speed_x); }
+            }
+            
+            // Find the line (connecting the current location and the destination) equation.
+            float slope = displacement_y / displacement_x;
+            float n = destination.y - (slope * destination.x);
+
+            // Movement only on one axis.
+            if (slope == 0) 
+            {
+                if (displacement_x >= 0) { move_right(1); }
+                else { move_left(1); }
+                return;
+            }
+            
+            // The values for the quadratic formula (using the distance equation).
+            float a = pow(slope, 2) + 1;
+            float b = 2 * slope * n -2 * slope * location.y -2 * location.x;
+            float c = pow(n, 2) -2 * n * location.y + pow(location.y, 2) + pow(location.x, 2) - pow(speed_x, 2);
+            
+            // The discriminant is negative, move up or down.
+            if (pow(b, 2) -4 * a * c < 0)
+            {
+                if (destination.y < location.y) { move_up(1); }
+                else { move_down(1); }
+                return;
+            }
+            
+            // The solutions of the quadratic formula.
+            float new_x_1 = ( - b + sqrt(pow(b, 2) -4 * a * c)) / (2 * a);
+            float new_x_2 = ( - b - sqrt(pow(b, 2) -4 * a * c)) / (2 * a);
+            
+            // Too large numbers (probably because the slope is too high).
+            if (new_x_1 != new_x_1 || new_x_2 != new_x_2)
+            {
+                if (destination.y < location.y) { move_up(1); }
+                else { move_down(1); }
+                return;
+            }
+            
+            // Find the desired solution and calculate the new y.
+            if (destination.x > location.x)
+            {
+                if (new_x_1 > location.x) { move_right(min((float)1, (float)(new_x_1 - location.x) / speed_x)); new_y = slope * new_x_1 + n; }
+                else { move_right(min((float)1, (float)(new_x_2 - location.x) / speed_x)); new_y = slope * new_x_2 + n; }
+            }
+            else
+            {
+                if (new_x_1 < location.x) { move_left(min((float)1, (float)(new_x_1 - location.x) / speed_x)); new_y = slope * new_x_1 + n; }
+                else { move_left(min((float)1, (float)(location.x - new_x_2) / speed_x)); new_y = slope * new_x_2 + n; }
+            }
+
+            // Check if need to move up or down.
+            if (destination.y < location.y) { move_up(min((float)1, (float)(location.y - new_y) / speed_x)); }
+            else { move_down(min((float)1, (float)(new_y - location.y) / speed_x)); }
+        }
+        
+        // The function causes the fish a jelly fish stunt.
+        void jelly_fish_stunt(float stunt_power) override
+        {
+            // Sting proof.
+            if (is_sting_proof) { return; }
+            
+            // Currently in a stunt, can't be stunt again.
+            if (current_stunt_frames_left > 0) { return; }
+            
+            // Play sting sound.
+            play_sound(sound_sting);
+            
+            // Stunt.
+            current_stunt_frames_left = (int) floor(stunt_power * fps);
+            
+            // Calculate how much scale decreases each frame.
+            stunt_size_decrease_per_frame = max((float) 1, ((required_scale - scale) / 8) * stunt_power) / current_stunt_frames_left;            
+            
+            // Save the current speed and stunt.
+            original_speed_x = speed_x;
+            original_speed_y = speed_y;
+            speed_x = 0;
+            speed_y = 0;
+        }
+        
+        // The function saves the state of my fish (see WorldState).
+        void save_state(my_fish_state* state)
+        {
+            Fish::save_state(&state -> fish);
+            state -> turbo_duration_frames_left = turbo_duration_frames_left;
+            state -> turbo_reload_frames_left = turbo_reload_frames_left;
+        }
+        
+        // The function restores a saved state of my fish.
+        void load_state(const my_fish_state* state)
+        {
+            Fish::load_state(&state -> fish);
+            turbo_duration_frames_left = state -> turbo_duration_frames_left;
+            turbo_reload_frames_left = state -> turbo_reload_frames_left;
+        }
+        
+        // Returns true if my fish has reached its required scale.
+        bool is_victory() { return scale >= required_scale; }
+        
+        // Returns the scale which wins.
+        float get_required_scale() { return required_scale; }
+        
+        // Returns False if my fish got eaten and the game is over.
+        bool is_alive() { return !is_eaten; }
+        
+        // Draws the scale widget, with the scale of the drawn snapshot (main thread, the required scale never changes).
+        void draw_scale_widget(float drawn_scale)
+        {
+            // Draw the scale title.
+            DrawText("Scale", scale_widget_location.x - 75, scale_widget_location.y, 25, BLACK);
+            
+            // Draw the stroke rectangle.
+            DrawRectangle(scale_widget_location.x - scale_widget_stroke, scale_widget_location.y - scale_widget_stroke, scale_widget_size.width + 2 * scale_widget_stroke, scale_widget_size.height + 2 * scale_widget_stroke, BLACK);
+            
+            // Draw the container rectangle.
+            DrawRectangle(scale_widget_location.x, scale_widget_location.y, scale_widget_size.width, scale_widget_size.height, WHITE);
+            
+            // Draw the fill rectangle.
+            DrawRectangle(scale_widget_location.x, scale_widget_location.y, scale_widget_size.width * (drawn_scale / required_scale), scale_widget_size.height, RED);
+        }
+        
+        // If available, applies the turbo.
+        void apply_turbo()
+        {
+            if (turbo_reload_frames_left == 0) 
+            {
+                turbo_reload_frames_left = turbo_reload_frames;
+                turbo_duration_frames_left = turbo_duration_frames;
+                speed_x *= turbo;
+                speed_y *= turbo;
+            }
+        }
+        
+        // Sets another frame of turbo.
+        void update_turbo()
+        {
+            if (turbo_reload_frames_left > 0) { turbo_reload_frames_left--; }
+            if (turbo_duration_frames_left == 1) { speed_x /= turbo; speed_y /= turbo; }
+            if (turbo_duration_frames_left > 0) { turbo_duration_frames_left--; }
+        }
+        
+        void draw_turbo_widget()
+        {
+            /*
+            // Draw the turbo title.
+            DrawText("Turbo", turbo_widget_location.x - 75, turbo_widget_location.y, 25, BLACK);
+            
+            // Draw the turbo rectangle.
+            DrawRectangle(turbo_widget_location.x - turbo_widget_stroke, turbo_widget_location.y - turbo_widget_stroke, turbo_widget_size.width + 2 * turbo_widget_stroke, turbo_widget_size.height + 2 * turbo_widget_stroke, BLACK);
+            
+            // Draw the container rectangle.
+            DrawRectangle(turbo_widget_location.x, turbo_widget_location.y, turbo_widget_size.width, turbo_widget_size.height, WHITE);
+            
+            // Draw the fill rectangle.
+            DrawRectangle(turbo_widget_location.x, turbo_widget_location.y, (int) (turbo_widget_size.width * ((float)(turbo_reload_frames - turbo_reload_frames_left) / turbo_reload_frames)), turbo_widget_size.height, RED);
+            */
+        }
+};
+
+
+class WanderFish final : public Fish
+{
+    /*
+        Represents a simple fish wandering in the world.
+        
+        Notes:
+            - Nothing derives from it, so a fish can be deleted as a WanderFish (see FishNetwork::free_fish(), the game keeps the fish which left).
+    */
+    
+    private:
+
+        // The range of steps (frames) for a new generated path.
+        int min_path_frames, max_path_frames;
+
+        // The index on the next path in paths stack.
+        int paths_stack_index;
+        
+        // The current path of the fish.
+        fish_path current_path;
+        
+        // Indicating the orginal frames amount the current path had, necessary for later reset (relevant only with paths_stack, repeat on).
+        int current_path_original_frames_amount;
+        
+        // The paths stack of the current wandering fish.
+        paths_stack my_paths_stack;
+        
+        // The range of speeds in both axes.
+        int min_speed_x;
+        int max_speed_x;
+        int min_speed_y;
+        int max_speed_y;
+        
+        // The fish initial location cannot be within this frame.
+        Rectangle exclude_setup_location_frame;
+        
+        // Draws the random numbers of the fish (the generator of its fish network).
+        Random* random;
+        
+        // The profile of the fish in its fish network, and the paths stack of the profile (see FishNetwork::load_fish()).
+        int profile_index;
+        int profile_paths_stack_index;
+   
+    public:
+        
+        // Constructor.
+        // new_paths_count_in_paths_stack should state the number of stacks which are saved in the received paths_stack.
+        // The location is relevant if there is no paths_stack or is_initial_location is false;
+        WanderFish(int new_fps, Image new_wander_fish_image, int* new_frames_amount, frame new_collision_frame, string new_fish_type, bool new_is_sting_proof, Location new_location, bool is_initial_left_location, bool is_randomize_x_coord, Size new_size, float new_min_speed_x, float new_max_speed_x, float new_min_speed_y, float new_max_speed_y, int new_min_path_frames, int new_max_path_frames, paths_stack new_paths_stack, int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, float new_scale, float new_max_scale, bool is_randomize_initial_scale, float new_eat_grow_ratio, float new_can_eat_ratio, float new_cant_eat_ratio, float new_rotation, bool new_is_facing_left_on_startup, int new_x_offset, int new_max_cells_within, Cell** new_cells_within, sound_variant new_sound_eat, sound_variant new_sound_sting, SfxMixer* new_sfx_mixer, Rectangle new_exclude_setup_location_frame, Random* new_random) : Fish(new_fps, new_wander_fish_image, new_frames_amount, new_collision_frame, new_fish_type, new_is_sting_proof, new_location, new_size, 0, 0, new_left_boundary, new_right_boundary, new_top_boundary, new_bottom_boundary, new_scale, new_max_scale, new_eat_grow_ratio, new_can_eat_ratio, new_cant_eat_ratio, new_rotation, new_is_facing_left_on_startup, new_max_cells_within, new_cells_within, new_sound_eat, new_sound_sting, new_sfx_mixer)
+        {
+            // Set the range of speeds on both axes.
+            min_speed_x = new_min_speed_x;
+            max_speed_x = new_max_speed_x;
+            min_speed_y = new_min_speed_y;
+            max_speed_y = new_max_speed_y;
+            
+            // Set the range of a new path frames.
+            min_path_frames = new_min_path_frames;
+            max_path_frames = new_max_path_frames;
+            
+            // Initial location cannot be within this frame.
+            exclude_setup_location_frame = new_exclude_setup_location_frame;
+            
+            // The random numbers generator, and no profile yet.
+            random = new_random;
+            profile_index = -1;
+            profile_paths_stack_index = -1;
+            
+            // If true, randomizing the initial scale.
+            if (is_randomize_initial_scale) { scale = max(1, random -> next() % (int) floor(max_scale * 1000 - 1000) / 1000 + 1);  }
+            
+            // Set the paths stack, and save the number of elements in it.
+            my_paths_stack = new_paths_stack;
+            paths_stack_index = 0;
+            
+            // If there are paths in stack path, pull out the first one to be the current path.
+            if (my_paths_stack.length > 0) 
+            {
+                // If initial location is relevant.
+                if (my_paths_stack.is_initial_location) { location.set_location(my_paths_stack.initial_location); }
+                
+                // If initial y coordinate is set.
+                else if (my_paths_stack.is_initial_y_coordinate) { set_random_initial_location(is_initial_left_location, my_paths_stack.is_randomize_x_coordinate || is_randomize_x_coord, new_x_offset, true, my_paths_stack.initial_y_coordinate, exclude_setup_location_frame); }
+                
+                // Otherwise, totally randomize the initial location.
+                else { set_random_initial_location(is_initial_left_location, is_randomize_x_coord, new_x_offset, false, 0, exclude_setup_location_frame); }
+                
+                // Set the first path as the current path.
+                current_path = my_paths_stack.paths[0];
+                
+                // Remember the original amount of frames.
+                current_path_original_frames_amount = current_path.current_frames_left;
+            }
+            
+            // Otherwise, generate new path and assign it.
+            else 
+            {
+                current_path = generate_new_path();
+                
+                set_random_initial_location(is_initial_left_location, is_randomize_x_coord, new_x_offset, false, 0, exclude_setup_location_frame);
+            }
+            
+            // Update the properties of the wander fish to match the properties of the current path.
+            match_path_in_fish();
+        }
+        
+        // Default Constructor.
+        WanderFish() : Fish()
+        {
+            min_path_frames = 100;
+            max_path_frames = 1000;
+            paths_stack_index = 0;
+            current_path_original_frames_amount = 1;
+            min_speed_x = 1;
+            max_speed_x = 10;
+            min_speed_y = 1;
+            max_speed_y = 1;
+            random = NULL;
+            profile_index = -1;
+            profile_paths_stack_index = -1;
+        }
+        
+        // The function sets a random initial_location.
+        void set_random_initial_location(bool is_initial_left_location, bool is_randomize_x_coord, int x_coord_offset, bool is_initial_y_coordinate, int initial_y_coordinate, Rectangle exclude_frame)
+        {
+            // The final coordinates.
+            int y_coordinates = 0;
+            int x_coordinates = 0;
+            Vector2 position = {0, 0};
+            
+            // The current frame rectangle with the current position.
+            Rectangle current_frame;
+            
+            // Make sure not in the exclude frame.
+            do
+            {
+                // Set the received y coordinate.
+                if (is_initial_y_coordinate) { y_coordinates = initial_y_coordinate; }
+                
+                // Randomize the location of the y axis.
+                else
+                {
+                    if (bottom_boundary - top_boundary <= 0) { y_coordinates = top_boundary + size.height; }
+                    else { y_coordinates = random -> next() % (bottom_boundary - top_boundary) + top_boundary; }
+                }
+                
+                // If random x coord is required.
+                if (is_randomize_x_coord)
+                {               
+                    // Randomize the x coordination.
+                    if (right_boundary - left_boundary <= 0) { x_coordinates = left_boundary; }
+                    else { x_coordinates = random -> next() % (right_boundary - left_boundary) + left_boundary; }
+                }
+                
+                // Left or right x coordinate is required.
+                else
+                {
+                    // Randomize the x_coord_offset.
+                    x_coord_offset = random -> next() % (x_coord_offset);
+                    
+                    // The location should be at the left side of the world.
+                    if (is_initial_left_location) { x_coordinates = left_boundary + x_coord_offset; }
+                    
+                    // The location should be at the right side of the world.
+                    else { x_coordinates = right_boundary - x_coord_offset; }
+                }
+                
+                // The generated location.
+                position.x = x_coordinates;
+                position.y = y_coordinates;
+                
+                // The frame of the fish if it would be set with the current location.
+                current_frame = {position.x - ((sqrt(scale) * size.width) / 2), position.y - ((sqrt(scale) * size.height) / 2), sqrt(scale) * size.width, sqrt(scale) * size.height};
+            }
+            while (CheckCollisionRecs(current_frame, exclude_frame));
+
+            // Set the initial location.
+            location.set_location(Location(x_coordinates, y_coordinates));
+        }
+        
+        // The function generates the next move of the wandering fish.
+        void move()
+        {
+            // Check if there are more frames left in the current path.
+            if (current_path.current_frames_left > 0)
+            {               
+                // Move in the current path direction.
+                if (current_path.is_moving_right) { move_right(1); }
+                else { move_left(1); }
+                if (current_path.is_moving_top) { move_up(1); }
+                else { move_down(1); }
+                
+                // Decrease the amount of frames left by 1.
+                current_path.current_frames_left -= 1;
+            }
+            
+            // No frames left, need to load new path. Check if there are more paths in the paths stack.
+            else if (paths_stack_index < my_paths_stack.length - 1)
+            {
+                // First reset the current path for later use.
+                my_paths_stack.paths[paths_stack_index].current_frames_left = current_path_original_frames_amount;
+                
+                // Point on the next path.
+                paths_stack_index++;
+
+                // Load the next path.
+                current_path = my_paths_stack.paths[paths_stack_index];
+                match_path_in_fish();
+                
+                // Save its original frames amount for later reset.
+                current_path_original_frames_amount = current_path.current_frames_left;
+
+                // Make a move with the current path.
+                move();
+            }
+            
+            // No paths left in the paths stack.
+            else 
+            {
+                // Check if the paths stack is set to repeat.
+                if (my_paths_stack.is_repeat)
+                {                   
+                    // First reset the current path for later use.
+                    my_paths_stack.paths[paths_stack_index].current_frames_left = current_path_original_frames_amount;
+                    
+                    // Reset the paths stack index.
+                    paths_stack_index = 0;
+                    
+                    // Load the next path.
+                    current_path = my_paths_stack.paths[paths_stack_index];
+                    match_path_in_fish();
+
+                    // Save its original amount of frames for later reset.
+                    current_path_original_frames_amount = current_path.current_frames_left;
+                }
+                
+                // No repeat.
+                else
+                {                    
+                    // Generate new path.
+                    current_path = generate_new_path();
+                    match_path_in_fish();
+                }
+                
+                // We are set to apply the next move.
+                move(); 
+            }
+        }
+        
+        // The function generates new path and returns it.
+        fish_path generate_new_path()
+        {
+            // Create the new path.
+            fish_path new_path;
+            
+            // Generate the amount of frames of the new path;
+            if (max_path_frames - min_path_frames <= 0) { new_path.current_frames_left = min_path_frames; }
+            else { new_path.current_frames_left = random -> next() % (max_path_frames - min_path_frames) + min_path_frames; }
+            
+            // Generate the speed of the fish on each axis.
+            if (max_speed_x - min_speed_x <= 0) { new_path.speed_x = min_speed_x; }
+            else { new_path.speed_x = random -> next() % (int) floor(max_speed_x - min_speed_x) + min_speed_x; }
+            if (max_speed_y - min_speed_y <= 0) { new_path.speed_y = min_speed_y; }
+            else { new_path.speed_y = random -> next() % (int) floor(max_speed_y - min_speed_y) + min_speed_y; }
+            
+            // Define the direction of the new path.
+            new_path.is_moving_right = random -> next() % 2;
+            new_path.is_moving_top = random -> next() % 2;
+
+            return new_path;
+        }
+        
+        // The function match the properties of the current path to the properties of the wander fish.
+        void match_path_in_fish()
+        {
+            // Set the speed of the wander fish.
+            speed_x = current_path.speed_x;
+            speed_y = current_path.speed_y;
+        }
+        
+        // The function sets the profile the fish was created from (see FishNetwork::load_fish()).
+        void set_profile(int new_profile_index, int new_profile_paths_stack_index)
+        {
+            profile_index = new_profile_index;
+            profile_paths_stack_index = new_profile_paths_stack_index;
+        }
+        
+        // Returns true if the fish was created from the profile and paths stack (a saved state of them can be loaded to it).
+        bool is_profile(int other_profile_index, int other_profile_paths_stack_index) { return profile_index == other_profile_index && profile_paths_stack_index == other_profile_paths_stack_index; }
+        
+        // The function saves the state of the fish (see WorldState).
+        void save_state(wander_fish_state* state)
+        {
+            Fish::save_state(&state -> fish);
+            state -> profile_index = profile_index;
+            state -> profile_paths_stack_index = profile_paths_stack_index;
+            state -> paths_stack_index = paths_stack_index;
+            state -> current_path = current_path;
+            state -> current_path_original_frames_amount = current_path_original_frames_amount;
+        }
+        
+        // The function restores a saved state of the fish (created from the same profile and paths stack).
+        void load_state(const wander_fish_state* state)
+        {
+            Fish::load_state(&state -> fish);
+            paths_stack_index = (state -> paths_stack_index < my_paths_stack.length) ? state -> paths_stack_index : 0;
+            current_path = state -> current_path;
+            current_path_original_frames_amount = state -> current_path_original_frames_amount;
+        }
+};
+
+
+class FishNetwork
+{
+    /*
+        Manages the fish in the world.
+        
+        Notes:
+            - A backdrop network (the background of the menus, see set_backdrop()) doesn't keep its fish on the grid, nothing collides behind the menus.
+              It is moved once in step_ticks ticks, every move covers all these ticks (and the gifs skip to the frame of the last tick).
+    */
+    
+    private:
+        
+        // How many fps there are per second.
+        int fps;
+        
+        // The maximum fish population in the world.
+        int max_population;
+        
+        // The current population.
+        int current_population;
+        
+        // The population is filled up to this limit (the max population, unless lowered by the quality governor).
+        int population_limit;
+        
+        // The eat grow ratio in the world.
+        float eat_grow_ratio;
+        
+        // FishNetwork updates its grid with the relevant information.
+        Grid* grid;
+        
+        // An array of fish profiles must be loaded on startup.
+        fish_profile* fish_on_startup;
+        int fish_on_startup_length;
+        
+        // An array of fish profiles to load when available.
+        fish_profile* available_fish;
+        int available_fish_length;
+        
+        // The current fish in the fish network, as pointers.
+        WanderFish** fish;
+        int current_fish_amount;
+        
+        // The fish which the last load_states() replaced or removed, freed by the next one (the snapshot drawn meanwhile still refers to them).
+        WanderFish** released_fish;
+        int released_fish_amount;
+        
+        // This array is like a lot. On a given random number, each cell in the array states the range of numbers indicating on the matching available fish in the available_fish array.
+        // See the implemantation in the constructor for further explanation.
+        int* proportions_lot;
+        int lot_range;
+        
+        // The x coordinate offset of new fish initialization.
+        int x_coord_offset;
+        
+        // Frame in which fish cannot be initialized on set-up.
+        Rectangle exclude_setup_location_frame;
+        
+        // The sound effects mixer of the fish.
+        SfxMixer* sfx_mixer;
+        
+        // How many ticks a move covers, and if the fish are kept on the grid (see set_backdrop()).
+        int step_ticks;
+        bool is_grid_tracked;
+        
+        // Draws the random numbers of the network and of its fish (saved with the world, see WorldState).
+        Random random;
+        
+    public:
+    
+        // The time the moves spent refreshing the grid is added to it, set by the simulation while it measures its phases (NULL otherwise, in seconds).
+        static double* grid_refresh_time;
+
+        // Constructor.
+        FishNetwork(int new_fps, int new_max_population, float new_eat_grow_ratio, Grid* new_grid, fish_profile* new_fish_on_startup, int new_fish_on_startup_length, fish_profile* new_available_fish, int new_available_fish_length, int new_x_coord_offset, Rectangle new_exclude_setup_location_frame, SfxMixer* new_sfx_mixer)
+        {
+            // How many frames there are per second.
+            fps = new_fps;
+            
+            // The max population.
+            max_population = new_max_population;
+            population_limit = max_population;
+            
+            // Save the eat grow ratio in the world.
+            eat_grow_ratio = new_eat_grow_ratio;
+            
+            // Set the x coordination offset.
+            x_coord_offset = new_x_coord_offset;
+            
+            // The current population.
+            current_population = 0;
+            
+            // Save the grid on which the fish network is happening.
+            grid = new_grid;
+            
+            // The fish profiles to load on startup.
+            fish_on_startup = new_fish_on_startup;
+            fish_on_startup_length = new_fish_on_startup_length;
+            
+            // The available fish profiles to load lively.
+            available_fish = new_available_fish;
+            available_fish_length = new_available_fish_length;
+
+            // Create the fish array.
+            fish = new WanderFish*[max_population];
+            current_fish_amount = 0;
+            released_fish = new WanderFish*[max_population];
+            released_fish_amount = 0;
+            
+            // Create the proportions lot.
+            
+            // The lot range states the boundaries of the random generated number. Being calculated in the following loop.
+            lot_range = 0;
+            
+            // Initialize the proportions lot array.
+            proportions_lot = new int[available_fish_length];
+            
+            // Iterate over the available fish proportions.
+            for (int i = 0; i < available_fish_length; i++)
+            {
+                proportions_lot[i] = available_fish[i].proportion * 1000;
+                lot_range += proportions_lot[i];
+            }
+        
+            // Set the frame in which fish cannot be initialized on setup.
+            exclude_setup_location_frame = new_exclude_setup_location_frame;
+            
+            // The mixer which plays the sounds of the fish.
+            sfx_mixer = new_sfx_mixer;
+            
+            // Moved every tick, on the grid.
+            step_ticks = 1;
+            is_grid_tracked = true;
+            
+            // Seeded from rand(), as the fish were before they had a generator of their own.
+            random = Random((uint64_t) rand() + 1);
+        }
+        
+        // Default Constructor.
+        FishNetwork()
+        {
+            max_population = 1;
+            population_limit = 1;
+            current_population = 0;
+            fish_on_startup = 0;
+            available_fish_length = 0;
+            current_fish_amount = 0;
+            released_fish = NULL;
+            released_fish_amount = 0;
+            lot_range = 0;
+            sfx_mixer = NULL;
+            step_ticks = 1;
+            is_grid_tracked = true;
+        }
+        
+        // The function makes the network a backdrop, moved once in new_step_ticks ticks and not kept on the grid (before setup()).
+        void set_backdrop(int new_step_ticks)
+        {
+            step_ticks = max(1, new_step_ticks);
+            is_grid_tracked = false;
+        }
+        
+        // Reset the current fish network.
+        void reset()
+        {
+            current_population = 0;
+            current_fish_amount = 0;
+        }
+        
+        // The function creates and loads all the fish on startup.
+        void setup()
+        {           
+            // Load all the fish on startup.
+            for (int i = 0; i < fish_on_startup_length; i++)
+                load_fish_profile(i, true);
+            
+            // Add fish to the fish network, to fill the max fish population.
+            load_available_fish(true);
+        }
+        
+        // The function loads available fish up to the max fish population.
+        void load_available_fish(bool is_on_setup)
+        {
+            // Keep loading fish up to the population limit.
+            while (current_fish_amount < population_limit)
+            {               
+                // lot the next available fish.
+                int random_lot = random.next() % lot_range;
+                
+                // Current lots sum.
+                int lots_sum = 0;
+                
+                // Spot the lotted fish, and load it.
+                for (int i = 0; i < available_fish_length; i++)
+                {
+                    lots_sum += proportions_lot[i];
+                    
+                    // That's the fish to load.
+                    if (random_lot < lots_sum)
+                    {
+                        // Load the lotted fish.
+                        load_fish_profile(fish_on_startup_length + i, is_on_setup);
+                        break;
+                    }
+                }
+            }
+        }
+        
+        // The function updates the boundaries of all the fish.
+        void update_boundaries(int left, int right, int top, int bottom, bool is_consider_size)
+        {
+            // Iterate over the current fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                // Update the boundaries of the current fish (taking the scaling into considerations)
+                fish[i] -> update_boundaries(left, right, top, bottom - (int) ceil(sqrt(fish[i] -> get_scale()) * fish[i] -> get_size().height), is_consider_size);
+            }
+        }
+        
+        // The function deletes all the eaten fish.
+        void handle_eaten()
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                // If the current fish is eaten.
+                if (fish[i] -> get_is_eaten())
+                {
+                    // delete it from the network, and its texture.
+                    fish[i] -> retire_gif();
+                    delete_fish(fish[i]);
+                    
+                    // The last fish replaced the current fish and current_fish_amount decreased by 1. We want to check the last fish as well.
+                    i = max(0, i - 1);
+                }
+            }
+        }
+        
+        // Move all the fish in the network to their next step.
+        void move()
+        {           
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                // Move the fish and save the feedback (a move of a backdrop covers its step ticks).
+                fish[i] -> move();
+                for (int step = 1; step < step_ticks && !fish[i] -> get_is_fish_out_of_bounds(); step++) { fish[i] -> move(); }
+
+                // Check if the fish is out of bounds.
+                if (fish[i] -> get_is_fish_out_of_bounds())
+                {
+                    // That's the end of the fish.
+                    delete_fish(fish[i]);
+                    
+                    // The last fish replaced the current fish and current_fish_amount decreased by 1. We want to check the last fish as well.
+                    i = max(0, i - 1);
+                }
+                
+                else if (is_grid_tracked)
+                {
+                    // Refresh the entity on the grid.
+                    if (grid_refresh_time == NULL) { grid -> refresh_entity(fish[i]); }
+                    else
+                    {
+                        double refresh_start_time = monotonic_time();
+                        grid -> refresh_entity(fish[i]);
+                        *grid_refresh_time += monotonic_time() - refresh_start_time;
+                    }
+                }
+            }
+        }
+        
+        // Returns how many ticks a move covers.
+        int get_step_ticks() { return step_ticks; }
+        
+        // The function sets the part of the max population which is kept, the fish above it are not replaced when they leave.
+        void set_population_ratio(float ratio) { population_limit = max(1, min(max_population, (int) ceil(max_population * ratio))); }
+        
+        // Prepare the gifs of all the fish to their next frame. The fish out of the view move to their next frame once in offscreen_frame_interval ticks (spread over the ticks).
+        void set_next_frame(Rectangle view, int offscreen_frame_interval, long tick)
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                if (offscreen_frame_interval > 1 && (tick + i) % offscreen_frame_interval != 0 && !CheckCollisionRecs(view, fish[i] -> get_updated_rectangular_frame())) { continue; }
+                
+                for (int step = 0; step < step_ticks; step++) { fish[i] -> set_next_frame(); }
+            }
+        }
+        
+        // Save the locations of all the fish before a tick moves them.
+        void save_previous_locations()
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                fish[i] -> save_previous_location();
+            }
+        }
+        
+        // The fish jumped (a new screen), they shouldn't be drawn moving.
+        void forget_previous_locations()
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                fish[i] -> forget_previous_location();
+            }
+        }
+        
+        // Save how to draw all the fish, returns how many snapshots were taken (up to max_snapshots).
+        int take_snapshots(gif_snapshot* snapshots, int max_snapshots)
+        {
+            int snapshots_amount = min(current_fish_amount, max_snapshots);
+            
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < snapshots_amount; i++)
+            {
+                fish[i] -> take_snapshot(&snapshots[i]);
+            }
+            
+            return snapshots_amount;
+        }
+        
+        // The fish is gone, remove it from the network.
+        void delete_fish(WanderFish* fish_to_remove)
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                // Check if this is the current fish.
+                if (fish_to_remove == fish[i])
+                {
+                    // Replace the last fish to the current cell.
+                    fish[i] = fish[current_fish_amount - 1];
+                    
+                    // Free the cell of the last fish, which was replaced.
+                    current_fish_amount--;
+                    
+                    // That's it.
+                    break;
+                }
+            }
+            
+            // Remove the fish from the grid.
+            if (is_grid_tracked) { grid -> remove_entity(fish_to_remove); }
+        }
+        
+        void delete_network()
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                fish[i] -> delete_gif();
+            }
+        }
+        
+        // The function loads a fish of the profile (the fish on startup, then the available fish) with one of its paths stacks.
+        void load_fish_profile(int profile_index, bool is_on_setup)
+        {
+            // Randomize a path stack from the paths_stack array of the fish profile.
+            load_fish(profile_index, random.next() % get_profile(profile_index) -> paths_stacks_amount, is_on_setup);
+        }
+        
+        // The function loads a fish of the profile with the received paths stack of the profile.
+        WanderFish* load_fish(int profile_index, int paths_stack_index, bool is_on_setup)
+        {
+            WanderFish* fish_to_load = create_fish(profile_index, paths_stack_index, is_on_setup);
+
+            // Save the fish in the fish array.
+            fish[current_fish_amount] = fish_to_load;
+            current_fish_amount++;
+            
+            // Add the fish to the grid.
+            if (is_grid_tracked) { grid -> add_entity(fish_to_load); }
+            
+            return fish_to_load;
+        }
+        
+        // The function creates a fish of the profile with the received paths stack of the profile (not in the network yet).
+        WanderFish* create_fish(int profile_index, int paths_stack_index, bool is_on_setup)
+        {
+            fish_profile current_fish_profile = *get_profile(profile_index);
+            
+            // The cells within array of the new fish.
+            Cell** cells_within = new Cell*[grid -> get_rows_amount() * grid -> get_columns_amount()];
+            
+            // Create the fish.
+            WanderFish* fish_to_load = new WanderFish(fps, *current_fish_profile.fish_image, current_fish_profile.fish_image_frames_amount, current_fish_profile.collision_frame, current_fish_profile.fish_type, current_fish_profile.is_sting_proof, current_fish_profile.paths_stacks[paths_stack_index].initial_location, current_fish_profile.paths_stacks[paths_stack_index].is_left, is_on_setup, current_fish_profile.size, current_fish_profile.min_speed_x, current_fish_profile.max_speed_x, current_fish_profile.min_speed_y, current_fish_profile.max_speed_y, current_fish_profile.min_frames_per_path, current_fish_profile.max_frames_per_path, current_fish_profile.paths_stacks[paths_stack_index], - x_coord_offset, grid -> get_width_pixels() + x_coord_offset, 0 + current_fish_profile.size.height, grid -> get_height_pixels() - current_fish_profile.size.height, 1, current_fish_profile.max_scaling, current_fish_profile.is_randomize_initial_scale, eat_grow_ratio, current_fish_profile.can_eat_ratio, current_fish_profile.cant_eat_ratio, 0, current_fish_profile.is_facing_left_on_startup, x_coord_offset, grid -> get_rows_amount() * grid -> get_columns_amount(), cells_within, current_fish_profile.sound_eat, current_fish_profile.sound_sting, sfx_mixer, exclude_setup_location_frame, &random);
+            fish_to_load -> set_profile(profile_index, paths_stack_index);
+            
+            return fish_to_load;
+        }
+        
+        // Returns the profile of the received index (the fish on startup, then the available fish).
+        fish_profile* get_profile(int profile_index)
+        {
+            if (profile_index < fish_on_startup_length) { return &fish_on_startup[profile_index]; }
+            
+            return &available_fish[profile_index - fish_on_startup_length];
+        }
+        
+        // The function saves the states of the fish, returns how many were saved (up to max_states, see WorldState).
+        int save_states(wander_fish_state* states, int max_states)
+        {
+            int states_amount = min(current_fish_amount, max_states);
+            
+            for (int i = 0; i < states_amount; i++) { fish[i] -> save_state(&states[i]); }
+            
+            return states_amount;
+        }
+        
+        // The function replaces the fish with the saved ones, without spawning. A fish of the same profile and paths stack is kept (with its texture)
+        // and put in the saved state, the others are retired and created from their profiles. Returns false if a state doesn't belong to the profiles
+        // of this network (nothing is changed).
+        // The retired fish are freed by the next call (main thread, while the simulation is idle), by then the drawn snapshot and the retired gifs
+        // don't refer to them anymore.
+        bool load_states(const wander_fish_state* states, int states_amount)
+        {
+            int profiles_amount = fish_on_startup_length + available_fish_length;
+            
+            for (int i = 0; i < states_amount; i++)
+            {
+                if (states[i].profile_index < 0 || states[i].profile_index >= profiles_amount) { return false; }
+                if (states[i].profile_paths_stack_index < 0 || states[i].profile_paths_stack_index >= get_profile(states[i].profile_index) -> paths_stacks_amount) { return false; }
+            }
+            
+            states_amount = min(states_amount, max_population);
+            
+            // The fish released by the previous call.
+            for (int i = 0; i < released_fish_amount; i++) { free_fish(released_fish[i]); }
+            released_fish_amount = 0;
+            
+            // The fish beyond the saved ones are removed.
+            while (current_fish_amount > states_amount)
+            {
+                current_fish_amount--;
+                fish[current_fish_amount] -> retire_gif();
+                if (is_grid_tracked) { grid -> remove_entity(fish[current_fish_amount]); }
+                
+                released_fish[released_fish_amount] = fish[current_fish_amount];
+                released_fish_amount++;
+            }
+            
+            for (int i = 0; i < states_amount; i++)
+            {
+                if (i == current_fish_amount) { load_fish(states[i].profile_index, states[i].profile_paths_stack_index, false); }
+                
+                // Another fish is in its place, replace it.
+                else if (!fish[i] -> is_profile(states[i].profile_index, states[i].profile_paths_stack_index))
+                {
+                    fish[i] -> retire_gif();
+                    if (is_grid_tracked) { grid -> remove_entity(fish[i]); }
+                    
+                    released_fish[released_fish_amount] = fish[i];
+                    released_fish_amount++;
+                    
+                    fish[i] = create_fish(states[i].profile_index, states[i].profile_paths_stack_index, false);
+                    if (is_grid_tracked) { grid -> add_entity(fish[i]); }
+                }
+                
+                fish[i] -> load_state(&states[i]);
+                
+                if (is_grid_tracked) { grid -> refresh_entity(fish[i]); }
+            }
+            
+            return true;
+        }
+        
+        // The function frees a fish which left the network, and its cells (nothing may refer to it anymore).
+        static void free_fish(WanderFish* left_fish)
+        {
+            delete[] left_fish -> get_cells_within();
+            delete left_fish;
+        }
+        
+        // Getters.
+        int get_fish_amount() { return current_fish_amount; }
+        WanderFish* get_fish(int index) { return fish[index]; }
+        
+        // Getters and setters of the state of the random numbers generator.
+        uint64_t get_random_state() { return random.get_state(); }
+        void set_random_state(uint64_t state) { random.set_state(state); }
+        
+        // For Debugging.
+        void print_frames()
+        {
+            // Iterate over all the fish in the network.
+            for (int i = 0; i < current_fish_amount; i++)
+            {
+                Rectangle frame = fish[i] -> get_updated_collision_frame();
+                DrawRectangle(frame.x,frame.y, frame.width, frame.height, RED);
+            }
+        }
+};
+
+double* FishNetwork::grid_refresh_time = NULL;
+
+class GameWorld
+{
+    /*
+        An instance of a world: its fish network, its grid, its camera, its background and my fish. The game switches between the instances by pointer.
+        
+        Notes:
+            - Every instance has objects of its own, nothing is shared between the instances.
+            - The fish are created on the first resume(). Later resumes continue from where the world was suspended, so switching takes the same time with any population.
+            - suspend() keeps the whole state, and only unloads the textures of the gifs (they are uploaded again when drawn).
+            - restart() starts the world over, its fish are created again on the next resume().
+            - A world without my fish is a backdrop (the background of the menus).
+    */
+    
+    private:
+    
+        // The number of the world (0 for a backdrop).
+        int number;
+        
+        // The background and the welcome window (NULL for a backdrop), loaded with the world bundle.
+        Texture2D* texture;
+        Texture2D* welcome_window;
+        
+        // The world objects (my fish is NULL for a backdrop).
+        MyFish* my_fish;
+        FishNetwork* fish_network;
+        Grid* grid;
+        
+        // The camera, and where it starts.
+        Camera2D camera;
+        Camera2D start_camera;
+        
+        // True once the fish were created, and while the world is not played.
+        bool is_setup;
+        bool is_suspended;
+    
+    public:
+    
+        // Constructor.
+        GameWorld(int new_number, Texture2D* new_texture, Texture2D* new_welcome_window, MyFish* new_my_fish, FishNetwork* new_fish_network, Grid* new_grid, Camera2D new_camera)
+        {
+            number = new_number;
+            texture = new_texture;
+            welcome_window = new_welcome_window;
+            my_fish = new_my_fish;
+            fish_network = new_fish_network;
+            grid = new_grid;
+            camera = new_camera;
+            start_camera = new_camera;
+            
+            is_setup = false;
+            is_suspended = true;
+        }
+        
+        // The function makes the world the played one, the fish are created the first time.
+        void resume()
+        {
+            if (!is_setup)
+            {
+                if (my_fish != NULL) { grid -> refresh_entity(my_fish); }
+                fish_network -> setup();
+                is_setup = true;
+            }
+            
+            is_suspended = false;
+        }
+        
+        // The function freezes the world as it is, and unloads the textures of its gifs (main thread, while the simulation is idle).
+        void suspend()
+        {
+            if (my_fish != NULL) { my_fish -> delete_gif(); }
+            fish_network -> delete_network();
+            
+            is_suspended = true;
+        }
+        
+        // The function makes the world the played one after it was restored (see WorldState), the fish are not created again.
+        void resume_restored()
+        {
+            is_setup = true;
+            is_suspended = false;
+        }
+        
+        // The function suspends the world and starts it over, as it was before the first resume().
+        void restart()
+        {
+            suspend();
+            
+            if (my_fish != NULL) { my_fish -> reset(); }
+            fish_network -> reset();
+            grid -> reset();
+            camera = start_camera;
+            
+            is_setup = false;
+        }
+        
+        // Getters.
+        int get_number() { return number; }
+        Texture2D* get_texture() { return texture; }
+        Texture2D* get_welcome_window() { return welcome_window; }
+        MyFish* get_my_fish() { return my_fish; }
+        FishNetwork* get_fish_network() { return fish_network; }
+        Grid* get_grid() { return grid; }
+        Camera2D* get_camera() { return &camera; }
+        bool get_is_suspended() { return is_suspended; }
+};
+
+
+// ----- Technical Classes -----
+
+class AtomicFileWriter
+{
+    /*
+        Replaces a file atomically: the new content goes to a temporary file which is renamed over the file, a crash in the middle of a write
+        leaves the previous file as it was. The latest content can be handed to a writer thread of its own, so a frame never waits for the disk.
+        
+        Notes:
+            - A durable write flushes the temporary file to the disk (fsync) before the rename, and the directory after it, so the new file survives
+              a power loss. The caches (the packs, which are checked when they are read) skip the flushes.
+            - The static functions write on the calling thread: open_temporary() and commit() for a file which is written in parts, write() for a
+              buffer.
+            - The writer thread writes only the latest content, a content which is handed over during a write is written right after it. On quit()
+              what is still pending is written.
+    */
+    
+    private:
+        
+        // The written file, and the name of its owner for the logs.
+        string file_path;
+        const char* name;
+        
+        // The content which is waiting for the writer, and the one it writes (double buffered, a size of 0 removes the file).
+        size_t max_size;
+        unsigned char* pending_data;
+        size_t pending_size;
+        bool is_pending;
+        unsigned char* written_data;
+        
+        // Measurements, the time in seconds.
+        long writes_amount;
+        long failed_writes_amount;
+        double last_write_time;
+        
+        // The writer thread.
+        pthread_t writer_thread;
+        bool is_quit;
+        pthread_mutex_t mutex;
+        pthread_cond_t write_requested;
+    
+    public:
+        
+        // Constructor, starts the writer thread of a file whose content is at most max_size bytes.
+        AtomicFileWriter(string new_file_path, size_t new_max_size, const char* new_name)
+        {
+            file_path = new_file_path;
+            name = new_name;
+            
+            max_size = new_max_size;
+            pending_data = new unsigned char[max_size];
+            pending_size = 0;
+            is_pending = false;
+            written_data = new unsigned char[max_size];
+            
+            writes_amount = 0;
+            failed_writes_amount = 0;
+            last_write_time = 0;
+            
+            is_quit = false;
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&write_requested, NULL);
+            
+            if (pthread_create(&writer_thread, NULL, &write_thread, (void *)this) != 0) { TraceLog(LOG_ERROR, "%s: error creating the writer thread", name); }
+        }
+        
+        // The function hands the content to the writer thread (replaces a content which wasn't written yet).
+        void write_async(const void* data, size_t size)
+        {
+            pthread_mutex_lock(&mutex);
+            memcpy(pending_data, data, min(size, max_size));
+            pending_size = min(size, max_size);
+            is_pending = true;
+            pthread_cond_signal(&write_requested);
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // The function removes the file in the background.
+        void remove_async()
+        {
+            pthread_mutex_lock(&mutex);
+            pending_size = 0;
+            is_pending = true;
+            pthread_cond_signal(&write_requested);
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // The function writes what is still pending, and stops the writer thread.
+        void quit()
+        {
+            pthread_mutex_lock(&mutex);
+            is_quit = true;
+            pthread_cond_signal(&write_requested);
+            pthread_mutex_unlock(&mutex);
+            
+            pthread_join(writer_thread, NULL);
+        }
+        
+        // Getters (after quit(), or for the stats).
+        long get_writes_amount() { return writes_amount; }
+        long get_failed_writes_amount() { return failed_writes_amount; }
+        double get_last_write_time() { return last_write_time; }
+        
+        // The function opens the temporary file of a file (NULL if it can't be written).
+        static FILE* open_temporary(string path)
+        {
+            string temporary_path = path + ".tmp";
+            FILE* temporary_file = fopen(temporary_path.c_str(), "wb");
+            if (temporary_file == NULL) { TraceLog(LOG_WARNING, "Could not write %s", temporary_path.c_str()); }
+            
+            return temporary_file;
+        }
+        
+        // The function closes the temporary file of a file and renames it over the file, if it was written whole (is_written). Returns false if the
+        // file was not replaced (the temporary file is removed).
+        static bool commit(FILE* temporary_file, string path, bool is_written, bool is_durable)
+        {
+            string temporary_path = path + ".tmp";
+            
+            is_written = is_written && ferror(temporary_file) == 0 && fflush(temporary_file) == 0;
+            
+            #if !defined(_WIN32)
+                if (is_durable) { is_written = is_written && fsync(fileno(temporary_file)) == 0; }
+            #endif
+            
+            is_written = (fclose(temporary_file) == 0) && is_written;
+            
+            if (!is_written) { remove(temporary_path.c_str()); TraceLog(LOG_WARNING, "Could not write %s", temporary_path.c_str()); return false; }
+            
+            #if defined(_WIN32)
+                remove(path.c_str());
+            #endif
+            
+            if (rename(temporary_path.c_str(), path.c_str()) != 0) { TraceLog(LOG_WARNING, "Could not replace %s", path.c_str()); return false; }
+            
+            // Flush the rename too.
+            #if !defined(_WIN32)
+                if (is_durable)
+                {
+                    size_t separator_index = path.find_last_of('/');
+                    string directory_path = (separator_index == string::npos) ? "." : path.substr(0, max((size_t) 1, separator_index));
+                    int directory = open(directory_path.c_str(), O_RDONLY);
+                    if (directory >= 0) { fsync(directory); close(directory); }
+                }
+            #endif
+            
+            return true;
+        }
+        
+        // The function replaces a file with a buffer, returns false if it was not replaced.
+        static bool write(string path, const void* data, size_t size, bool is_durable)
+        {
+            FILE* temporary_file = open_temporary(path);
+            if (temporary_file == NULL) { return false; }
+            
+            return commit(temporary_file, path, fwrite(data, 1, size, temporary_file) == size, is_durable);
+        }
+    
+    private:
+        
+        // The writer thread, writes the pending content whenever there is one (and what is pending on quit).
+        static void* write_thread(void* argument)
+        {
+            AtomicFileWriter* writer = (AtomicFileWriter*) argument;
+            
+            while (true)
+            {
+                pthread_mutex_lock(&writer -> mutex);
+                
+                while (!writer -> is_pending && !writer -> is_quit) { pthread_cond_wait(&writer -> write_requested, &writer -> mutex); }
+                
+                if (!writer -> is_pending) { pthread_mutex_unlock(&writer -> mutex); break; }
+                
+                // Take the pending content, the next one can be handed over meanwhile.
+                unsigned char* data = writer -> pending_data;
+                writer -> pending_data = writer -> written_data;
+                writer -> written_data = data;
+                size_t size = writer -> pending_size;
+                writer -> is_pending = false;
+                
+                pthread_mutex_unlock(&writer -> mutex);
+                
+                if (size == 0) { remove(writer -> file_path.c_str()); continue; }
+                
+                double write_start_time = monotonic_time();
+                
+                if (write(writer -> file_path, data, size, true)) { writer -> writes_amount++; }
+                else { writer -> failed_writes_amount++; }
+                
+                writer -> last_write_time = monotonic_time() - write_start_time;
+            }
+            
+            return NULL;
+        }
+};
+
+
+class Save
+{
+    /*
+        Keeps the game progress in a binary save record (save_record). Attributes are public.
+        
+        Notes:
+            - The record is versioned and has a checksum, a broken or unknown record is ignored (the defaults are used).
+            - The record is written durably by a writer thread of its own (see AtomicFileWriter), so a frame never waits for the disk and a crash
+              in the middle of a write leaves the previous record as it was.
+            - The legacy text save (the "encrypted" save.txt) is read once, when there is no record yet, and migrated to a record.
+    */
+    public:
+        
+        // To what world the user has reached.
+        int world_checkpoint;
+    
+    private:
+        
+        // The path to the save record, and to the legacy text save.
+        string file_path;
+        string legacy_file_path;
+        
+        // Writes the record in the background.
+        AtomicFileWriter writer;
+    
+    public:
+    
+        // Constructor, reads the progress (and migrates the legacy save if there is no record yet).
+        Save(string new_file_path, string new_legacy_file_path) : writer(new_file_path, sizeof(save_record), "Save")
+        {
+            // Save the paths.
+            file_path = new_file_path;
+            legacy_file_path = new_legacy_file_path;
+            
+            // Default values.
+            world_checkpoint = 1;
+            
+            // Read the record.
+            save_record record;
+            if (read_record(&record)) { world_checkpoint = record.world_checkpoint; return; }
+            
+            // No record yet, migrate the legacy save (once, the record is found on the next launches).
+            if (read_legacy())
+            {
+                TraceLog(LOG_INFO, "Save: migrated %s (world checkpoint %d)", legacy_file_path.c_str(), world_checkpoint);
+                request_write();
+            }
+        }
+        
+        // The function updates the world checkpoint, the record is written in the background.
+        void update_world_checkpoint(int new_checkpoint)
+        {
+            // Update the value of world checkpoint.
+            world_checkpoint = new_checkpoint;
+            
+            request_write();
+        }
+        
+        // The function writes what is still pending, and stops the writer thread.
+        void quit()
+        {
+            writer.quit();
+            
+            if (writer.get_writes_amount() > 0 || writer.get_failed_writes_amount() > 0) { TraceLog(LOG_INFO, "Save: %ld records written, %ld writes failed", writer.get_writes_amount(), writer.get_failed_writes_amount()); }
+        }
+        
+        // The function recieves an encrypted line of the legacy save, decrypts it and returns the decrypted line.
+        static string decrypt(const string& to_decrypt)
+        {
+            // The decrypted string will be here at the end.
+            string decrypted;
+            decrypted.reserve(to_decrypt.length() / 4);
+            
+            // The current encrypted character, and its index.
+            long current = 0;
+            bool is_current = false;
+            int char_index = 0;
+            
+            // Iterate over the received string.
+            for (int index = 0; index < (int) to_decrypt.length(); index++)
+            {
+                // Is the current encrypted character fully read?
+                if (to_decrypt[index] == '_')
+                {
+                    // Decrypt the current char (get it's ascii value).
+                    if (is_current) { decrypted += char((current - 7) / (char_index + 4)); }
+                    
+                    current = 0;
+                    is_current = false;
+                    char_index++;
+                }
+                
+                // This is not a number, the received string was not encrypted according to the protocol.
+                else if (!isdigit((unsigned char) to_decrypt[index])) { return ""; }
+                
+                // Keep reading the current encrypted character.
+                else if (current < 100000000) { current = current * 10 + (to_decrypt[index] - '0'); is_current = true; }
+            }
+            
+            return decrypted;
+        }
+        
+        // The function returns the checksum of a record (FNV-1a, a save record is checked up to its checksum field).
+        static uint32_t checksum(const unsigned char* data, size_t length)
+        {
+            uint32_t hash = 2166136261u;
+            
+            for (size_t i = 0; i < length; i++)
+            {
+                hash ^= data[i];
+                hash *= 16777619u;
+            }
+            
+            return hash;
+        }
+    
+    private:
+    
+        // The layout version of the record.
+        static const uint32_t VERSION = 1;
+        
+        // The function reads the record, returns false if there is no valid record.
+        bool read_record(save_record* record)
+        {
+            FILE* record_file = fopen(file_path.c_str(), "rb");
+            if (record_file == NULL) { return false; }
+            
+            bool is_read = fread(record, sizeof(save_record), 1, record_file) == 1;
+            fclose(record_file);
+            
+            if (!is_read || memcmp(record -> magic, "FSAV", 4) != 0) { TraceLog(LOG_WARNING, "Save: %s is not a save record", file_path.c_str()); return false; }
+            if (record -> version != VERSION) { TraceLog(LOG_WARNING, "Save: %s has version %u", file_path.c_str(), record -> version); return false; }
+            if (record -> checksum != checksum((const unsigned char*) record, offsetof(save_record, checksum))) { TraceLog(LOG_WARNING, "Save: %s is broken (checksum)", file_path.c_str()); return false; }
+            
+            return true;
+        }
+        
+        // The function reads the progress from the legacy text save, returns false if there is nothing to migrate.
+        bool read_legacy()
+        {
+            ifstream legacy_file(legacy_file_path.c_str(), ios::in | ios::binary);
+            if (!legacy_file) { return false; }
+            
+            string world_checkpoint_prefix = "world checkpoint: ";
+            bool is_found = false;
+            
+            // The current line read from the file, do not read more than 100 lines from the file.
+            string current_line;
+            for (int count = 100; count > 0 && getline(legacy_file, current_line); count--)
+            {
+                // Decrypt the current line.
+                current_line = decrypt(current_line);
+                
+                // Read world checkpoint.
+                if (current_line.compare(0, world_checkpoint_prefix.length(), world_checkpoint_prefix) == 0 && current_line.length() >= world_checkpoint_prefix.length() + 2 && isdigit((unsigned char) current_line[world_checkpoint_prefix.length()]) && isdigit((unsigned char) current_line[world_checkpoint_prefix.length() + 1]))
+                {
+                    world_checkpoint = (current_line[world_checkpoint_prefix.length()] - '0') * 10 + (current_line[world_checkpoint_prefix.length() + 1] - '0');
+                    is_found = true;
+                }
+            }
+            
+            return is_found;
+        }
+        
+        // The function hands the current progress to the writer thread (replaces a progress which wasn't written yet).
+        void request_write()
+        {
+            save_record record;
+            memset(&record, 0, sizeof(save_record));
+            memcpy(record.magic, "FSAV", 4);
+            record.version = VERSION;
+            record.world_checkpoint = world_checkpoint;
+            record.checksum = checksum((const unsigned char*) &record, offsetof(save_record, checksum));
+            
+            writer.write_async(&record, sizeof(save_record));
+        }
+};
+
+
+class AssetPack
+{
+    /*
+        A single file of pre-decoded images, so the gifs and pngs are not decoded again on every launch.
+        
+        Notes:
+            - The pack is memory mapped. Uncompressed entries are handed out as images pointing straight into the mapping, and uploaded to the GPU from there.
+            - Every entry is keyed by the hash of its source file. A changed source file is simply decoded again, and the pack is rebuilt with it.
+            - Images returned from the mapping must never be unloaded, check is_mapped() before calling UnloadImage().
+    */
+    
+    private:
+    
+        // The path of the pack file.
+        string file_path;
+        
+        // If true, the pixels are compressed when the pack is rebuilt (smaller file, but can't be used straight from the mapping).
+        bool is_compress;
+        
+        // The pack file as it is mapped to the memory (NULL if there is no valid pack).
+        unsigned char* mapping;
+        size_t mapping_size;
+        
+        // The table of contents of the mapped pack (points into the mapping).
+        pack_entry* entries;
+        int entries_amount;
+        
+        // Mapped entries which were replaced by a newer decoded image, they are dropped when the pack is rebuilt.
+        bool* is_entry_replaced;
+        
+        // The mappings of the pack before it was rebuilt, the images which were found there still point into them.
+        unsigned char* old_mappings[8];
+        size_t old_mappings_sizes[8];
+        int old_mappings_amount;
+        
+        // The images which were decoded on this launch, and should be added to the pack.
+        int max_new_entries;
+        int new_entries_amount;
+        pack_entry* new_entries;
+        Image* new_images;
+        bool* is_free_new_image;
+        
+        // How many images were found in the pack, and how many had to be decoded.
+        int hits;
+        int misses;
+        
+        // The pack is accessed by the loading threads.
+        pthread_mutex_t mutex;
+    
+    public:
+    
+        // Constructor.
+        AssetPack(string new_file_path, int new_max_new_entries, bool new_is_compress)
+        {
+            // Save the pack properties.
+            file_path = new_file_path;
+            is_compress = new_is_compress;
+            
+            // Nothing is mapped yet.
+            mapping = NULL;
+            mapping_size = 0;
+            entries = NULL;
+            entries_amount = 0;
+            is_entry_replaced = NULL;
+            old_mappings_amount = 0;
+            
+            // Create the new entries arrays.
+            max_new_entries = new_max_new_entries;
+            new_entries_amount = 0;
+            new_entries = new pack_entry[max_new_entries];
+            new_images = new Image[max_new_entries];
+            is_free_new_image = new bool[max_new_entries];
+            
+            // Reset the counters.
+            hits = 0;
+            misses = 0;
+            
+            pthread_mutex_init(&mutex, NULL);
+            
+            // Map the current pack file, if there is one.
+            open_pack();
+        }
+        
+        // The function maps the pack file and validates its table of contents.
+        void open_pack()
+        {
+            #if defined(_WIN32)
+            
+                // No mmap, simply read the whole file.
+                unsigned int bytes_read = 0;
+                mapping = LoadFileData(file_path.c_str(), &bytes_read);
+                mapping_size = bytes_read;
+                
+            #else
+            
+                // Open the pack file.
+                int descriptor = open(file_path.c_str(), O_RDONLY);
+                if (descriptor < 0) { return; }
+                
+                // Get its size and map it.
+                struct stat file_stat;
+                if (fstat(descriptor, &file_stat) == 0 && file_stat.st_size > 0)
+                {
+                    void* file_mapping = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                    
+                    if (file_mapping != MAP_FAILED)
+                    {
+                        mapping = (unsigned char*) file_mapping;
+                        mapping_size = file_stat.st_size;
+                    }
+                }
+                
+                // The mapping stays valid after closing the file.
+                close(descriptor);
+                
+            #endif
+            
+            if (mapping == NULL) { return; }
+            
+            // Validate the header.
+            pack_header* header = (pack_header*) mapping;
+            if (mapping_size < sizeof(pack_header) || memcmp(header -> magic, "FPAK", 4) != 0 || header -> version != VERSION || header -> entries_amount > (mapping_size - sizeof(pack_header)) / sizeof(pack_entry)) { close_pack(); return; }
+            
+            // The table of contents follows the header.
+            entries = (pack_entry*) (mapping + sizeof(pack_header));
+            entries_amount = header -> entries_amount;
+            
+            // Validate that all the entries are within the file, and hold as many pixels as their images have.
+            for (int i = 0; i < entries_amount; i++)
+            {
+                if (!is_entry_valid(&entries[i], mapping_size)) { TraceLog(LOG_WARNING, "Asset pack: entry %d of %s is not valid, the pack is ignored", i, file_path.c_str()); close_pack(); return; }
+            }
+            
+            // No entry was replaced yet.
+            is_entry_replaced = new bool[entries_amount];
+            for (int i = 0; i < entries_amount; i++) { is_entry_replaced[i] = false; }
+        }
+        
+        // The function unmaps the pack file.
+        void close_pack()
+        {
+            // Unmap the pack before it was rebuilt too.
+            for (int i = 0; i < old_mappings_amount; i++) { unmap(old_mappings[i], old_mappings_sizes[i]); }
+            old_mappings_amount = 0;
+            
+            if (mapping == NULL) { return; }
+            
+            unmap(mapping, mapping_size);
+            
+            mapping = NULL;
+            mapping_size = 0;
+            entries = NULL;
+            entries_amount = 0;
+            delete[] is_entry_replaced;
+            is_entry_replaced = NULL;
+        }
+        
+        // The function looks for a valid entry of the received source file. If found, sets the image and its frames amount and returns true.
+        bool find(const char* path, uint64_t source_hash, Image* image, int* frames_amount)
+        {
+            // The key of the entry.
+            uint64_t name_hash = hash_string(path);
+            
+            pthread_mutex_lock(&mutex);
+            
+            // Iterate over the table of contents.
+            for (int i = 0; i < entries_amount; i++)
+            {
+                // Not this entry.
+                if (entries[i].name_hash != name_hash) { continue; }
+                
+                // The source file was changed since the pack was built.
+                if (entries[i].source_hash != source_hash) { break; }
+                
+                // Set the image properties.
+                image -> width = entries[i].width;
+                image -> height = entries[i].height;
+                image -> format = entries[i].format;
+                image -> mipmaps = 1;
+                *frames_amount = entries[i].frames_amount;
+                
+                // Uncompressed, the pixels are used straight from the mapping.
+                if (!entries[i].is_compressed) { image -> data = mapping + entries[i].offset; }
+                
+                // Compressed, decompress a copy of the pixels.
+                else
+                {
+                    int decompressed_size = 0;
+                    image -> data = DecompressData(mapping + entries[i].offset, (int) entries[i].stored_size, &decompressed_size);
+                    
+                    // The entry is corrupted.
+                    if (image -> data == NULL || (uint64_t) decompressed_size != entries[i].pixels_size) { if (image -> data != NULL) { MemFree(image -> data); } break; }
+                }
+                
+                hits++;
+                pthread_mutex_unlock(&mutex);
+                return true;
+            }
+            
+            misses++;
+            pthread_mutex_unlock(&mutex);
+            return false;
+        }
+        
+        // The function adds a decoded image to the pack. The image must stay loaded until save() is called, if is_free_after_save is true save() unloads it.
+        void add(const char* path, uint64_t source_hash, Image image, int frames_amount, bool is_free_after_save)
+        {
+            pthread_mutex_lock(&mutex);
+            
+            // No room for more entries, the image would simply be decoded again on the next launch.
+            if (new_entries_amount >= max_new_entries)
+            {
+                TraceLog(LOG_WARNING, "Asset pack is full, %s is not packed", path);
+                if (is_free_after_save) { UnloadImage(image); }
+                pthread_mutex_unlock(&mutex);
+                return;
+            }
+            
+            // Describe the new entry (the offset is set when saving).
+            pack_entry new_entry;
+            memset(&new_entry, 0, sizeof(pack_entry));
+            new_entry.name_hash = hash_string(path);
+            new_entry.source_hash = source_hash;
+            new_entry.pixels_size = (uint64_t) GetPixelDataSize(image.width, image.height, image.format) * frames_amount;
+            new_entry.width = image.width;
+            new_entry.height = image.height;
+            new_entry.format = image.format;
+            new_entry.frames_amount = frames_amount;
+            
+            // Save the new entry.
+            new_entries[new_entries_amount] = new_entry;
+            new_images[new_entries_amount] = image;
+            is_free_new_image[new_entries_amount] = is_free_after_save;
+            new_entries_amount++;
+            
+            // The outdated mapped entry of the same source file is dropped on rebuild.
+            for (int i = 0; i < entries_amount; i++)
+            {
+                if (entries[i].name_hash == new_entry.name_hash) { is_entry_replaced[i] = true; }
+            }
+            
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // The function rebuilds the pack file with the valid mapped entries and the images decoded on this launch.
+        // The current mapping stays valid, images which point into it can still be used.
+        void save()
+        {
+            pthread_mutex_lock(&mutex);
+            
+            // Count the entries of the new pack.
+            int kept_entries_amount = 0;
+            for (int i = 0; i < entries_amount; i++) { if (!is_entry_replaced[i]) { kept_entries_amount++; } }
+            
+            // Write to a temporary file first, so a crash while writing never leaves a broken pack behind (a cache, it is checked when it is read).
+            FILE* pack_file = AtomicFileWriter::open_temporary(file_path);
+            if (pack_file == NULL) { pthread_mutex_unlock(&mutex); return; }
+            
+            // The header.
+            pack_header header;
+            memcpy(header.magic, "FPAK", 4);
+            header.version = VERSION;
+            header.entries_amount = kept_entries_amount + new_entries_amount;
+            header.padding = 0;
+            
+            // The final table of contents, the offsets are set while writing the pixels.
+            pack_entry* table = new pack_entry[header.entries_amount];
+            
+            // Leave room for the header and the table of contents, they are written at the end.
+            uint64_t offset = align(sizeof(pack_header) + (uint64_t) header.entries_amount * sizeof(pack_entry));
+            fseek(pack_file, (long) offset, SEEK_SET);
+            
+            int table_index = 0;
+            
+            // Copy the kept entries as they are.
+            for (int i = 0; i < entries_amount; i++)
+            {
+                if (is_entry_replaced[i]) { continue; }
+                
+                table[table_index] = entries[i];
+                table[table_index].offset = offset;
+                offset = write_pixels(pack_file, offset, mapping + entries[i].offset, entries[i].stored_size);
+                table_index++;
+            }
+            
+            // Write the new entries.
+            for (int i = 0; i < new_entries_amount; i++)
+            {
+                table[table_index] = new_entries[i];
+                table[table_index].offset = offset;
+                
+                // Compress the pixels if required, and keep them raw if it doesn't pay off.
+                int compressed_size = 0;
+                unsigned char* compressed = NULL;
+                if (is_compress) { compressed = CompressData((unsigned char*) new_images[i].data, (int) new_entries[i].pixels_size, &compressed_size); }
+                
+                if (compressed != NULL && (uint64_t) compressed_size < new_entries[i].pixels_size)
+                {
+                    table[table_index].is_compressed = 1;
+                    table[table_index].stored_size = compressed_size;
+                    offset = write_pixels(pack_file, offset, compressed, compressed_size);
+                }
+                else
+                {
+                    table[table_index].is_compressed = 0;
+                    table[table_index].stored_size = new_entries[i].pixels_size;
+                    offset = write_pixels(pack_file, offset, (unsigned char*) new_images[i].data, new_entries[i].pixels_size);
+                }
+                
+                if (compressed != NULL) { MemFree(compressed); }
+                
+                // The image is no longer needed by the pack.
+                if (is_free_new_image[i]) { UnloadImage(new_images[i]); }
+                
+                table_index++;
+            }
+            
+            // Now write the header and the table of contents.
+            fseek(pack_file, 0, SEEK_SET);
+            fwrite(&header, sizeof(pack_header), 1, pack_file);
+            fwrite(table, sizeof(pack_entry), header.entries_amount, pack_file);
+            
+            delete[] table;
+            
+            // Replace the old pack.
+            if (AtomicFileWriter::commit(pack_file, file_path, true, false))
+            {
+                // Map the rebuilt pack, so the next rebuild keeps what was written now (assets loaded later are packed on another save).
+                // The current mapping stays, the images which were found there still point into it.
+                if (mapping != NULL && old_mappings_amount < 8)
+                {
+                    old_mappings[old_mappings_amount] = mapping;
+                    old_mappings_sizes[old_mappings_amount] = mapping_size;
+                    old_mappings_amount++;
+                }
+                
+                mapping = NULL;
+                mapping_size = 0;
+                entries = NULL;
+                entries_amount = 0;
+                delete[] is_entry_replaced;
+                is_entry_replaced = NULL;
+                
+                open_pack();
+            }
+            
+            // Everything was written.
+            new_entries_amount = 0;
+            
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // Returns true if some images had to be decoded, and the pack should be rebuilt.
+        bool is_dirty() { return new_entries_amount > 0; }
+        
+        // Returns true if the image pixels are owned by the mapping (such image must not be unloaded).
+        bool is_mapped(Image image)
+        {
+            unsigned char* data = (unsigned char*) image.data;
+            
+            for (int i = 0; i < old_mappings_amount; i++) { if (data >= old_mappings[i] && data < old_mappings[i] + old_mappings_sizes[i]) { return true; } }
+            
+            return mapping != NULL && data >= mapping && data < mapping + mapping_size;
+        }
+        
+        // Getters.
+        int get_hits() { return hits; }
+        int get_misses() { return misses; }
+        
+        // The function hashes the content of a file.
+        uint64_t hash_file(const char* path)
+        {
+            unsigned int bytes_read = 0;
+            unsigned char* file_data = LoadFileData(path, &bytes_read);
+            
+            // A missing file gets a hash that never matches an entry.
+            if (file_data == NULL) { return 0; }
+            
+            uint64_t hash = hash_bytes(file_data, bytes_read, FNV_OFFSET_BASIS);
+            UnloadFileData(file_data);
+            
+            return hash;
+        }
+        
+        // The function hashes a string.
+        uint64_t hash_string(const char* to_hash) { return hash_bytes((const unsigned char*) to_hash, strlen(to_hash), FNV_OFFSET_BASIS); }
+        
+        // The function hashes bytes which were already read.
+        static uint64_t hash_data(const unsigned char* data, size_t length) { return hash_bytes(data, length, FNV_OFFSET_BASIS); }
+        
+        // FNV-1a over the received bytes.
+        static uint64_t hash_bytes(const unsigned char* data, size_t length, uint64_t hash)
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                hash ^= data[i];
+                hash *= FNV_PRIME;
+            }
+            
+            return hash;
+        }
+        
+    private:
+    
+        // The layout version of the pack file.
+        static const uint32_t VERSION = 1;
+        
+        // FNV-1a constants.
+        static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+        static const uint64_t FNV_PRIME = 1099511628211ULL;
+        
+        // The largest width or height of a packed image.
+        static const int MAX_IMAGE_DIMENSION = 16384;
+        
+        // The pixels of every entry are aligned, so they can be uploaded straight from the mapping.
+        static uint64_t align(uint64_t offset) { return (offset + 63) & ~((uint64_t) 63); }
+        
+        // The function unmaps a pack file.
+        static void unmap(unsigned char* pack_mapping, size_t pack_mapping_size)
+        {
+            #if defined(_WIN32)
+                UnloadFileData(pack_mapping);
+            #else
+                munmap(pack_mapping, pack_mapping_size);
+            #endif
+        }
+        
+        // Returns true if an entry is within the mapping, and its pixels are as many as its image has (decoded images, not GPU compressed formats).
+        static bool is_entry_valid(pack_entry* entry, size_t pack_mapping_size)
+        {
+            if (entry -> offset > pack_mapping_size || entry -> stored_size > pack_mapping_size - entry -> offset) { return false; }
+            
+            if (entry -> width <= 0 || entry -> width > MAX_IMAGE_DIMENSION || entry -> height <= 0 || entry -> height > MAX_IMAGE_DIMENSION || entry -> frames_amount <= 0) { return false; }
+            if (entry -> format < PIXELFORMAT_UNCOMPRESSED_GRAYSCALE || entry -> format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) { return false; }
+            
+            // A row at a time, so the size of a large image doesn't overflow.
+            uint64_t image_size = (uint64_t) GetPixelDataSize(entry -> width, 1, entry -> format) * entry -> height * entry -> frames_amount;
+            if (entry -> pixels_size != image_size) { return false; }
+            
+            // The uncompressed pixels are used straight from the mapping, the compressed ones are decompressed (see find()).
+            if (!entry -> is_compressed) { return entry -> stored_size == entry -> pixels_size; }
+            
+            return entry -> stored_size <= INT_MAX;
+        }
+        
+        // The function writes pixels at the received offset, and returns the aligned offset of the next entry.
+        uint64_t write_pixels(FILE* pack_file, uint64_t offset, unsigned char* pixels, uint64_t size)
+        {
+            fseek(pack_file, (long) offset, SEEK_SET);
+            fwrite(pixels, 1, size, pack_file);
+            
+            return align(offset + size);
+        }
+};
+
+
+class StartupTracer
+{
+    /*
+        Measures where the startup time goes: the wall time and bytes of every startup phase and every loaded asset, per thread.
+        
+        Notes:
+            - record() can be called from any thread, the threads are numbered in order of their first record (the creating thread is 0, the main thread).
+            - After finish() nothing more is recorded, the assets loaded later (bundles) are not part of the startup.
+            - The report is a table sorted by time (the biggest offenders first), and a json file for comparing launches.
+    */
+    
+    private:
+    
+        // The records.
+        int max_entries;
+        int entries_amount;
+        trace_entry* entries;
+        
+        // The threads which recorded, their index is the thread number.
+        pthread_t threads[64];
+        int threads_amount;
+        
+        // When the tracer was created, and when finish() was called.
+        double start_time;
+        double finish_time;
+        bool is_active;
+        
+        // The records come from the loading threads too.
+        pthread_mutex_t mutex;
+    
+    public:
+    
+        // Constructor.
+        StartupTracer(int new_max_entries)
+        {
+            max_entries = new_max_entries;
+            entries_amount = 0;
+            entries = new trace_entry[max_entries];
+            
+            pthread_mutex_init(&mutex, NULL);
+            
+            // The creating thread is the main thread.
+            threads[0] = pthread_self();
+            threads_amount = 1;
+            
+            start_time = monotonic_time();
+            finish_time = start_time;
+            is_active = true;
+        }
+        
+        // The function records a part of the startup, which started at phase_start_time and ends now. The name must stay valid (a literal or a path constant).
+        void record(const char* name, const char* category, double phase_start_time, uint64_t bytes)
+        {
+            double end_time = monotonic_time();
+            
+            pthread_mutex_lock(&mutex);
+            
+            if (is_active && entries_amount < max_entries)
+            {
+                trace_entry entry;
+                entry.name = name;
+                entry.category = category;
+                entry.thread = get_thread_index();
+                entry.start_time = phase_start_time - start_time;
+                entry.end_time = end_time - start_time;
+                entry.bytes = bytes;
+                
+                entries[entries_amount] = entry;
+                entries_amount++;
+            }
+            
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // The function stops recording, the startup is over.
+        void finish()
+        {
+            pthread_mutex_lock(&mutex);
+            is_active = false;
+            finish_time = monotonic_time();
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // The function logs the records as a table, the longest first, and the totals per thread.
+        void report()
+        {
+            // Sort the records order by duration (a few dozens, a simple selection sort).
+            int* order = new int[entries_amount];
+            for (int i = 0; i < entries_amount; i++) { order[i] = i; }
+            
+            for (int i = 0; i < entries_amount; i++)
+            {
+                for (int j = i + 1; j < entries_amount; j++)
+                {
+                    if (get_duration(order[j]) > get_duration(order[i])) { int temp = order[i]; order[i] = order[j]; order[j] = temp; }
+                }
+            }
+            
+            TraceLog(LOG_INFO, "Startup trace, %.1f ms in total", (finish_time - start_time) * 1000);
+            TraceLog(LOG_INFO, "    %-8s %-8s %10s %10s %10s  %s", "thread", "category", "start ms", "ms", "MB", "name");
+            
+            for (int i = 0; i < entries_amount; i++)
+            {
+                trace_entry* entry = &entries[order[i]];
+                TraceLog(LOG_INFO, "    %-8d %-8s %10.1f %10.1f %10.2f  %s", entry -> thread, entry -> category, entry -> start_time * 1000, get_duration(order[i]) * 1000, entry -> bytes / (1024.0 * 1024.0), entry -> name);
+            }
+            
+            // The busy time and bytes of every thread.
+            for (int thread = 0; thread < threads_amount; thread++)
+            {
+                double busy_time = 0;
+                uint64_t bytes = 0;
+                
+                for (int i = 0; i < entries_amount; i++)
+                {
+                    if (entries[i].thread != thread) { continue; }
+                    
+                    busy_time += get_duration(i);
+                    bytes += entries[i].bytes;
+                }
+                
+                TraceLog(LOG_INFO, "    thread %d: %.1f ms, %.2f MB", thread, busy_time * 1000, bytes / (1024.0 * 1024.0));
+            }
+            
+            delete[] order;
+        }
+        
+        // The function writes the records as json, for comparing launches.
+        void save_json(string path)
+        {
+            FILE* json_file = fopen(path.c_str(), "w");
+            if (json_file == NULL) { TraceLog(LOG_WARNING, "Could not write the startup trace %s", path.c_str()); return; }
+            
+            fprintf(json_file, "{\n    \"total_ms\": %.3f,\n    \"threads\": %d,\n    \"entries\": [\n", (finish_time - start_time) * 1000, threads_amount);
+            
+            for (int i = 0; i < entries_amount; i++)
+            {
+                fprintf(json_file, "        {\"name\": \"");
+                write_json_string(json_file, entries[i].name);
+                fprintf(json_file, "\", \"category\": \"%s\", \"thread\": %d, \"start_ms\": %.3f, \"duration_ms\": %.3f, \"bytes\": %llu}%s\n", entries[i].category, entries[i].thread, entries[i].start_time * 1000, get_duration(i) * 1000, (unsigned long long) entries[i].bytes, i + 1 < entries_amount ? "," : "");
+            }
+            
+            fprintf(json_file, "    ]\n}\n");
+            fclose(json_file);
+        }
+    
+    private:
+    
+        // Returns the duration of a record in seconds.
+        double get_duration(int index) { return entries[index].end_time - entries[index].start_time; }
+        
+        // Returns the number of the current thread, a new thread gets the next number (called with the mutex locked).
+        int get_thread_index()
+        {
+            pthread_t current_thread = pthread_self();
+            
+            for (int i = 0; i < threads_amount; i++) { if (pthread_equal(threads[i], current_thread)) { return i; } }
+            
+            if (threads_amount == 64) { return 63; }
+            
+            threads[threads_amount] = current_thread;
+            return threads_amount++;
+        }
+        
+        // The function writes a string to a json file, escaping the quotes and backslashes.
+        static void write_json_string(FILE* json_file, const char* text)
+        {
+            for (const char* character = text; *character != '\0'; character++)
+            {
+                if (*character == '"' || *character == '\\') { fputc('\\', json_file); }
+                fputc(*character, json_file);
+            }
+        }
+};
+
+
+class FrameClock
+{
+    /*
+        Runs the simulation in fixed ticks, independently of the rendering rate, and measures the frame pacing.
+        
+        Notes:
+            - Every frame adds the real time that passed to an accumulator, and runs as many ticks as fit in it (begin_frame()).
+            - The time left in the accumulator (get_alpha()) is how far the drawing is between the last two ticks, the entities are drawn interpolated by it.
+            - A long hitch doesn't run a burst of ticks, at most max_ticks_per_frame run and the rest of the time is dropped (counted as dropped).
+            - The frame times of the last frames are kept in a ring, for the pacing stats (mean, p99, max and the ticks per frame).
+            - The frames of an idle screen are skipped (skip_frame()), the time waiting for the input is neither simulated nor counted.
+    */
+    
+    private:
+    
+        // The length of a tick, in seconds.
+        int ticks_per_second;
+        double tick_duration;
+        int max_ticks_per_frame;
+        
+        // The time which wasn't simulated yet.
+        double accumulator;
+        double last_frame_time;
+        
+        // The frame times of the last frames (seconds), as a ring.
+        int max_history;
+        int history_amount;
+        int history_index;
+        double* frame_times;
+        
+        // Counters.
+        long frames_amount;
+        long ticks_amount;
+        long frames_without_ticks;
+        long frames_with_several_ticks;
+        long skipped_frames;
+        double dropped_time;
+    
+    public:
+    
+        // Constructor.
+        FrameClock(int new_ticks_per_second, int new_max_ticks_per_frame, int new_max_history)
+        {
+            ticks_per_second = new_ticks_per_second;
+            tick_duration = 1.0 / ticks_per_second;
+            max_ticks_per_frame = new_max_ticks_per_frame;
+            
+            accumulator = 0;
+            last_frame_time = -1;
+            
+            // Create the frame times ring.
+            max_history = new_max_history;
+            history_amount = 0;
+            history_index = 0;
+            frame_times = new double[max_history];
+            
+            frames_amount = 0;
+            ticks_amount = 0;
+            frames_without_ticks = 0;
+            frames_with_several_ticks = 0;
+            skipped_frames = 0;
+            dropped_time = 0;
+        }
+        
+        // The function measures the time since the previous frame, and returns how many ticks to simulate on this frame.
+        int begin_frame()
+        {
+            double current_time = monotonic_time();
+            
+            // The first frame runs a single tick.
+            if (last_frame_time < 0) { last_frame_time = current_time - tick_duration; }
+            
+            double frame_time = current_time - last_frame_time;
+            last_frame_time = current_time;
+            
+            // Save the frame time.
+            frame_times[history_index] = frame_time;
+            history_index = (history_index + 1) % max_history;
+            history_amount = min(history_amount + 1, max_history);
+            frames_amount++;
+            
+            // Run the ticks which fit in the time.
+            accumulator += frame_time;
+            int ticks = (int) floor(accumulator / tick_duration);
+            
+            // Too far behind (a hitch, or the game was in the background), drop the time instead of catching up.
+            if (ticks > max_ticks_per_frame)
+            {
+                dropped_time += (ticks - max_ticks_per_frame) * tick_duration;
+                ticks = max_ticks_per_frame;
+                accumulator = fmod(accumulator, tick_duration) + ticks * tick_duration;
+            }
+            
+            accumulator -= ticks * tick_duration;
+            
+            ticks_amount += ticks;
+            if (ticks == 0) { frames_without_ticks++; }
+            if (ticks > 1) { frames_with_several_ticks++; }
+            
+            return ticks;
+        }
+        
+        // The function starts a frame which is not simulated (an idle screen), the next frame measures its time from now.
+        void skip_frame()
+        {
+            last_frame_time = monotonic_time();
+            skipped_frames++;
+        }
+        
+        // Returns how far the current frame is between the previous tick and the last one (0 to 1).
+        float get_alpha() { return (float) min(1.0, accumulator / tick_duration); }
+        
+        // Returns a percentile of the last frame times, in milliseconds.
+        double get_frame_time_percentile(double percentile)
+        {
+            if (history_amount == 0) { return 0; }
+            
+            // Sort a copy of the ring (few hundred frames, insertion sort).
+            double* sorted_times = new double[history_amount];
+            for (int i = 0; i < history_amount; i++)
+            {
+                int j = i - 1;
+                while (j >= 0 && sorted_times[j] > frame_times[i]) { sorted_times[j + 1] = sorted_times[j]; j--; }
+                sorted_times[j + 1] = frame_times[i];
+            }
+            
+            double frame_time = sorted_times[min(history_amount - 1, (int) (percentile * history_amount))];
+            delete[] sorted_times;
+            
+            return frame_time * 1000;
+        }
+        
+        // Returns the mean of the last frame times, in milliseconds.
+        double get_mean_frame_time()
+        {
+            if (history_amount == 0) { return 0; }
+            
+            double total_time = 0;
+            for (int i = 0; i < history_amount; i++) { total_time += frame_times[i]; }
+            
+            return total_time / history_amount * 1000;
+        }
+        
+        // The function draws the pacing stats of the last frames.
+        void draw_stats(int x, int y)
+        {
+            DrawText(TextFormat("Frame: %.1f ms (p99 %.1f, max %.1f), ticks: %d/s", get_mean_frame_time(), get_frame_time_percentile(0.99), get_frame_time_percentile(1), ticks_per_second), x, y, 20, BLACK);
+        }
+        
+        // The function logs the pacing stats.
+        void report()
+        {
+            TraceLog(LOG_INFO, "Frame pacing: %ld frames, %ld ticks, mean %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms (last %d frames)", frames_amount, ticks_amount, get_mean_frame_time(), get_frame_time_percentile(0.5), get_frame_time_percentile(0.99), get_frame_time_percentile(1), history_amount);
+            TraceLog(LOG_INFO, "Frame pacing: %ld frames without a tick, %ld frames with several ticks, %.2f seconds dropped, %ld idle frames skipped", frames_without_ticks, frames_with_several_ticks, dropped_time, skipped_frames);
+        }
+};
+
+
+class QualityGovernor
+{
+    /*
+        Holds the frame time within a budget, by lowering the load which doesn't change the game when a device can't keep up.
+        
+        Notes:
+            - Measures the phases of every frame on the main thread (FramePhase). The cost of a frame is its update, its drawing and the wait for the simulation,
+              without the wait for the display.
+            - Every level lowers the quality by a step (sim_quality): the fish out of the view animate slower, then the background of the menus gets less fish,
+              and last the ambient population of the world is lowered.
+            - Hysteresis: the level is lowered once the smoothed cost stays over the budget for a few frames, and raised only once it stays well under the budget
+              for a longer while. A level which was lowered again right after it was raised waits twice longer before the next raise.
+    */
+    
+    private:
+    
+        // The budget of a frame, and the parts of it which lower and raise the level (seconds).
+        double budget;
+        double lower_ratio;
+        double raise_ratio;
+        
+        // How many frames the cost must stay over (or under) the budget before the level changes.
+        int lower_frames;
+        int raise_frames;
+        int* raise_frames_of_levels;
+        
+        // The levels, from the full quality.
+        int levels_amount;
+        sim_quality* levels;
+        int level;
+        
+        // The phases of the current frame, and their smoothed times (seconds).
+        int phase;
+        double phase_start_time;
+        double* phases_times;
+        double* smoothed_phases_times;
+        double smoothed_cost;
+        
+        // The frames the cost was over or under the budget in a row, and since the last change.
+        int over_frames;
+        int under_frames;
+        long frames_since_change;
+        bool was_raised;
+        
+        // Measurements.
+        long* frames_on_levels;
+        long lowered_amount;
+        long raised_amount;
+        string last_decision;
+    
+    public:
+    
+        // Constructor, the budget is in seconds.
+        QualityGovernor(double new_budget)
+        {
+            budget = new_budget;
+            lower_ratio = 0.9;
+            raise_ratio = 0.6;
+            lower_frames = 30;
+            raise_frames = 120;
+            
+            // The levels (the fish out of the view animate every n ticks, the world population, the menus background population).
+            levels_amount = 5;
+            levels = new sim_quality[levels_amount];
+            levels[0].offscreen_frame_interval = 1; levels[0].world_population_ratio = 1; levels[0].background_population_ratio = 1;
+            levels[1].offscreen_frame_interval = 2; levels[1].world_population_ratio = 1; levels[1].background_population_ratio = 1;
+            levels[2].offscreen_frame_interval = 4; levels[2].world_population_ratio = 1; levels[2].background_population_ratio = 0.5;
+            levels[3].offscreen_frame_interval = 4; levels[3].world_population_ratio = 0.8; levels[3].background_population_ratio = 0.5;
+            levels[4].offscreen_frame_interval = 4; levels[4].world_population_ratio = 0.6; levels[4].background_population_ratio = 0.5;
+            level = 0;
+            
+            raise_frames_of_levels = new int[levels_amount];
+            frames_on_levels = new long[levels_amount];
+            for (int i = 0; i < levels_amount; i++) { raise_frames_of_levels[i] = raise_frames; frames_on_levels[i] = 0; }
+            
+            phases_times = new double[FRAME_PHASES_AMOUNT];
+            smoothed_phases_times = new double[FRAME_PHASES_AMOUNT];
+            for (int i = 0; i < FRAME_PHASES_AMOUNT; i++) { phases_times[i] = 0; smoothed_phases_times[i] = 0; }
+            phase = FRAME_PHASE_UPDATE;
+            phase_start_time = monotonic_time();
+            smoothed_cost = 0;
+            
+            over_frames = 0;
+            under_frames = 0;
+            frames_since_change = 0;
+            was_raised = false;
+            lowered_amount = 0;
+            raised_amount = 0;
+            last_decision = "Full quality";
+        }
+        
+        // The function starts measuring a frame, from its update.
+        void begin_frame()
+        {
+            for (int i = 0; i < FRAME_PHASES_AMOUNT; i++) { phases_times[i] = 0; }
+            
+            phase = FRAME_PHASE_UPDATE;
+            phase_start_time = monotonic_time();
+        }
+        
+        // The function ends the current phase of the frame, and starts the next one (FramePhase).
+        void begin_phase(int new_phase)
+        {
+            double current_time = monotonic_time();
+            
+            phases_times[phase] += current_time - phase_start_time;
+            phase = new_phase;
+            phase_start_time = current_time;
+        }
+        
+        // The function ends the frame, and changes the level if needed.
+        void end_frame()
+        {
+            begin_phase(phase);
+            
+            // Smooth the phases over the last frames (a single slow frame is a hitch, not a weak device).
+            for (int i = 0; i < FRAME_PHASES_AMOUNT; i++) { smoothed_phases_times[i] += (phases_times[i] - smoothed_phases_times[i]) * 0.1; }
+            smoothed_cost = smoothed_phases_times[FRAME_PHASE_UPDATE] + smoothed_phases_times[FRAME_PHASE_DRAW] + smoothed_phases_times[FRAME_PHASE_SIMULATION_WAIT];
+            
+            frames_on_levels[level]++;
+            frames_since_change++;
+            over_frames = (smoothed_cost > budget * lower_ratio) ? over_frames + 1 : 0;
+            under_frames = (smoothed_cost < budget * raise_ratio) ? under_frames + 1 : 0;
+            
+            // Over the budget, lower the quality.
+            if (over_frames >= lower_frames && level < levels_amount - 1)
+            {
+                // The raise didn't hold, the level above is tried again later.
+                if (was_raised && frames_since_change < raise_frames_of_levels[level]) { raise_frames_of_levels[level] = min(raise_frames_of_levels[level] * 2, raise_frames * 8); }
+                
+                level++;
+                lowered_amount++;
+                last_decision = TextFormat("Lowered to %d (%.1f ms over %.1f ms)", level, smoothed_cost * 1000, budget * lower_ratio * 1000);
+                TraceLog(LOG_INFO, "Quality: %s", last_decision.c_str());
+                change_level(false);
+            }
+            
+            // Well under the budget for a while, raise the quality.
+            else if (under_frames >= raise_frames_of_levels[max(0, level - 1)] && level > 0)
+            {
+                level--;
+                raised_amount++;
+                last_decision = TextFormat("Raised to %d (%.1f ms under %.1f ms)", level, smoothed_cost * 1000, budget * raise_ratio * 1000);
+                TraceLog(LOG_INFO, "Quality: %s", last_decision.c_str());
+                change_level(true);
+            }
+        }
+        
+        // Returns the load of the current level.
+        sim_quality get_quality() { return levels[level]; }
+        
+        // Getters.
+        int get_level() { return level; }
+        
+        // The function draws the level, the phases of the frames, and the last decision.
+        void draw_stats(int x, int y)
+        {
+            DrawText(TextFormat("Quality %d/%d: %.1f ms of %.1f (update %.1f, draw %.1f, simulation wait %.1f, display %.1f)", level, levels_amount - 1, smoothed_cost * 1000, budget * 1000, smoothed_phases_times[FRAME_PHASE_UPDATE] * 1000, smoothed_phases_times[FRAME_PHASE_DRAW] * 1000, smoothed_phases_times[FRAME_PHASE_SIMULATION_WAIT] * 1000, smoothed_phases_times[FRAME_PHASE_DISPLAY] * 1000), x, y, 20, BLACK);
+            DrawText(TextFormat("%s, off-screen gifs every %d ticks, population %.0f%% (menus %.0f%%)", last_decision.c_str(), levels[level].offscreen_frame_interval, levels[level].world_population_ratio * 100, levels[level].background_population_ratio * 100), x, y + 25, 20, BLACK);
+        }
+        
+        // The function logs how long every level was held.
+        void report()
+        {
+            TraceLog(LOG_INFO, "Quality: lowered %ld times, raised %ld times, budget %.1f ms", lowered_amount, raised_amount, budget * 1000);
+            
+            for (int i = 0; i < levels_amount; i++)
+            {
+                if (frames_on_levels[i] > 0) { TraceLog(LOG_INFO, "Quality: level %d for %ld frames", i, frames_on_levels[i]); }
+            }
+        }
+    
+    private:
+    
+        // The function starts counting the frames of a new level.
+        void change_level(bool is_raised)
+        {
+            was_raised = is_raised;
+            frames_since_change = 0;
+            over_frames = 0;
+            under_frames = 0;
+        }
+};
+
+
+class WorldState
+{
+    /*
+        The whole simulation state of a world instance, so a world which was left in the middle (the game was closed or killed) continues from there.
+        
+        Notes:
+            - The state is a header (world_state_header), the state of my fish, the states of the fish of the network (fixed size records)
+              and the order of the entities in the cells of the grid. The order decides which collision is checked first, with it the restored
+              world continues exactly as the saved one would have.
+            - capture() takes the state to the memory (main thread, while the simulation is idle). capture_state() and restore_state() are the record
+              itself, the rewind keeps its history in the same records (see Rewind). The file is written durably by a writer
+              thread of its own (see AtomicFileWriter), only the latest captured state is written.
+            - restore() creates the fish from their profiles and puts them where they were, the world is not set up again (no spawning).
+            - The random numbers generator of the fish network is saved too, the restored world draws the numbers it would have drawn.
+            - A state with a wrong magic, version, size or checksum is ignored.
+    */
+    
+    private:
+    
+        // The path of the state file.
+        string file_path;
+        
+        // The captured (or read) state, and if it can still be restored.
+        int max_fish;
+        int max_grid_entries;
+        size_t max_data_size;
+        unsigned char* data;
+        size_t data_size;
+        bool is_restorable;
+        
+        // The entities of the restored world by their state indexes (my fish is the last one).
+        GridEntity** entities;
+        
+        // Writes the state in the background.
+        AtomicFileWriter writer;
+        
+        // Measurements, in seconds.
+        double last_capture_time;
+    
+    public:
+    
+        // Constructor, max_fish is the max population of the fish networks and max_cells the cells of their grids.
+        WorldState(string new_file_path, int new_max_fish, int new_max_cells) : writer(new_file_path, get_max_size(new_max_fish, get_max_grid_entries(new_max_fish, new_max_cells)), "World state")
+        {
+            file_path = new_file_path;
+            
+            max_fish = new_max_fish;
+            max_grid_entries = get_max_grid_entries(max_fish, new_max_cells);
+            max_data_size = get_max_size(max_fish, max_grid_entries);
+            data = new unsigned char[max_data_size];
+            data_size = 0;
+            is_restorable = false;
+            
+            entities = new GridEntity*[max_fish + 1];
+            
+            last_capture_time = 0;
+        }
+        
+        // The function takes the state of the world, returns its size in bytes (main thread, while the simulation is idle).
+        size_t capture(GameWorld* game_world)
+        {
+            double capture_start_time = monotonic_time();
+            
+            data_size = capture_state(game_world, data, max_fish, max_grid_entries);
+            
+            // The state which was read is replaced.
+            is_restorable = false;
+            
+            last_capture_time = monotonic_time() - capture_start_time;
+            
+            return data_size;
+        }
+        
+        // The function puts the world in the state which was read (main thread, while the simulation is idle), returns false if there is no
+        // state of this world. The world is then resumed as it was.
+        bool restore(GameWorld* game_world)
+        {
+            if (!can_restore(game_world -> get_number())) { return false; }
+            
+            is_restorable = false;
+            
+            // Start from an empty world.
+            game_world -> restart();
+            
+            if (!restore_state(game_world, data, entities)) { TraceLog(LOG_WARNING, "World state: %s doesn't match world %d", file_path.c_str(), game_world -> get_number()); game_world -> restart(); return false; }
+            
+            game_world -> resume_restored();
+            
+            return true;
+        }
+        
+        // Returns true if a state of the world was read, and can be restored.
+        bool can_restore(int world_number) { return is_restorable && ((world_state_header*) data) -> world_number == world_number; }
+        
+        // The function reads the state file, returns false if there is no valid state.
+        bool read()
+        {
+            double read_start_time = monotonic_time();
+            
+            is_restorable = false;
+            
+            FILE* state_file = fopen(file_path.c_str(), "rb");
+            if (state_file == NULL) { return false; }
+            
+            data_size = fread(data, 1, max_data_size, state_file);
+            fclose(state_file);
+            
+            world_state_header* header = (world_state_header*) data;
+            
+            if (data_size < sizeof(world_state_header) + sizeof(my_fish_state) || memcmp(header -> magic, "FWLD", 4) != 0 || header -> version != VERSION) { TraceLog(LOG_WARNING, "World state: %s is not a world state", file_path.c_str()); return false; }
+            if (header -> fish_amount < 0 || header -> fish_amount > max_fish || header -> grid_entries_amount < 0 || header -> grid_entries_amount > max_grid_entries || data_size != get_grid_entries_offset(header -> fish_amount) + (size_t) header -> grid_entries_amount * sizeof(int32_t)) { TraceLog(LOG_WARNING, "World state: %s has a wrong size", file_path.c_str()); return false; }
+            if (header -> checksum != Save::checksum(data + sizeof(world_state_header), data_size - sizeof(world_state_header))) { TraceLog(LOG_WARNING, "World state: %s is broken (checksum)", file_path.c_str()); return false; }
+            
+            is_restorable = true;
+            
+            TraceLog(LOG_INFO, "World state: world %d with %d fish (%zu bytes) read in %.2f ms", header -> world_number, header -> fish_amount, data_size, (monotonic_time() - read_start_time) * 1000);
+            
+            return true;
+        }
+        
+        // The function hands the captured state to the writer thread (replaces a state which wasn't written yet).
+        void write_async() { writer.write_async(data, data_size); }
+        
+        // The function removes the state file in the background (the world is over, it isn't continued).
+        void discard()
+        {
+            is_restorable = false;
+            writer.remove_async();
+        }
+        
+        // The function writes what is still pending, and stops the writer thread.
+        void quit() { writer.quit(); }
+        
+        // The function logs the size of the last state, and how long it took.
+        void report()
+        {
+            if (writer.get_writes_amount() == 0) { return; }
+            
+            TraceLog(LOG_INFO, "World state: %ld states written, the last one %zu bytes, captured in %.3f ms and written in %.2f ms", writer.get_writes_amount(), data_size, last_capture_time * 1000, writer.get_last_write_time() * 1000);
+        }
+    
+        // The function writes the state of the world to state_data (get_max_size() bytes), returns its size in bytes (while the simulation is idle,
+        // or on the simulation thread). The state is made of 4 bytes fields.
+        static size_t capture_state(GameWorld* game_world, unsigned char* state_data, int max_fish, int max_grid_entries)
+        {
+            world_state_header* header = (world_state_header*) state_data;
+            my_fish_state* my_fish_record = (my_fish_state*) (state_data + sizeof(world_state_header));
+            wander_fish_state* fish_records = (wander_fish_state*) (state_data + sizeof(world_state_header) + sizeof(my_fish_state));
+            
+            memset(header, 0, sizeof(world_state_header) + sizeof(my_fish_state));
+            memcpy(header -> magic, "FWLD", 4);
+            header -> version = VERSION;
+            header -> world_number = game_world -> get_number();
+            header -> fish_amount = game_world -> get_fish_network() -> save_states(fish_records, max_fish);
+            header -> random_state = game_world -> get_fish_network() -> get_random_state();
+            header -> camera_target_x = game_world -> get_camera() -> target.x;
+            header -> camera_target_y = game_world -> get_camera() -> target.y;
+            header -> camera_zoom = game_world -> get_camera() -> zoom;
+            
+            if (game_world -> get_my_fish() != NULL) { game_world -> get_my_fish() -> save_state(my_fish_record); }
+            
+            // The order of the cells, by the state indexes of the entities (my fish follows the fish of the network).
+            for (int i = 0; i < header -> fish_amount; i++) { game_world -> get_fish_network() -> get_fish(i) -> set_state_index(i); }
+            if (game_world -> get_my_fish() != NULL) { game_world -> get_my_fish() -> set_state_index(header -> fish_amount); }
+            
+            int32_t* grid_entries = (int32_t*) (state_data + get_grid_entries_offset(header -> fish_amount));
+            header -> grid_entries_amount = max(0, game_world -> get_grid() -> save_cells(grid_entries, max_grid_entries));
+            
+            size_t state_size = get_grid_entries_offset(header -> fish_amount) + (size_t) header -> grid_entries_amount * sizeof(int32_t);
+            header -> checksum = Save::checksum(state_data + sizeof(world_state_header), state_size - sizeof(world_state_header));
+            
+            return state_size;
+        }
+        
+        // The function puts the world in a captured state (while the simulation is idle), entities has room for the fish and my fish. The fish which are
+        // already in the world are reused when they match. Returns false if the state doesn't belong to the world.
+        static bool restore_state(GameWorld* game_world, const unsigned char* state_data, GridEntity** entities)
+        {
+            const world_state_header* header = (const world_state_header*) state_data;
+            const my_fish_state* my_fish_record = (const my_fish_state*) (state_data + sizeof(world_state_header));
+            const wander_fish_state* fish_records = (const wander_fish_state*) (state_data + sizeof(world_state_header) + sizeof(my_fish_state));
+            
+            if (header -> world_number != game_world -> get_number()) { return false; }
+            if (!game_world -> get_fish_network() -> load_states(fish_records, header -> fish_amount)) { return false; }
+            
+            if (game_world -> get_my_fish() != NULL)
+            {
+                game_world -> get_my_fish() -> load_state(my_fish_record);
+                game_world -> get_grid() -> refresh_entity(game_world -> get_my_fish());
+            }
+            
+            // Put the entities in the cells in the saved order (a state without it keeps the order they were loaded in).
+            if (header -> grid_entries_amount > 0 && game_world -> get_my_fish() != NULL && game_world -> get_fish_network() -> get_fish_amount() == header -> fish_amount)
+            {
+                for (int i = 0; i < header -> fish_amount; i++) { entities[i] = game_world -> get_fish_network() -> get_fish(i); }
+                entities[header -> fish_amount] = game_world -> get_my_fish();
+                
+                const int32_t* grid_entries = (const int32_t*) (state_data + get_grid_entries_offset(header -> fish_amount));
+                if (!game_world -> get_grid() -> load_cells(grid_entries, header -> grid_entries_amount, entities, header -> fish_amount + 1))
+                {
+                    // Back to the order they were loaded in.
+                    TraceLog(LOG_WARNING, "World state: the cells don't match the grid of world %d", header -> world_number);
+                    for (int i = 0; i <= header -> fish_amount; i++) { entities[i] -> reset_cells_within(); game_world -> get_grid() -> add_entity(entities[i]); }
+                }
+            }
+            
+            game_world -> get_fish_network() -> set_random_state(header -> random_state);
+            game_world -> get_camera() -> target.x = header -> camera_target_x;
+            game_world -> get_camera() -> target.y = header -> camera_target_y;
+            game_world -> get_camera() -> zoom = header -> camera_zoom;
+            
+            return true;
+        }
+        
+        // Returns how many numbers may describe the cells of a grid, every cell has its entities amount and may have all the entities.
+        static int get_max_grid_entries(int max_fish, int max_cells) { return max_cells * (max_fish + 2); }
+        
+        // Returns the max size of a state.
+        static size_t get_max_size(int max_fish, int max_grid_entries) { return get_grid_entries_offset(max_fish) + (size_t) max_grid_entries * sizeof(int32_t); }
+    
+    private:
+    
+        // The layout version of the world state.
+        static const uint32_t VERSION = 1;
+        
+        // Returns where the cells of the grid start, after the states of the fish.
+        static size_t get_grid_entries_offset(int fish_amount) { return sizeof(world_state_header) + sizeof(my_fish_state) + (size_t) fish_amount * sizeof(wander_fish_state); }
+
+};
+
+
+class Rewind
+{
+    /*
+        The history of the played world, the last seconds of its ticks, so the world can be rolled back (a bad jelly fish sting).
+        
+        Notes:
+            - Every tick is captured as a world state (see WorldState::capture_state()), the fish network, my fish, the random numbers generator and the grid.
+            - A keyframe is kept whole once in keyframe_ticks ticks, the ticks between are kept as a delta against their keyframe: the 4 bytes words which
+              differ from it (xor), with the runs of equal words skipped. A tick is restored from its keyframe and its own delta, O(state size).
+            - The history is a ring of bytes of a fixed size, and at most max_ticks ticks. The oldest ticks are dropped for the new ones, a keyframe
+              with the ticks which depend on it.
+            - capture() runs on the simulation thread after a tick, step_back() on the main thread while the simulation is idle. Stepping back drops the
+              ticks after the restored one, the next captured tick follows it.
+    */
+    
+    private:
+    
+        // The size of the captured states.
+        int max_fish;
+        int max_grid_entries;
+        size_t max_state_size;
+        
+        // The captured (or restored) state, its keyframe, and the encoded delta.
+        unsigned char* state;
+        unsigned char* keyframe_state;
+        size_t keyframe_size;
+        long keyframe_tick;
+        unsigned char* delta;
+        
+        // The ring of bytes, and where the next tick is written.
+        unsigned char* history;
+        size_t history_size;
+        size_t write_offset;
+        
+        // The ticks in the history (a ring of max_ticks entries, empty when the oldest tick is after the newest one).
+        rewind_entry* entries;
+        int max_ticks;
+        long oldest_tick;
+        long newest_tick;
+        int keyframe_ticks;
+        
+        // The entities of the restored world by their state indexes.
+        GridEntity** entities;
+        
+        // Measurements (in seconds), the bytes kept against the whole states.
+        int ticks_per_second;
+        long ticks_captured;
+        long keyframes_amount;
+        double total_kept_bytes;
+        double total_state_bytes;
+        double total_capture_time;
+        double max_capture_time;
+        long ticks_rewound;
+        double last_restore_time;
+    
+    public:
+    
+        // Constructor, the history holds up to max_seconds of ticks within history_size bytes (a keyframe once in new_keyframe_ticks ticks).
+        Rewind(int new_ticks_per_second, int max_seconds, int new_keyframe_ticks, size_t new_history_size, int new_max_fish, int new_max_cells)
+        {
+            max_fish = new_max_fish;
+            max_grid_entries = WorldState::get_max_grid_entries(max_fish, new_max_cells);
+            max_state_size = WorldState::get_max_size(max_fish, max_grid_entries);
+            
+            state = new unsigned char[max_state_size];
+            keyframe_state = new unsigned char[max_state_size];
+            keyframe_size = 0;
+            keyframe_tick = -1;
+            
+            // The worst delta is a run for every other word.
+            delta = new unsigned char[sizeof(uint32_t) + max_state_size * 3];
+            
+            // A keyframe and its delta always fit.
+            history_size = max(new_history_size, max_state_size * 4);
+            history = new unsigned char[history_size];
+            write_offset = 0;
+            
+            ticks_per_second = new_ticks_per_second;
+            max_ticks = max(2, max_seconds * ticks_per_second);
+            entries = new rewind_entry[max_ticks];
+            keyframe_ticks = max(1, new_keyframe_ticks);
+            
+            entities = new GridEntity*[max_fish + 1];
+            
+            ticks_captured = 0;
+            keyframes_amount = 0;
+            total_kept_bytes = 0;
+            total_state_bytes = 0;
+            total_capture_time = 0;
+            max_capture_time = 0;
+            ticks_rewound = 0;
+            last_restore_time = 0;
+            
+            clear();
+        }
+        
+        // The function forgets the history (another world is played, or it was started over).
+        void clear()
+        {
+            oldest_tick = 0;
+            newest_tick = -1;
+            keyframe_tick = -1;
+            write_offset = 0;
+        }
+        
+        // The function keeps the state of the world after a tick (simulation thread).
+        void capture(GameWorld* game_world)
+        {
+            double capture_start_time = monotonic_time();
+            
+            size_t state_size = WorldState::capture_state(game_world, state, max_fish, max_grid_entries);
+            long tick = newest_tick + 1;
+            
+            // The oldest tick makes room for this one.
+            if (tick - oldest_tick >= max_ticks) { drop_oldest(); }
+            
+            // A delta against the keyframe, unless it is time for a new keyframe (or the delta isn't smaller).
+            bool is_keyframe = keyframe_tick < oldest_tick || tick - keyframe_tick >= keyframe_ticks;
+            size_t kept_size = 0;
+            
+            if (!is_keyframe)
+            {
+                kept_size = encode_delta(state_size);
+                is_keyframe = kept_size >= state_size;
+            }
+            
+            if (!is_keyframe)
+            {
+                make_room(kept_size);
+                
+                // The room was made of its keyframe.
+                is_keyframe = keyframe_tick < oldest_tick;
+            }
+            
+            if (is_keyframe)
+            {
+                kept_size = state_size;
+                make_room(kept_size);
+                
+                memcpy(keyframe_state, state, state_size);
+                keyframe_size = state_size;
+                keyframe_tick = tick;
+                keyframes_amount++;
+            }
+            
+            memcpy(history + write_offset, is_keyframe ? state : delta, kept_size);
+            
+            rewind_entry* entry = &entries[tick % max_ticks];
+            entry -> offset = write_offset;
+            entry -> size = kept_size;
+            entry -> keyframe_tick = keyframe_tick;
+            
+            write_offset += kept_size;
+            newest_tick = tick;
+            if (oldest_tick > newest_tick) { oldest_tick = newest_tick; }
+            
+            double capture_time = monotonic_time() - capture_start_time;
+            ticks_captured++;
+            total_kept_bytes += kept_size;
+            total_state_bytes += state_size;
+            total_capture_time += capture_time;
+            max_capture_time = max(max_capture_time, capture_time);
+        }
+        
+        // The function rolls the world back by ticks_amount ticks, as far as the history goes (main thread, while the simulation is idle).
+        // Returns false if there is nothing to roll back to.
+        bool step_back(GameWorld* game_world, int ticks_amount)
+        {
+            if (newest_tick <= oldest_tick || ticks_amount <= 0) { return false; }
+            
+            double restore_start_time = monotonic_time();
+            
+            long tick = max(oldest_tick, newest_tick - ticks_amount);
+            decode(tick);
+            
+            if (!WorldState::restore_state(game_world, state, entities)) { TraceLog(LOG_WARNING, "Rewind: the history doesn't match world %d", game_world -> get_number()); clear(); return false; }
+            
+            // The ticks after it are dropped, the next tick is written after it.
+            ticks_rewound += newest_tick - tick;
+            newest_tick = tick;
+            write_offset = entries[tick % max_ticks].offset + entries[tick % max_ticks].size;
+            
+            last_restore_time = monotonic_time() - restore_start_time;
+            
+            return true;
+        }
+        
+        // Returns how many seconds can be rolled back.
+        float get_seconds() { return (newest_tick > oldest_tick) ? (float) (newest_tick - oldest_tick) / ticks_per_second : 0; }
+        
+        // The function draws how much history there is, and what it costs.
+        void draw_stats(int x, int y)
+        {
+            DrawText(TextFormat("Rewind: %.1f s, %.1f KB/s, capture %.3f ms a tick", get_seconds(), get_bytes_per_second() / 1024, (ticks_captured > 0) ? total_capture_time / ticks_captured * 1000 : 0), x, y, 20, BLACK);
+        }
+        
+        // The function logs the bytes a second of history, and the capture cost of a tick.
+        void report()
+        {
+            if (ticks_captured == 0) { return; }
+            
+            TraceLog(LOG_INFO, "Rewind: %ld ticks captured (%ld keyframes), %.1f KB a second of history (%.0f%% of the whole states), capture %.3f ms a tick (max %.3f ms)", ticks_captured, keyframes_amount, get_bytes_per_second() / 1024, 100 * total_kept_bytes / total_state_bytes, total_capture_time / ticks_captured * 1000, max_capture_time * 1000);
+            TraceLog(LOG_INFO, "Rewind: %d ticks at most in %.1f KB, %ld ticks rewound (last restore %.3f ms)", max_ticks, history_size / 1024.0, ticks_rewound, last_restore_time * 1000);
+        }
+    
+    private:
+    
+        // Returns the bytes a second of history.
+        double get_bytes_per_second() { return (ticks_captured > 0) ? total_kept_bytes / ticks_captured * ticks_per_second : 0; }
+        
+        // The function drops the oldest tick, and the ticks which can't be decoded without it.
+        void drop_oldest()
+        {
+            oldest_tick++;
+            
+            while (oldest_tick <= newest_tick && entries[oldest_tick % max_ticks].keyframe_tick != oldest_tick) { oldest_tick++; }
+        }
+        
+        // The function drops the oldest ticks whose bytes are needed for size bytes at the write offset (wraps to the start of the ring).
+        void make_room(size_t size)
+        {
+            if (write_offset + size > history_size)
+            {
+                // The ticks at the end of the ring are the oldest ones.
+                while (oldest_tick <= newest_tick && entries[oldest_tick % max_ticks].offset >= write_offset) { drop_oldest(); }
+                
+                write_offset = 0;
+            }
+            
+            while (oldest_tick <= newest_tick && entries[oldest_tick % max_ticks].offset < write_offset + size && write_offset < entries[oldest_tick % max_ticks].offset + entries[oldest_tick % max_ticks].size) { drop_oldest(); }
+        }
+        
+        // The function encodes the state against the keyframe, returns the size of the delta: the size of the state, then runs of skipped
+        // (equal) words and xored words (16 bits counts of each).
+        size_t encode_delta(size_t state_size)
+        {
+            const uint32_t* words = (const uint32_t*) state;
+            const uint32_t* keyframe_words = (const uint32_t*) keyframe_state;
+            int words_amount = state_size / sizeof(uint32_t);
+            int keyframe_words_amount = keyframe_size / sizeof(uint32_t);
+            
+            uint32_t size_field = state_size;
+            memcpy(delta, &size_field, sizeof(uint32_t));
+            unsigned char* output = delta + sizeof(uint32_t);
+            
+            int word_index = 0;
+            while (word_index < words_amount)
+            {
+                // The equal words.
+                int skipped_amount = 0;
+                while (word_index < words_amount && skipped_amount < 65535 && get_xored_word(words, keyframe_words, keyframe_words_amount, word_index) == 0) { word_index++; skipped_amount++; }
+                
+                // The differing words, a single equal word doesn't end them.
+                int xored_start = word_index;
+                while (word_index < words_amount && word_index - xored_start < 65535)
+                {
+                    if (get_xored_word(words, keyframe_words, keyframe_words_amount, word_index) == 0 && (word_index + 1 >= words_amount || get_xored_word(words, keyframe_words, keyframe_words_amount, word_index + 1) == 0)) { break; }
+                    word_index++;
+                }
+                
+                uint16_t counts[2] = {(uint16_t) skipped_amount, (uint16_t) (word_index - xored_start)};
+                memcpy(output, counts, sizeof(counts));
+                output += sizeof(counts);
+                
+                for (int i = xored_start; i < word_index; i++)
+                {
+                    uint32_t xored_word = get_xored_word(words, keyframe_words, keyframe_words_amount, i);
+                    memcpy(output, &xored_word, sizeof(uint32_t));
+                    output += sizeof(uint32_t);
+                }
+            }
+            
+            return output - delta;
+        }
+        
+        // The function puts the state of the tick in state (and its keyframe in the keyframe state), returns its size.
+        size_t decode(long tick)
+        {
+            const rewind_entry* entry = &entries[tick % max_ticks];
+            const rewind_entry* keyframe_entry = &entries[entry -> keyframe_tick % max_ticks];
+            
+            memcpy(keyframe_state, history + keyframe_entry -> offset, keyframe_entry -> size);
+            keyframe_size = keyframe_entry -> size;
+            keyframe_tick = entry -> keyframe_tick;
+            
+            if (entry -> keyframe_tick == tick) { memcpy(state, keyframe_state, keyframe_size); return keyframe_size; }
+            
+            const unsigned char* input = history + entry -> offset;
+            uint32_t state_size;
+            memcpy(&state_size, input, sizeof(uint32_t));
+            input += sizeof(uint32_t);
+            
+            // The words beyond the keyframe were xored against 0.
+            memcpy(state, keyframe_state, min((size_t) state_size, keyframe_size));
+            if (state_size > keyframe_size) { memset(state + keyframe_size, 0, state_size - keyframe_size); }
+            
+            uint32_t* words = (uint32_t*) state;
+            int word_index = 0;
+            
+            while (input < history + entry -> offset + entry -> size)
+            {
+                uint16_t counts[2];
+                memcpy(counts, input, sizeof(counts));
+                input += sizeof(counts);
+                
+                word_index += counts[0];
+                
+                for (int i = 0; i < counts[1]; i++, word_index++)
+                {
+                    uint32_t xored_word;
+                    memcpy(&xored_word, input, sizeof(uint32_t));
+                    input += sizeof(uint32_t);
+                    
+                    words[word_index] ^= xored_word;
+                }
+            }
+            
+            return state_size;
+        }
+        
+        // Returns a word of the state xored with the word of the keyframe (0 beyond the keyframe).
+        static uint32_t get_xored_word(const uint32_t* words, const uint32_t* keyframe_words, int keyframe_words_amount, int word_index) { return words[word_index] ^ ((word_index < keyframe_words_amount) ? keyframe_words[word_index] : 0); }
+};
+
+
+class InputRecorder
+{
+    /*
+        Records the input of the played frames to a file, or replays a recording instead of the user, so a run of the game can be played again
+        exactly (a performance spike is reproduced, and profiled again after a change).
+        
+        Notes:
+            - The recording starts with the seed of rand() (it seeds the random numbers generators of the fish networks, see FishNetwork), the world
+              checkpoint of the save and the size of the screen. Raylib seeds rand() from the time in InitWindow(), start() seeds it again after it.
+            - A frame is a fixed record (recorded_frame): the input of the frame (see read_frame_input()), how many ticks it ran, the quality they
+              ran with (see QualityGovernor) and if the world which was selected on the map was loaded. These are the things which differ between
+              runs, the screens change on them exactly as they did.
+            - The mouse and the touch are kept in whole pixels, the recorded run uses them as they are kept (its input is the replayed input).
+            - After every frame, the checksum of the simulated world is kept (the world state of it, see WorldState::capture_state()). A replay compares
+              its own checksums with them, the first frame which differs is where the runs went apart.
+            - While recording or replaying, a world is always played from its start (the world state isn't restored or saved), and a replay doesn't
+              change the progress of the player.
+            - A replay ends with the recording (the game is closed).
+    */
+    
+    private:
+        
+        // The recording.
+        string file_path;
+        FILE* file;
+        int mode;
+        
+        // The frame which is played (open until its world was checked), and how many frames were recorded or replayed.
+        recorded_frame frame;
+        bool is_frame_open;
+        long frames_amount;
+        
+        // The checked states of the world.
+        int max_fish;
+        int max_grid_entries;
+        unsigned char* state;
+        
+        // The frames whose world differed from the recording, and the first of them (-1 if none).
+        long mismatches_amount;
+        long first_mismatch_frame;
+        
+        // The version of the recording.
+        static const uint32_t VERSION = 1;
+    
+    public:
+        
+        // Constructor, max_fish is the max population of the fish networks and max_cells the cells of their grids (see WorldState).
+        InputRecorder(string new_file_path, int new_mode, int new_max_fish, int new_max_cells)
+        {
+            file_path = new_file_path;
+            file = NULL;
+            mode = new_mode;
+            
+            memset(&frame, 0, sizeof(recorded_frame));
+            is_frame_open = false;
+            frames_amount = 0;
+            
+            max_fish = new_max_fish;
+            max_grid_entries = WorldState::get_max_grid_entries(max_fish, new_max_cells);
+            state = NULL;
+            
+            mismatches_amount = 0;
+            first_mismatch_frame = -1;
+        }
+        
+        // The function opens the recording, after the window was created (it seeds rand()). A replay puts the world checkpoint of the recording
+        // in the save. Returns false if there was nothing to replay or the recording can't be written, the game is played as usual.
+        bool start(int* world_checkpoint, int screen_width, int screen_height)
+        {
+            if (mode == RECORDER_OFF) { return true; }
+            
+            recording_header header;
+            memset(&header, 0, sizeof(recording_header));
+            
+            if (mode == RECORDER_RECORD)
+            {
+                file = fopen(file_path.c_str(), "wb");
+                if (file == NULL) { TraceLog(LOG_ERROR, "Input recorder: could not write %s", file_path.c_str()); mode = RECORDER_OFF; return false; }
+                
+                memcpy(header.magic, "FREC", 4);
+                header.version = VERSION;
+                header.seed = (uint32_t) time(NULL);
+                header.world_checkpoint = *world_checkpoint;
+                header.screen_width = screen_width;
+                header.screen_height = screen_height;
+                fwrite(&header, sizeof(recording_header), 1, file);
+            }
+            
+            else
+            {
+                file = fopen(file_path.c_str(), "rb");
+                
+                if (file == NULL || fread(&header, sizeof(recording_header), 1, file) != 1 || memcmp(header.magic, "FREC", 4) != 0 || header.version != VERSION)
+                {
+                    TraceLog(LOG_ERROR, "Input recorder: %s is not a recording", file_path.c_str());
+                    if (file != NULL) { fclose(file); }
+                    file = NULL;
+                    mode = RECORDER_OFF;
+                    
+                    return false;
+                }
+                
+                // The buttons are where they were on the recorded screen only.
+                if (header.screen_width != screen_width || header.screen_height != screen_height) { TraceLog(LOG_WARNING, "Input recorder: recorded on a %dx%d screen, replayed on %dx%d", header.screen_width, header.screen_height, screen_width, screen_height); }
+                
+                *world_checkpoint = header.world_checkpoint;
+            }
+            
+            srand(header.seed);
+            
+            // The padding of the states is never written, it stays zero.
+            size_t max_state_size = WorldState::get_max_size(max_fish, max_grid_entries);
+            state = new unsigned char[max_state_size];
+            memset(state, 0, max_state_size);
+            
+            TraceLog(LOG_INFO, "Input recorder: %s %s (seed %u)", mode == RECORDER_RECORD ? "recording to" : "replaying", file_path.c_str(), header.seed);
+            
+            return true;
+        }
+        
+        // The function starts the next frame, after the world of the previous one was checked (while the simulation is idle). The input which was read
+        // is recorded, or replaced by the replayed input. Returns false when the replay is over.
+        bool next_frame(GameWorld* game_world, frame_input* input)
+        {
+            if (mode == RECORDER_OFF) { return true; }
+            
+            finish_frame(game_world);
+            
+            if (mode == RECORDER_RECORD) { encode(input); }
+            else
+            {
+                recorded_frame next_recorded_frame;
+                if (fread(&next_recorded_frame, sizeof(recorded_frame), 1, file) != 1) { return false; }
+                
+                frame = next_recorded_frame;
+            }
+            
+            decode(input);
+            
+            is_frame_open = true;
+            frames_amount++;
+            
+            return true;
+        }
+        
+        // Returns the ticks the frame runs: recorded, or replayed instead of the ticks of the clock.
+        int sync_ticks(int ticks)
+        {
+            if (mode == RECORDER_REPLAY) { return frame.ticks; }
+            
+            frame.ticks = (uint8_t) ticks;
+            
+            return ticks;
+        }
+        
+        // Returns the quality of the next ticks: recorded, or replayed instead of the quality of the governor.
+        sim_quality sync_quality(sim_quality quality)
+        {
+            if (mode == RECORDER_REPLAY)
+            {
+                quality.offscreen_frame_interval = frame.offscreen_frame_interval;
+                quality.world_population_ratio = frame.world_population_ratio;
+                quality.background_population_ratio = frame.background_population_ratio;
+                
+                return quality;
+            }
+            
+            frame.offscreen_frame_interval = (uint8_t) quality.offscreen_frame_interval;
+            frame.world_population_ratio = quality.world_population_ratio;
+            frame.background_population_ratio = quality.background_population_ratio;
+            
+            return quality;
+        }
+        
+        // Returns if the selected world was loaded on the frame: recorded, or replayed (the caller waits for it, the world is entered on the same frame).
+        bool sync_world_loaded(bool is_loaded)
+        {
+            if (mode == RECORDER_REPLAY) { return (frame.flags & RECORDED_WORLD_LOADED) != 0; }
+            
+            if (is_loaded) { frame.flags |= RECORDED_WORLD_LOADED; }
+            
+            return is_loaded;
+        }
+        
+        // The function checks the world of the last frame and closes the recording.
+        void quit(GameWorld* game_world)
+        {
+            if (mode == RECORDER_OFF) { return; }
+            
+            finish_frame(game_world);
+            
+            fclose(file);
+            file = NULL;
+            
+            report();
+            
+            mode = RECORDER_OFF;
+        }
+        
+        // Getters.
+        bool is_active() { return mode != RECORDER_OFF; }
+        bool is_replaying() { return mode == RECORDER_REPLAY; }
+    
+    private:
+        
+        // The function keeps the checksum of the world after the frame, or compares it with the recorded one.
+        void finish_frame(GameWorld* game_world)
+        {
+            if (!is_frame_open) { return; }
+            is_frame_open = false;
+            
+            size_t state_size = WorldState::capture_state(game_world, state, max_fish, max_grid_entries);
+            uint32_t checksum = Save::checksum(state, state_size);
+            
+            if (mode == RECORDER_RECORD)
+            {
+                frame.checksum = checksum;
+                fwrite(&frame, sizeof(recorded_frame), 1, file);
+                
+                return;
+            }
+            
+            if (checksum == frame.checksum) { return; }
+            
+            if (first_mismatch_frame < 0)
+            {
+                first_mismatch_frame = frames_amount - 1;
+                TraceLog(LOG_WARNING, "Input recorder: the world of frame %ld differs from the recording", first_mismatch_frame);
+            }
+            
+            mismatches_amount++;
+        }
+        
+        // The function keeps the input in the frame (the ticks and the quality are kept as they are set).
+        void encode(frame_input* input)
+        {
+            frame.flags = 0;
+            if (input -> is_right_down) { frame.flags |= RECORDED_RIGHT_DOWN; }
+            if (input -> is_left_down) { frame.flags |= RECORDED_LEFT_DOWN; }
+            if (input -> is_up_down) { frame.flags |= RECORDED_UP_DOWN; }
+            if (input -> is_down_down) { frame.flags |= RECORDED_DOWN_DOWN; }
+            if (input -> is_rewind_down) { frame.flags |= RECORDED_REWIND_DOWN; }
+            if (input -> is_mouse_pressed) { frame.flags |= RECORDED_MOUSE_PRESSED; }
+            if (input -> is_mouse_released) { frame.flags |= RECORDED_MOUSE_RELEASED; }
+            if (input -> is_focused) { frame.flags |= RECORDED_FOCUSED; }
+            if (input -> is_input_event) { frame.flags |= RECORDED_INPUT_EVENT; }
+            
+            frame.gesture = (uint16_t) input -> gesture;
+            frame.touch_count = (uint8_t) min(input -> touch_count, 255);
+            frame.mouse_x = (int16_t) floor(input -> mouse_point.x);
+            frame.mouse_y = (int16_t) floor(input -> mouse_point.y);
+            frame.touch_x = (int16_t) input -> touch_location.x;
+            frame.touch_y = (int16_t) input -> touch_location.y;
+        }
+        
+        // The function puts the input of the frame in the input.
+        void decode(frame_input* input)
+        {
+            input -> is_right_down = (frame.flags & RECORDED_RIGHT_DOWN) != 0;
+            input -> is_left_down = (frame.flags & RECORDED_LEFT_DOWN) != 0;
+            input -> is_up_down = (frame.flags & RECORDED_UP_DOWN) != 0;
+            input -> is_down_down = (frame.flags & RECORDED_DOWN_DOWN) != 0;
+            input -> is_rewind_down = (frame.flags & RECORDED_REWIND_DOWN) != 0;
+            input -> is_mouse_pressed = (frame.flags & RECORDED_MOUSE_PRESSED) != 0;
+            input -> is_mouse_released = (frame.flags & RECORDED_MOUSE_RELEASED) != 0;
+            input -> is_focused = (frame.flags & RECORDED_FOCUSED) != 0;
+            input -> is_input_event = (frame.flags & RECORDED_INPUT_EVENT) != 0;
+            
+            input -> gesture = frame.gesture;
+            input -> touch_count = frame.touch_count;
+            input -> mouse_point = (Vector2) { (float) frame.mouse_x, (float) frame.mouse_y };
+            input -> touch_location = Location(frame.touch_x, frame.touch_y);
+        }
+        
+        // The function logs how many frames were recorded, or how the replay matched the recording.
+        void report()
+        {
+            if (mode == RECORDER_RECORD) { TraceLog(LOG_INFO, "Input recorder: %ld frames recorded (%ld bytes)", frames_amount, (long) (sizeof(recording_header) + frames_amount * sizeof(recorded_frame))); }
+            else if (mismatches_amount == 0) { TraceLog(LOG_INFO, "Input recorder: %ld frames replayed, the world matched the recording on all of them", frames_amount); }
+            else { TraceLog(LOG_WARNING, "Input recorder: %ld frames replayed, the world differed from the recording on %ld of them (first on frame %ld)", frames_amount, mismatches_amount, first_mismatch_frame); }
+        }
+};
+
+
+class WorldSnapshot
+{
+    /*
+        What the ticks of a frame left behind, everything the main thread needs to draw the world.
+        
+        Notes:
+            - Taken by the simulation thread at the end of the ticks, and drawn by the main thread while the simulation already runs the next frame (the main thread doesn't read the live entities).
+            - The gifs are drawn in the order they were taken (the fish network, then my fish).
+    */
+    
+    private:
+    
+        // The gifs.
+        int max_gifs;
+        int gifs_amount;
+        gif_snapshot* gifs;
+        
+        // The camera on the last tick and the target on the one before it, and how far the drawing is between them.
+        Camera2D camera;
+        Vector2 previous_camera_target;
+        float alpha;
+        
+        // The scale of my fish, for the scale widget.
+        float my_fish_scale;
+        
+        // Where the sounds of the ticks are heard from, and how far.
+        Location listener;
+        float hearing_distance;
+        
+        // The amount of entities in every cell of the grid, for debugging.
+        int max_cells;
+        int rows_amount;
+        int columns_amount;
+        int cell_width_pixels;
+        int cell_height_pixels;
+        int* cells_entities_amounts;
+    
+    public:
+    
+        // Constructor.
+        WorldSnapshot(int new_max_gifs, int new_max_cells)
+        {
+            max_gifs = new_max_gifs;
+            gifs_amount = 0;
+            gifs = new gif_snapshot[max_gifs];
+            
+            camera = { 0 };
+            camera.zoom = 1;
+            previous_camera_target = camera.target;
+            alpha = 1;
+            my_fish_scale = 0;
+            listener = Location(0, 0);
+            hearing_distance = -1;
+            
+            max_cells = new_max_cells;
+            rows_amount = 0;
+            columns_amount = 0;
+            cell_width_pixels = 0;
+            cell_height_pixels = 0;
+            cells_entities_amounts = new int[max_cells];
+        }
+        
+        // The function takes the snapshot of the world (simulation thread), my fish is not taken on the background of the menus (NULL on a backdrop).
+        void take(FishNetwork* fish_network, MyFish* my_fish, bool is_my_fish, Grid* grid, Camera2D new_camera, Vector2 new_previous_camera_target, float new_alpha, Location new_listener, float new_hearing_distance)
+        {
+            // The gifs, the fish network and then my fish.
+            gifs_amount = fish_network -> take_snapshots(gifs, max_gifs - 1);
+            if (is_my_fish) { my_fish -> take_snapshot(&gifs[gifs_amount]); gifs_amount++; }
+            
+            camera = new_camera;
+            previous_camera_target = new_previous_camera_target;
+            alpha = new_alpha;
+            my_fish_scale = (my_fish != NULL) ? my_fish -> get_scale() : 0;
+            listener = new_listener;
+            hearing_distance = new_hearing_distance;
+            
+            // The occupied cells.
+            rows_amount = grid -> get_rows_amount();
+            columns_amount = min(grid -> get_columns_amount(), max_cells / max(1, rows_amount));
+            cell_width_pixels = grid -> get_cell_width_pixels();
+            cell_height_pixels = grid -> get_cell_height_pixels();
+            for (int row_index = 0; row_index < rows_amount; row_index++)
+            {
+                for (int col_index = 0; col_index < columns_amount; col_index++)
+                {
+                    cells_entities_amounts[row_index * columns_amount + col_index] = grid -> get_cells()[row_index][col_index] -> get_entities_counter();
+                }
+            }
+        }
+        
+        // The function draws the gifs between the previous tick and the last one (main thread, within the camera mode).
+        void draw_gifs()
+        {
+            for (int i = 0; i < gifs_amount; i++) { gifs[i].gif -> draw_snapshot(gifs[i], alpha); }
+        }
+        
+        // Debug, the function draws the grid (the occupied cells are gray).
+        void draw_grid()
+        {
+            for (int row_index = 0; row_index < rows_amount; row_index++)
+            {
+                for (int col_index = 0; col_index < columns_amount; col_index++)
+                {
+                    if (cells_entities_amounts[row_index * columns_amount + col_index] > 0) { DrawRectangle(col_index * cell_width_pixels, row_index * cell_height_pixels, cell_width_pixels, cell_height_pixels, GRAY); }
+                    else { DrawRectangle(col_index * cell_width_pixels, row_index * cell_height_pixels, cell_width_pixels, cell_height_pixels, LIGHTGRAY); }
+                }
+            }
+        }
+        
+        // Debug, the function draws the collision frames of the gifs.
+        void draw_collision_frames()
+        {
+            for (int i = 0; i < gifs_amount; i++) { DrawRectangle(gifs[i].collision_frame.x, gifs[i].collision_frame.y, gifs[i].collision_frame.width, gifs[i].collision_frame.height, RED); }
+        }
+        
+        // The function sets how far the drawing is between the previous tick and the last one (a still frame of the backdrop).
+        void set_alpha(float new_alpha) { alpha = new_alpha; }
+        
+        // Returns the camera between the previous tick and the last one.
+        Camera2D get_drawn_camera()
+        {
+            Camera2D drawn_camera = camera;
+            drawn_camera.target.x = previous_camera_target.x + (camera.target.x - previous_camera_target.x) * alpha;
+            drawn_camera.target.y = previous_camera_target.y + (camera.target.y - previous_camera_target.y) * alpha;
+            
+            return drawn_camera;
+        }
+        
+        // Getters.
+        float get_my_fish_scale() { return my_fish_scale; }
+        Location get_listener() { return listener; }
+        float get_hearing_distance() { return hearing_distance; }
+};
+
+
+class Simulation
+{
+    /*
+        Runs the ticks of a frame on a thread of its own, while the main thread draws the ticks of the previous frame.
+        
+        Notes:
+            - start() hands the ticks of a frame to the simulation thread, wait() blocks until they are done. Between wait() and the next start() the world belongs to the main thread (the screens changes and resets are made there).
+            - The simulation thread never touches the GPU or the input. The main thread gathers the input before start(), and draws the snapshot of the last finished frame (one snapshot is taken while the other is drawn).
+            - A new screen has nothing to draw yet, its first frame is simulated before it is drawn.
+            - The gifs removed by the ticks are retired, their textures are unloaded by the main thread after the frame was drawn. The victory and defeat are events, the sounds are requests (both lock free queues).
+            - Measures how long the ticks took, and how long the main thread waited for them (the rest was hidden behind the drawing). When not pipelined, the main thread waits right after start().
+            - The phases of the ticks can be measured too (measure_phases(), see MacroBenchmark and FrameProfiler), nothing is measured otherwise.
+    */
+    
+    private:
+    
+        // The simulated world, owned by the main thread between the frames (the world instance, and its objects).
+        GameWorld* game_world;
+        MyFish* my_fish;
+        FishNetwork* fish_network;
+        Grid* grid;
+        Camera2D* camera;
+        Texture2D* world;
+        
+        // The screen, and how far out of the world the fish are released.
+        int screen_width;
+        int screen_height;
+        int x_coord_offset;
+        
+        // If true, the camera doesn't follow my fish (debug camera).
+        bool is_camera_fixed;
+        
+        // Where the camera follows my fish, and the size of the screen in the world.
+        int camera_pos_x;
+        int camera_pos_y;
+        int camera_current_width;
+        int camera_current_height;
+        Vector2 previous_camera_target;
+        
+        // The frame to simulate.
+        int mode;
+        int ticks_amount;
+        sim_input input;
+        float alpha;
+        bool is_new_screen;
+        
+        // The load which is simulated (see QualityGovernor), and how many ticks were simulated.
+        sim_quality quality;
+        long ticks_simulated;
+        
+        // The snapshot which is drawn, and the one which is taken.
+        WorldSnapshot* front_snapshot;
+        WorldSnapshot* back_snapshot;
+        
+        // The events of the ticks, and the removed gifs.
+        EventQueue<int> events;
+        EventQueue<MyGif*> retired_gifs;
+        
+        // Keeps the ticks of the world, so it can be rolled back (NULL without a rewind).
+        Rewind* rewind;
+        
+        // The simulation thread, is_job is true from start() until the ticks are done.
+        pthread_t simulation_thread;
+        bool is_job;
+        bool is_snapshot_taken;
+        bool is_quit;
+        pthread_mutex_t mutex;
+        pthread_cond_t job_started;
+        pthread_cond_t job_finished;
+        
+        // If false, the main thread waits for the ticks before it draws.
+        bool is_pipelined;
+        
+        // Measurements, in seconds (the still frames of the backdrop weren't simulated).
+        long frames_amount;
+        long still_frames_amount;
+        double job_start_time;
+        double last_simulation_time;
+        double last_wait_time;
+        double total_simulation_time;
+        double total_wait_time;
+        double max_simulation_time;
+        
+        // The times of the phases of the ticks of the last frame, in seconds (TickPhase, NULL when they are not measured), and when the current phase started.
+        double* phase_times;
+        double phase_start_time;
+        
+        // The time the current move spent refreshing the grid (see FishNetwork::grid_refresh_time).
+        double grid_refresh_time;
+    
+    public:
+    
+        // Constructor, max_gifs is the max population and my fish.
+        Simulation(GameWorld* new_game_world, int new_screen_width, int new_screen_height, int new_x_coord_offset, bool new_is_camera_fixed, int new_max_gifs, int new_max_cells, bool new_is_pipelined, Rewind* new_rewind) : events(16), retired_gifs(new_max_gifs * 8)
+        {
+            set_world(new_game_world);
+            rewind = new_rewind;
+            
+            screen_width = new_screen_width;
+            screen_height = new_screen_height;
+            x_coord_offset = new_x_coord_offset;
+            is_camera_fixed = new_is_camera_fixed;
+            
+            camera_pos_x = 0;
+            camera_pos_y = 0;
+            camera_current_width = 0;
+            camera_current_height = 0;
+            previous_camera_target = camera -> target;
+            
+            mode = SIM_MODE_BACKGROUND;
+            ticks_amount = 0;
+            alpha = 1;
+            is_new_screen = true;
+            
+            quality.offscreen_frame_interval = 1;
+            quality.world_population_ratio = 1;
+            quality.background_population_ratio = 1;
+            ticks_simulated = 0;
+            
+            front_snapshot = new WorldSnapshot(new_max_gifs, new_max_cells);
+            back_snapshot = new WorldSnapshot(new_max_gifs, new_max_cells);
+            
+            // The gifs are retired to this simulation (every tick can remove the whole population twice, eaten and out of bounds, up to 4 ticks a frame).
+            MyGif::retired_gifs = &retired_gifs;
+            
+            is_pipelined = new_is_pipelined;
+            
+            frames_amount = 0;
+            still_frames_amount = 0;
+            job_start_time = 0;
+            last_simulation_time = 0;
+            last_wait_time = 0;
+            total_simulation_time = 0;
+            total_wait_time = 0;
+            max_simulation_time = 0;
+            phase_times = NULL;
+            phase_start_time = 0;
+            grid_refresh_time = 0;
+            
+            is_job = false;
+            is_snapshot_taken = false;
+            is_quit = false;
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&job_started, NULL);
+            pthread_cond_init(&job_finished, NULL);
+            
+            if (pthread_create(&simulation_thread, NULL, &simulate_thread, (void *)this) != 0) { TraceLog(LOG_ERROR, "Error creating simulation thread"); }
+        }
+        
+        // The function starts the ticks of a frame (SimMode), alpha is how far the drawing of the frame is between its last two ticks.
+        void start(int new_mode, int new_ticks_amount, sim_input new_input, float new_alpha, bool new_is_new_screen)
+        {
+            // A frame of the backdrop without a move only draws further between the last two moves, the simulation thread isn't woken.
+            if (new_mode == SIM_MODE_BACKGROUND && mode == SIM_MODE_BACKGROUND && !new_is_new_screen)
+            {
+                int step_ticks = fish_network -> get_step_ticks();
+                long next_move_tick = ticks_simulated + (step_ticks - ticks_simulated % step_ticks) % step_ticks;
+                
+                if (next_move_tick >= ticks_simulated + new_ticks_amount)
+                {
+                    ticks_simulated += new_ticks_amount;
+                    front_snapshot -> set_alpha(get_drawn_alpha(step_ticks, new_alpha));
+                    still_frames_amount++;
+                    
+                    return;
+                }
+            }
+            
+            pthread_mutex_lock(&mutex);
+            
+            mode = new_mode;
+            ticks_amount = new_ticks_amount;
+            input = new_input;
+            alpha = new_alpha;
+            is_new_screen = new_is_new_screen;
+            
+            is_job = true;
+            pthread_cond_signal(&job_started);
+            
+            pthread_mutex_unlock(&mutex);
+            
+            // Nothing to draw on a new screen yet.
+            if (!is_pipelined || is_new_screen) { wait(); }
+        }
+        
+        // The function waits until the ticks of the frame are done, then their snapshot is the one which is drawn.
+        void wait()
+        {
+            double wait_start_time = monotonic_time();
+            
+            pthread_mutex_lock(&mutex);
+            
+            while (is_job) { pthread_cond_wait(&job_finished, &mutex); }
+            
+            // Already waited for.
+            if (!is_snapshot_taken) { pthread_mutex_unlock(&mutex); return; }
+            
+            is_snapshot_taken = false;
+            
+            pthread_mutex_unlock(&mutex);
+            
+            // Swap the snapshots.
+            WorldSnapshot* drawn_snapshot = front_snapshot;
+            front_snapshot = back_snapshot;
+            back_snapshot = drawn_snapshot;
+            
+            last_wait_time = monotonic_time() - wait_start_time;
+            total_wait_time += last_wait_time;
+            total_simulation_time += last_simulation_time;
+            max_simulation_time = max(max_simulation_time, last_simulation_time);
+            frames_amount++;
+        }
+        
+        // The function takes the next event of the ticks (SimEvent), returns false if there is none (main thread, after wait()).
+        bool pop_event(int* event) { return events.pop(event); }
+        
+        // The function unloads the textures of the removed gifs (main thread, after the frame was drawn).
+        void unload_retired_gifs()
+        {
+            MyGif* gif;
+            while (retired_gifs.pop(&gif)) { gif -> delete_gif(); }
+        }
+        
+        // Returns the snapshot to draw.
+        WorldSnapshot* get_snapshot() { return front_snapshot; }
+        
+        // The function switches the simulated world instance (main thread, between wait() and start(), the next start() should be a new screen).
+        void set_world(GameWorld* new_game_world)
+        {
+            game_world = new_game_world;
+            my_fish = new_game_world -> get_my_fish();
+            fish_network = new_game_world -> get_fish_network();
+            grid = new_game_world -> get_grid();
+            camera = new_game_world -> get_camera();
+            world = new_game_world -> get_texture();
+        }
+        
+        // The function sets the load of the next frames (main thread, between wait() and start()).
+        void set_quality(sim_quality new_quality) { quality = new_quality; }
+        
+        // The function measures the phases of the ticks: their times are added to the array (TickPhase), which the main thread clears between the frames
+        // (NULL to stop measuring).
+        void measure_phases(double* new_phase_times)
+        {
+            phase_times = new_phase_times;
+            grid_refresh_time = 0;
+            FishNetwork::grid_refresh_time = (phase_times != NULL) ? &grid_refresh_time : NULL;
+        }
+        
+        // Returns the name of a phase of the ticks (TickPhase).
+        static const char* get_phase_name(int phase)
+        {
+            const char* names[] = {"my_fish", "eaten", "release", "move", "grid", "collisions", "camera", "frames", "rewind", "snapshot"};
+            
+            return names[phase];
+        }
+        
+        // Returns how long the ticks of the last frame took, in seconds (main thread, after wait()).
+        double get_last_simulation_time() { return last_simulation_time; }
+        
+        // The function stops the simulation thread.
+        void quit()
+        {
+            pthread_mutex_lock(&mutex);
+            is_quit = true;
+            pthread_cond_signal(&job_started);
+            pthread_mutex_unlock(&mutex);
+            
+            pthread_join(simulation_thread, NULL);
+            
+            MyGif::retired_gifs = NULL;
+            FishNetwork::grid_refresh_time = NULL;
+        }
+        
+        // The function draws how long the ticks took, and how long the main thread waited for them.
+        void draw_stats(int x, int y)
+        {
+            DrawText(TextFormat("Simulation: %.1f ms, waited %.1f ms (%s)", last_simulation_time * 1000, last_wait_time * 1000, is_pipelined ? "pipelined" : "serial"), x, y, 20, BLACK);
+        }
+        
+        // The function logs the measurements.
+        void report()
+        {
+            if (frames_amount == 0) { return; }
+            
+            double hidden_percent = (total_simulation_time > 0) ? 100 * max(0.0, 1 - total_wait_time / total_simulation_time) : 0;
+            TraceLog(LOG_INFO, "Simulation (%s): %ld frames, mean %.2f ms a frame (max %.2f ms), the main thread waited %.2f ms a frame (%.0f%% hidden behind the drawing)", is_pipelined ? "pipelined" : "serial", frames_amount, total_simulation_time / frames_amount * 1000, max_simulation_time * 1000, total_wait_time / frames_amount * 1000, hidden_percent);
+            TraceLog(LOG_INFO, "Simulation: %ld still frames of the backdrop (not simulated)", still_frames_amount);
+            
+            if (events.get_dropped_amount() > 0 || retired_gifs.get_dropped_amount() > 0) { TraceLog(LOG_WARNING, "Simulation: %ld events and %ld retired gifs were dropped", events.get_dropped_amount(), retired_gifs.get_dropped_amount()); }
+        }
+    
+    private:
+    
+        // The simulation thread, runs the ticks whenever a frame is started.
+        static void* simulate_thread(void* argument)
+        {
+            Simulation* simulation = (Simulation*) argument;
+            
+            while (true)
+            {
+                pthread_mutex_lock(&simulation -> mutex);
+                
+                while (!simulation -> is_job && !simulation -> is_quit) { pthread_cond_wait(&simulation -> job_started, &simulation -> mutex); }
+                
+                if (simulation -> is_quit) { pthread_mutex_unlock(&simulation -> mutex); break; }
+                
+                pthread_mutex_unlock(&simulation -> mutex);
+                
+                double simulation_start_time = monotonic_time();
+                simulation -> simulate();
+                double simulation_time = monotonic_time() - simulation_start_time;
+                
+                pthread_mutex_lock(&simulation -> mutex);
+                simulation -> last_simulation_time = simulation_time;
+                simulation -> is_job = false;
+                simulation -> is_snapshot_taken = true;
+                pthread_cond_signal(&simulation -> job_finished);
+                pthread_mutex_unlock(&simulation -> mutex);
+            }
+            
+            return NULL;
+        }
+        
+        // The function runs the ticks of the frame, and takes their snapshot.
+        void simulate()
+        {
+            // The population which is kept on this screen.
+            fish_network -> set_population_ratio(mode == SIM_MODE_BACKGROUND ? quality.background_population_ratio : quality.world_population_ratio);
+            
+            // A backdrop moves once in its step ticks.
+            int step_ticks = (mode == SIM_MODE_BACKGROUND) ? fish_network -> get_step_ticks() : 1;
+            
+            if (phase_times != NULL) { phase_start_time = monotonic_time(); }
+            
+            for (int tick = 0; tick < ticks_amount; tick++, ticks_simulated++)
+            {
+                // Nothing happens between the moves of a backdrop.
+                if (ticks_simulated % step_ticks != 0) { continue; }
+                
+                // Save the state of the previous tick, the drawing interpolates from it.
+                if (mode != SIM_MODE_BACKGROUND) { my_fish -> save_previous_location(); }
+                fish_network -> save_previous_locations();
+                previous_camera_target = camera -> target;
+                
+                if (mode == SIM_MODE_BACKGROUND) { tick_background(); }
+                else if (mode == SIM_MODE_ANIMATE) { tick_animate(); }
+                
+                // The game is over, the next ticks belong to the victory or defeat screen.
+                else if (!tick_world()) { break; }
+                
+                // Keep the tick, the world can be rolled back to it.
+                else if (rewind != NULL) { rewind -> capture(game_world); mark_phase(TICK_PHASE_REWIND); }
+            }
+            
+            // A new screen, nothing moved on it yet (don't draw between the states of two screens).
+            if (is_new_screen)
+            {
+                if (my_fish != NULL) { my_fish -> forget_previous_location(); }
+                fish_network -> forget_previous_locations();
+                previous_camera_target = camera -> target;
+            }
+            
+            back_snapshot -> take(fish_network, my_fish, mode != SIM_MODE_BACKGROUND, grid, *camera, previous_camera_target, get_drawn_alpha(step_ticks, alpha), Location(camera_pos_x, camera_pos_y), camera_current_width);
+            mark_phase(TICK_PHASE_SNAPSHOT);
+        }
+        
+        // The function adds the time since the previous phase ended to a phase of the tick, when the phases are measured.
+        void mark_phase(int phase)
+        {
+            if (phase_times == NULL) { return; }
+            
+            double now = monotonic_time();
+            phase_times[phase] += now - phase_start_time;
+            phase_start_time = now;
+        }
+        
+        // The function ends the move of the fish, the time it spent refreshing the grid is a phase of its own.
+        void mark_move_phase()
+        {
+            if (phase_times == NULL) { return; }
+            
+            mark_phase(TICK_PHASE_MOVE);
+            phase_times[TICK_PHASE_MOVE] -= grid_refresh_time;
+            phase_times[TICK_PHASE_GRID] += grid_refresh_time;
+            grid_refresh_time = 0;
+        }
+        
+        // The function returns how far the drawing is between the last two moves, a backdrop moves once in step_ticks ticks (the ticks since its last move, and the part of the next tick).
+        float get_drawn_alpha(int step_ticks, float tick_alpha) { return (((ticks_simulated + step_ticks - 1) % step_ticks) + tick_alpha) / step_ticks; }
+        
+        // The function runs a move of the world in the background of the main menu and map (once in the step ticks of the backdrop).
+        void tick_background()
+        {
+            fish_network -> update_boundaries(-x_coord_offset, world -> width + x_coord_offset, 0, world -> height, true);
+            fish_network -> load_available_fish(false);
+            mark_phase(TICK_PHASE_RELEASE);
+            
+            fish_network -> move();
+            mark_move_phase();
+            
+            fish_network -> set_next_frame(get_view(), quality.offscreen_frame_interval, ticks_simulated);
+            mark_phase(TICK_PHASE_FRAMES);
+        }
+        
+        // The function prepares all the fish to their next gif frame (they stay in place).
+        void tick_animate()
+        {
+            if (my_fish != NULL) { my_fish -> set_next_frame(); }
+            fish_network -> set_next_frame(get_view(), quality.offscreen_frame_interval, ticks_simulated);
+            mark_phase(TICK_PHASE_FRAMES);
+        }
+        
+        // The function runs a tick of the world, returns false if the game is over.
+        bool tick_world()
+        {
+            // ----- Handle world -----
+
+            // - Boundaries Management -
+
+            // Set the relevant boundaries for all the fish (its scaling considartions occurs within the fish update boundaries calls).
+            // Needs to be updated each frame becuase the scaling of the fish can be changed.
+            
+            // Update my fish.
+            int my_fish_current_width = (int) ceil(sqrt(my_fish -> get_scale()) * my_fish -> get_size().width);
+            int my_fish_current_height = (int) ceil(sqrt(my_fish -> get_scale()) * my_fish -> get_size().height);
+            my_fish -> update_boundaries(ceil(my_fish_current_width / 2), world -> width - ceil(my_fish_current_width / 2), ceil(my_fish_current_height / 2), world -> height - ceil(my_fish_current_height / 2), false);
+        
+            // Update the fish network.
+            fish_network -> update_boundaries(-x_coord_offset, world -> width + x_coord_offset, 0, world -> height, true);
+            
+            // True if needs to dispatch the camera due to getting close to the boundaries.
+            bool is_camera_dispatch_x_right = my_fish -> get_location().x + ceil(camera_current_width / 2) >= world -> width;
+            bool is_camera_dispatch_x_left = my_fish -> get_location().x - ceil(camera_current_width / 2) <= 0;
+            bool is_camera_dispatch_x =  is_camera_dispatch_x_left || is_camera_dispatch_x_right;
+            
+            bool is_camera_dispatch_y_top = my_fish -> get_location().y - ceil(camera_current_height / 2) <= 0;
+            bool is_camera_dispatch_y_bottom = my_fish -> get_location().y + ceil(camera_current_height / 2) >= world -> height;
+            bool is_camera_dispatch_y = is_camera_dispatch_y_top || is_camera_dispatch_y_bottom;
+            
+            // - Turbo.
+            my_fish -> update_turbo();
+            
+            // - Stunt.
+            my_fish -> update_stunt();
+            
+            // --- User Input Management ---
+            
+            // Handle arrow keys strokes. They move the fish in the world.
+            if (input.is_right_down) { my_fish -> move_right(1); grid -> refresh_entity(my_fish); }
+            if (input.is_left_down) { my_fish -> move_left(1); grid -> refresh_entity(my_fish); }
+            if (input.is_up_down) { my_fish -> move_up(1); grid -> refresh_entity(my_fish); }
+            if (input.is_down_down) { my_fish -> move_down(1); grid -> refresh_entity(my_fish); }
+            
+            // He is indeed trying to move the fish towards the touch.
+            if (input.gesture != GESTURE_NONE)
+            {
+                // Calculate the touch as a point in the wolrd and not on the screen.
+                Location destination = Location(camera -> target.x - (int)floor(screen_width * (1 / camera -> zoom) / 2) + input.touch_location.x * (1 / camera -> zoom), camera -> target.y - (int)floor(screen_height * (1 / camera -> zoom) / 2) + input.touch_location.y * (1 / camera -> zoom));
+                
+                // Move the fish towards the destination.
+                my_fish -> move_towards(destination);
+                
+                // And update the grid.
+                grid -> refresh_entity(my_fish);
+            }
+            
+            mark_phase(TICK_PHASE_MY_FISH);
+            
+            // --- Entities Calculations ---
+            
+            // Remove all the eaten fish from the previous frame.
+            fish_network -> handle_eaten();
+            mark_phase(TICK_PHASE_EATEN);
+            
+            // Release available fish.
+            fish_network -> load_available_fish(false);
+            mark_phase(TICK_PHASE_RELEASE);
+            
+            // Move all the fish in the fish network.
+            fish_network -> move();
+            mark_move_phase();
+            
+            // --- Handle Collisions ---
+            
+            // A reference to the cells array.
+            Cell*** grid_cells = grid -> get_cells();
+            
+            // The entities array of the current cell.
+            GridEntity** entities_in_cell;
+            int current_cell_entities_amount;
+            
+            // The rectangular frame of the two entities in the loop.
+            Rectangle first_entity_rectangle;
+            Rectangle second_entity_rectangle;    
+
+            // Iterate over the cells of the grid.
+            for (int row_index = 0; row_index < grid -> get_rows_amount(); row_index++)
+            {
+                for (int col_index = 0; col_index < grid -> get_columns_amount(); col_index++)
+                {
+                    // Save the amount of entities in the current cell.
+                    current_cell_entities_amount = grid_cells[row_index][col_index] -> get_entities_counter();
+
+                    // Get the array of entities in the cell.
+                    entities_in_cell = grid_cells[row_index][col_index] -> get_entities();
+                    
+                    // Iterate over all the possible entities pairs in the current cell.
+                    for (int first_entity_index = 0; first_entity_index < current_cell_entities_amount; first_entity_index++)
+                    {
+                        for (int second_entity_index = first_entity_index + 1; second_entity_index < current_cell_entities_amount; second_entity_index++)
+                        {
+                            // Get the rectangle frame of the two entities.
+                            first_entity_rectangle = entities_in_cell[first_entity_index] -> get_updated_collision_frame();
+                            second_entity_rectangle = entities_in_cell[second_entity_index] -> get_updated_collision_frame();
+                            
+                            // Check if the two current entities are overlapping.
+                            if (CheckCollisionRecs(first_entity_rectangle, second_entity_rectangle))
+                            {
+                                // Tell the first entity it collided with the second entity.
+                                entities_in_cell[first_entity_index] -> handle_collision(entities_in_cell[second_entity_index]);
+                            }
+                        }
+                    }
+                }
+            }
+            
+            mark_phase(TICK_PHASE_COLLISIONS);
+
+            // --- Camera ---
+            
+            // Calculate the width and height of the camera screen (changed due to camera.zoom).
+            camera_current_width = (1 / camera -> zoom) * screen_width;
+            camera_current_height = (1 / camera -> zoom) * screen_height;
+            
+            // Camera follows my fish movement.
+            
+            // If the fish is not close to the boundaries.
+            if (!is_camera_dispatch_x) { camera_pos_x = max((int)ceil(camera_current_width / 2), min(my_fish -> get_location().x, (int)(world -> width - ceil(camera_current_width / 2)))); }
+            
+            if (!is_camera_dispatch_y) { camera_pos_y = max((int)ceil(camera_current_height / 2), min(my_fish -> get_location().y, (int)(world -> height - ceil(camera_current_height / 2)))); }
+
+            // Update the camera position.
+            if (!is_camera_fixed) { camera -> target = (Vector2){ (float) camera_pos_x, (float) camera_pos_y }; }
+            
+            mark_phase(TICK_PHASE_CAMERA);
+
+            // --- Prepare Gifs for drawing ---
+            
+            // Prepare all the fish to their next gif frame.
+            my_fish -> set_next_frame();        
+            fish_network -> set_next_frame(get_view(), quality.offscreen_frame_interval, ticks_simulated);
+            
+            // Check if the game is over.
+            bool is_game_over = false;
+            if (!my_fish -> is_alive()) { events.push(SIM_EVENT_DEFEAT); is_game_over = true; }
+            
+            // Check if the fish has reached the required size.
+            if (my_fish -> is_victory()) { events.push(SIM_EVENT_VICTORY); is_game_over = true; }
+            
+            mark_phase(TICK_PHASE_FRAMES);
+            
+            return !is_game_over;
+        }
+        
+        // Returns the part of the world which is on the screen.
+        Rectangle get_view()
+        {
+            Rectangle view = {camera -> target.x - camera -> offset.x / camera -> zoom, camera -> target.y - camera -> offset.y / camera -> zoom, screen_width / camera -> zoom, screen_height / camera -> zoom};
+            
+            return view;
+        }
+};
+
+
+class FrameProfiler
+{
+    /*
+        Measures where the time of every frame goes, phase by phase, and shows it on an overlay of rolling graphs (toggled by F3).
+        
+        Notes:
+            - The phases of the main loop are marked in order, like the quality governor marks them (begin_phase()): the input, the update of the screens,
+              the drawing, the wait for the display (EndDrawing()) and the wait for the simulation.
+            - The phases of the ticks (TickPhase) run on the simulation thread, they are measured there (see Simulation::measure_phases()) and added to the
+              frame after its ticks were waited for. The ticks of a pipelined frame run while it is drawn, they are not a part of its total.
+            - The last frames are kept in a ring, in milliseconds. They are written as csv (a frame a line) when the profiler is turned off, and when the game
+              is closed.
+            - Disabled, nothing is measured: the marks return right away, and the simulation measures nothing.
+    */
+    
+    private:
+        
+        // If the frames are measured.
+        bool is_enabled;
+        
+        // The phases of the current frame (ProfilePhase, then TickPhase), and when the current one started.
+        int columns_amount;
+        int phase;
+        double phase_start_time;
+        double* frame_times;
+        
+        // The times of the ticks of the frame, added by the simulation thread (seconds, TickPhase).
+        double* tick_phases_times;
+        
+        // The phases of the last frames (milliseconds), as a ring.
+        int max_history;
+        int history_amount;
+        int history_index;
+        float* history;
+        long frames_amount;
+        
+        // Where the csv is written.
+        string csv_path;
+        
+        // How many of the last frames the graphs show, and their size (pixels).
+        static const int GRAPH_FRAMES = 240;
+        static const int GRAPH_HEIGHT = 20;
+    
+    public:
+        
+        // Constructor.
+        FrameProfiler(int new_max_history, string new_csv_path)
+        {
+            is_enabled = false;
+            
+            columns_amount = PROFILE_PHASES_AMOUNT + TICK_PHASES_AMOUNT;
+            phase = PROFILE_PHASE_UPDATE;
+            phase_start_time = 0;
+            frame_times = new double[columns_amount];
+            tick_phases_times = new double[TICK_PHASES_AMOUNT];
+            for (int i = 0; i < columns_amount; i++) { frame_times[i] = 0; }
+            for (int i = 0; i < TICK_PHASES_AMOUNT; i++) { tick_phases_times[i] = 0; }
+            
+            // Create the frames ring.
+            max_history = new_max_history;
+            history_amount = 0;
+            history_index = 0;
+            history = new float[max_history * columns_amount];
+            frames_amount = 0;
+            
+            csv_path = new_csv_path;
+        }
+        
+        // The function starts measuring a frame, from the update of its assets.
+        void begin_frame()
         {
-            entities_counter = 0;
+            if (!is_enabled) { return; }
+            
+            for (int i = 0; i < columns_amount; i++) { frame_times[i] = 0; }
+            
+            phase = PROFILE_PHASE_UPDATE;
+            phase_start_time = monotonic_time();
         }
         
-        // Add new entity to the cell.
-        void add_entity(GridEntity* new_entity)
+        // The function ends the current phase of the frame, and starts the next one (ProfilePhase).
+        void begin_phase(int new_phase)
         {
-            // Add the entity to the cell.
-            entities[entities_counter] = new_entity;
-            entities_counter += 1;
-
-            // Add the cell to the entity.
-            new_entity -> cells_within[new_entity -> get_amount_of_cells_within()] = this;
-            new_entity -> cell_within_was_added();
+            if (!is_enabled) { return; }
+            
+            double current_time = monotonic_time();
+            
+            frame_times[phase] += current_time - phase_start_time;
+            phase = new_phase;
+            phase_start_time = current_time;
         }
         
-        // Remove received entity from the cell.
-        void remove_entity(GridEntity* entity_to_remove)
+        // The function ends the frame, after its ticks were waited for (their phases are taken, and cleared for the next frame), and keeps it in the ring.
+        void end_frame()
         {
-            // Find the received entity in the entities array.
-            for (int i = 0; i < entities_counter; i++)
+            if (!is_enabled) { return; }
+            
+            begin_phase(phase);
+            
+            for (int i = 0; i < TICK_PHASES_AMOUNT; i++)
             {
-                // Check if the current entity is the entity to remove.
-                if (entity_to_remove == entities[i])
+                frame_times[PROFILE_PHASES_AMOUNT + i] = tick_phases_times[i];
+                tick_phases_times[i] = 0;
+            }
+            
+            float* row = &history[history_index * columns_amount];
+            for (int i = 0; i < columns_amount; i++) { row[i] = (float) (frame_times[i] * 1000); }
+            
+            history_index = (history_index + 1) % max_history;
+            history_amount = min(history_amount + 1, max_history);
+            frames_amount++;
+        }
+        
+        // The function turns the profiler on or off (between the frames, while the simulation is idle). Turned off, the measured frames are written as csv.
+        void toggle()
+        {
+            is_enabled = !is_enabled;
+            
+            if (is_enabled) { history_amount = 0; history_index = 0; }
+            else { save_csv(); }
+            
+            for (int i = 0; i < TICK_PHASES_AMOUNT; i++) { tick_phases_times[i] = 0; }
+            
+            TraceLog(LOG_INFO, "Frame profiler: %s", is_enabled ? "on" : "off");
+        }
+        
+        // Returns the array the simulation adds the phases of the ticks to (NULL when disabled, nothing is measured, see Simulation::measure_phases()).
+        double* get_tick_phases_times() { return is_enabled ? tick_phases_times : NULL; }
+        
+        // Getters.
+        bool get_is_enabled() { return is_enabled; }
+        
+        // Returns the name of a column of the frames (ProfilePhase, then TickPhase).
+        static const char* get_column_name(int column)
+        {
+            const char* names[] = {"input", "update", "draw", "display", "simulation_wait"};
+            
+            if (column < PROFILE_PHASES_AMOUNT) { return names[column]; }
+            
+            return Simulation::get_phase_name(column - PROFILE_PHASES_AMOUNT);
+        }
+        
+        // The function draws a row for every phase: its last, mean and max times over the graphed frames, and their rolling graph (the frame cost first,
+        // without the wait for the display).
+        void draw_overlay(int x, int y)
+        {
+            if (!is_enabled || history_amount == 0) { return; }
+            
+            int frames_shown = min(history_amount, GRAPH_FRAMES);
+            int row_height = GRAPH_HEIGHT + 4;
+            int text_width = 330;
+            
+            DrawRectangle(x - 5, y - 5, text_width + GRAPH_FRAMES + 10, (columns_amount + 1) * row_height + 10, Fade(RAYWHITE, 0.85));
+            
+            for (int column = -1; column < columns_amount; column++)
+            {
+                int row_y = y + (column + 1) * row_height;
+                
+                double last_time = 0;
+                double total_time = 0;
+                double max_time = 0.001;
+                
+                for (int i = 0; i < frames_shown; i++)
                 {
-                    // Overide the current entity with the entity at the end of the array.
-                    entities[i] = entities[entities_counter - 1];
-                    
-                    // Free the entity at the end of the array.
-                    entities_counter -= 1;
+                    double time = get_time(i, column);
                     
-                    // That's it.
-                    break;
+                    if (i == 0) { last_time = time; }
+                    total_time += time;
+                    max_time = max(max_time, time);
+                }
+                
+                Color color = (column < 0) ? BLACK : (column < PROFILE_PHASES_AMOUNT ? DARKBLUE : MAROON);
+                DrawText(TextFormat("%-16s %6.2f %6.2f %6.2f", column < 0 ? "frame" : get_column_name(column), last_time, total_time / frames_shown, max_time), x, row_y + 2, 16, color);
+                
+                // The newest frame on the right, every frame a bar scaled to the max time.
+                for (int i = 0; i < frames_shown; i++)
+                {
+                    int bar_height = (int) ceil(get_time(i, column) / max_time * GRAPH_HEIGHT);
+                    DrawRectangle(x + text_width + GRAPH_FRAMES - 1 - i, row_y + GRAPH_HEIGHT - bar_height, 1, bar_height, color);
                 }
             }
         }
         
-        // The function returns the current amount of entities in the cell.
-        int get_entities_counter() { return entities_counter; }
+        // The function writes the measured frames as csv, the oldest first (milliseconds, a column a phase).
+        void save_csv()
+        {
+            if (history_amount == 0) { return; }
+            
+            FILE* csv_file = fopen(csv_path.c_str(), "w");
+            if (csv_file == NULL) { TraceLog(LOG_WARNING, "Frame profiler: could not write %s", csv_path.c_str()); return; }
+            
+            fprintf(csv_file, "frame");
+            for (int column = 0; column < columns_amount; column++) { fprintf(csv_file, ",%s_ms", get_column_name(column)); }
+            fprintf(csv_file, "\n");
+            
+            for (int i = history_amount - 1; i >= 0; i--)
+            {
+                float* row = get_row(i);
+                
+                fprintf(csv_file, "%ld", frames_amount - 1 - i);
+                for (int column = 0; column < columns_amount; column++) { fprintf(csv_file, ",%.4f", row[column]); }
+                fprintf(csv_file, "\n");
+            }
+            
+            fclose(csv_file);
+            
+            TraceLog(LOG_INFO, "Frame profiler: %d frames were written to %s", history_amount, csv_path.c_str());
+        }
         
-        // The function returns all the entities in the cell.
-        GridEntity** get_entities() { return entities; }
+        // The function writes the measured frames when the game is closed while profiling.
+        void quit() { if (is_enabled) { save_csv(); } }
+    
+    private:
+        
+        // Returns a frame of the ring, back frames before the last one.
+        float* get_row(int back) { return &history[((history_index - 1 - back + max_history) % max_history) * columns_amount]; }
+        
+        // Returns the time of a column of a frame (milliseconds), the column -1 is the cost of the frame (its main phases without the display).
+        double get_time(int back, int column)
+        {
+            float* row = get_row(back);
+            
+            if (column >= 0) { return row[column]; }
+            
+            return row[PROFILE_PHASE_INPUT] + row[PROFILE_PHASE_UPDATE] + row[PROFILE_PHASE_DRAW] + row[PROFILE_PHASE_SIMULATION_WAIT];
+        }
 };
 
 
-class Grid
+class MusicPlayer
 {
     /*
-        The grid reduces significantly the amount of collision checks in the world.
+        Plays the background music as streams, on a thread of its own.
+        
+        Notes:
+            - A track is decoded a little at a time into a small ring buffer (the two halves of its audio stream), instead of decoding the whole mp3 into a sound.
+            - All the raylib music calls are made by the player thread, the other threads only request the track to play.
+            - The tracks loop gaplessly (the decoder wraps to the start within the same buffer), and changing a track crossfades from the previous one.
+            - A track is opened the first time it is played, and stays open (an open track is only its decoder and buffer).
+            - The mutex only guards the requests. The player thread takes them and opens, decodes and fades the tracks without it, so a play() never
+              waits for a track being opened from the disk.
     */
     
     private:
+    
+        // The tracks.
+        int max_tracks;
+        int tracks_amount;
+        const char** tracks_paths;
+        Music* tracks;
+        bool* is_track_loaded;
         
-        // The maximum amount of entities a cell can contain.
-        int cell_maximum_amount_of_entities;
+        // The size of each of the two halves of the ring buffer of every track, in frames.
+        int buffer_frames;
         
-        // The amount of columns in the grid.
-        int columns_amount;
+        // How long the crossfade between tracks takes, in seconds.
+        float crossfade_duration;
         
-        // The amount of rows in the grid.
-        int rows_amount;
+        // The track which was requested to play (-1 for none), set by any thread (under the mutex, with is_quit and the added tracks).
+        int requested_track;
         
-        // The width of the grid in pixels.
-        int width_pixels;
+        // The playing track, and the one fading out (-1 for none), used by the player thread only.
+        int current_track;
+        int fading_track;
+        double fade_start_time;
         
-        // The height of the grid in pixels.
-        int height_pixels;
+        // The player thread.
+        pthread_t player_thread;
+        bool is_quit;
+        pthread_mutex_t mutex;
+    
+    public:
+    
+        // Constructor, the audio device must be initialized.
+        MusicPlayer(int new_max_tracks, int new_buffer_frames, float new_crossfade_duration)
+        {
+            // Create the tracks arrays.
+            max_tracks = new_max_tracks;
+            tracks_amount = 0;
+            tracks_paths = new const char*[max_tracks];
+            tracks = new Music[max_tracks];
+            is_track_loaded = new bool[max_tracks];
+            
+            buffer_frames = new_buffer_frames;
+            crossfade_duration = new_crossfade_duration;
+            
+            // Nothing is playing.
+            requested_track = -1;
+            current_track = -1;
+            fading_track = -1;
+            fade_start_time = 0;
+            
+            is_quit = false;
+            pthread_mutex_init(&mutex, NULL);
+            
+            if (pthread_create(&player_thread, NULL, &play_thread, (void *)this) != 0) { TraceLog(LOG_ERROR, "Error creating music thread"); }
+        }
         
-        // The width of each cell in pixels.
-        int cell_width_pixels;
+        // The function adds a track, returns its number for play().
+        int add_track(const char* path)
+        {
+            if (tracks_amount >= max_tracks) { TraceLog(LOG_ERROR, "Too many music tracks, %s is skipped", path); return -1; }
+            
+            pthread_mutex_lock(&mutex);
+            
+            tracks_paths[tracks_amount] = path;
+            is_track_loaded[tracks_amount] = false;
+            tracks_amount++;
+            
+            pthread_mutex_unlock(&mutex);
+            
+            return tracks_amount - 1;
+        }
         
-        // The height of each cell in pixels.
-        int cell_height_pixels;
+        // The function crossfades to the track (keeps playing if it is already the current track).
+        void play(int track)
+        {
+            pthread_mutex_lock(&mutex);
+            requested_track = track;
+            pthread_mutex_unlock(&mutex);
+        }
         
-        // An 2d matrix with the cells of the grid, as pointers.
-        Cell*** cells;
-      
+        // The function stops the player thread and closes the tracks.
+        void quit()
+        {
+            pthread_mutex_lock(&mutex);
+            is_quit = true;
+            pthread_mutex_unlock(&mutex);
+            
+            pthread_join(player_thread, NULL);
+            
+            for (int i = 0; i < tracks_amount; i++)
+            {
+                if (is_track_loaded[i]) { UnloadMusicStream(tracks[i]); is_track_loaded[i] = false; }
+            }
+        }
+    
+    private:
+    
+        // The function opens a track, if it is not open yet.
+        void load_track(int track)
+        {
+            if (is_track_loaded[track]) { return; }
+            
+            // The size of the stream buffer is taken from the default when the stream is created.
+            SetAudioStreamBufferSizeDefault(buffer_frames);
+            tracks[track] = LoadMusicStream(tracks_paths[track]);
+            tracks[track].looping = true;
+            is_track_loaded[track] = true;
+        }
+        
+        // The function starts playing the requested track, the current one starts fading out.
+        void start_track(int track)
+        {
+            // Going back to the track which is fading out, it keeps playing from where it is and fades in from its volume.
+            if (track != -1 && track == fading_track)
+            {
+                fading_track = current_track;
+                current_track = track;
+                fade_start_time = monotonic_time() - (1 - get_fade()) * crossfade_duration;
+                return;
+            }
+            
+            // A track that didn't finish fading out yet is simply stopped.
+            if (fading_track != -1) { StopMusicStream(tracks[fading_track]); }
+            
+            fading_track = current_track;
+            current_track = track;
+            fade_start_time = monotonic_time();
+            
+            if (current_track == -1) { return; }
+            
+            load_track(current_track);
+            SetMusicVolume(tracks[current_track], 0);
+            PlayMusicStream(tracks[current_track]);
+        }
+        
+        // The function returns how far the crossfade is, from 0 to 1.
+        float get_fade()
+        {
+            if (crossfade_duration <= 0) { return 1; }
+            
+            return (float) min(1.0, (monotonic_time() - fade_start_time) / crossfade_duration);
+        }
+        
+        // The function updates the crossfade volumes.
+        void update_volumes()
+        {
+            float fade = get_fade();
+            
+            if (current_track != -1) { SetMusicVolume(tracks[current_track], fade); }
+            
+            if (fading_track != -1)
+            {
+                SetMusicVolume(tracks[fading_track], 1 - fade);
+                
+                // Faded out.
+                if (fade >= 1) { StopMusicStream(tracks[fading_track]); fading_track = -1; }
+            }
+        }
+        
+        // The player thread function, keeps the buffers of the playing tracks filled.
+        static void* play_thread(void* player_argument)
+        {
+            // Cast the argument to the player.
+            MusicPlayer* player = (MusicPlayer*) player_argument;
+            
+            while (true)
+            {
+                // Take the requests (the tracks and the streams belong to this thread, they are opened and decoded without the mutex).
+                pthread_mutex_lock(&player -> mutex);
+                bool is_quit = player -> is_quit;
+                int requested_track = player -> requested_track;
+                pthread_mutex_unlock(&player -> mutex);
+                
+                if (is_quit) { return NULL; }
+                
+                // A new track was requested.
+                if (requested_track != player -> current_track) { player -> start_track(requested_track); }
+                
+                player -> update_volumes();
+                
+                // Decode into the parts of the buffers which were already played.
+                if (player -> current_track != -1) { UpdateMusicStream(player -> tracks[player -> current_track]); }
+                if (player -> fading_track != -1) { UpdateMusicStream(player -> tracks[player -> fading_track]); }
+                
+                // Half of the buffer lasts much longer than this.
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+};
+
+
+class WorkerPool
+{
+    /*
+        A fixed amount of worker threads, which run the submitted tasks in order of submission.
+        
+        Notes:
+            - The tasks are plain functions with an argument, like the pthread functions.
+            - The pool lives for the whole game, so work can be handed to it after the loading screen too.
+    */
+    
+    private:
+    
+        // A task waiting to run.
+        struct pool_task
+        {
+            void* (*function)(void*);
+            void* argument;
+        };
+    
+        // The worker threads.
+        int workers_amount;
+        pthread_t* workers;
+        
+        // The waiting tasks, a circular array.
+        int max_tasks;
+        int first_task;
+        int tasks_amount;
+        pool_task* tasks;
+        
+        // If true, the workers exit once there are no more tasks.
+        bool is_quit;
+        
+        // Guards the tasks array, the workers sleep on the condition when there is nothing to do.
+        pthread_mutex_t mutex;
+        pthread_cond_t task_added;
+        pthread_cond_t task_removed;
+    
     public:
     
-        // Counstructor.
-        Grid(int new_columns_amount, int new_rows_amount, int new_cell_maximum_amount_of_entities, int new_width_pixels, int new_height_pixels)
+        // Constructor.
+        WorkerPool(int new_workers_amount, int new_max_tasks)
+        {
+            // Create the tasks array.
+            max_tasks = new_max_tasks;
+            first_task = 0;
+            tasks_amount = 0;
+            tasks = new pool_task[max_tasks];
+            is_quit = false;
+            
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&task_added, NULL);
+            pthread_cond_init(&task_removed, NULL);
+            
+            // Start the workers.
+            workers_amount = 0;
+            workers = new pthread_t[new_workers_amount];
+            
+            for (int i = 0; i < new_workers_amount; i++)
+            {
+                if (pthread_create(&workers[workers_amount], NULL, &work, (void *)this) != 0) { TraceLog(LOG_ERROR, "Error creating worker thread"); break; }
+                workers_amount++;
+            }
+        }
+        
+        // The function returns the amount of cores, the default amount of workers.
+        static int get_cores_amount()
+        {
+            int cores_amount = (int) std::thread::hardware_concurrency();
+            
+            // Unknown.
+            if (cores_amount <= 0) { cores_amount = 2; }
+            
+            return cores_amount;
+        }
+        
+        // The function adds a task to the pool, waits if the tasks array is full.
+        void submit(void* (*function)(void*), void* argument)
+        {
+            pthread_mutex_lock(&mutex);
+            
+            while (tasks_amount == max_tasks) { pthread_cond_wait(&task_removed, &mutex); }
+            
+            // Add the task at the end of the circular array.
+            tasks[(first_task + tasks_amount) % max_tasks].function = function;
+            tasks[(first_task + tasks_amount) % max_tasks].argument = argument;
+            tasks_amount++;
+            
+            pthread_cond_signal(&task_added);
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        // The function adds a task to the pool, only if there is room (for optional work, a worker must never wait on the pool). Returns true if added.
+        bool try_submit(void* (*function)(void*), void* argument)
+        {
+            pthread_mutex_lock(&mutex);
+            
+            if (tasks_amount == max_tasks) { pthread_mutex_unlock(&mutex); return false; }
+            
+            tasks[(first_task + tasks_amount) % max_tasks].function = function;
+            tasks[(first_task + tasks_amount) % max_tasks].argument = argument;
+            tasks_amount++;
+            
+            pthread_cond_signal(&task_added);
+            pthread_mutex_unlock(&mutex);
+            
+            return true;
+        }
+        
+        // The function finishes the waiting tasks and stops the workers.
+        void quit()
+        {
+            pthread_mutex_lock(&mutex);
+            is_quit = true;
+            pthread_cond_broadcast(&task_added);
+            pthread_mutex_unlock(&mutex);
+            
+            for (int i = 0; i < workers_amount; i++) { pthread_join(workers[i], NULL); }
+            workers_amount = 0;
+        }
+        
+        int get_workers_amount() { return workers_amount; }
+    
+    private:
+    
+        // The worker thread function.
+        static void* work(void* pool_argument)
+        {
+            // Cast the argument to the pool.
+            WorkerPool* pool = (WorkerPool*) pool_argument;
+            pool_task task;
+            
+            while (true)
+            {
+                pthread_mutex_lock(&pool -> mutex);
+                
+                // Sleep until there is something to do.
+                while (pool -> tasks_amount == 0 && !pool -> is_quit) { pthread_cond_wait(&pool -> task_added, &pool -> mutex); }
+                
+                // Quit only when all the tasks are done.
+                if (pool -> tasks_amount == 0) { pthread_mutex_unlock(&pool -> mutex); return NULL; }
+                
+                // Take the first task.
+                task = pool -> tasks[pool -> first_task];
+                pool -> first_task = (pool -> first_task + 1) % pool -> max_tasks;
+                pool -> tasks_amount--;
+                
+                pthread_cond_signal(&pool -> task_removed);
+                pthread_mutex_unlock(&pool -> mutex);
+                
+                task.function(task.argument);
+            }
+        }
+};
+
+
+class GifDecoder
+{
+    /*
+        A gif decoder made for the game animations, replaces LoadImageAnim.
+        
+        Notes:
+            - All the frames descriptors are parsed first, then the frames are LZW decoded in parallel (on the worker pool), and finally
+              composed one after the other straight into the returned image.
+            - The returned image has the same layout as LoadImageAnim: all the frames one below the other, RGBA, allocated once.
+            - Anything it can't decode is handed to LoadImageAnim.
+    */
+    
+    private:
+    
+        // The frames which are decoded together, shared with the pool tasks which help decoding them.
+        struct decode_context
         {
-            // Set the amount of rows and columns.
-            columns_amount = new_columns_amount;
-            rows_amount = new_rows_amount;
+            const unsigned char* data;
+            size_t size;
+            gif_frame* frames;
+            int frames_amount;
             
-            // Set the width of the grid in pixels.
-            width_pixels = new_width_pixels;
-            height_pixels = new_height_pixels;
+            // The next frame to take, and how many were decoded.
+            std::atomic<int> next_frame;
+            std::atomic<int> decoded_frames;
             
-            // Calculate and save the amount of pixels each cell covers.
-            cell_width_pixels = width_pixels / columns_amount;
-            cell_height_pixels = height_pixels / rows_amount;
+            // The decoding thread and the helping tasks, the last one to finish deletes the context.
+            std::atomic<int> references;
+        };
+    
+    public:
+    
+        // The function loads a gif file. Uses the pool to decode the frames in parallel, if not NULL.
+        static Image load(const char* path, int* frames_amount, WorkerPool* pool)
+        {
+            unsigned int size = 0;
+            unsigned char* data = LoadFileData(path, &size);
             
-            // Save the maximum amount of entites a single cell can contain.
-            cell_maximum_amount_of_entities = new_cell_maximum_amount_of_entities;
-              
-            // Declare the cells matrix.
-            cells = new Cell**[rows_amount];
-            for(int i = 0; i < rows_amount; i++)
-                cells[i] = new Cell*[columns_amount];
+            Image image = decode(data, size, frames_amount, pool);
+            if (data != NULL) { UnloadFileData(data); }
             
-            // Create the cells of the grid.
-            for (int row_index = 0; row_index < rows_amount; row_index++)
-            {
-                for (int column_index = 0; column_index < columns_amount; column_index++)
-                {
-                    cells[row_index][column_index] = new Cell(cell_maximum_amount_of_entities, new GridEntity*[cell_maximum_amount_of_entities]);
-                }
-            }
+            // Not a gif this decoder knows, let raylib try.
+            if (image.data == NULL) { image = LoadImageAnim(path, frames_amount); }
+            
+            return image;
         }
         
-        // Default Constructor.
-        Grid()
+        // The function decodes a gif from the memory. Returns an image without data if it can't.
+        static Image decode(const unsigned char* data, size_t size, int* frames_amount, WorkerPool* pool)
         {
-            cell_maximum_amount_of_entities = 0;
-            columns_amount = 0;
-            rows_amount = 0;
-            width_pixels = 0;
-            height_pixels = 0;
-            cell_width_pixels = 0;
-            cell_height_pixels = 0;
+            Image image = { NULL, 0, 0, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+            int canvas_width = 0, canvas_height = 0;
+            
+            if (data == NULL) { return image; }
+            
+            // Count the frames, then describe them.
+            int amount = parse(data, size, NULL, 0, &canvas_width, &canvas_height);
+            if (amount <= 0) { return image; }
+            
+            decode_context* context = new decode_context;
+            context -> data = data;
+            context -> size = size;
+            context -> frames = new gif_frame[amount];
+            context -> frames_amount = parse(data, size, context -> frames, amount, &canvas_width, &canvas_height);
+            context -> next_frame.store(0);
+            context -> decoded_frames.store(0);
+            context -> references.store(1);
+            
+            // Let idle workers help with the frames (there is always one less than the frames, this thread decodes too).
+            int helpers_amount = 0;
+            if (pool != NULL) { helpers_amount = min(pool -> get_workers_amount(), context -> frames_amount) - 1; }
+            
+            for (int i = 0; i < helpers_amount; i++)
+            {
+                context -> references++;
+                if (!pool -> try_submit(&decode_frames_task, (void *)context)) { context -> references--; break; }
+            }
+            
+            // Decode frames until all were taken, then wait for the ones the helpers are still decoding.
+            decode_frames(context);
+            while (context -> decoded_frames.load() < context -> frames_amount) { std::this_thread::yield(); }
+            
+            // Compose the frames into the image.
+            image.width = canvas_width;
+            image.height = canvas_height;
+            image.data = MemAlloc((unsigned int) canvas_width * canvas_height * 4 * context -> frames_amount);
+            *frames_amount = context -> frames_amount;
+            
+            compose(context -> frames, context -> frames_amount, (unsigned char*) image.data, canvas_width, canvas_height);
+            
+            // Free the frames. The helpers which didn't start yet only touch the context.
+            for (int i = 0; i < context -> frames_amount; i++) { delete[] context -> frames[i].indexes; }
+            delete[] context -> frames;
+            context -> frames = NULL;
+            
+            release(context);
+            
+            return image;
         }
+    
+    private:
+    
+        // Reads a little endian 16 bit number.
+        static int read_16(const unsigned char* data) { return data[0] | (data[1] << 8); }
         
-        // Reset the grid.
-        void reset() 
+        // The function skips data sub-blocks, returns false if the file ended before the terminator.
+        static bool skip_sub_blocks(const unsigned char* data, size_t size, size_t* position)
         {
-            // Iterate over the cells in the grid.
-            for (int row_index = 0; row_index < rows_amount; row_index++)
-                for (int col_index = 0; col_index < columns_amount; col_index++)
-                    cells[row_index][col_index] -> reset();
+            while (*position < size)
+            {
+                int block_size = data[*position];
+                *position += block_size + 1;
+                
+                if (block_size == 0) { return true; }
+            }
+            
+            return false;
         }
         
-        // The function receives an entity and refresh it location on the grid.
-        void refresh_entity(GridEntity* entity_to_refresh)
+        // The function parses the frames descriptors into the frames array (only counts them if NULL). Returns the frames amount, or -1 if invalid.
+        static int parse(const unsigned char* data, size_t size, gif_frame* frames, int max_frames, int* canvas_width, int* canvas_height)
         {
-            // Remove it from the grid.
-            remove_entity(entity_to_refresh);
+            // The header and the logical screen descriptor.
+            if (size < 13 || memcmp(data, "GIF8", 4) != 0) { return -1; }
             
-            // Add it to the grid.
-            add_entity(entity_to_refresh);
+            *canvas_width = read_16(data + 6);
+            *canvas_height = read_16(data + 8);
+            
+            if (*canvas_width <= 0 || *canvas_height <= 0) { return -1; }
+            
+            // The global color table.
+            const unsigned char* global_palette = NULL;
+            int global_palette_size = 0;
+            size_t position = 13;
+            
+            if (data[10] & 0x80)
+            {
+                global_palette = data + position;
+                global_palette_size = 2 << (data[10] & 7);
+                position += 3 * global_palette_size;
+            }
+            
+            // The graphic control of the next frame.
+            int transparent_index = -1;
+            int disposal = 0;
+            int frames_amount = 0;
+            
+            while (position < size)
+            {
+                int block_type = data[position++];
+                
+                // An extension.
+                if (block_type == 0x21)
+                {
+                    if (position + 1 >= size) { return -1; }
+                    int label = data[position++];
+                    
+                    // The graphic control extension.
+                    if (label == 0xF9 && position + 5 <= size && data[position] == 4)
+                    {
+                        disposal = (data[position + 1] >> 2) & 7;
+                        transparent_index = (data[position + 1] & 1) ? data[position + 4] : -1;
+                    }
+                    
+                    if (!skip_sub_blocks(data, size, &position)) { return -1; }
+                }
+                
+                // An image descriptor.
+                else if (block_type == 0x2C)
+                {
+                    if (position + 10 > size) { return -1; }
+                    
+                    gif_frame frame;
+                    frame.x = read_16(data + position);
+                    frame.y = read_16(data + position + 2);
+                    frame.width = read_16(data + position + 4);
+                    frame.height = read_16(data + position + 6);
+                    frame.is_interlaced = (data[position + 8] & 0x40) != 0;
+                    frame.palette = global_palette;
+                    frame.palette_size = global_palette_size;
+                    frame.transparent_index = transparent_index;
+                    frame.disposal = disposal;
+                    frame.indexes = NULL;
+                    
+                    // The local color table.
+                    int packed = data[position + 8];
+                    position += 9;
+                    
+                    if (packed & 0x80)
+                    {
+                        frame.palette = data + position;
+                        frame.palette_size = 2 << (packed & 7);
+                        position += 3 * frame.palette_size;
+                    }
+                    
+                    // The compressed pixels.
+                    if (position >= size || frame.palette == NULL) { return -1; }
+                    
+                    frame.min_code_size = data[position++];
+                    frame.data_offset = position;
+                    
+                    if (frame.min_code_size < 2 || frame.min_code_size > 8) { return -1; }
+                    if (!skip_sub_blocks(data, size, &position)) { return -1; }
+                    
+                    if (frames != NULL && frames_amount < max_frames) { frames[frames_amount] = frame; }
+                    frames_amount++;
+                    
+                    // The graphic control applies to a single frame.
+                    transparent_index = -1;
+                    disposal = 0;
+                }
+                
+                // The trailer.
+                else if (block_type == 0x3B) { break; }
+                
+                else { return -1; }
+            }
+            
+            return frames_amount;
         }
         
-        // The function receives an entity and adds it to the grid.
-        void add_entity(GridEntity* new_entity)
+        // The function LZW decodes the color indexes of a frame.
+        static void decode_lzw(const unsigned char* data, size_t size, gif_frame* frame)
         {
-            /*
-                The rectangles are not rotated. 
-                This fact means that a rectangle is within a cell, if and only if the cell is between the y axis boundaries of the rectangle, as well as the x axis boundaries.
-            */
-			
-            // Get the location and size of the entity.
-            Location location = new_entity -> get_location();
-            Size size = new_entity -> get_size();
-            float scale = new_entity -> get_scale();
-           
-            // Calculate the x boundaries.
-            int x_boundary_left = location.x - ((sqrt(scale) * size.width) / 2);
-            int x_boundary_right = x_boundary_left + (sqrt(scale) * size.width);
-            
-            // Calculate the y boundaries.
-            int y_boundary_top = location.y - ((sqrt(scale) * size.height) / 2);
-            int y_boundary_bottom = y_boundary_top + (sqrt(scale) * size.height);
+            // The codes table, every code is a prefix code followed by a color index.
+            short prefixes[4096];
+            unsigned char suffixes[4096];
+            unsigned char firsts[4096];
+            unsigned short lengths[4096];
             
-            // Find the left and right columns indexes boundaries.
-            int left_column_index_boundary = (int) floor( (double) x_boundary_left / cell_width_pixels);
-            int right_column_index_boundary = (int) floor( (double) x_boundary_right / cell_width_pixels);
+            int pixels_amount = frame -> width * frame -> height;
+            frame -> indexes = new unsigned char[pixels_amount > 0 ? pixels_amount : 1];
+            memset(frame -> indexes, 0, pixels_amount > 0 ? pixels_amount : 1);
             
-            // Find the top and bottom rows indexes boundaries.
-            int top_row_index_boundary = (int) floor( (double) y_boundary_top / cell_height_pixels);
-            int bottom_row_index_boundary = (int) floor( (double) y_boundary_bottom / cell_height_pixels);
+            int clear_code = 1 << frame -> min_code_size;
+            int end_code = clear_code + 1;
             
-            // Don't care if outside the grid.
-            if (top_row_index_boundary >= rows_amount) { top_row_index_boundary = rows_amount - 1; }
-            else if (top_row_index_boundary < 0) { top_row_index_boundary = 0; }
+            for (int i = 0; i < clear_code; i++)
+            {
+                prefixes[i] = -1;
+                suffixes[i] = (unsigned char) i;
+                firsts[i] = (unsigned char) i;
+                lengths[i] = 1;
+            }
             
-            if (bottom_row_index_boundary < 0) { bottom_row_index_boundary = 0; }
-            else if (bottom_row_index_boundary >= rows_amount) { bottom_row_index_boundary = rows_amount - 1; }
+            int code_size = frame -> min_code_size + 1;
+            int next_code = end_code + 1;
+            int previous_code = -1;
+            int pixel = 0;
             
-            if (left_column_index_boundary < 0) { left_column_index_boundary = 0; }
-            else if (left_column_index_boundary >= columns_amount) { left_column_index_boundary = columns_amount - 1; }
+            // The bits reader, over the data sub-blocks.
+            size_t position = frame -> data_offset;
+            int block_left = 0;
+            uint32_t bits = 0;
+            int bits_amount = 0;
             
-            if (right_column_index_boundary >= columns_amount) { right_column_index_boundary = columns_amount - 1; }
-            else if (right_column_index_boundary < 0) { right_column_index_boundary = 0; }
-
-            // Add the entity to all the cells within those boundaries.
-            for (int row_index = top_row_index_boundary; row_index <= bottom_row_index_boundary; row_index++)
+            while (pixel < pixels_amount)
             {
-                for(int col_index = left_column_index_boundary; col_index <= right_column_index_boundary; col_index++)
+                // Read the next code.
+                while (bits_amount < code_size)
                 {
-                    // Add the entity to the current cell (also adds the cell to the current entity).
-                    cells[row_index][col_index] -> add_entity(new_entity);
+                    if (block_left == 0)
+                    {
+                        if (position >= size || data[position] == 0) { return; }
+                        block_left = data[position++];
+                    }
+                    
+                    if (position >= size) { return; }
+                    
+                    bits |= (uint32_t) data[position++] << bits_amount;
+                    bits_amount += 8;
+                    block_left--;
+                }
+                
+                int code = bits & ((1 << code_size) - 1);
+                bits >>= code_size;
+                bits_amount -= code_size;
+                
+                // Reset the table.
+                if (code == clear_code)
+                {
+                    code_size = frame -> min_code_size + 1;
+                    next_code = end_code + 1;
+                    previous_code = -1;
+                    continue;
+                }
+                
+                if (code == end_code) { return; }
+                
+                // An unknown code, the data is corrupted.
+                if (code > next_code || (previous_code == -1 && code >= clear_code)) { return; }
+                
+                // Add the previous code followed by the first color of this one (of the previous, if this is the new code).
+                if (previous_code != -1 && next_code < 4096)
+                {
+                    prefixes[next_code] = (short) previous_code;
+                    suffixes[next_code] = (code < next_code) ? firsts[code] : firsts[previous_code];
+                    firsts[next_code] = firsts[previous_code];
+                    lengths[next_code] = lengths[previous_code] + 1;
+                    next_code++;
+                    
+                    if (next_code == (1 << code_size) && code_size < 12) { code_size++; }
                 }
+                
+                // Write the colors of the code, from the last to the first.
+                int length = lengths[code];
+                int write = pixel + length - 1;
+                
+                for (int current = code; current != -1; current = prefixes[current])
+                {
+                    if (write < pixels_amount) { frame -> indexes[write] = suffixes[current]; }
+                    write--;
+                }
+                
+                pixel += length;
+                previous_code = code;
             }
         }
         
-        // The function removes an entity from the grid.
-        void remove_entity(GridEntity* entity_to_remove)
+        // The function decodes frames until all the frames were taken.
+        static void decode_frames(decode_context* context)
         {
-            // How many cells the entity is currently within.
-            int amount_of_cells_within = entity_to_remove -> get_amount_of_cells_within();
+            int frame = context -> next_frame.fetch_add(1);
             
-            // Get the list of cells that the entity is currently within.
-            Cell** cells_within = entity_to_remove -> get_cells_within();
-
-            // Iterate over the cells within.
-            for (int i = 0; i < amount_of_cells_within; i++)
+            while (frame < context -> frames_amount)
             {
-                cells_within[i] -> remove_entity(entity_to_remove);
+                decode_lzw(context -> data, context -> size, &context -> frames[frame]);
+                context -> decoded_frames++;
+                
+                frame = context -> next_frame.fetch_add(1);
             }
+        }
+        
+        // The pool task which helps decoding the frames.
+        static void* decode_frames_task(void* context_argument)
+        {
+            decode_context* context = (decode_context*) context_argument;
             
-            // Reset the cells within of the entity to remove.
-            entity_to_remove -> reset_cells_within();
+            decode_frames(context);
+            release(context);
+            
+            return NULL;
         }
         
-        // Getters.
+        // The function releases a reference to the context, and deletes it if it was the last.
+        static void release(decode_context* context)
+        {
+            if (context -> references.fetch_sub(1) == 1) { delete context; }
+        }
+        
+        // The function composes the decoded frames one after the other, every frame starts from the previous one after its disposal.
+        static void compose(gif_frame* frames, int frames_amount, unsigned char* pixels, int canvas_width, int canvas_height)
+        {
+            size_t canvas_size = (size_t) canvas_width * canvas_height * 4;
+            
+            // The area under the previous frame, for the restore disposal.
+            unsigned char* restore = NULL;
+            
+            // The interlaced rows order.
+            int* rows = new int[canvas_height > 0 ? canvas_height : 1];
+            
+            for (int i = 0; i < frames_amount; i++)
+            {
+                unsigned char* canvas = pixels + i * canvas_size;
+                gif_frame* frame = &frames[i];
+                
+                // The frame rectangle, clipped to the canvas.
+                int right = min(frame -> x + frame -> width, canvas_width);
+                int bottom = min(frame -> y + frame -> height, canvas_height);
+                
+                // Start from the previous frame (the first frame starts transparent, the image is allocated cleared).
+                if (i > 0)
+                {
+                    gif_frame* previous = &frames[i - 1];
+                    int previous_right = min(previous -> x + previous -> width, canvas_width);
+                    int previous_bottom = min(previous -> y + previous -> height, canvas_height);
+                    
+                    memcpy(canvas, canvas - canvas_size, canvas_size);
+                    
+                    for (int y = previous -> y; y < previous_bottom; y++)
+                    {
+                        if (previous_right <= previous -> x) { break; }
+                        
+                        unsigned char* row = canvas + ((size_t) y * canvas_width + previous -> x) * 4;
+                        size_t row_size = (size_t) (previous_right - previous -> x) * 4;
+                        
+                        // Clear the previous frame area.
+                        if (previous -> disposal == 2) { memset(row, 0, row_size); }
+                        
+                        // Restore what was under the previous frame.
+                        else if (previous -> disposal == 3 && restore != NULL) { memcpy(row, restore + (y - previous -> y) * row_size, row_size); }
+                    }
+                }
+                
+                if (right <= frame -> x || bottom <= frame -> y) { continue; }
+                
+                size_t row_size = (size_t) (right - frame -> x) * 4;
+                
+                // Save what is under the frame, if the next frame should restore it.
+                if (frame -> disposal == 3)
+                {
+                    delete[] restore;
+                    restore = new unsigned char[row_size * (bottom - frame -> y)];
+                    
+                    for (int y = frame -> y; y < bottom; y++) { memcpy(restore + (y - frame -> y) * row_size, canvas + ((size_t) y * canvas_width + frame -> x) * 4, row_size); }
+                }
+                
+                // The rows order in the decoded indexes.
+                int row = 0;
+                
+                if (frame -> is_interlaced)
+                {
+                    const int starts[4] = { 0, 4, 2, 1 };
+                    const int steps[4] = { 8, 8, 4, 2 };
+                    
+                    for (int pass = 0; pass < 4; pass++)
+                    {
+                        for (int y = starts[pass]; y < frame -> height; y += steps[pass]) { if (row < canvas_height) { rows[row] = y; } row++; }
+                    }
+                }
+                
+                else { for (int y = 0; y < frame -> height && y < canvas_height; y++) { rows[y] = y; } }
+                
+                // Draw the frame colors, skip the transparent ones.
+                for (int source_row = 0; source_row < frame -> height && source_row < canvas_height; source_row++)
+                {
+                    int y = frame -> y + rows[source_row];
+                    if (y >= bottom) { continue; }
+                    
+                    const unsigned char* indexes = frame -> indexes + (size_t) source_row * frame -> width;
+                    unsigned char* pixel = canvas + ((size_t) y * canvas_width + frame -> x) * 4;
+                    
+                    for (int x = frame -> x; x < right; x++, indexes++, pixel += 4)
+                    {
+                        int index = *indexes;
+                        if (index == frame -> transparent_index || index >= frame -> palette_size) { continue; }
+                        
+                        pixel[0] = frame -> palette[index * 3];
+                        pixel[1] = frame -> palette[index * 3 + 1];
+                        pixel[2] = frame -> palette[index * 3 + 2];
+                        pixel[3] = 255;
+                    }
+                }
+            }
+            
+            delete[] restore;
+            delete[] rows;
+        }
+};
 
-        // The function returns the amount of columns.
-        int get_columns_amount() { return columns_amount; }
+
+class CompletionQueue
+{
+    /*
+        A lock free queue of finished asset jobs, many workers push and the main thread pops.
         
-        // The function returns the amount of rows.
-        int get_rows_amount() { return rows_amount; }
+        Notes:
+            - An intrusive linked list (the jobs hold the next pointer), so pushing never allocates and never waits.
+            - Pop must be called from a single thread only.
+    */
+    
+    private:
+    
+        // An empty job the list always starts from.
+        asset_job stub;
         
-        // Getters.
-        int get_width_pixels() { return width_pixels; }
-        int get_height_pixels() { return height_pixels; }
-        int get_cell_width_pixels() { return cell_width_pixels; }
-        int get_cell_height_pixels() { return cell_height_pixels; }
+        // The workers push at the head, the main thread pops from the tail.
+        std::atomic<asset_job*> head;
+        asset_job* tail;
+    
+    public:
+    
+        // Constructor.
+        CompletionQueue()
+        {
+            stub.next.store(NULL);
+            head.store(&stub);
+            tail = &stub;
+        }
         
-        // Returns the cells matrix.
-        Cell*** get_cells() { return cells; }
-
+        // The function adds a finished job to the queue (any thread).
+        void push(asset_job* job)
+        {
+            job -> next.store(NULL, std::memory_order_relaxed);
+            
+            // Take the head, then link the previous head to the job.
+            asset_job* previous = head.exchange(job, std::memory_order_acq_rel);
+            previous -> next.store(job, std::memory_order_release);
+        }
+        
+        // The function returns the next finished job, or NULL if there is none yet (main thread only).
+        asset_job* pop()
+        {
+            asset_job* job = tail;
+            asset_job* next = job -> next.load(std::memory_order_acquire);
+            
+            // Skip the stub.
+            if (job == &stub)
+            {
+                if (next == NULL) { return NULL; }
+                
+                tail = next;
+                job = next;
+                next = next -> next.load(std::memory_order_acquire);
+            }
+            
+            // The job is followed by another one.
+            if (next != NULL) { tail = next; return job; }
+            
+            // A push is in the middle of linking, try again on the next call.
+            if (job != head.load(std::memory_order_acquire)) { return NULL; }
+            
+            // The job is the last one, put the stub behind it so it can be taken.
+            push(&stub);
+            next = job -> next.load(std::memory_order_acquire);
+            
+            if (next != NULL) { tail = next; return job; }
+            
+            return NULL;
+        }
 };
 
 
-class MyGif: public GridEntity
+class AssetLoader
 {
     /*
-        Load a gif to the screen.
+        Loads the game assets on a worker pool. Every asset is a job, decoded by the workers and finished on the main thread.
         
         Notes:
-            - The gif is loaded as a texture, and manipulated as a texture.
-            - The gif doesn't have to be on a grid, an almost identical MyGif class is spared due to unnecessary code overload. Simply the value of max_cells_within can be ignored and the array    
-              cells_within should be nothing but a null pointer.
+            - Decoding (gif, png, mp3) runs on the workers, GPU uploads are made on the main thread (process_completed()).
+            - The sound effects are decoded and compressed on the workers, and added to the sound effects store on the main thread.
+            - The finished jobs are handed over in a lock free queue, so the uploads start while other assets are still decoded.
+            - The progress is weighted by the size of the source files, so a big gif moves the loading bar more than a small button.
+            - Every asset belongs to one or more bundles (AssetBundle flags). Only the requested bundles are loaded, an asset shared by
+              bundles is loaded once.
     */
     
-    protected:
+    private:
     
-        // An optional attribute, if true on intialization, the gif originaly facing left. Indicates to flip it horizontaly to face right on startup.
-        bool is_facing_left_on_startup;
+        // The pack with the pre-decoded images.
+        AssetPack* pack;
         
-        // If true, flips the gif horizontally.
-        bool is_flip_horizontal;
+        // The workers which decode the assets.
+        WorkerPool* pool;
         
-        // If true, flips the gif vertically.
-        bool is_flip_vertical;
+        // Measures every decode and upload (NULL if not measured).
+        StartupTracer* tracer;
         
-        // When the gif is loaded, this variable contains the amount of frames this gif has.
-        int* frames_amount;
+        // The store which keeps the sound effects.
+        SfxStore* sfx_store;
         
-        // Pointing on the current frame of the gif that is being displayed.
-        int current_frame = 0;
+        // The jobs.
+        int max_jobs;
+        int jobs_amount;
+        asset_job* jobs;
         
-        // The gif as image.
-        Image my_gif_image;
-
-        // The gif as texture.
-        Texture2D my_gif_texture;
+        // The decoded jobs, waiting for the main thread.
+        CompletionQueue completed;
+        int submitted_amount;
+        int completed_amount;
         
-        // The tint of the gif.
-        Color tint;
+        // The bundles which were handed to the workers.
+        unsigned int requested_bundles;
+        
+        // The weight of the submitted jobs, and of the decoded jobs (written by the workers).
+        uint64_t total_weight;
+        std::atomic<uint64_t> decoded_weight;
     
     public:
     
         // Constructor.
-        MyGif(Image new_my_gif_image, int* new_frames_amount, frame new_collision_frame, string new_entity_type, Location new_location, Size new_size, float new_scale, float new_max_scale, int new_rotation, bool new_is_facing_left_on_startup, int new_max_cells_within, Cell** new_cells_within) : GridEntity(new_entity_type, new_collision_frame, new_location, new_size, new_scale, new_max_scale, new_rotation, new_max_cells_within, new_cells_within)
+        AssetLoader(AssetPack* new_pack, WorkerPool* new_pool, StartupTracer* new_tracer, SfxStore* new_sfx_store, int new_max_jobs) : decoded_weight(0)
         {
-            // Save the image of the gif.
-            my_gif_image = new_my_gif_image;
+            pack = new_pack;
+            pool = new_pool;
+            tracer = new_tracer;
+            sfx_store = new_sfx_store;
+            
+            // Create the jobs array.
+            max_jobs = new_max_jobs;
+            jobs_amount = 0;
+            jobs = new asset_job[max_jobs];
+            
+            requested_bundles = 0;
+            submitted_amount = 0;
+            completed_amount = 0;
+            total_weight = 0;
+        }
+        
+        // The function adds an animated image (gif) to the bundles.
+        void add_animation(const char* path, Image* image, int* frames_amount, unsigned int bundles) { add_job(ASSET_ANIMATION, path, (void*) image, frames_amount, bundles); }
+        
+        // The function adds a texture (png) to the bundles.
+        void add_texture(const char* path, Texture2D* texture, unsigned int bundles) { add_job(ASSET_TEXTURE, path, (void*) texture, NULL, bundles); }
+        
+        // The function adds a sound effect to the bundles, the clip is set to its number in the sound effects store.
+        void add_sound(const char* path, int* clip, unsigned int bundles) { add_job(ASSET_SOUND, path, (void*) clip, NULL, bundles); }
+        
+        // The function finds the image of an animation by the path it was added with, returns false if it was not added.
+        bool find_animation(const char* path, Image** image, int** frames_amount)
+        {
+            for (int i = 0; i < jobs_amount; i++)
+            {
+                if (jobs[i].type != ASSET_ANIMATION || strcmp(jobs[i].path, path) != 0) { continue; }
+                
+                *image = (Image*) jobs[i].target;
+                *frames_amount = jobs[i].frames_amount;
+                return true;
+            }
             
-            // Save the frames amount instance.
-            frames_amount = new_frames_amount;
+            return false;
+        }
+        
+        // The function finds a texture by the path it was added with, NULL if it was not added.
+        Texture2D* find_texture(const char* path)
+        {
+            for (int i = 0; i < jobs_amount; i++) { if (jobs[i].type == ASSET_TEXTURE && strcmp(jobs[i].path, path) == 0) { return (Texture2D*) jobs[i].target; } }
             
-            // True if the gif faces left originaly.
-            is_facing_left_on_startup = new_is_facing_left_on_startup;
+            return NULL;
+        }
+        
+        // The function sets the size of the images of the bundles from their file headers, so the worlds can be set-up before their images are loaded.
+        void read_sizes(unsigned int bundles)
+        {
+            for (int i = 0; i < jobs_amount; i++)
+            {
+                if (!(jobs[i].bundles & bundles) || jobs[i].type == ASSET_SOUND || jobs[i].is_submitted) { continue; }
+                
+                int width = 0, height = 0;
+                if (!read_image_size(jobs[i].path, &width, &height)) { continue; }
+                
+                if (jobs[i].type == ASSET_ANIMATION) { ((Image*) jobs[i].target) -> width = width; ((Image*) jobs[i].target) -> height = height; }
+                else { ((Texture2D*) jobs[i].target) -> width = width; ((Texture2D*) jobs[i].target) -> height = height; }
+            }
+        }
+        
+        // The function hands the jobs of the bundles to the workers (the ones which were not requested yet), the biggest first so they don't end up last on a single worker.
+        void load_bundles(unsigned int bundles)
+        {
+            // Already requested (called every frame while prefetching).
+            if ((requested_bundles & bundles) == bundles) { return; }
+            requested_bundles |= bundles;
             
-            // Set the texture on initialization to face right.
-            if (is_facing_left_on_startup) { is_flip_horizontal = true; }
-            else { is_flip_horizontal = false; }
-
-            // Do not flip the texture verticaly on initialization.
-            is_flip_vertical = false;           
-
-            // Create the texture instance.
-            my_gif_texture = LoadTextureFromImage(my_gif_image);
+            // The jobs to submit.
+            int* order = new int[jobs_amount];
+            int order_amount = 0;
             
-            // Set the collision frame to match the current size.
-            set_original_size(Size(my_gif_texture.width, my_gif_texture.height));
+            for (int i = 0; i < jobs_amount; i++)
+            {
+                if (!(jobs[i].bundles & bundles) || jobs[i].is_submitted) { continue; }
+                
+                jobs[i].is_submitted = true;
+                total_weight += jobs[i].weight;
+                order[order_amount++] = i;
+            }
             
-            // Set the tint to white.
-            tint = WHITE;
+            // Sort the jobs order by weight (few jobs, a simple selection sort).
+            for (int i = 0; i < order_amount; i++)
+            {
+                for (int j = i + 1; j < order_amount; j++)
+                {
+                    if (jobs[order[j]].weight > jobs[order[i]].weight) { int temp = order[i]; order[i] = order[j]; order[j] = temp; }
+                }
+            }
+            
+            for (int i = 0; i < order_amount; i++) { pool -> submit(&decode, (void *)&jobs[order[i]]); }
+            submitted_amount += order_amount;
+            
+            delete[] order;
         }
         
-        // Default Constructor.
-        MyGif() : GridEntity()
+        // The function finishes the decoded jobs (main thread only, needs the GPU and audio device).
+        void process_completed()
         {
-            is_facing_left_on_startup = false;
-            is_flip_horizontal = false;
-            is_flip_vertical = false;
+            asset_job* job = completed.pop();
+            
+            while (job != NULL)
+            {
+                double upload_start_time = monotonic_time();
+                
+                switch (job -> type)
+                {
+                    case ASSET_ANIMATION:
+                    {
+                        // The animation frames are uploaded by every gif itself.
+                        *((Image*) job -> target) = job -> image;
+                        
+                    } break;
+                    
+                    case ASSET_TEXTURE:
+                    {
+                        // Upload the texture (straight from the mapping, if packed and not compressed).
+                        *((Texture2D*) job -> target) = LoadTextureFromImage(job -> image);
+                        
+                        // Pack the newly decoded image for the next launches (the pack unloads it once it is saved).
+                        if (!job -> is_packed && job -> image.data != NULL) { pack -> add(job -> path, job -> source_hash, job -> image, 1, true); }
+                        
+                        // A decompressed copy of a packed image.
+                        else if (job -> is_packed && !pack -> is_mapped(job -> image)) { UnloadImage(job -> image); }
+                        
+                    } break;
+                    
+                    case ASSET_SOUND:
+                    {
+                        *((int*) job -> target) = sfx_store -> add_clip(job -> clip);
+                        
+                    } break;
+                }
+                
+                if (tracer != NULL) { tracer -> record(job -> path, "upload", upload_start_time, get_decoded_bytes(job)); }
+                
+                job -> is_completed = true;
+                completed_amount++;
+                job = completed.pop();
+            }
         }
         
-        // Flipping manipulations
-        void flip_horizontal() {is_facing_left_on_startup ? is_flip_horizontal = false : is_flip_horizontal = true;}
-        void flip_vertical() {is_flip_vertical = true;}
-        void unflip_horizontal() {is_facing_left_on_startup ? is_flip_horizontal = true : is_flip_horizontal = false;}
-        void unflip_vertical() {is_flip_vertical = false;}
+        // The function returns true if all the assets of the bundles were loaded.
+        bool is_loaded(unsigned int bundles)
+        {
+            for (int i = 0; i < jobs_amount; i++) { if ((jobs[i].bundles & bundles) && !jobs[i].is_completed) { return false; } }
+            
+            return true;
+        }
         
-        // Change the tint of the gif.
-        void update_tint(Color new_tint) { tint = new_tint; }
+        // The function loads the bundles and waits for them (for small bundles, the screen is not updated meanwhile).
+        void wait_loaded(unsigned int bundles)
+        {
+            load_bundles(bundles);
+            
+            while (true)
+            {
+                process_completed();
+                if (is_loaded(bundles)) { return; }
+                
+                WaitTime(0.001);
+            }
+        }
         
-        // The function Prepare the next frame of the gif.
-        void set_next_frame()
+        // The function unloads the assets of the bundles which are not shared with the kept bundles, they are loaded again when their bundle is requested (main thread only).
+        // Returns how many assets were unloaded.
+        int unload_bundles(unsigned int bundles, unsigned int kept_bundles)
         {
-            // Containing required data about the next frame.
-            int next_frame_data_offset;
+            int unloaded_amount = 0;
             
-            // Point on the next frame.
-            current_frame++;
+            for (int i = 0; i < jobs_amount; i++)
+            {
+                asset_job* job = &jobs[i];
+                
+                // Not in the bundles, still needed, still decoded, or a sound (the sound effects store keeps its clips).
+                if (!(job -> bundles & bundles) || (job -> bundles & kept_bundles) || !job -> is_completed || job -> type == ASSET_SOUND) { continue; }
+                
+                // A gif decoded on this launch is still saved to the pack from its pixels.
+                if (job -> type == ASSET_ANIMATION && !job -> is_packed && pack -> is_dirty()) { continue; }
+                
+                // The sizes stay, like after read_sizes().
+                if (job -> type == ASSET_ANIMATION)
+                {
+                    Image* image = (Image*) job -> target;
+                    if (image -> data != NULL && !pack -> is_mapped(*image)) { UnloadImage(*image); }
+                    image -> data = NULL;
+                    *job -> frames_amount = 1;
+                }
+                else
+                {
+                    Texture2D* texture = (Texture2D*) job -> target;
+                    if (texture -> id != 0) { UnloadTexture(*texture); }
+                    texture -> id = 0;
+                }
+                
+                // The job can be submitted again.
+                job -> is_submitted = false;
+                job -> is_completed = false;
+                submitted_amount--;
+                completed_amount--;
+                total_weight -= job -> weight;
+                decoded_weight.fetch_sub(job -> weight);
+                unloaded_amount++;
+            }
             
-            // Reset the current frame index if currently displaying the last frame of the gif.
-            if (current_frame >= *frames_amount) { current_frame = 0; }
-
-            // Get memory offset position for next frame data in image.data.
-            next_frame_data_offset = my_gif_image.width * my_gif_image.height * 4 * current_frame;
-
-            // Update GPU texture data with next frame image data.
-            UpdateTexture(my_gif_texture, ((unsigned char *) my_gif_image.data) + next_frame_data_offset);
+            requested_bundles &= ~bundles;
+            
+            return unloaded_amount;
         }
         
-        // The function draws the last frame that was set with set_next_frame().
-        void draw_next_frame()
+        // The function returns true if all the requested bundles were loaded.
+        bool is_idle() { return completed_amount == submitted_amount; }
+        
+        // The function returns the decoded part of the requested bundles (0 to 1), by weight.
+        float get_progress()
         {
-            // -1 cause flip, 1 do not flips.
-            float flip_width = 1, flip_height = 1;
+            if (total_weight == 0) { return 1; }
             
-            // Check if required flipping.
-            if (is_flip_horizontal) {flip_width = -1;}
-            if (is_flip_vertical) {flip_height = -1;}
-            
-            // Crop the gif (we don't want to crop any gif, so just take its original frame).
-            Rectangle source = {0, 0, flip_width * my_gif_texture.width, flip_height * my_gif_texture.height};
+            return (float) ((double) decoded_weight.load() / total_weight);
+        }
+    
+    private:
+    
+        // The function adds a job to the jobs array.
+        void add_job(AssetType type, const char* path, void* target, int* frames_amount, unsigned int bundles)
+        {
+            if (jobs_amount >= max_jobs) { TraceLog(LOG_ERROR, "Too many assets to load, %s is skipped", path); return; }
+            
+            asset_job* job = &jobs[jobs_amount];
+            job -> type = type;
+            job -> path = path;
+            job -> loader = this;
+            job -> bundles = bundles;
+            job -> target = target;
+            job -> frames_amount = frames_amount;
+            job -> is_packed = false;
+            job -> is_submitted = false;
+            job -> is_completed = false;
+            
+            // An empty file still counts, so the bar moves.
+            job -> weight = (uint64_t) GetFileLength(path) + 1;
+            
+            // Nothing is loaded yet, the asset is empty until its bundle is loaded.
+            switch (type)
+            {
+                case ASSET_ANIMATION: { Image empty_image = { NULL, 0, 0, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }; *((Image*) target) = empty_image; *frames_amount = 1; } break;
+                case ASSET_TEXTURE: { memset(target, 0, sizeof(Texture2D)); } break;
+                case ASSET_SOUND: { *((int*) target) = -1; } break;
+            }
             
-            // Where to draw the gif. The input location is where to put the center on the screen.
-            Rectangle destination = {(float) location.x, (float) location.y, (float) floor(sqrt(scale) * size.width), (float) floor(sqrt(scale) * size.height)};
+            jobs_amount++;
+        }
+        
+        // Returns the size of the decoded data of a job.
+        static uint64_t get_decoded_bytes(asset_job* job)
+        {
+            if (job -> type == ASSET_SOUND) { return (uint64_t) job -> clip.blocks_amount * SfxStore::BLOCK_BYTES; }
             
-            // We want the gif to be rotated in relation to its center, and we want that the inputed location in the destination rectangle will be the center.
-            Vector2 center = {(sqrt(scale) * size.width) / 2, (sqrt(scale) * size.height) / 2};
+            int frames_amount = (job -> type == ASSET_ANIMATION) ? *job -> frames_amount : 1;
+            if (job -> image.data == NULL) { return 0; }
             
-            // Draw the next frame of the gif properly.
-            DrawTexturePro(my_gif_texture, source, destination, center, rotation, tint);
+            return (uint64_t) GetPixelDataSize(job -> image.width, job -> image.height, job -> image.format) * frames_amount;
         }
-
-        // The function removes the gif from the screen.
-        void delete_gif()
+        
+        // The function reads the size of a png or gif from its header.
+        static bool read_image_size(const char* path, int* width, int* height)
         {
-            // Remove the texture.
-            UnloadTexture(my_gif_texture);
+            unsigned int bytes_read = 0;
+            unsigned char* file_data = LoadFileData(path, &bytes_read);
+            bool is_read = false;
+            
+            if (file_data == NULL) { return false; }
+            
+            // Png, the size is in the first chunk (big endian).
+            if (bytes_read >= 24 && memcmp(file_data, "\x89PNG", 4) == 0)
+            {
+                *width = (file_data[16] << 24) | (file_data[17] << 16) | (file_data[18] << 8) | file_data[19];
+                *height = (file_data[20] << 24) | (file_data[21] << 16) | (file_data[22] << 8) | file_data[23];
+                is_read = true;
+            }
+            
+            // Gif, the size of the canvas (little endian).
+            else if (bytes_read >= 10 && memcmp(file_data, "GIF8", 4) == 0)
+            {
+                *width = file_data[6] | (file_data[7] << 8);
+                *height = file_data[8] | (file_data[9] << 8);
+                is_read = true;
+            }
+            
+            UnloadFileData(file_data);
+            
+            return is_read;
         }
         
-        // Returns the center location of the gif.
-        Location get_location() {return location;}
+        // The worker function, decodes a single job.
+        static void* decode(void* job_argument)
+        {
+            // Cast the argument to the job.
+            asset_job* job = (asset_job*) job_argument;
+            AssetLoader* loader = job -> loader;
+            int frames_amount = 1;
+            double decode_start_time = monotonic_time();
+            
+            switch (job -> type)
+            {
+                case ASSET_ANIMATION:
+                {
+                    // Identify the current content of the source file.
+                    job -> source_hash = loader -> pack -> hash_file(job -> path);
+                    
+                    // Already decoded on a previous launch.
+                    job -> is_packed = loader -> pack -> find(job -> path, job -> source_hash, &job -> image, job -> frames_amount);
+                    
+                    // Decode the gif, and pack it for the next launches (animations stay loaded for the whole game).
+                    if (!job -> is_packed)
+                    {
+                        job -> image = GifDecoder::load(job -> path, job -> frames_amount, loader -> pool);
+                        loader -> pack -> add(job -> path, job -> source_hash, job -> image, *job -> frames_amount, false);
+                    }
+                    
+                } break;
+                
+                case ASSET_TEXTURE:
+                {
+                    // Identify the current content of the source file.
+                    job -> source_hash = loader -> pack -> hash_file(job -> path);
+                    
+                    // Already decoded on a previous launch, otherwise decode the image.
+                    job -> is_packed = loader -> pack -> find(job -> path, job -> source_hash, &job -> image, &frames_amount);
+                    if (!job -> is_packed) { job -> image = LoadImage(job -> path); }
+                    
+                } break;
+                
+                case ASSET_SOUND:
+                {
+                    Wave wave = LoadWave(job -> path);
+                    job -> clip = SfxStore::encode(wave, job -> path);
+                    UnloadWave(wave);
+                    
+                } break;
+            }
+            
+            if (loader -> tracer != NULL) { loader -> tracer -> record(job -> path, job -> is_packed ? "pack" : "decode", decode_start_time, get_decoded_bytes(job)); }
+            
+            // Update the progress, and hand the job to the main thread.
+            loader -> decoded_weight.fetch_add(job -> weight);
+            loader -> completed.push(job);
+            
+            return NULL;
+        }
 };
 
 
-// ----- Game Classes -----
-
-
-// Need to declare for the Fish class.
-class FishNetwork;
-
-
-class Fish : public MyGif
+class WorldPack
 {
     /*
-        Represents a fish.
+        The description of a world: its fish profiles with their paths stacks and paths, their proportions, the grid, the population and the assets.
+        
+        Notes:
+            - The source is a text file, compiled to a binary pack of flat tables which is read in one go. The pack is compiled again only when
+              its source was changed (the pack keeps the hash of its source), or its layout version. A pack without a source is used as it is.
+            - A pack has a checksum, a broken pack is compiled again.
+            - resolve() makes the fish profiles of the tables: the animations and the textures are found by their paths (see AssetLoader), the
+              sounds by their names, and the anchored coordinates by the size of the world. The paths of the profiles point into the pack.
+            - The text source has a line for every property ("#" starts a comment):
+                world <number>, population <amount>, grid <columns> <rows>, background <path>, welcome_window <path>, and optionally
+                world_size <width> <height> (the size of the background otherwise).
+                fish <type> starts a fish profile, with: animation <path>, collision <x> <y> <width> <height>, size <width> <height>,
+                max_scaling <scale>, speed_x <min> <max>, speed_y <min> <max>, frames_per_path <min> <max>, eat_ratios <can eat> <can't eat>,
+                sounds <eat> <sting>, proportion <proportion>, and the flags sting_proof, facing_left, randomize_scale and on_startup.
+                stack <from_left|from_right> [repeat] [location <x> <y>] [start_at_location] [y <y>] [randomize_x] starts a paths stack of the
+                fish, with its paths: path <speed x> <speed y> <right|left> <up|down> <frames>.
+            - A coordinate is a number, or an anchor (left, right, bottom or above, see WorldAnchor) with an optional offset, like bottom-50.
+            - A source which was made in memory (see WorldGenerator) is compiled by compile_source(), without a compiled pack.
     */
     
-    protected:
-        
-        // How many frames elapsed in a second.
-        int fps;
-
-        // The type of the fish.
-        string fish_type;
-        
-        // The speed of the fish on the x and y axes, pixels/frame;
-        float speed_x, speed_y;
-        
-        // The location boundaries of the fish.
-        int left_boundary, right_boundary, top_boundary, bottom_boundary;
-        
-        // Indicating if the fish is out of bounds.
-        bool is_fish_out_of_bounds;
-        
-        // Indicates on the moving direction of the fish on the x axis.
-        bool is_moving_right;
-        
-        // Indicating that the fish was eaten.
-        bool is_eaten;
-        
-        // How much the fish grows after eating another fish.
-        float eat_grow_ratio;
-        
-        // Can eat fish that are <can_eat_ratio> my size and greater.
-        float can_eat_ratio;
-        
-        // Can't eat fish that are <cant_eat_ratio> and less my size.
-        float cant_eat_ratio;
-        
-        // If true the fish can't get stinged.
-        bool is_sting_proof;
-        
-        // How many frames left for the current stunt to over.
-        int current_stunt_frames_left;
-        
-        // How much size decreases each frame from the current stunt.
-        float stunt_size_decrease_per_frame;
-
-        // The original speed of the fish (for when the speed is temporarly changed).
-        int original_speed_x;
-        int original_speed_y;
+    private:
+    
+        // The text source, and the compiled pack.
+        string source_path;
+        string compiled_path;
         
-        // Sounds.
-        Sound sound_eat;
-        Sound sound_sting;
-       
+        // The compiled pack and its tables (NULL until it is loaded).
+        unsigned char* data;
+        size_t data_size;
+        world_pack_header* header;
+        world_pack_profile* profiles;
+        world_pack_stack* stacks;
+        fish_path* paths;
+        const char* strings;
+        
+        // The fish profiles and their paths stacks, made by resolve() (the profiles on startup first).
+        fish_profile* fish_profiles;
+        paths_stack* paths_stacks;
+        int on_startup_amount;
+        
+        // The background and the welcome window, found by resolve().
+        Texture2D* background;
+        Texture2D* welcome_window;
+        
+        // True if the pack was compiled on this launch.
+        bool is_compiled;
+    
     public:
+    
+        // Constructor.
+        WorldPack(string new_source_path, string new_compiled_path)
+        {
+            source_path = new_source_path;
+            compiled_path = new_compiled_path;
+            
+            data = NULL;
+            data_size = 0;
+            header = NULL;
+            profiles = NULL;
+            stacks = NULL;
+            paths = NULL;
+            strings = NULL;
+            
+            fish_profiles = NULL;
+            paths_stacks = NULL;
+            on_startup_amount = 0;
+            background = NULL;
+            welcome_window = NULL;
+            is_compiled = false;
+        }
         
-        // Counstructor.
-        Fish(int new_fps, Image new_my_fish_image, int* new_frames_amount, frame new_collision_frame, string new_fish_type, bool new_is_sting_proof, Location new_location, Size new_size, float new_speed_x, float new_speed_y, int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, float new_scale, float new_max_scale, float new_eat_grow_ratio, float new_can_eat_ratio, float new_cant_eat_ratio, float new_rotation, bool new_is_facing_left_on_startup, int new_max_cells_within, Cell** new_cells_within, Sound new_sound_eat, Sound new_sound_sting) : MyGif(new_my_fish_image, new_frames_amount, new_collision_frame, "Fish", new_location, new_size, new_scale, new_max_scale, new_rotation, new_is_facing_left_on_startup, new_max_cells_within, new_cells_within)
+        // The function reads the compiled pack, it is compiled first if it is missing or out of date. Returns false if there is no valid pack.
+        bool load()
         {
-            // How many frames are there per second.
-            fps = new_fps;
+            if (header != NULL) { return true; }
             
-            // Save the type of the fish.
-            fish_type = new_fish_type;
+            double start_time = GetTime();
             
-            // Set the speed of the fish.
-            speed_x = new_speed_x;
-            speed_y = new_speed_y;
+            unsigned int source_size = 0;
+            unsigned char* source = LoadFileData(source_path.c_str(), &source_size);
+            uint64_t source_hash = (source != NULL) ? AssetPack::hash_data(source, source_size) : 0;
             
-            // Set the boundaries of the fish.
-            left_boundary = new_left_boundary;
-            right_boundary = new_right_boundary;
-            top_boundary = new_top_boundary;
-            bottom_boundary = new_bottom_boundary;
+            if (!read_compiled(source_hash, source != NULL))
+            {
+                if (source == NULL) { TraceLog(LOG_ERROR, "WorldPack: there is neither %s nor %s", source_path.c_str(), compiled_path.c_str()); return false; }
+                
+                bool is_valid = compile((const char*) source, source_size, source_hash);
+                UnloadFileData(source);
+                if (!is_valid) { return false; }
+                
+                write_compiled();
+                is_compiled = true;
+            }
+            else if (source != NULL) { UnloadFileData(source); }
             
-            // Set false in initialization. Update accurate value on the first move call.
-            is_fish_out_of_bounds = false;
+            TraceLog(LOG_INFO, "WorldPack: world %d, %d fish profiles, %d paths stacks, %d paths, %d bytes (%s in %.3f ms)", header -> world_number, header -> profiles_amount, header -> stacks_amount, header -> paths_amount, (int) data_size, is_compiled ? "compiled" : "read", (GetTime() - start_time) * 1000);
             
-            // Set the moving direction.
-            is_moving_right = (is_facing_left_on_startup) ? false: true;
+            return true;
+        }
+        
+        // The function compiles a source which is in memory, returns false if there is a pack already or the source is not valid.
+        bool compile_source(const char* source, unsigned int source_size)
+        {
+            if (header != NULL) { return false; }
             
-            // The fish is not eaten on startup.
-            is_eaten = false;
+            is_compiled = compile(source, source_size, AssetPack::hash_data((const unsigned char*) source, source_size));
             
-            // The ratio of eating and growing.
-            eat_grow_ratio = new_eat_grow_ratio;
+            return is_compiled;
+        }
+        
+        // The function makes the fish profiles of the pack, for a world of its size (the background is at least sized, see AssetLoader).
+        // Returns false if an asset or a sound of the pack is unknown.
+        bool resolve(AssetLoader* asset_loader, int x_coord_offset, const char** sound_names, sound_variant* sounds, int sounds_amount)
+        {
+            if (fish_profiles != NULL) { return true; }
             
-            // The ratio of fish size can eat.
-            can_eat_ratio = new_can_eat_ratio;
+            background = asset_loader -> find_texture(strings + header -> background);
+            welcome_window = asset_loader -> find_texture(strings + header -> welcome_window);
+            if (background == NULL || welcome_window == NULL) { TraceLog(LOG_ERROR, "WorldPack: the textures of world %d were not added to the asset loader", header -> world_number); return false; }
             
-            // The ratio of fish size can't eat.
-            cant_eat_ratio = new_cant_eat_ratio;
+            fish_profile* new_profiles = new fish_profile[header -> profiles_amount];
+            paths_stack* new_stacks = new paths_stack[header -> stacks_amount];
+            int profiles_amount = 0;
+            on_startup_amount = 0;
             
-            // Stunt properties.
-            is_sting_proof = new_is_sting_proof;
-            current_stunt_frames_left = 0;
-            stunt_size_decrease_per_frame = 0;
+            // The profiles on startup first, then the available fish.
+            for (int is_on_startup = 1; is_on_startup >= 0; is_on_startup--)
+            {
+                for (int i = 0; i < header -> profiles_amount; i++)
+                {
+                    world_pack_profile* source = &profiles[i];
+                    if (source -> is_on_startup != is_on_startup) { continue; }
+                    
+                    fish_profile* profile = &new_profiles[profiles_amount++];
+                    if (is_on_startup) { on_startup_amount++; }
+                    
+                    const char* animation = strings + source -> animation;
+                    int sound_eat = find_sound(strings + source -> sound_eat, sound_names, sounds_amount);
+                    int sound_sting = find_sound(strings + source -> sound_sting, sound_names, sounds_amount);
+                    
+                    if (!asset_loader -> find_animation(animation, &profile -> fish_image, &profile -> fish_image_frames_amount) || sound_eat < 0 || sound_sting < 0)
+                    {
+                        TraceLog(LOG_ERROR, "WorldPack: \"%s\" of world %d has an unknown animation or sound", strings + source -> fish_type, header -> world_number);
+                        delete[] new_profiles;
+                        delete[] new_stacks;
+                        return false;
+                    }
+                    
+                    profile -> fish_type = strings + source -> fish_type;
+                    profile -> collision_frame = source -> collision_frame;
+                    profile -> is_sting_proof = source -> is_sting_proof != 0;
+                    profile -> is_facing_left_on_startup = source -> is_facing_left_on_startup != 0;
+                    profile -> size = Size(source -> width, source -> height);
+                    profile -> max_scaling = source -> max_scaling;
+                    profile -> min_speed_x = source -> min_speed_x;
+                    profile -> max_speed_x = source -> max_speed_x;
+                    profile -> min_speed_y = source -> min_speed_y;
+                    profile -> max_speed_y = source -> max_speed_y;
+                    profile -> min_frames_per_path = source -> min_frames_per_path;
+                    profile -> max_frames_per_path = source -> max_frames_per_path;
+                    profile -> can_eat_ratio = source -> can_eat_ratio;
+                    profile -> cant_eat_ratio = source -> cant_eat_ratio;
+                    profile -> is_randomize_initial_scale = source -> is_randomize_initial_scale != 0;
+                    profile -> paths_stacks_amount = source -> stacks_amount;
+                    profile -> paths_stacks = &new_stacks[source -> first_stack];
+                    profile -> sound_eat = sounds[sound_eat];
+                    profile -> sound_sting = sounds[sound_sting];
+                    profile -> proportion = source -> proportion;
+                    
+                    // The paths stacks, with the coordinates in this world.
+                    int image_height = profile -> fish_image -> height;
+                    
+                    for (int j = source -> first_stack; j < source -> first_stack + source -> stacks_amount; j++)
+                    {
+                        world_pack_stack* stack = &stacks[j];
+                        paths_stack* target = &new_stacks[j];
+                        
+                        target -> initial_location = Location(get_coordinate(stack -> initial_x, stack -> initial_x_anchor, x_coord_offset, image_height), get_coordinate(stack -> initial_y, stack -> initial_y_anchor, x_coord_offset, image_height));
+                        target -> initial_y_coordinate = get_coordinate(stack -> initial_y_coordinate, stack -> initial_y_coordinate_anchor, x_coord_offset, image_height);
+                        target -> length = stack -> paths_amount;
+                        target -> paths = &paths[stack -> first_path];
+                        target -> is_repeat = stack -> is_repeat != 0;
+                        target -> is_initial_location = stack -> is_initial_location != 0;
+                        target -> is_initial_y_coordinate = stack -> is_initial_y_coordinate != 0;
+                        target -> is_randomize_x_coordinate = stack -> is_randomize_x_coordinate != 0;
+                        target -> is_left = stack -> is_left != 0;
+                    }
+                }
+            }
             
-            // Sounds.
-            sound_eat = new_sound_eat;
-            sound_sting = new_sound_sting;
-        }
-
-        // Default Constructor.
-        Fish() : MyGif()
-        {
-            fish_type = "none";
-            speed_x = 1;
-            speed_y = 1;
-            left_boundary = 0;
-            right_boundary = 0;
-            top_boundary = 1;
-            bottom_boundary = 1;
-            is_fish_out_of_bounds = false;
-            is_eaten = false;
-        }
-
-        // Apply movements (including boundaries check).
-        void move_left(float ratio) 
-        {
-            if (location.x - (int)(ratio * speed_x) < left_boundary) { location.x = left_boundary; boundary_exceed(); is_fish_out_of_bounds = true; }
-            else { location.x -= (int)floor(ratio * speed_x + 0.5); flip_horizontal(); }
+            fish_profiles = new_profiles;
+            paths_stacks = new_stacks;
             
-            if (is_moving_right) { flip_collision_frame_horizontal(); }
-            is_moving_right = false;
+            return true;
         }
         
-        void move_right(float ratio) 
-        {
-            if (location.x + (int) (ratio * speed_x) > right_boundary) { location.x = right_boundary; boundary_exceed(); is_fish_out_of_bounds = true;}
-            else { location.x += (int)floor(ratio * speed_x + 0.5); unflip_horizontal(); }
-            
-            if (!is_moving_right) { flip_collision_frame_horizontal(); }
-            is_moving_right = true;
-        }
+        // Getters.
+        int get_world_number() { return header -> world_number; }
+        int get_width() { return (header -> world_width > 0) ? header -> world_width : background -> width; }
+        int get_height() { return (header -> world_height > 0) ? header -> world_height : background -> height; }
+        int get_population() { return header -> population; }
+        int get_grid_columns() { return header -> grid_columns; }
+        int get_grid_rows() { return header -> grid_rows; }
+        Texture2D* get_background() { return background; }
+        Texture2D* get_welcome_window() { return welcome_window; }
+        fish_profile* get_profiles_on_startup() { return fish_profiles; }
+        int get_profiles_on_startup_amount() { return on_startup_amount; }
+        fish_profile* get_available_fish() { return fish_profiles + on_startup_amount; }
+        int get_available_fish_amount() { return header -> profiles_amount - on_startup_amount; }
+        
+        // The tables of the pack, and its strings by their offsets.
+        int get_profiles_amount() { return header -> profiles_amount; }
+        world_pack_profile* get_pack_profile(int index) { return &profiles[index]; }
+        world_pack_stack* get_pack_stack(int index) { return &stacks[index]; }
+        const char* get_string(int offset) { return strings + offset; }
+        const char* get_background_path() { return strings + header -> background; }
+        const char* get_welcome_window_path() { return strings + header -> welcome_window; }
+    
+    private:
+    
+        // The layout version of the pack.
+        static const uint32_t VERSION = 2;
         
-        void move_up(float ratio) 
+        // The longest line of a source.
+        static const int MAX_LINE_LENGTH = 1024;
+        
+        // The function returns a coordinate of the pack in the world (the image height is of the fish it belongs to).
+        int get_coordinate(int value, int anchor, int x_coord_offset, int image_height)
         {
-            if (location.y - (int)(ratio * speed_y) < top_boundary) { location.y = top_boundary; boundary_exceed(); is_fish_out_of_bounds = true;}
-            else { location.y -= (int)floor(ratio * speed_y + 0.5); }
+            switch (anchor)
+            {
+                case WORLD_ANCHOR_LEFT: return - x_coord_offset + value;
+                case WORLD_ANCHOR_RIGHT: return get_width() + x_coord_offset + value;
+                case WORLD_ANCHOR_BOTTOM: return get_height() + value;
+                case WORLD_ANCHOR_ABOVE: return - image_height + value;
+                default: return value;
+            }
         }
         
-        void move_down(float ratio) 
+        // The function returns the index of a sound by its name, -1 if it is unknown.
+        static int find_sound(const char* name, const char** sound_names, int sounds_amount)
         {
-            if (location.y + (int)(ratio * speed_y) > bottom_boundary) { location.y = bottom_boundary; boundary_exceed(); is_fish_out_of_bounds = true;}
-            else { location.y += (int)floor(ratio * speed_y + 0.5); }
+            for (int i = 0; i < sounds_amount; i++) { if (strcmp(sound_names[i], name) == 0) { return i; } }
+            
+            return -1;
         }
         
-        // The function causes the fish a jelly fish stunt.
-        virtual void jelly_fish_stunt(float stunt_power)
+        // The function reads the compiled pack, returns false if it is missing, broken or out of date.
+        bool read_compiled(uint64_t source_hash, bool is_source)
         {
-            // Sting proof.
-            if (is_sting_proof) { return; }
+            FILE* pack_file = fopen(compiled_path.c_str(), "rb");
+            if (pack_file == NULL) { return false; }
             
-            // Currently in a stunt, can't be stunt again.
-            if (current_stunt_frames_left > 0) { return; }
+            fseek(pack_file, 0, SEEK_END);
+            long file_size = ftell(pack_file);
+            fseek(pack_file, 0, SEEK_SET);
             
-            // Play sting sound.
-            PlaySound(sound_sting);
+            if (file_size < (long) sizeof(world_pack_header)) { fclose(pack_file); return false; }
             
-            // Stunt.
-            current_stunt_frames_left = (int) floor(stunt_power * fps);
+            unsigned char* file_data = new unsigned char[file_size];
+            bool is_read = fread(file_data, 1, file_size, pack_file) == (size_t) file_size;
+            fclose(pack_file);
             
-            // Calculate how much scale decreases each frame.
-            stunt_size_decrease_per_frame = (((scale - 1) / 4) * stunt_power) / current_stunt_frames_left;
+            if (!is_read || !is_valid_pack(file_data, file_size)) { TraceLog(LOG_WARNING, "WorldPack: %s is broken", compiled_path.c_str()); delete[] file_data; return false; }
             
-            // Save the current speed and stunt.
-            original_speed_x = speed_x;
-            original_speed_y = speed_y;
-            speed_x = 0;
-            speed_y = 0;
+            // The source was changed since the pack was compiled.
+            if (is_source && ((world_pack_header*) file_data) -> source_hash != source_hash) { TraceLog(LOG_INFO, "WorldPack: %s is out of date", compiled_path.c_str()); delete[] file_data; return false; }
+            
+            set_tables(file_data, file_size);
+            
+            return true;
         }
         
-        // Update the stunt for the current frame.
-        void update_stunt()
+        // The function replaces the compiled pack (a cache, a failure only costs a compile on the next launch).
+        void write_compiled() { AtomicFileWriter::write(compiled_path, data, data_size, false); }
+        
+        // The function returns true if the data is a whole pack, which every offset and range of is within its tables.
+        static bool is_valid_pack(const unsigned char* pack_data, size_t pack_size)
         {
-            // If currently finished stun.
-            if (current_stunt_frames_left == 1)
+            const world_pack_header* pack_header = (const world_pack_header*) pack_data;
+            
+            if (memcmp(pack_header -> magic, "FWPK", 4) != 0 || pack_header -> version != VERSION) { return false; }
+            if (pack_header -> profiles_amount <= 0 || pack_header -> stacks_amount <= 0 || pack_header -> paths_amount <= 0 || pack_header -> strings_size <= 0) { return false; }
+            
+            size_t expected_size = sizeof(world_pack_header) + pack_header -> profiles_amount * sizeof(world_pack_profile) + pack_header -> stacks_amount * sizeof(world_pack_stack) + pack_header -> paths_amount * sizeof(fish_path) + pack_header -> strings_size;
+            if (pack_size != expected_size) { return false; }
+            if (pack_header -> checksum != Save::checksum(pack_data + sizeof(world_pack_header), pack_size - sizeof(world_pack_header))) { return false; }
+            
+            const world_pack_profile* pack_profiles = (const world_pack_profile*) (pack_data + sizeof(world_pack_header));
+            const world_pack_stack* pack_stacks = (const world_pack_stack*) (pack_profiles + pack_header -> profiles_amount);
+            const char* pack_strings = (const char*) ((const fish_path*) (pack_stacks + pack_header -> stacks_amount) + pack_header -> paths_amount);
+            int strings_size = pack_header -> strings_size;
+            
+            // Every string ends within the strings.
+            if (pack_strings[strings_size - 1] != '\0') { return false; }
+            if (!is_in_range(pack_header -> background, 1, strings_size) || !is_in_range(pack_header -> welcome_window, 1, strings_size)) { return false; }
+            
+            for (int i = 0; i < pack_header -> profiles_amount; i++)
             {
-                // If the scale is not big enough, the fish is dead.
-                if (scale < 1.2) { eaten(); return; }
+                const world_pack_profile* profile = &pack_profiles[i];
                 
-                // Restore the speed of the fish.
-                speed_x = original_speed_x;
-                speed_y = original_speed_y;
-                update_tint(WHITE);
-                current_stunt_frames_left--;
+                if (!is_in_range(profile -> animation, 1, strings_size) || !is_in_range(profile -> fish_type, 1, strings_size)) { return false; }
+                if (!is_in_range(profile -> sound_eat, 1, strings_size) || !is_in_range(profile -> sound_sting, 1, strings_size)) { return false; }
+                if (profile -> stacks_amount <= 0 || !is_in_range(profile -> first_stack, profile -> stacks_amount, pack_header -> stacks_amount)) { return false; }
             }
             
-            // Move to the next frame.
-            if (current_stunt_frames_left > 0) 
+            for (int i = 0; i < pack_header -> stacks_amount; i++)
             {
-                current_stunt_frames_left--;
-                
-                // Update the tint for sting effect.
-                if (current_stunt_frames_left % 2 == 1) { tint = BLUE; }
-                else { tint = WHITE; }
-                
-                // Decrease the size.
-                scale -= stunt_size_decrease_per_frame;
+                if (pack_stacks[i].paths_amount <= 0 || !is_in_range(pack_stacks[i].first_path, pack_stacks[i].paths_amount, pack_header -> paths_amount)) { return false; }
             }
+            
+            return true;
         }
         
-        // The function receives new boundaries, and sets them as the new boundaries of the fish.
-        void update_boundaries(int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, bool is_consider_size)
+        // The function returns true if the range [first, first + amount) is within [0, size).
+        static bool is_in_range(int first, int amount, int size) { return first >= 0 && amount >= 0 && first <= size - amount; }
+        
+        // The function makes the pack the loaded one (the pack is valid).
+        void set_tables(unsigned char* pack_data, size_t pack_size)
         {
-            // Note: the boundaries are compared to the current location of the fish, which considers its center. Therefore the precise boundary would be calculated with half the current dimentions of the fish.
-            if (is_consider_size)
+            data = pack_data;
+            data_size = pack_size;
+            header = (world_pack_header*) data;
+            profiles = (world_pack_profile*) (data + sizeof(world_pack_header));
+            stacks = (world_pack_stack*) (profiles + header -> profiles_amount);
+            paths = (fish_path*) (stacks + header -> stacks_amount);
+            strings = (const char*) (paths + header -> paths_amount);
+        }
+        
+        // The function compiles the text source to a pack, and makes it the loaded one. Returns false (and logs the line) if the source is not valid.
+        bool compile(const char* source, unsigned int source_size, uint64_t source_hash)
+        {
+            // Every line adds a single record at most, so the tables are sized by the lines.
+            int lines_amount = 1;
+            for (unsigned int i = 0; i < source_size; i++) { if (source[i] == '\n') { lines_amount++; } }
+            
+            world_pack_header new_header;
+            memset(&new_header, 0, sizeof(world_pack_header));
+            memcpy(new_header.magic, "FWPK", 4);
+            new_header.version = VERSION;
+            new_header.source_hash = source_hash;
+            new_header.background = -1;
+            new_header.welcome_window = -1;
+            
+            world_pack_profile* new_profiles = new world_pack_profile[lines_amount];
+            world_pack_stack* new_stacks = new world_pack_stack[lines_amount];
+            fish_path* new_paths = new fish_path[lines_amount];
+            char* new_strings = new char[source_size + lines_amount];
+            int profiles_amount = 0, stacks_amount = 0, paths_amount = 0, strings_size = 0;
+            
+            // The profile and the stack which the next lines belong to.
+            world_pack_profile* profile = NULL;
+            world_pack_stack* stack = NULL;
+            
+            const char* error = NULL;
+            char line[MAX_LINE_LENGTH];
+            int line_number = 0;
+            unsigned int position = 0;
+            
+            while (error == NULL && position < source_size)
             {
-                left_boundary = new_left_boundary - (int) floor(sqrt(scale) * size.width / 2);
-                right_boundary = new_right_boundary + (int) ceil(sqrt(scale) * size.width / 2);
-                top_boundary = new_top_boundary - (int) floor(sqrt(scale) * size.height / 2);
-                bottom_boundary = new_bottom_boundary + (int) ceil(sqrt(scale) * size.height / 2);
+                // Copy the line, without its comment.
+                int line_length = 0;
+                while (position < source_size && source[position] != '\n')
+                {
+                    if (line_length < MAX_LINE_LENGTH - 1) { line[line_length++] = source[position]; }
+                    position++;
+                }
+                
+                position++;
+                line_number++;
+                line[line_length] = '\0';
+                
+                char* comment = strchr(line, '#');
+                if (comment != NULL) { *comment = '\0'; }
+                
+                char* cursor = line;
+                char* key = next_token(&cursor);
+                if (key == NULL) { continue; }
+                
+                // The values of most keys are tokens, the rest of the line is a single value for the strings.
+                bool is_rest_of_line = false;
+                
+                // - World.
+                if (strcmp(key, "world") == 0) { if (!parse_int(next_token(&cursor), &new_header.world_number) || new_header.world_number <= 0) { error = "expected a world number"; } }
+                else if (strcmp(key, "population") == 0) { if (!parse_int(next_token(&cursor), &new_header.population) || new_header.population <= 0) { error = "expected a population"; } }
+                else if (strcmp(key, "grid") == 0)
+                {
+                    if (!parse_int(next_token(&cursor), &new_header.grid_columns) || !parse_int(next_token(&cursor), &new_header.grid_rows) || new_header.grid_columns <= 0 || new_header.grid_rows <= 0) { error = "expected the columns and rows of the grid"; }
+                }
+                else if (strcmp(key, "world_size") == 0)
+                {
+                    if (!parse_int(next_token(&cursor), &new_header.world_width) || !parse_int(next_token(&cursor), &new_header.world_height) || new_header.world_width <= 0 || new_header.world_height <= 0) { error = "expected the width and height of the world"; }
+                }
+                else if (strcmp(key, "background") == 0 || strcmp(key, "welcome_window") == 0)
+                {
+                    is_rest_of_line = true;
+                    int* target = (strcmp(key, "background") == 0) ? &new_header.background : &new_header.welcome_window;
+                    if (!add_rest_of_line(cursor, new_strings, &strings_size, target)) { error = "expected a path"; }
+                }
+                
+                // - Fish profile.
+                else if (strcmp(key, "fish") == 0)
+                {
+                    is_rest_of_line = true;
+                    profile = &new_profiles[profiles_amount++];
+                    stack = NULL;
+                    
+                    // The defaults.
+                    memset(profile, 0, sizeof(world_pack_profile));
+                    profile -> animation = -1;
+                    profile -> sound_eat = -1;
+                    profile -> sound_sting = -1;
+                    profile -> max_scaling = 1;
+                    profile -> min_frames_per_path = 30;
+                    profile -> max_frames_per_path = 300;
+                    profile -> can_eat_ratio = 1.2;
+                    profile -> cant_eat_ratio = 2;
+                    profile -> proportion = 1;
+                    profile -> first_stack = stacks_amount;
+                    
+                    if (!add_rest_of_line(cursor, new_strings, &strings_size, &profile -> fish_type)) { error = "expected a fish type"; }
+                }
+                else if (profile == NULL && strcmp(key, "stack") != 0 && strcmp(key, "path") != 0) { error = "unknown world property"; }
+                else if (strcmp(key, "animation") == 0) { is_rest_of_line = true; if (!add_rest_of_line(cursor, new_strings, &strings_size, &profile -> animation)) { error = "expected a path"; } }
+                else if (strcmp(key, "collision") == 0)
+                {
+                    frame* collision_frame = &profile -> collision_frame;
+                    if (!parse_int(next_token(&cursor), &collision_frame -> x_offset) || !parse_int(next_token(&cursor), &collision_frame -> y_offset) || !parse_int(next_token(&cursor), &collision_frame -> width) || !parse_int(next_token(&cursor), &collision_frame -> height)) { error = "expected x, y, width and height"; }
+                }
+                else if (strcmp(key, "size") == 0) { if (!parse_int(next_token(&cursor), &profile -> width) || !parse_int(next_token(&cursor), &profile -> height) || profile -> width <= 0 || profile -> height <= 0) { error = "expected a width and a height"; } }
+                else if (strcmp(key, "max_scaling") == 0) { if (!parse_float(next_token(&cursor), &profile -> max_scaling)) { error = "expected a scale"; } }
+                else if (strcmp(key, "speed_x") == 0) { if (!parse_float(next_token(&cursor), &profile -> min_speed_x) || !parse_float(next_token(&cursor), &profile -> max_speed_x)) { error = "expected a minimum and a maximum"; } }
+                else if (strcmp(key, "speed_y") == 0) { if (!parse_float(next_token(&cursor), &profile -> min_speed_y) || !parse_float(next_token(&cursor), &profile -> max_speed_y)) { error = "expected a minimum and a maximum"; } }
+                else if (strcmp(key, "frames_per_path") == 0)
+                {
+                    if (!parse_int(next_token(&cursor), &profile -> min_frames_per_path) || !parse_int(next_token(&cursor), &profile -> max_frames_per_path) || profile -> min_frames_per_path > profile -> max_frames_per_path) { error = "expected a minimum and a maximum"; }
+                }
+                else if (strcmp(key, "eat_ratios") == 0) { if (!parse_float(next_token(&cursor), &profile -> can_eat_ratio) || !parse_float(next_token(&cursor), &profile -> cant_eat_ratio)) { error = "expected the can eat and can't eat ratios"; } }
+                else if (strcmp(key, "sounds") == 0)
+                {
+                    if (!add_string(next_token(&cursor), new_strings, &strings_size, &profile -> sound_eat) || !add_string(next_token(&cursor), new_strings, &strings_size, &profile -> sound_sting)) { error = "expected the eat and sting sounds"; }
+                }
+                else if (strcmp(key, "proportion") == 0) { if (!parse_float(next_token(&cursor), &profile -> proportion) || profile -> proportion < 0) { error = "expected a proportion"; } }
+                else if (strcmp(key, "sting_proof") == 0) { profile -> is_sting_proof = 1; }
+                else if (strcmp(key, "facing_left") == 0) { profile -> is_facing_left_on_startup = 1; }
+                else if (strcmp(key, "randomize_scale") == 0) { profile -> is_randomize_initial_scale = 1; }
+                else if (strcmp(key, "on_startup") == 0) { profile -> is_on_startup = 1; }
+                
+                // - Paths stack.
+                else if (strcmp(key, "stack") == 0)
+                {
+                    if (profile == NULL) { error = "a stack out of a fish"; }
+                    else
+                    {
+                        is_rest_of_line = true;
+                        stack = &new_stacks[stacks_amount++];
+                        memset(stack, 0, sizeof(world_pack_stack));
+                        stack -> first_path = paths_amount;
+                        profile -> stacks_amount++;
+                        
+                        for (char* flag = next_token(&cursor); flag != NULL && error == NULL; flag = next_token(&cursor))
+                        {
+                            if (strcmp(flag, "from_left") == 0) { stack -> is_left = 1; }
+                            else if (strcmp(flag, "from_right") == 0) { stack -> is_left = 0; }
+                            else if (strcmp(flag, "repeat") == 0) { stack -> is_repeat = 1; }
+                            else if (strcmp(flag, "start_at_location") == 0) { stack -> is_initial_location = 1; }
+                            else if (strcmp(flag, "randomize_x") == 0) { stack -> is_randomize_x_coordinate = 1; }
+                            else if (strcmp(flag, "location") == 0)
+                            {
+                                if (!parse_coordinate(next_token(&cursor), &stack -> initial_x_anchor, &stack -> initial_x) || !parse_coordinate(next_token(&cursor), &stack -> initial_y_anchor, &stack -> initial_y)) { error = "expected the x and y of the location"; }
+                            }
+                            else if (strcmp(flag, "y") == 0)
+                            {
+                                stack -> is_initial_y_coordinate = 1;
+                                if (!parse_coordinate(next_token(&cursor), &stack -> initial_y_coordinate_anchor, &stack -> initial_y_coordinate)) { error = "expected a y coordinate"; }
+                            }
+                            else { error = "unknown stack flag"; }
+                        }
+                    }
+                }
+                else if (strcmp(key, "path") == 0)
+                {
+                    if (stack == NULL) { error = "a path out of a stack"; }
+                    else
+                    {
+                        fish_path* path = &new_paths[paths_amount];
+                        char* horizontal = NULL;
+                        char* vertical = NULL;
+                        
+                        if (!parse_int(next_token(&cursor), &path -> speed_x) || !parse_int(next_token(&cursor), &path -> speed_y) || (horizontal = next_token(&cursor)) == NULL || (vertical = next_token(&cursor)) == NULL || !parse_int(next_token(&cursor), &path -> current_frames_left)) { error = "expected speed x, speed y, right or left, up or down and frames"; }
+                        else if ((strcmp(horizontal, "right") != 0 && strcmp(horizontal, "left") != 0) || (strcmp(vertical, "up") != 0 && strcmp(vertical, "down") != 0)) { error = "expected right or left, and up or down"; }
+                        else
+                        {
+                            path -> is_moving_right = strcmp(horizontal, "right") == 0;
+                            path -> is_moving_top = strcmp(vertical, "up") == 0;
+                            paths_amount++;
+                            stack -> paths_amount++;
+                        }
+                    }
+                }
+                else { error = "unknown fish property"; }
+                
+                if (error == NULL && !is_rest_of_line && next_token(&cursor) != NULL) { error = "too many values"; }
+            }
+            
+            // The whole world was described.
+            if (error == NULL)
+            {
+                if (new_header.world_number <= 0 || new_header.population <= 0 || new_header.grid_columns <= 0 || new_header.background < 0 || new_header.welcome_window < 0) { error = "the world, population, grid, background or welcome_window is missing"; }
+                else if (profiles_amount == 0) { error = "there are no fish"; }
+                
+                for (int i = 0; i < profiles_amount && error == NULL; i++)
+                {
+                    if (new_profiles[i].animation < 0 || new_profiles[i].width <= 0 || new_profiles[i].sound_eat < 0 || new_profiles[i].stacks_amount == 0) { error = "a fish without an animation, size, sounds or stacks"; }
+                }
+                
+                for (int i = 0; i < stacks_amount && error == NULL; i++) { if (new_stacks[i].paths_amount == 0) { error = "a stack without paths"; } }
+                
+                line_number = 0;
             }
             
+            if (error != NULL)
+            {
+                if (line_number > 0) { TraceLog(LOG_ERROR, "WorldPack: %s:%d: %s", source_path.c_str(), line_number, error); }
+                else { TraceLog(LOG_ERROR, "WorldPack: %s: %s", source_path.c_str(), error); }
+            }
             else
             {
-                left_boundary = new_left_boundary;
-                right_boundary = new_right_boundary;
-                top_boundary = new_top_boundary;
-                bottom_boundary = new_bottom_boundary;
+                new_header.profiles_amount = profiles_amount;
+                new_header.stacks_amount = stacks_amount;
+                new_header.paths_amount = paths_amount;
+                new_header.strings_size = strings_size;
+                
+                // Lay the tables after the header.
+                size_t pack_size = sizeof(world_pack_header) + profiles_amount * sizeof(world_pack_profile) + stacks_amount * sizeof(world_pack_stack) + paths_amount * sizeof(fish_path) + strings_size;
+                unsigned char* pack_data = new unsigned char[pack_size];
+                unsigned char* target = pack_data;
+                
+                memcpy(target, &new_header, sizeof(world_pack_header)); target += sizeof(world_pack_header);
+                memcpy(target, new_profiles, profiles_amount * sizeof(world_pack_profile)); target += profiles_amount * sizeof(world_pack_profile);
+                memcpy(target, new_stacks, stacks_amount * sizeof(world_pack_stack)); target += stacks_amount * sizeof(world_pack_stack);
+                memcpy(target, new_paths, paths_amount * sizeof(fish_path)); target += paths_amount * sizeof(fish_path);
+                memcpy(target, new_strings, strings_size);
+                
+                ((world_pack_header*) pack_data) -> checksum = Save::checksum(pack_data + sizeof(world_pack_header), pack_size - sizeof(world_pack_header));
+                set_tables(pack_data, pack_size);
             }
+            
+            delete[] new_profiles;
+            delete[] new_stacks;
+            delete[] new_paths;
+            delete[] new_strings;
+            
+            return error == NULL;
         }
         
-        // The function is being called when the fish is out of bounds.
-        void boundary_exceed() { if (fish_type != "my fish") { delete_gif(); } }
-        
-        // Returns true if the fish is out of bounds.
-        bool get_is_fish_out_of_bounds() { return is_fish_out_of_bounds; }
-        
-        // Getters.
-        Size get_size() { return size; }
-        string get_fish_type() { return fish_type; }
-        bool get_is_eaten() { return is_eaten; }
+        // The function returns the next token of a line and moves the cursor after it, NULL at the end of the line.
+        static char* next_token(char** cursor)
+        {
+            char* start = *cursor;
+            while (*start != '\0' && isspace((unsigned char) *start)) { start++; }
+            if (*start == '\0') { *cursor = start; return NULL; }
+            
+            char* end = start;
+            while (*end != '\0' && !isspace((unsigned char) *end)) { end++; }
+            
+            if (*end != '\0') { *end = '\0'; end++; }
+            *cursor = end;
+            
+            return start;
+        }
         
-        // The function deletes the fish from the world.
-        // If the gif is not a part of a network, it is required to manualy remove it from the grid.
-        void delete_fish()
+        // The function parses a whole token as an integer.
+        static bool parse_int(const char* token, int32_t* value)
         {
-            // delete_gif();
+            if (token == NULL) { return false; }
+            
+            char* end;
+            long parsed = strtol(token, &end, 10);
+            if (*end != '\0' || end == token) { return false; }
+            
+            *value = (int32_t) parsed;
+            return true;
         }
         
-        // The function receives the amount of pixels were eaten by the fish (simply calculation of width, height and scale of the eaten entity), and increases the size of the fish.
-        bool eat (int pixels)
+        // The function parses a whole token as a number.
+        static bool parse_float(const char* token, float* value)
         {
-            // Cannot eat, already max size.
-            if (scale == max_scale) { return false; }
+            if (token == NULL) { return false; }
             
-            // Play eating sound.
-            PlaySound(sound_eat);
+            char* end;
+            float parsed = strtof(token, &end);
+            if (*end != '\0' || end == token) { return false; }
             
-            // Use the ratio to decide how much of the recieved pixels to digest.
-            pixels = (int) floor(pixels * eat_grow_ratio);
+            *value = parsed;
+            return true;
+        }
+        
+        // The function parses a coordinate: a number, or an anchor with an optional offset (see WorldAnchor).
+        static bool parse_coordinate(const char* token, uint8_t* anchor, int32_t* value)
+        {
+            if (token == NULL) { return false; }
             
-            // How many pixels are required to increase the width and the height by 1 pixel (the 4 is for the corners).
-            int current_pixels_for_loop = (int) floor((2 * size.width * sqrt(scale)) + (2 * size.height * sqrt(scale)) + 4);
+            const char* anchors_names[] = {"left", "right", "bottom", "above"};
+            const WorldAnchor anchors[] = {WORLD_ANCHOR_LEFT, WORLD_ANCHOR_RIGHT, WORLD_ANCHOR_BOTTOM, WORLD_ANCHOR_ABOVE};
             
-            // How many full loops can be added.
-            int full_loops_counter = 0;
+            *anchor = WORLD_ANCHOR_NONE;
+            *value = 0;
             
-            // Count the full loops available, and update the left pixels.
-            while (pixels > current_pixels_for_loop)
+            for (int i = 0; i < 4; i++)
             {
-                pixels -= current_pixels_for_loop;
-                current_pixels_for_loop += 4;
-                full_loops_counter += 1;
+                size_t name_length = strlen(anchors_names[i]);
+                if (strncmp(token, anchors_names[i], name_length) != 0) { continue; }
+                
+                *anchor = anchors[i];
+                token += name_length;
+                
+                // Only the anchor.
+                if (*token == '\0') { return true; }
+                if (*token != '+' && *token != '-') { return false; }
+                break;
             }
             
-            // The new scale is the current width + the added pixels / the original width of the fish.
-            float new_scale = (float) pow(((size.width * sqrt(scale)) + full_loops_counter + ( (double) pixels / current_pixels_for_loop) ) / size.width, 2);
-            if (new_scale > max_scale) { scale = max_scale; }
-            else { scale = new_scale; }
-            
-            // Scaled up.
-            return true;
+            return parse_int(token, value);
         }
         
-        // The function is being called when the fish is getting eaten.
-        void eaten()
+        // The function adds a token to the strings, returns false if there is no token.
+        static bool add_string(const char* token, char* strings_table, int* strings_size, int32_t* offset)
         {
-            // Indicate that the fish is getting eaten.
-            is_eaten = true;
+            if (token == NULL) { return false; }
+            
+            size_t length = strlen(token);
+            memcpy(strings_table + *strings_size, token, length + 1);
+            *offset = *strings_size;
+            *strings_size += length + 1;
+            
+            return true;
         }
         
-        // Eat ratio getters.
-        float get_can_eat_ratio() { return can_eat_ratio; }
-        float get_cant_eat_ratio() { return cant_eat_ratio; }
-        
-        // The function handles a collision between the fish and another GridEntity (Note that a collision between two entities is called only once).
-        void handle_collision(GridEntity* collided_with_entity)
+        // The function adds the rest of a line to the strings (a path or a name with spaces), without its surrounding spaces.
+        static bool add_rest_of_line(char* cursor, char* strings_table, int* strings_size, int32_t* offset)
         {
-            // It's a collision of two fish.
-            if (collided_with_entity -> get_entity_type() == "Fish")
-            {   
-                // There is no canibalism in fish-hood.
-                if (fish_type == ((Fish*) collided_with_entity) -> get_fish_type())
-                {
-                    // Ignore the collision.
-                    return;
-                }
-                
-                // - Handle My Fish and Jelly Fish Collision -
-                
-                if (((Fish*) collided_with_entity) -> get_fish_type().rfind("Jelly Fish", 0) == 0)
-                {
-                    jelly_fish_stunt(((Fish*) collided_with_entity) -> scale);
-                    return;
-                }
-                
-                else if (fish_type.rfind("Jelly Fish", 0) == 0)
-                {
-                    ((Fish*) collided_with_entity) -> jelly_fish_stunt(scale);
-                    return;
-                }
-                
-                // - Handle Classic Fish Collision -
-                
-                // The size in width of the current fish.
-                int my_size = (int) floor(size.width * size.height * scale);
+            while (*cursor != '\0' && isspace((unsigned char) *cursor)) { cursor++; }
             
-                // The size in width of the received fish.
-                int other_size = (int) floor(collided_with_entity -> get_size().width * collided_with_entity -> get_size().height * collided_with_entity -> get_scale());
-
-                // Check if the current fish can eat the other one.
-                if (my_size > other_size * can_eat_ratio && (my_size < other_size * cant_eat_ratio || fish_type == "my fish" || ((Fish*) collided_with_entity) -> get_fish_type() == "my fish"))
-                {
-                    // Try to eat, if ate, update eaten.
-                    if (eat(other_size)) { ((Fish*) collided_with_entity) -> eaten(); }
-                }
-                
-                // Check if the other fish can eat the current one.
-                else if (other_size > my_size * ((Fish*) collided_with_entity) -> get_can_eat_ratio() && (other_size < my_size * ((Fish*) collided_with_entity) -> get_cant_eat_ratio() || fish_type == "my fish" || ((Fish*) collided_with_entity) -> get_fish_type() == "my fish"))
-                {
-                    // Try to eat, if ate, update eaten.
-                    if (((Fish*)collided_with_entity) -> eat(my_size)) { eaten(); }
-                }
-            }           
+            char* end = cursor + strlen(cursor);
+            while (end > cursor && isspace((unsigned char) end[-1])) { end--; }
+            *end = '\0';
+            
+            if (*cursor == '\0') { return false; }
+            
+            return add_string(cursor, strings_table, strings_size, offset);
         }
 };
 
 
-class MyFish : public Fish
+class WorldCatalog
 {
     /*
-        Represents the fish of the user.
+        The worlds of the game, described by their world packs (see WorldPack). A world is created when it is first played, the packs of
+        worlds which are not played are never read.
+        
+        Notes:
+            - A world is created from its pack with my fish in its middle, and kept as long as the game runs (see GameWorld).
+            - The population and the grid of a pack are capped by the limits the game was set-up with (the simulation and the world state are
+              sized by them).
+            - The packs refer to the sounds by their names, the catalog holds the sounds by those names.
     */
     
-    protected:
-        
-        // The speed multiplier when turbo is on.
-        float turbo;
-        
-        // How many frames the turbo last.
-        int turbo_duration_frames;
-        
-        // How many frames left till the end of the current turbo.
-        int turbo_duration_frames_left;
-        
-        // How many frames last to finish the turbo reloading.
-        int turbo_reload_frames_left;
-        
-        // How many frames it takes to revive the turbo.
-        int turbo_reload_frames;
+    private:
     
-        // When my fish reach that scale, victory.
-        float required_scale;
-        
-        // Where on the screen to draw the scale widget.
-        Location scale_widget_location;
-        
-        // The size of the scale widget.
-        Size scale_widget_size;
+        // The packs and the worlds, by the world number (NULL until they are needed, index 0 is the backdrop which is not in the catalog).
+        int worlds_amount;
+        WorldPack** packs;
+        GameWorld** worlds;
         
-        // The stroke of the scale widget.
-        int scale_widget_stroke;
-        
-        // Where on the screen to draw the scale widget.
-        Location turbo_widget_location;
+        // Where the sources and the compiled packs are.
+        string source_directory;
+        string compiled_directory;
         
-        // The size of the scale widget.
-        Size turbo_widget_size;
+        // The assets and the sounds which the packs refer to.
+        AssetLoader* asset_loader;
+        SfxMixer* sfx_mixer;
+        const char** sound_names;
+        sound_variant* sounds;
+        int sounds_amount;
         
-        // The stroke of the scale widget.
-        int turbo_widget_stroke;
+        // The limits of the worlds.
+        int fps;
+        int max_population;
+        int max_grid_columns;
+        int max_grid_rows;
+        float eat_grow_ratio;
+        int x_coord_offset;
         
-        // Data relevant for resetting.
-        Location startup_location;
-        float original_scale;
+        // The screen, and the zoom of the cameras.
+        int screen_width;
+        int screen_height;
+        float camera_zoom;
         
+        // My fish.
+        Image* my_fish_image;
+        int* my_fish_image_frames_amount;
+        sound_variant my_fish_sound_eat;
+        sound_variant my_fish_sound_sting;
+    
     public:
     
         // Constructor.
-        MyFish(int new_fps, Image new_my_fish_image, int* new_frames_amount, frame new_collision_frame, bool new_is_sting_proof, Location new_location, Size new_size, int new_speed_x, int new_speed_y, int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, float new_scale, float new_required_scale, float new_eat_grow_ratio, float new_can_eat_ratio, float new_cant_eat_ratio, float new_rotation, bool new_is_facing_left_on_startup, int new_max_cells_within, Cell** new_cells_within, Location new_scale_widget_location, Size new_scale_sidget_size, int new_scale_widget_stroke, float new_turbo, int new_turbo_duration_frames, int new_turbo_reload_frames, Location new_turbo_widget_location, Size new_turbo_widget_size, int new_turbo_widget_stroke, Sound new_sound_eat, Sound new_sound_sting) : Fish(new_fps, new_my_fish_image, new_frames_amount, new_collision_frame, "my fish", new_is_sting_proof, new_location, new_size, new_speed_x, new_speed_y, new_left_boundary, new_right_boundary, new_top_boundary, new_bottom_boundary, new_scale, new_required_scale, new_eat_grow_ratio, new_can_eat_ratio, new_cant_eat_ratio, new_rotation, new_is_facing_left_on_startup, new_max_cells_within, new_cells_within, new_sound_eat, new_sound_sting)
+        WorldCatalog(int new_worlds_amount, string new_source_directory, string new_compiled_directory, AssetLoader* new_asset_loader, SfxMixer* new_sfx_mixer, const char** new_sound_names, sound_variant* new_sounds, int new_sounds_amount, int new_fps, int new_max_population, int new_max_grid_columns, int new_max_grid_rows, float new_eat_grow_ratio, int new_x_coord_offset, int new_screen_width, int new_screen_height, float new_camera_zoom, Image* new_my_fish_image, int* new_my_fish_image_frames_amount, sound_variant new_my_fish_sound_eat, sound_variant new_my_fish_sound_sting)
         {
-            // Initialize my fish properties.
+            worlds_amount = new_worlds_amount;
+            packs = new WorldPack*[worlds_amount + 1];
+            worlds = new GameWorld*[worlds_amount + 1];
+            for (int i = 0; i <= worlds_amount; i++) { packs[i] = NULL; worlds[i] = NULL; }
+            
+            source_directory = new_source_directory;
+            compiled_directory = new_compiled_directory;
+            
+            asset_loader = new_asset_loader;
+            sfx_mixer = new_sfx_mixer;
+            sound_names = new_sound_names;
+            sounds = new_sounds;
+            sounds_amount = new_sounds_amount;
+            
             fps = new_fps;
-            current_stunt_frames_left = 0;
-            required_scale = new_required_scale;
-            scale_widget_location.set_location(new_scale_widget_location);
-            scale_widget_size = new_scale_sidget_size;
-            scale_widget_stroke = new_scale_widget_stroke;
-            turbo = new_turbo;
-            turbo_duration_frames = new_turbo_duration_frames;
-            turbo_duration_frames_left = 0;
-            turbo_reload_frames = new_turbo_reload_frames;
-            turbo_reload_frames_left = 0;
-            turbo_widget_location = new_turbo_widget_location;
-            turbo_widget_size = new_turbo_widget_size;
-            turbo_widget_stroke = new_turbo_widget_stroke;
+            max_population = new_max_population;
+            max_grid_columns = new_max_grid_columns;
+            max_grid_rows = new_max_grid_rows;
+            eat_grow_ratio = new_eat_grow_ratio;
+            x_coord_offset = new_x_coord_offset;
             
-            // Properties relevant for resetting.
-            startup_location = new_location;
-            original_scale = new_scale;
+            screen_width = new_screen_width;
+            screen_height = new_screen_height;
+            camera_zoom = new_camera_zoom;
+            
+            my_fish_image = new_my_fish_image;
+            my_fish_image_frames_amount = new_my_fish_image_frames_amount;
+            my_fish_sound_eat = new_my_fish_sound_eat;
+            my_fish_sound_sting = new_my_fish_sound_sting;
         }
         
-        // Default Constructor.
-        MyFish() : Fish()
+        // The function returns the pack of a world with its fish profiles, it is read the first time (the world textures must be at least sized).
+        // Returns NULL if the pack is missing or not valid.
+        WorldPack* get_pack(int number)
         {
+            if (number < 1 || number > worlds_amount) { return NULL; }
+            
+            if (packs[number] == NULL)
+            {
+                char file_name[32];
+                snprintf(file_name, sizeof(file_name), "World %d", number);
+                
+                WorldPack* pack = new WorldPack(source_directory + file_name + ".txt", compiled_directory + file_name + ".pack");
+                
+                if (!pack -> load() || !pack -> resolve(asset_loader, x_coord_offset, sound_names, sounds, sounds_amount)) { delete pack; return NULL; }
+                if (pack -> get_world_number() != number) { TraceLog(LOG_WARNING, "WorldCatalog: the pack of world %d describes world %d", number, pack -> get_world_number()); }
+                
+                packs[number] = pack;
+            }
             
+            return packs[number];
         }
         
-        // Resets the fish to its initial properties.
-        void reset()
+        // The function puts a pack which was made in memory in place of the pack of a world (see WorldGenerator), returns false if it can't be resolved.
+        bool set_pack(int number, WorldPack* pack)
         {
-            current_stunt_frames_left = 0;
-            turbo_duration_frames_left = 0;
-            turbo_reload_frames_left = 0;
-            location.set_location(startup_location);
-            scale = original_scale;
+            if (number < 1 || number > worlds_amount || worlds[number] != NULL) { return false; }
+            if (!pack -> resolve(asset_loader, x_coord_offset, sound_names, sounds, sounds_amount)) { return false; }
+            
+            packs[number] = pack;
+            
+            return true;
         }
         
-        // The function moves the fish towards the received destination.
-        void move_towards(Location destination)
+        // The function returns a world, it is created the first time it is needed (after its bundle was loaded). Returns NULL if its pack is not valid.
+        GameWorld* get_world(int number)
         {
-            float new_y;
-            float displacement_x = destination.x - location.x;
-            float displacement_y = destination.y - location.y;
-            
-            // If the distance is less than the speed, set the destination as the new location.
-            if (sqrt(pow(displacement_x, 2) + pow(displacement_y, 2)) < speed_x)
-            {
-                if (destination.x > location.x) { move_right(((float)destination.x - location.x) / speed_x); }
-                else { move_left((float)(location.x - destination.x) / speed_x); }
-            }
-            
-            // Find the line (connecting the current location and the destination) equation.
-            float slope = displacement_y / displacement_x;
-            float n = destination.y - (slope * destination.x);
-
-            // Movement only on one axis.
-            if (slope == 0) 
-            {
-                if (displacement_x >= 0) { move_right(1); }
-                else { move_left(1); }
-                return;
-            }
+            if (number < 1 || number > worlds_amount) { return NULL; }
+            if (worlds[number] != NULL) { return worlds[number]; }
             
-            // The values for the quadratic formula (using the distance equation).
-            float a = pow(slope, 2) + 1;
-            float b = 2 * slope * n -2 * slope * location.y -2 * location.x;
-            float c = pow(n, 2) -2 * n * location.y + pow(location.y, 2) + pow(location.x, 2) - pow(speed_x, 2);
+            double start_time = GetTime();
             
-            // The discriminant is negative, move up or down.
-            if (pow(b, 2) -4 * a * c < 0)
-            {
-                if (destination.y < location.y) { move_up(1); }
-                else { move_down(1); }
-                return;
-            }
+            WorldPack* pack = get_pack(number);
+            if (pack == NULL) { return NULL; }
             
-            // The solutions of the quadratic formula.
-            float new_x_1 = ( - b + sqrt(pow(b, 2) -4 * a * c)) / (2 * a);
-            float new_x_2 = ( - b - sqrt(pow(b, 2) -4 * a * c)) / (2 * a);
+            int width = pack -> get_width();
+            int height = pack -> get_height();
+            int population = min(pack -> get_population(), max_population);
+            int grid_columns = min(pack -> get_grid_columns(), max_grid_columns);
+            int grid_rows = min(pack -> get_grid_rows(), max_grid_rows);
             
-            // Too large numbers (probably because the slope is too high).
-            if (new_x_1 != new_x_1 || new_x_2 != new_x_2)
+            if (population != pack -> get_population() || grid_columns != pack -> get_grid_columns() || grid_rows != pack -> get_grid_rows())
             {
-                if (destination.y < location.y) { move_up(1); }
-                else { move_down(1); }
-                return;
+                TraceLog(LOG_WARNING, "WorldCatalog: world %d is capped to a population of %d and a grid of %dx%d", number, population, grid_columns, grid_rows);
             }
             
-            // Find the desired solution and calculate the new y.
-            if (destination.x > location.x)
-            {
-                if (new_x_1 > location.x) { move_right(min((float)1, (float)(new_x_1 - location.x) / speed_x)); new_y = slope * new_x_1 + n; }
-                else { move_right(min((float)1, (float)(new_x_2 - location.x) / speed_x)); new_y = slope * new_x_2 + n; }
-            }
-            else
-            {
-                if (new_x_1 < location.x) { move_left(min((float)1, (float)(new_x_1 - location.x) / speed_x)); new_y = slope * new_x_1 + n; }
-                else { move_left(min((float)1, (float)(location.x - new_x_2) / speed_x)); new_y = slope * new_x_2 + n; }
-            }
-
-            // Check if need to move up or down.
-            if (destination.y < location.y) { move_up(min((float)1, (float)(location.y - new_y) / speed_x)); }
-            else { move_down(min((float)1, (float)(new_y - location.y) / speed_x)); }
-        }
-        
-        // The function causes the fish a jelly fish stunt.
-        void jelly_fish_stunt(float stunt_power) override
-        {
-            // Sting proof.
-            if (is_sting_proof) { return; }
+            // Create the grid.
+            Grid* grid = new Grid(grid_columns, grid_rows, population, width, height);
             
-            // Currently in a stunt, can't be stunt again.
-            if (current_stunt_frames_left > 0) { return; }
+            // My fish, in the middle of the world.
+            Cell** cells_within_my_fish = new Cell*[grid_rows * grid_columns];
+            frame my_fish_collision_frame = {-54, -4, 549, 439};
+            MyFish* my_fish = new MyFish(fps, *my_fish_image, my_fish_image_frames_amount, my_fish_collision_frame, false, Location(width / 2, height / 2), Size(150, 107), 23, 23, 0, 0, 0, 0, 1, 15, eat_grow_ratio, 1.2, 10000, 0, true, population, cells_within_my_fish, Location(100, screen_height - 75), Size(150, 20), 1, 2, fps * 2, fps * 5, Location(350, screen_height - 75), Size(150, 20), 1, my_fish_sound_eat, my_fish_sound_sting, sfx_mixer);
             
-            // Play sting sound.
-            PlaySound(sound_sting);
+            // The fish network.
+            FishNetwork* fish_network = new FishNetwork(fps, population, eat_grow_ratio, grid, pack -> get_profiles_on_startup(), pack -> get_profiles_on_startup_amount(), pack -> get_available_fish(), pack -> get_available_fish_amount(), x_coord_offset, my_fish -> get_updated_rectangular_frame_triple_size(), sfx_mixer);
+            fish_network -> update_boundaries(- x_coord_offset, width + x_coord_offset, 0, height, true);
             
-            // Stunt.
-            current_stunt_frames_left = (int) floor(stunt_power * fps);
+            // The camera, on my fish.
+            Camera2D camera = { 0 };
+            camera.target = (Vector2) { (float) my_fish -> get_location().x, (float) my_fish -> get_location().y };
+            camera.offset = (Vector2) { (float) screen_width / 2, (float) screen_height / 2 };
+            camera.rotation = 0;
+            camera.zoom = camera_zoom;
             
-            // Calculate how much scale decreases each frame.
-            stunt_size_decrease_per_frame = max((float) 1, ((required_scale - scale) / 8) * stunt_power) / current_stunt_frames_left;            
+            // The fish are created when it is first played.
+            worlds[number] = new GameWorld(number, pack -> get_background(), pack -> get_welcome_window(), my_fish, fish_network, grid, camera);
             
-            // Save the current speed and stunt.
-            original_speed_x = speed_x;
-            original_speed_y = speed_y;
-            speed_x = 0;
-            speed_y = 0;
+            TraceLog(LOG_INFO, "WorldCatalog: world %d was created in %.3f ms", number, (GetTime() - start_time) * 1000);
+            
+            return worlds[number];
         }
         
-        // Returns true if my fish has reached its required scale.
-        bool is_victory() { return scale >= required_scale; }
+        // The function suspends all the worlds which were created (unloads the textures of their gifs).
+        void suspend_all()
+        {
+            for (int i = 1; i <= worlds_amount; i++) { if (worlds[i] != NULL) { worlds[i] -> suspend(); } }
+        }
+};
+
+
+class WorldGenerator
+{
+    /*
+        Makes synthetic worlds for scaling tests: the source of a world pack (see WorldPack), drawn from settings (synthetic_world_settings)
+        with a fixed seed. The same settings and base pack always make the same world.
         
-        // Returns False if my fish got eaten and the game is over.
-        bool is_alive() { return !is_eaten; }
+        Notes:
+            - The species are drawn from the profiles of a base pack: their animations, collision frames, speeds, ratios and sounds. Their size is
+              scaled within the spread of the settings, and their proportions are drawn.
+            - The paths: wandering fish cross the world from the left or the right, zigzagging fish go up and down on the way, and jelly fish fall
+              from above and drift (like the jelly fish of world 3). A species of a fish which keeps a height (a crab on the bottom) keeps it.
+            - get_settings() keeps the density of the base world, the world grows with the population and the grid keeps the size of its cells.
+              The cells and the fish keep arrays of cells x population (see Grid and FishNetwork), so the cells are capped by MAX_GRID_SLOTS and
+              grow larger on the largest populations.
+            - The source is compiled in memory (WorldPack::compile_source()) and played like any world, or written to be looked at.
+    */
+    
+    public:
+    
+        // The number of the synthetic worlds.
+        static const int WORLD_NUMBER = 100;
+        
+        // The most cells x population a grid of a synthetic world has.
+        static const long MAX_GRID_SLOTS = 16 * 1024 * 1024;
         
-        // Draws the current scale widget.
-        void draw_scale_widget()
+        // The function returns the settings of a synthetic world of the population, with the density of the base world (the base pack is resolved).
+        static synthetic_world_settings get_settings(WorldPack* base, int population, uint64_t seed)
         {
-            // Draw the scale title.
-            DrawText("Scale", scale_widget_location.x - 75, scale_widget_location.y, 25, BLACK);
-            
-            // Draw the stroke rectangle.
-            DrawRectangle(scale_widget_location.x - scale_widget_stroke, scale_widget_location.y - scale_widget_stroke, scale_widget_size.width + 2 * scale_widget_stroke, scale_widget_size.height + 2 * scale_widget_stroke, BLACK);
-            
-            // Draw the container rectangle.
-            DrawRectangle(scale_widget_location.x, scale_widget_location.y, scale_widget_size.width, scale_widget_size.height, WHITE);
-            
-            // Draw the fill rectangle.
-            DrawRectangle(scale_widget_location.x, scale_widget_location.y, scale_widget_size.width * (scale / required_scale), scale_widget_size.height, RED);
+            float factor = sqrt((float) population / base -> get_population());
+            
+            synthetic_world_settings settings;
+            settings.seed = seed;
+            settings.population = population;
+            settings.width = max(1, (int) round(base -> get_width() * factor));
+            settings.height = max(1, (int) round(base -> get_height() * factor));
+            
+            // The grid grows like the world, as long as it is within the slots.
+            float grid_factor = min(factor, (float) sqrt((double) MAX_GRID_SLOTS / population / (base -> get_grid_columns() * base -> get_grid_rows())));
+            settings.grid_columns = max(1, (int) round(base -> get_grid_columns() * grid_factor));
+            settings.grid_rows = max(1, (int) round(base -> get_grid_rows() * grid_factor));
+            
+            settings.species_amount = 16;
+            settings.min_scale = 0.6;
+            settings.max_scale = 1.6;
+            settings.jelly_fish_ratio = 0.15;
+            settings.zigzag_ratio = 0.3;
+            
+            return settings;
         }
         
-        // If available, applies the turbo.
-        void apply_turbo()
+        // The function returns the source of a synthetic world, its species are drawn from the profiles of the base pack.
+        static string generate(WorldPack* base, synthetic_world_settings settings)
         {
-            if (turbo_reload_frames_left == 0) 
+            Random random = Random(settings.seed);
+            string source;
+            
+            append(&source, "# A synthetic world made by WorldGenerator (seed %llu, population %d, %d species).\n\n", (unsigned long long) settings.seed, settings.population, settings.species_amount);
+            append(&source, "world %d\nbackground %s\nwelcome_window %s\n", WORLD_NUMBER, base -> get_background_path(), base -> get_welcome_window_path());
+            append(&source, "world_size %d %d\npopulation %d\ngrid %d %d\n", settings.width, settings.height, settings.population, settings.grid_columns, settings.grid_rows);
+            
+            // The jelly fish of the base, and the other fish.
+            int profiles_amount = base -> get_profiles_amount();
+            int* jelly_fish = new int[profiles_amount];
+            int* other_fish = new int[profiles_amount];
+            int jelly_fish_amount = 0, other_fish_amount = 0;
+            
+            for (int i = 0; i < profiles_amount; i++)
             {
-                turbo_reload_frames_left = turbo_reload_frames;
-                turbo_duration_frames_left = turbo_duration_frames;
-                speed_x *= turbo;
-                speed_y *= turbo;
+                world_pack_stack* stack = base -> get_pack_stack(base -> get_pack_profile(i) -> first_stack);
+                if (stack -> is_initial_y_coordinate && stack -> initial_y_coordinate_anchor == WORLD_ANCHOR_ABOVE) { jelly_fish[jelly_fish_amount++] = i; }
+                else { other_fish[other_fish_amount++] = i; }
+            }
+            
+            for (int i = 0; i < settings.species_amount; i++)
+            {
+                // The base of the species (a jelly fish species is drawn from any fish if the base has no jelly fish).
+                bool is_jelly_fish = draw_ratio(&random) < settings.jelly_fish_ratio || other_fish_amount == 0;
+                int base_index = (is_jelly_fish && jelly_fish_amount > 0) ? jelly_fish[random.next() % jelly_fish_amount] : other_fish[random.next() % max(other_fish_amount, 1)];
+                world_pack_profile* profile = base -> get_pack_profile(base_index);
+                world_pack_stack* base_stack = base -> get_pack_stack(profile -> first_stack);
+                
+                float scale = settings.min_scale + draw_ratio(&random) * (settings.max_scale - settings.min_scale);
+                float proportion = 0.05 + draw_ratio(&random) * 1.95;
+                
+                append(&source, "\nfish %s %d\n", base -> get_string(profile -> fish_type), i + 1);
+                append(&source, "animation %s\n", base -> get_string(profile -> animation));
+                append(&source, "collision %d %d %d %d\n", profile -> collision_frame.x_offset, profile -> collision_frame.y_offset, profile -> collision_frame.width, profile -> collision_frame.height);
+                append(&source, "size %d %d\n", max(1, (int) round(profile -> width * scale)), max(1, (int) round(profile -> height * scale)));
+                if (profile -> is_sting_proof) { append(&source, "sting_proof\n"); }
+                if (profile -> is_facing_left_on_startup) { append(&source, "facing_left\n"); }
+                if (profile -> is_randomize_initial_scale) { append(&source, "randomize_scale\n"); }
+                append(&source, "max_scaling %g\nspeed_x %g %g\nspeed_y %g %g\n", profile -> max_scaling, profile -> min_speed_x, profile -> max_speed_x, profile -> min_speed_y, profile -> max_speed_y);
+                append(&source, "frames_per_path %d %d\neat_ratios %g %g\n", profile -> min_frames_per_path, profile -> max_frames_per_path, profile -> can_eat_ratio, profile -> cant_eat_ratio);
+                append(&source, "sounds %s %s\nproportion %.4f\n", base -> get_string(profile -> sound_eat), base -> get_string(profile -> sound_sting), proportion);
+                
+                // Fall from above, and drift.
+                if (is_jelly_fish)
+                {
+                    for (int j = 0; j < 3; j++)
+                    {
+                        append(&source, "stack from_right y above-10 randomize_x\n");
+                        append(&source, "path %d %d right down 40\npath 13 1 right down 50\n", 4 + random.next() % 17, 35 + random.next() % 26);
+                    }
+                }
+                
+                // Keep the height of the base (on the bottom).
+                else if (base_stack -> is_initial_y_coordinate)
+                {
+                    string y = get_coordinate_text(base_stack -> initial_y_coordinate_anchor, base_stack -> initial_y_coordinate);
+                    append(&source, "stack from_left y %s\npath 10 0 right up 100\n", y.c_str());
+                    append(&source, "stack from_right y %s\npath 10 0 left up 100\n", y.c_str());
+                }
+                
+                // Go up and down on the way.
+                else if (draw_ratio(&random) < settings.zigzag_ratio)
+                {
+                    int paths_amount = 2 + random.next() % 3;
+                    int frames = 20 + random.next() % 41;
+                    
+                    for (int left = 1; left >= 0; left--)
+                    {
+                        append(&source, "stack %s repeat\n", left ? "from_left" : "from_right");
+                        for (int j = 0; j < paths_amount; j++) { append(&source, "path 10 3 %s %s %d\n", left ? "right" : "left", (j % 2 == 0) ? "up" : "down", frames); }
+                    }
+                }
+                
+                // Wander across.
+                else
+                {
+                    append(&source, "stack from_left\npath 10 0 right up 100\n");
+                    append(&source, "stack from_right\npath 10 0 left up 100\n");
+                }
             }
+            
+            delete[] jelly_fish;
+            delete[] other_fish;
+            
+            return source;
         }
         
-        // Sets another frame of turbo.
-        void update_turbo()
+        // The function writes the source of a synthetic world, returns false if it could not be written.
+        static bool write(string source, const char* path)
         {
-            if (turbo_reload_frames_left > 0) { turbo_reload_frames_left--; }
-            if (turbo_duration_frames_left == 1) { speed_x /= turbo; speed_y /= turbo; }
-            if (turbo_duration_frames_left > 0) { turbo_duration_frames_left--; }
+            FILE* source_file = fopen(path, "wb");
+            if (source_file == NULL) { TraceLog(LOG_WARNING, "WorldGenerator: could not write %s", path); return false; }
+            
+            bool is_written = fwrite(source.c_str(), 1, source.length(), source_file) == source.length();
+            is_written = (fclose(source_file) == 0) && is_written;
+            
+            return is_written;
         }
+    
+    private:
+    
+        // The function returns a number in [0, 1).
+        static float draw_ratio(Random* random) { return (random -> next() % 10000) / 10000.0f; }
         
-        void draw_turbo_widget()
+        // The function appends formatted text to the source.
+        static void append(string* source, const char* format, ...)
         {
-            /*
-            // Draw the turbo title.
-            DrawText("Turbo", turbo_widget_location.x - 75, turbo_widget_location.y, 25, BLACK);
+            char text[512];
+            va_list arguments;
+            va_start(arguments, format);
+            vsnprintf(text, sizeof(text), format, arguments);
+            va_end(arguments);
             
-            // Draw the turbo rectangle.
-            DrawRectangle(turbo_widget_location.x - turbo_widget_stroke, turbo_widget_location.y - turbo_widget_stroke, turbo_widget_size.width + 2 * turbo_widget_stroke, turbo_widget_size.height + 2 * turbo_widget_stroke, BLACK);
+            *source += text;
+        }
+        
+        // The function returns the text of a coordinate of a pack (see WorldPack).
+        static string get_coordinate_text(int anchor, int value)
+        {
+            const char* anchors_names[] = {"", "left", "right", "bottom", "above"};
+            char text[32];
             
-            // Draw the container rectangle.
-            DrawRectangle(turbo_widget_location.x, turbo_widget_location.y, turbo_widget_size.width, turbo_widget_size.height, WHITE);
+            if (anchor == WORLD_ANCHOR_NONE) { snprintf(text, sizeof(text), "%d", value); }
+            else if (value == 0) { snprintf(text, sizeof(text), "%s", anchors_names[anchor]); }
+            else { snprintf(text, sizeof(text), "%s%+d", anchors_names[anchor], value); }
             
-            // Draw the fill rectangle.
-            DrawRectangle(turbo_widget_location.x, turbo_widget_location.y, (int) (turbo_widget_size.width * ((float)(turbo_reload_frames - turbo_reload_frames_left) / turbo_reload_frames)), turbo_widget_size.height, RED);
-            */
+            return text;
         }
 };
 
 
-class WanderFish : public Fish
+class BenchmarkResults
 {
     /*
-        Represents a simple fish wandering in the world.
+        The results of a benchmark, a row for every measured thing, written as json and compared with the json of a previous run (the baseline).
+        
+        Notes:
+            - A row has the statistics of the samples of what was measured (the ticks of a phase, the repetitions of a function), in the unit
+              of the benchmark and for one operation: the minimum, the median, the mean, the 99th percentile and the standard deviation.
+            - The json has a row a line, so a baseline is read back line by line. The benchmark writes its own settings before the rows.
+            - The noise of a row is its deviation as a part of its mean. A row regressed if its median grew by more than the tolerance and
+              by more than the noise floor, and by more than twice the noise (of the run or of the baseline) if the noise is compared.
     */
     
     private:
-
-        // The range of steps (frames) for a new generated path.
-        int min_path_frames, max_path_frames;
-
-        // The index on the next path in paths stack.
-        int paths_stack_index;
         
-        // The current path of the fish.
-        fish_path current_path;
-        
-        // Indicating the orginal frames amount the current path had, necessary for later reset (relevant only with paths_stack, repeat on).
-        int current_path_original_frames_amount;
-        
-        // The paths stack of the current wandering fish.
-        paths_stack my_paths_stack;
+        // The name of the benchmark in the log, the unit of the results and how many of them are in a second.
+        const char* title;
+        const char* unit;
+        double units_per_second;
         
-        // The range of speeds in both axes.
-        int min_speed_x;
-        int max_speed_x;
-        int min_speed_y;
-        int max_speed_y;
+        // The rows.
+        benchmark_result* results;
+        int results_amount;
+        int max_results;
         
-        // The fish initial location cannot be within this frame.
-        Rectangle exclude_setup_location_frame;
-   
+        // How much a median can grow before it is a regression, as a part of the median of the baseline, at least in the unit (the noise of short phases),
+        // and if the noise of the rows is compared.
+        double tolerance;
+        double noise_floor;
+        bool is_noise_compared;
+    
     public:
         
         // Constructor.
-        // new_paths_count_in_paths_stack should state the number of stacks which are saved in the received paths_stack.
-        // The location is relevant if there is no paths_stack or is_initial_location is false;
-        WanderFish(int new_fps, Image new_wander_fish_image, int* new_frames_amount, frame new_collision_frame, string new_fish_type, bool new_is_sting_proof, Location new_location, bool is_initial_left_location, bool is_randomize_x_coord, Size new_size, float new_min_speed_x, float new_max_speed_x, float new_min_speed_y, float new_max_speed_y, int new_min_path_frames, int new_max_path_frames, paths_stack new_paths_stack, int new_left_boundary, int new_right_boundary, int new_top_boundary, int new_bottom_boundary, float new_scale, float new_max_scale, bool is_randomize_initial_scale, float new_eat_grow_ratio, float new_can_eat_ratio, float new_cant_eat_ratio, float new_rotation, bool new_is_facing_left_on_startup, int new_x_offset, int new_max_cells_within, Cell** new_cells_within, Sound new_sound_eat, Sound new_sound_sting, Rectangle new_exclude_setup_location_frame) : Fish(new_fps, new_wander_fish_image, new_frames_amount, new_collision_frame, new_fish_type, new_is_sting_proof, new_location, new_size, 0, 0, new_left_boundary, new_right_boundary, new_top_boundary, new_bottom_boundary, new_scale, new_max_scale, new_eat_grow_ratio, new_can_eat_ratio, new_cant_eat_ratio, new_rotation, new_is_facing_left_on_startup, new_max_cells_within, new_cells_within, new_sound_eat, new_sound_sting)
+        BenchmarkResults(const char* new_title, const char* new_unit, double new_units_per_second, int new_max_results, double new_tolerance, double new_noise_floor, bool new_is_noise_compared)
         {
-            // Set the range of speeds on both axes.
-            min_speed_x = new_min_speed_x;
-            max_speed_x = new_max_speed_x;
-            min_speed_y = new_min_speed_y;
-            max_speed_y = new_max_speed_y;
+            title = new_title;
+            unit = new_unit;
+            units_per_second = new_units_per_second;
             
-            // Set the range of a new path frames.
-            min_path_frames = new_min_path_frames;
-            max_path_frames = new_max_path_frames;
+            max_results = new_max_results;
+            results = new benchmark_result[max_results];
+            results_amount = 0;
             
-            // Initial location cannot be within this frame.
-            exclude_setup_location_frame = new_exclude_setup_location_frame;
+            tolerance = new_tolerance;
+            noise_floor = new_noise_floor;
+            is_noise_compared = new_is_noise_compared;
+        }
+        
+        // The function adds a row from the times of its samples (seconds, of the operations of a sample), returns it (NULL if there are too many rows).
+        // The times are sorted.
+        benchmark_result* add(const char* name, int operations, double* times, int times_amount)
+        {
+            if (results_amount == max_results || times_amount == 0) { return NULL; }
             
-            // If true, randomizing the initial scale.
-            if (is_randomize_initial_scale) { scale = max(1, rand() % (int) floor(max_scale * 1000 - 1000) / 1000 + 1);  }
+            benchmark_result* result = &results[results_amount];
+            results_amount++;
             
-            // Set the paths stack, and save the number of elements in it.
-            my_paths_stack = new_paths_stack;
-            paths_stack_index = 0;
+            snprintf(result -> name, sizeof(result -> name), "%s", name);
+            result -> operations = operations;
             
-            // If there are paths in stack path, pull out the first one to be the current path.
-            if (my_paths_stack.length > 0) 
-            {
-                // If initial location is relevant.
-                if (my_paths_stack.is_initial_location) { location.set_location(my_paths_stack.initial_location); }
-                
-                // If initial y coordinate is set.
-                else if (my_paths_stack.is_initial_y_coordinate) { set_random_initial_location(is_initial_left_location, my_paths_stack.is_randomize_x_coordinate || is_randomize_x_coord, new_x_offset, true, my_paths_stack.initial_y_coordinate, exclude_setup_location_frame); }
-                
-                // Otherwise, totally randomize the initial location.
-                else { set_random_initial_location(is_initial_left_location, is_randomize_x_coord, new_x_offset, false, 0, exclude_setup_location_frame); }
-                
-                // Set the first path as the current path.
-                current_path = my_paths_stack.paths[0];
-                
-                // Remember the original amount of frames.
-                current_path_original_frames_amount = current_path.current_frames_left;
-            }
+            double scale = units_per_second / operations;
             
-            // Otherwise, generate new path and assign it.
-            else 
-            {
-                current_path = generate_new_path();
-                
-                set_random_initial_location(is_initial_left_location, is_randomize_x_coord, new_x_offset, false, 0, exclude_setup_location_frame);
-            }
+            double sum = 0;
+            for (int i = 0; i < times_amount; i++) { sum += times[i]; }
+            result -> mean = sum / times_amount * scale;
             
-            // Update the properties of the wander fish to match the properties of the current path.
-            match_path_in_fish();
+            double squares_sum = 0;
+            for (int i = 0; i < times_amount; i++) { squares_sum += (times[i] * scale - result -> mean) * (times[i] * scale - result -> mean); }
+            result -> deviation = (times_amount > 1) ? sqrt(squares_sum / (times_amount - 1)) : 0;
+            
+            qsort(times, times_amount, sizeof(double), compare_times);
+            
+            result -> min = times[0] * scale;
+            result -> median = times[get_rank(0.5, times_amount)] * scale;
+            result -> p99 = times[get_rank(0.99, times_amount)] * scale;
+            
+            return result;
         }
         
-        // Default Constructor.
-        WanderFish() : Fish()
+        // Returns the noise of a row, its deviation as a part of its mean.
+        static double get_noise(benchmark_result* result) { return (result -> mean > 0) ? result -> deviation / result -> mean : 0; }
+        
+        // The function logs the rows as a table.
+        void report()
         {
-            min_path_frames = 100;
-            max_path_frames = 1000;
-            paths_stack_index = 0;
-            current_path_original_frames_amount = 1;
-            min_speed_x = 1;
-            max_speed_x = 10;
-            min_speed_y = 1;
-            max_speed_y = 1;
+            TraceLog(LOG_INFO, "%s, in %s an operation:", title, unit);
+            TraceLog(LOG_INFO, "    %-44s %10s %10s %10s %10s %10s %8s", "name", "ops", "min", "p50", "mean", "p99", "noise");
+            
+            for (int i = 0; i < results_amount; i++)
+            {
+                TraceLog(LOG_INFO, "    %-44s %10d %10.3f %10.3f %10.3f %10.3f %7.1f%%", results[i].name, results[i].operations, results[i].min, results[i].median, results[i].mean, results[i].p99, get_noise(&results[i]) * 100);
+            }
         }
         
-        // The function sets a random initial_location.
-        void set_random_initial_location(bool is_initial_left_location, bool is_randomize_x_coord, int x_coord_offset, bool is_initial_y_coordinate, int initial_y_coordinate, Rectangle exclude_frame)
+        // The function writes the rows as json, after the settings of the benchmark (json members, each line ends with a comma).
+        void save_json(string path, string settings)
         {
-            // The final coordinates.
-            int y_coordinates = 0;
-            int x_coordinates = 0;
-            Vector2 position = {0, 0};
+            FILE* json_file = fopen(path.c_str(), "w");
+            if (json_file == NULL) { TraceLog(LOG_WARNING, "%s: could not write %s", title, path.c_str()); return; }
             
-            // The current frame rectangle with the current position.
-            Rectangle current_frame;
+            fprintf(json_file, "{\n%s    \"results\": [\n", settings.c_str());
             
-            // Make sure not in the exclude frame.
-            do
+            for (int i = 0; i < results_amount; i++)
             {
-                // Set the received y coordinate.
-                if (is_initial_y_coordinate) { y_coordinates = initial_y_coordinate; }
-                
-                // Randomize the location of the y axis.
-                else
-                {
-                    if (bottom_boundary - top_boundary <= 0) { y_coordinates = top_boundary + size.height; }
-                    else { y_coordinates = rand() % (bottom_boundary - top_boundary) + top_boundary; }
-                }
-                
-                // If random x coord is required.
-                if (is_randomize_x_coord)
-                {               
-                    // Randomize the x coordination.
-                    if (right_boundary - left_boundary <= 0) { x_coordinates = left_boundary; }
-                    else { x_coordinates = rand() % (right_boundary - left_boundary) + left_boundary; }
-                }
-                
-                // Left or right x coordinate is required.
-                else
-                {
-                    // Randomize the x_coord_offset.
-                    x_coord_offset = rand() % (x_coord_offset);
-                    
-                    // The location should be at the left side of the world.
-                    if (is_initial_left_location) { x_coordinates = left_boundary + x_coord_offset; }
-                    
-                    // The location should be at the right side of the world.
-                    else { x_coordinates = right_boundary - x_coord_offset; }
-                }
-                
-                // The generated location.
-                position.x = x_coordinates;
-                position.y = y_coordinates;
-                
-                // The frame of the fish if it would be set with the current location.
-                current_frame = {position.x - ((sqrt(scale) * size.width) / 2), position.y - ((sqrt(scale) * size.height) / 2), sqrt(scale) * size.width, sqrt(scale) * size.height};
+                fprintf(json_file, "        {\"name\": \"%s\", \"operations\": %d, \"min_%s\": %.4f, \"p50_%s\": %.4f, \"mean_%s\": %.4f, \"p99_%s\": %.4f, \"stddev_%s\": %.4f}%s\n", results[i].name, results[i].operations, unit, results[i].min, unit, results[i].median, unit, results[i].mean, unit, results[i].p99, unit, results[i].deviation, i + 1 < results_amount ? "," : "");
             }
-            while (CheckCollisionRecs(current_frame, exclude_frame));
-
-            // Set the initial location.
-            location.set_location(Location(x_coordinates, y_coordinates));
+            
+            fprintf(json_file, "    ]\n}\n");
+            fclose(json_file);
+            
+            TraceLog(LOG_INFO, "%s: the results were written to %s", title, path.c_str());
         }
         
-        // The function generates the next move of the wandering fish.
-        void move()
+        // The function logs the rows next to the rows of the baseline, returns false if a row regressed (true if there is no baseline).
+        bool compare(string baseline_path)
         {
-            // Check if there are more frames left in the current path.
-            if (current_path.current_frames_left > 0)
-            {               
-                // Move in the current path direction.
-                if (current_path.is_moving_right) { move_right(1); }
-                else { move_left(1); }
-                if (current_path.is_moving_top) { move_up(1); }
-                else { move_down(1); }
-                
-                // Decrease the amount of frames left by 1.
-                current_path.current_frames_left -= 1;
+            benchmark_result* baseline = new benchmark_result[max_results];
+            int baseline_amount = read_baseline(baseline_path, baseline);
+            
+            if (baseline_amount == 0)
+            {
+                TraceLog(LOG_INFO, "%s: there is no baseline (%s), copy the results there to compare the next runs", title, baseline_path.c_str());
+                delete[] baseline;
+                return true;
             }
             
-            // No frames left, need to load new path. Check if there are more paths in the paths stack.
-            else if (paths_stack_index < my_paths_stack.length - 1)
+            int regressions_amount = 0;
+            
+            TraceLog(LOG_INFO, "%s, compared with the baseline (tolerance %.0f%%):", title, tolerance * 100);
+            
+            for (int i = 0; i < results_amount; i++)
             {
-                // First reset the current path for later use.
-                my_paths_stack.paths[paths_stack_index].current_frames_left = current_path_original_frames_amount;
+                benchmark_result* base = NULL;
+                for (int j = 0; j < baseline_amount && base == NULL; j++)
+                {
+                    if (strcmp(baseline[j].name, results[i].name) == 0) { base = &baseline[j]; }
+                }
                 
-                // Point on the next path.
-                paths_stack_index++;
-
-                // Load the next path.
-                current_path = my_paths_stack.paths[paths_stack_index];
-                match_path_in_fish();
+                if (base == NULL) { TraceLog(LOG_INFO, "    %-44s not in the baseline", results[i].name); continue; }
+                
+                double change = (base -> median > 0) ? results[i].median / base -> median - 1 : 0;
+                double noise = is_noise_compared ? max(get_noise(&results[i]), get_noise(base)) : 0;
+                bool is_regression = change > tolerance && results[i].median - base -> median > noise_floor && change > 2 * noise;
+                if (is_regression) { regressions_amount++; }
                 
-                // Save its original frames amount for later reset.
-                current_path_original_frames_amount = current_path.current_frames_left;
-
-                // Make a move with the current path.
-                move();
+                char noise_text[32] = "";
+                if (is_noise_compared) { snprintf(noise_text, sizeof(noise_text), " (noise %.1f%%)", noise * 100); }
+                
+                TraceLog(is_regression ? LOG_WARNING : LOG_INFO, "    %-44s p50 %10.3f %s, baseline %10.3f %s, %+7.1f%%%s%s", results[i].name, results[i].median, unit, base -> median, unit, change * 100, noise_text, is_regression ? " regressed" : "");
             }
             
-            // No paths left in the paths stack.
-            else 
+            TraceLog(regressions_amount > 0 ? LOG_WARNING : LOG_INFO, "%s: %d regressed", title, regressions_amount);
+            
+            delete[] baseline;
+            
+            return regressions_amount == 0;
+        }
+        
+        // Getters.
+        int get_results_amount() { return results_amount; }
+    
+    private:
+        
+        // The function reads the rows of a baseline json (written by save_json()), returns how many were read (0 if there is no baseline).
+        int read_baseline(string path, benchmark_result* baseline)
+        {
+            FILE* json_file = fopen(path.c_str(), "r");
+            if (json_file == NULL) { return 0; }
+            
+            int baseline_amount = 0;
+            char line[512];
+            
+            while (baseline_amount < max_results && fgets(line, sizeof(line), json_file) != NULL)
             {
-                // Check if the paths stack is set to repeat.
-                if (my_paths_stack.is_repeat)
-                {                   
-                    // First reset the current path for later use.
-                    my_paths_stack.paths[paths_stack_index].current_frames_left = current_path_original_frames_amount;
-                    
-                    // Reset the paths stack index.
-                    paths_stack_index = 0;
-                    
-                    // Load the next path.
-                    current_path = my_paths_stack.paths[paths_stack_index];
-                    match_path_in_fish();
-
-                    // Save its original amount of frames for later reset.
-                    current_path_original_frames_amount = current_path.current_frames_left;
-                }
+                benchmark_result* result = &baseline[baseline_amount];
                 
-                // No repeat.
-                else
-                {                    
-                    // Generate new path.
-                    current_path = generate_new_path();
-                    match_path_in_fish();
-                }
+                // The rows are the lines with operations (the settings of the benchmark can be named too).
+                if (strstr(line, "\"operations\": ") == NULL || !find_json_string(line, "\"name\": \"", result -> name, sizeof(result -> name))) { continue; }
                 
-                // We are set to apply the next move.
-                move(); 
+                result -> operations = (int) find_json_value(line, "\"operations\": ");
+                result -> min = find_json_number(line, "min");
+                result -> median = find_json_number(line, "p50");
+                result -> mean = find_json_number(line, "mean");
+                result -> p99 = find_json_number(line, "p99");
+                result -> deviation = find_json_number(line, "stddev");
+                baseline_amount++;
             }
+            
+            fclose(json_file);
+            
+            return baseline_amount;
         }
         
-        // The function generates new path and returns it.
-        fish_path generate_new_path()
+        // Returns the number of a statistic on a json line, its key is the statistic and the unit (0 if the key is not on the line).
+        double find_json_number(const char* line, const char* statistic)
         {
-            // Create the new path.
-            fish_path new_path;
+            char key[32];
+            snprintf(key, sizeof(key), "\"%s_%s\": ", statistic, unit);
             
-            // Generate the amount of frames of the new path;
-            if (max_path_frames - min_path_frames <= 0) { new_path.current_frames_left = min_path_frames; }
-            else { new_path.current_frames_left = rand() % (max_path_frames - min_path_frames) + min_path_frames; }
+            return find_json_value(line, key);
+        }
+        
+        // Returns the number which follows the key on a json line (0 if the key is not on the line).
+        static double find_json_value(const char* line, const char* key)
+        {
+            const char* start = strstr(line, key);
             
-            // Generate the speed of the fish on each axis.
-            if (max_speed_x - min_speed_x <= 0) { new_path.speed_x = min_speed_x; }
-            else { new_path.speed_x = rand() % (int) floor(max_speed_x - min_speed_x) + min_speed_x; }
-            if (max_speed_y - min_speed_y <= 0) { new_path.speed_y = min_speed_y; }
-            else { new_path.speed_y = rand() % (int) floor(max_speed_y - min_speed_y) + min_speed_y; }
+            return (start == NULL) ? 0 : atof(start + strlen(key));
+        }
+        
+        // The function copies the string value which follows the key on a json line, returns false if the key is not on the line.
+        static bool find_json_string(const char* line, const char* key, char* value, int value_size)
+        {
+            const char* start = strstr(line, key);
+            if (start == NULL) { return false; }
+            start += strlen(key);
             
-            // Define the direction of the new path.
-            new_path.is_moving_right = rand() % 2;
-            new_path.is_moving_top = rand() % 2;
-
-            return new_path;
+            const char* end = strchr(start, '"');
+            if (end == NULL) { return false; }
+            
+            snprintf(value, value_size, "%.*s", (int) (end - start), start);
+            
+            return true;
         }
         
-        // The function match the properties of the current path to the properties of the wander fish.
-        void match_path_in_fish()
+        // The function compares two times, for sorting.
+        static int compare_times(const void* first, const void* second)
         {
-            // Set the speed of the wander fish.
-            speed_x = current_path.speed_x;
-            speed_y = current_path.speed_y;
+            double first_time = *((const double*) first);
+            double second_time = *((const double*) second);
+            
+            return (first_time > second_time) - (first_time < second_time);
         }
+        
+        // Returns the index of a percentile of sorted samples (the nearest rank).
+        static int get_rank(double percentile, int samples_amount) { return max(0, min(samples_amount - 1, (int) ceil(percentile * samples_amount) - 1)); }
 };
 
 
-class FishNetwork
+class BenchmarkWorlds
 {
     /*
-        Manages the fish in the world.
+        The worlds the benchmarks are played on, read from their packs (see WorldPack) as the game reads them, with no window and no audio device.
+        
+        Notes:
+            - The images are sized from their file headers and never decoded (see AssetLoader::read_sizes()), and the sounds are silent.
+            - A pack is read and resolved the first time it is needed, and kept until the benchmark is over.
+            - A world is played in a catalog of its own (see WorldCatalog), as world 1, with the limits of its pack.
+            - Reads the files directly, a desktop tool (the android assets are opened through the window).
     */
     
     private:
         
-        // How many fps there are per second.
-        int fps;
-        
-        // The maximum fish population in the world.
-        int max_population;
-        
-        // The current population.
-        int current_population;
-        
-        // The eat grow ratio in the world.
-        float eat_grow_ratio;
-        
-        // FishNetwork updates its grid with the relevant information.
-        Grid* grid;
-        
-        // An array of fish profiles must be loaded on startup.
-        fish_profile* fish_on_startup;
-        int fish_on_startup_length;
-        
-        // An array of fish profiles to load when available.
-        fish_profile* available_fish;
-        int available_fish_length;
-        
-        // The current fish in the fish network, as pointers.
-        WanderFish** fish;
-        int current_fish_amount;
+        // How many assets the worlds can refer to.
+        static const int MAX_ASSETS = 64;
         
-        // This array is like a lot. On a given random number, each cell in the array states the range of numbers indicating on the matching available fish in the available_fish array.
-        // See the implemantation in the constructor for further explanation.
-        int* proportions_lot;
-        int lot_range;
+        // Where the worlds are.
+        string source_directory;
+        string compiled_directory;
         
-        // The x coordinate offset of new fish initialization.
+        // The margin of the fish out of the world, as in the game.
         int x_coord_offset;
         
-        // Frame in which fish cannot be initialized on set-up.
-        Rectangle exclude_setup_location_frame;
+        // The assets, only sized (my fish is the first animation).
+        AssetLoader asset_loader;
+        Image* images;
+        int* images_frames_amounts;
+        int images_amount;
+        Texture2D* textures;
+        int textures_amount;
+        
+        // The sounds, by the names the packs refer to (silent).
+        SfxStore sfx_store;
+        SfxMixer sfx_mixer;
+        const char* sound_names[4];
+        sound_variant sounds[4];
         
+        // The packs of the worlds (NULL until needed).
+        WorldPack* packs[4];
+    
     public:
-
+        
         // Constructor.
-        FishNetwork(int new_fps, int new_max_population, float new_eat_grow_ratio, Grid* new_grid, fish_profile* new_fish_on_startup, int new_fish_on_startup_length, fish_profile* new_available_fish, int new_available_fish_length, int new_x_coord_offset, Rectangle new_exclude_setup_location_frame)
+        BenchmarkWorlds(string new_source_directory, string new_compiled_directory, const char* my_fish_path, int new_x_coord_offset) : asset_loader(NULL, NULL, NULL, NULL, MAX_ASSETS), sfx_store(16, 0), sfx_mixer(&sfx_store, 32)
         {
-            // How many frames there are per second.
-            fps = new_fps;
-            
-            // The max population.
-            max_population = new_max_population;
+            source_directory = new_source_directory;
+            compiled_directory = new_compiled_directory;
+            x_coord_offset = new_x_coord_offset;
             
-            // Save the eat grow ratio in the world.
-            eat_grow_ratio = new_eat_grow_ratio;
+            images = new Image[MAX_ASSETS];
+            images_frames_amounts = new int[MAX_ASSETS];
+            images_amount = 0;
+            textures = new Texture2D[MAX_ASSETS];
+            textures_amount = 0;
             
-            // Set the x coordination offset.
-            x_coord_offset = new_x_coord_offset;
+            // The names of the sounds of the worlds (see the sound variants of the game), without a clip.
+            const char* names[] = {"eat", "eat_lower", "sting1", "sting1_lower"};
+            for (int i = 0; i < 4; i++)
+            {
+                sound_names[i] = names[i];
+                sounds[i].clip = -1;
+                sounds[i].pitch = 1;
+                sounds[i].gain = 1;
+            }
             
-            // The current population.
-            current_population = 0;
+            for (int i = 0; i < 4; i++) { packs[i] = NULL; }
             
-            // Save the grid on which the fish network is happening.
-            grid = new_grid;
+            // My fish, added first.
+            add_animation(my_fish_path);
+        }
+        
+        // The function returns the pack of a world of the game, read and resolved the first time (NULL if it is not valid).
+        WorldPack* get_pack(int number)
+        {
+            if (packs[number] != NULL) { return packs[number]; }
             
-            // The fish profiles to load on startup.
-            fish_on_startup = new_fish_on_startup;
-            fish_on_startup_length = new_fish_on_startup_length;
+            char file_name[32];
+            snprintf(file_name, sizeof(file_name), "World %d", number);
             
-            // The available fish profiles to load lively.
-            available_fish = new_available_fish;
-            available_fish_length = new_available_fish_length;
-
-            // Create the fish array.
-            fish = new WanderFish*[max_population];
-            current_fish_amount = 0;
+            WorldPack* pack = new WorldPack(source_directory + file_name + ".txt", compiled_directory + file_name + ".pack");
+            if (!pack -> load()) { delete pack; return NULL; }
             
-            // Create the proportions lot.
+            // Size the assets of the pack.
+            add_texture(pack -> get_background_path());
+            add_texture(pack -> get_welcome_window_path());
+            for (int i = 0; i < pack -> get_profiles_amount(); i++) { add_animation(pack -> get_string(pack -> get_pack_profile(i) -> animation)); }
+            asset_loader.read_sizes(1);
             
-            // The lot range states the boundaries of the random generated number. Being calculated in the following loop.
-            lot_range = 0;
+            if (!pack -> resolve(&asset_loader, x_coord_offset, sound_names, sounds, 4)) { delete pack; return NULL; }
+            if (pack -> get_width() <= 0 || pack -> get_height() <= 0) { TraceLog(LOG_ERROR, "BenchmarkWorlds: the size of world %d is unknown (its background could not be read)", number); delete pack; return NULL; }
             
-            // Initialize the proportions lot array.
-            proportions_lot = new int[available_fish_length];
+            packs[number] = pack;
             
-            // Iterate over the available fish proportions.
-            for (int i = 0; i < available_fish_length; i++)
-            {
-                proportions_lot[i] = available_fish[i].proportion * 1000;
-                lot_range += proportions_lot[i];
-            }
-        
-            // Set the frame in which fish cannot be initialized on setup.
-            exclude_setup_location_frame = new_exclude_setup_location_frame;
-        }
-        
-        // Default Constructor.
-        FishNetwork()
-        {
-            max_population = 1;
-            current_population = 0;
-            fish_on_startup = 0;
-            available_fish_length = 0;
-            current_fish_amount = 0;
-            lot_range = 0;
+            return pack;
         }
         
-        // Reset the current fish network.
-        void reset()
+        // The function returns a catalog which plays a pack (a world of the game or a synthetic world) as world 1, with the limits of the pack.
+        // Returns NULL if the pack can't be resolved.
+        WorldCatalog* make_catalog(WorldPack* pack, int fps, float eat_grow_ratio, int margin, int screen_width, int screen_height, float camera_zoom)
         {
-            current_population = 0;
-            current_fish_amount = 0;
-        }
-        
-        // The function creates and loads all the fish on startup.
-        void setup()
-        {           
-            // Load all the fish on startup.
-            for (int i = 0; i < fish_on_startup_length; i++)
-                load_fish_profile(fish_on_startup[i], true);
+            WorldCatalog* catalog = new WorldCatalog(1, source_directory, compiled_directory, &asset_loader, &sfx_mixer, sound_names, sounds, 4, fps, pack -> get_population(), pack -> get_grid_columns(), pack -> get_grid_rows(), eat_grow_ratio, margin, screen_width, screen_height, camera_zoom, &images[0], &images_frames_amounts[0], sounds[0], sounds[2]);
+            if (!catalog -> set_pack(1, pack)) { delete catalog; return NULL; }
             
-            // Add fish to the fish network, to fill the max fish population.
-            load_available_fish(true);
-        }
-        
-        // The function loads available fish up to the max fish population.
-        void load_available_fish(bool is_on_setup)
-        {
-            // Keep loading fish up to the max population.
-            while (current_fish_amount < max_population)
-            {               
-                // lot the next available fish.
-                int random_lot = rand() % lot_range;
-                
-                // Current lots sum.
-                int lots_sum = 0;
-                
-                // Spot the lotted fish, and load it.
-                for (int i = 0; i < available_fish_length; i++)
-                {
-                    lots_sum += proportions_lot[i];
-                    
-                    // That's the fish to load.
-                    if (random_lot < lots_sum)
-                    {
-                        // Load the lotted fish.
-                        load_fish_profile(available_fish[i], is_on_setup);
-                        break;
-                    }
-                }
-            }
+            return catalog;
         }
+    
+    private:
         
-        // The function updates the boundaries of all the fish.
-        void update_boundaries(int left, int right, int top, int bottom, bool is_consider_size)
+        // The function adds an animation to the assets, once.
+        void add_animation(const char* path)
         {
-            // Iterate over the current fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
-            {
-                // Update the boundaries of the current fish (taking the scaling into considerations)
-                fish[i] -> update_boundaries(left, right, top, bottom - (int) ceil(sqrt(fish[i] -> get_scale()) * fish[i] -> get_size().height), is_consider_size);
-            }
+            Image* image;
+            int* frames_amount;
+            if (asset_loader.find_animation(path, &image, &frames_amount) || images_amount == MAX_ASSETS) { return; }
+            
+            asset_loader.add_animation(path, &images[images_amount], &images_frames_amounts[images_amount], 1);
+            images_amount++;
         }
         
-        // The function deletes all the eaten fish.
-        void handle_eaten()
+        // The function adds a texture to the assets, once.
+        void add_texture(const char* path)
         {
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
-            {
-                // If the current fish is eaten.
-                if (fish[i] -> get_is_eaten())
-                {
-                    // delete it from the network.
-                    delete_fish(fish[i]);
-                    
-                    // The last fish replaced the current fish and current_fish_amount decreased by 1. We want to check the last fish as well.
-                    i = max(0, i - 1);
-                }
-            }
-        }
-        
-        // Move all the fish in the network to their next step.
-        void move()
-        {           
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
-            {
-                // Move the fish and save the feedback.
-                fish[i] -> move();
-
-                // Check if the fish is out of bounds.
-                if (fish[i] -> get_is_fish_out_of_bounds())
-                {
-                    // That's the end of the fish.
-                    delete_fish(fish[i]);
-                    
-                    // The last fish replaced the current fish and current_fish_amount decreased by 1. We want to check the last fish as well.
-                    i = max(0, i - 1);
-                }
-                
-                else
-                {
-                    // Refresh the entity on the grid.
-                    grid -> refresh_entity(fish[i]);
-                }
-            }
+            if (asset_loader.find_texture(path) != NULL || textures_amount == MAX_ASSETS) { return; }
+            
+            asset_loader.add_texture(path, &textures[textures_amount], 1);
+            textures_amount++;
         }
+};
+
+
+class MacroBenchmark
+{
+    /*
+        Runs gameplay scenarios headless and measures the phases of their ticks (see TickPhase): the three worlds, my fish at its largest,
+        a storm of jelly fish, ten thousand small fish and fish which all swim in the margins out of the world.
         
-        // Prepare the gifs of all the fish to their next frame.
-        void set_next_frame()
+        Notes:
+            - Only the simulation runs (see Simulation, not pipelined). Nothing is drawn and no sound is played, so there is no window and no
+              audio device (see BenchmarkWorlds).
+            - The screen is a fixed 1920x1080, so the view (the gifs which are animated off screen) is the same on every machine.
+            - My fish follows a fixed input, right and left and up and down. A game which is over (victory or defeat) is started again, and
+              counted as a restart.
+            - The synthetic worlds are made from world 3 with a fixed seed (see WorldGenerator), the same on every run.
+            - The results are written as json (see BenchmarkResults): the statistics of every phase, and of the whole tick, in milliseconds.
+            - The baseline is the json of a previous run. A phase regressed if its median grew by more than the tolerance (and the noise floor).
+            - The worlds of the scenarios are kept until the benchmark is over, like the game keeps its worlds.
+    */
+    
+    private:
+        
+        // The screen the scenarios are simulated for.
+        static const int SCREEN_WIDTH = 1920;
+        static const int SCREEN_HEIGHT = 1080;
+        
+        // The seed of the synthetic worlds.
+        static const int SEED = 1;
+        
+        // The scenarios.
+        static const int SCENARIOS_AMOUNT = 7;
+        benchmark_scenario scenarios[SCENARIOS_AMOUNT];
+        
+        // The measured phases, and the whole tick.
+        static const int RESULTS_PER_SCENARIO = TICK_PHASES_AMOUNT + 1;
+        
+        // The game properties.
+        int fps;
+        int ticks_amount;
+        float eat_grow_ratio;
+        int x_coord_offset;
+        
+        // The zoom of the camera, as in the game.
+        float camera_zoom;
+        
+        // The worlds of the game, which the scenarios are played on or made from.
+        BenchmarkWorlds worlds;
+        
+        // The results of the scenarios, and how many times their games were restarted and how many fish were in them at the end.
+        BenchmarkResults results;
+        int* restarts;
+        int* fish_amounts;
+    
+    public:
+        
+        // Constructor.
+        MacroBenchmark(string new_source_directory, string new_compiled_directory, const char* new_my_fish_path, int new_fps, int new_ticks_amount, float new_eat_grow_ratio, int new_x_coord_offset) : worlds(new_source_directory, new_compiled_directory, new_my_fish_path, new_x_coord_offset), results("Macro benchmark", "ms", 1000, SCENARIOS_AMOUNT * RESULTS_PER_SCENARIO, 0.1, 0.005, false)
         {
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
-            {
-                fish[i] -> set_next_frame();
-            }
+            fps = new_fps;
+            ticks_amount = new_ticks_amount;
+            eat_grow_ratio = new_eat_grow_ratio;
+            x_coord_offset = new_x_coord_offset;
+            
+            camera_zoom = 0.7;
+            
+            // name, world, population, jelly fish, min scale, max scale, my fish scale, margin.
+            benchmark_scenario new_scenarios[SCENARIOS_AMOUNT] = {
+                {"World 1", 1, 0, 0, 0, 0, 0, 0},
+                {"World 2", 2, 0, 0, 0, 0, 0, 0},
+                {"World 3", 3, 0, 0, 0, 0, 0, 0},
+                {"Player at max scale", 3, 0, 0, 0, 0, 0.8, 0},
+                {"Jellyfish storm", 0, 2000, 1, 0.6, 1.6, 0, 0},
+                {"10k small fish", 0, 10000, 0.15, 0.2, 0.5, 0, 0},
+                {"All fish off-world margin", 0, 2000, 0.15, 0.6, 1.6, 0, 20}};
+            for (int i = 0; i < SCENARIOS_AMOUNT; i++) { scenarios[i] = new_scenarios[i]; }
+            
+            restarts = new int[SCENARIOS_AMOUNT];
+            fish_amounts = new int[SCENARIOS_AMOUNT];
         }
         
-        // Draw the next frame of all the fish.
-        void draw_next_frame()
+        // The function runs all the scenarios and writes their results, then compares them with the baseline if there is one.
+        // Returns false if a scenario could not run or a phase regressed.
+        bool run(string results_path, string baseline_path)
         {
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
-            {
-                fish[i] -> draw_next_frame();
-            }
+            TraceLog(LOG_INFO, "Macro benchmark, %d scenarios of %d ticks", SCENARIOS_AMOUNT, ticks_amount);
+            
+            bool is_passed = true;
+            for (int i = 0; i < SCENARIOS_AMOUNT; i++) { if (!run_scenario(i)) { is_passed = false; } }
+            
+            results.report();
+            results.save_json(results_path, get_json_settings());
+            
+            if (!results.compare(baseline_path)) { is_passed = false; }
+            
+            return is_passed;
         }
+    
+    private:
         
-        // The fish is gone, remove it from the network.
-        void delete_fish(WanderFish* fish_to_remove)
+        // The function runs a scenario for the ticks, and keeps the times of its phases. Returns false if its world could not be made.
+        bool run_scenario(int index)
         {
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
+            benchmark_scenario* scenario = &scenarios[index];
+            
+            restarts[index] = 0;
+            fish_amounts[index] = 0;
+            
+            WorldPack* pack = make_pack(scenario);
+            if (pack == NULL) { TraceLog(LOG_ERROR, "Macro benchmark: the world of \"%s\" could not be made", scenario -> name); return false; }
+            
+            // The margin of the fish, the game one or a part of the world.
+            int margin = (scenario -> margin_ratio > 0) ? (int) (pack -> get_width() * scenario -> margin_ratio) : x_coord_offset;
+            
+            // The world, with its own limits.
+            WorldCatalog* catalog = worlds.make_catalog(pack, fps, eat_grow_ratio, margin, SCREEN_WIDTH, SCREEN_HEIGHT, camera_zoom);
+            if (catalog == NULL) { TraceLog(LOG_ERROR, "Macro benchmark: the world of \"%s\" could not be resolved", scenario -> name); return false; }
+            
+            GameWorld* game_world = catalog -> get_world(1);
+            if (game_world == NULL) { return false; }
+            
+            double setup_start_time = monotonic_time();
+            game_world -> resume();
+            set_my_fish_scale(game_world, scenario);
+            double setup_time = monotonic_time() - setup_start_time;
+            
+            Simulation simulation(game_world, SCREEN_WIDTH, SCREEN_HEIGHT, margin, false, pack -> get_population() + 1, pack -> get_grid_columns() * pack -> get_grid_rows(), false, NULL);
+            
+            // The times of every tick, the whole tick first and then the phases.
+            double* phase_times = new double[TICK_PHASES_AMOUNT];
+            double* times = new double[RESULTS_PER_SCENARIO * ticks_amount];
+            simulation.measure_phases(phase_times);
+            
+            bool is_new_screen = true;
+            
+            for (int tick = 0; tick < ticks_amount; tick++)
             {
-                // Check if this is the current fish.
-                if (fish_to_remove == fish[i])
+                for (int i = 0; i < TICK_PHASES_AMOUNT; i++) { phase_times[i] = 0; }
+                
+                simulation.start(SIM_MODE_WORLD, 1, get_input(tick), 1, is_new_screen);
+                simulation.wait();
+                simulation.unload_retired_gifs();
+                is_new_screen = false;
+                
+                times[tick] = simulation.get_last_simulation_time();
+                for (int i = 0; i < TICK_PHASES_AMOUNT; i++) { times[(i + 1) * ticks_amount + tick] = phase_times[i]; }
+                
+                // The game is over, start it again.
+                int event;
+                bool is_game_over = false;
+                while (simulation.pop_event(&event)) { is_game_over = true; }
+                
+                if (is_game_over)
                 {
-                    // Replace the last fish to the current cell.
-                    fish[i] = fish[current_fish_amount - 1];
-                    
-                    // Free the cell of the last fish, which was replaced.
-                    current_fish_amount--;
+                    game_world -> restart();
+                    game_world -> resume();
+                    set_my_fish_scale(game_world, scenario);
                     
-                    // That's it.
-                    break;
+                    is_new_screen = true;
+                    restarts[index]++;
                 }
             }
             
-            // Remove the fish from the grid.
-            grid -> remove_entity(fish_to_remove);
-        }
-        
-        void delete_network()
-        {
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
+            fish_amounts[index] = game_world -> get_fish_network() -> get_fish_amount();
+            
+            simulation.quit();
+            
+            // The results of the scenario, the whole tick first, named by the scenario and the phase.
+            double tick_mean = 0;
+            for (int i = 0; i < RESULTS_PER_SCENARIO; i++)
             {
-                fish[i] -> delete_gif();
+                char name[96];
+                snprintf(name, sizeof(name), "%s: %s", scenario -> name, get_phase_name(i));
+                
+                benchmark_result* result = results.add(name, 1, &times[i * ticks_amount], ticks_amount);
+                if (i == 0 && result != NULL) { tick_mean = result -> mean; }
             }
+            
+            TraceLog(LOG_INFO, "Macro benchmark: \"%s\", %d fish, grid %dx%d, set-up %.1f ms, %.3f ms a tick, %d restarts", scenario -> name, fish_amounts[index], pack -> get_grid_columns(), pack -> get_grid_rows(), setup_time * 1000, tick_mean, restarts[index]);
+            
+            delete[] phase_times;
+            delete[] times;
+            
+            return true;
         }
         
-        // The function receives a fish profile and loads it to the fish network.
-        void load_fish_profile(fish_profile current_fish_profile, bool is_on_setup)
+        // The function returns the pack of a scenario, a world of the game or a synthetic world (NULL if it can't be made).
+        WorldPack* make_pack(benchmark_scenario* scenario)
         {
-            // Randomize a path stack from the paths_stack array of the fish profile.
-            int random_paths_stack_index = rand() % current_fish_profile.paths_stacks_amount;
+            if (scenario -> world_number > 0) { return worlds.get_pack(scenario -> world_number); }
             
-            // The cells within array of the new fish.
-            Cell** cells_within = new Cell*[grid -> get_rows_amount() * grid -> get_columns_amount()];
+            WorldPack* base = worlds.get_pack(3);
+            if (base == NULL) { return NULL; }
             
-            // Create the fish.
-            WanderFish* fish_to_load = new WanderFish(fps, current_fish_profile.fish_image, current_fish_profile.fish_image_frames_amount, current_fish_profile.collision_frame, current_fish_profile.fish_type, current_fish_profile.is_sting_proof, current_fish_profile.paths_stacks[random_paths_stack_index].initial_location, current_fish_profile.paths_stacks[random_paths_stack_index].is_left, is_on_setup, current_fish_profile.size, current_fish_profile.min_speed_x, current_fish_profile.max_speed_x, current_fish_profile.min_speed_y, current_fish_profile.max_speed_y, current_fish_profile.min_frames_per_path, current_fish_profile.max_frames_per_path, current_fish_profile.paths_stacks[random_paths_stack_index], - x_coord_offset, grid -> get_width_pixels() + x_coord_offset, 0 + current_fish_profile.size.height, grid -> get_height_pixels() - current_fish_profile.size.height, 1, current_fish_profile.max_scaling, current_fish_profile.is_randomize_initial_scale, eat_grow_ratio, current_fish_profile.can_eat_ratio, current_fish_profile.cant_eat_ratio, 0, current_fish_profile.is_facing_left_on_startup, x_coord_offset, grid -> get_rows_amount() * grid -> get_columns_amount(), cells_within, current_fish_profile.sound_eat, current_fish_profile.sound_sting, exclude_setup_location_frame);
-
-            // Save the fish in the fish array.
-            fish[current_fish_amount] = fish_to_load;
-            current_fish_amount++;
+            synthetic_world_settings settings = WorldGenerator::get_settings(base, scenario -> population, SEED);
+            settings.jelly_fish_ratio = scenario -> jelly_fish_ratio;
+            settings.min_scale = scenario -> min_scale;
+            settings.max_scale = scenario -> max_scale;
             
-            // Add the fish to the grid.
-            grid -> add_entity(fish_to_load);
+            string source = WorldGenerator::generate(base, settings);
+            
+            WorldPack* pack = new WorldPack("", "");
+            if (!pack -> compile_source(source.c_str(), source.length())) { delete pack; return NULL; }
+            
+            return pack;
         }
+        
+        // The function sets the scale of my fish of the scenario, after the world was started.
+        void set_my_fish_scale(GameWorld* game_world, benchmark_scenario* scenario)
+        {
+            if (scenario -> my_fish_scale_ratio <= 0) { return; }
             
-        // For Debugging.
-        void print_frames()
+            MyFish* my_fish = game_world -> get_my_fish();
+            my_fish -> set_scale(my_fish -> get_required_scale() * scenario -> my_fish_scale_ratio);
+            game_world -> get_grid() -> refresh_entity(my_fish);
+        }
+        
+        // Returns the input of a tick: right and left every 3 seconds, up and down every 2 seconds.
+        sim_input get_input(int tick)
         {
-            // Iterate over all the fish in the network.
-            for (int i = 0; i < current_fish_amount; i++)
+            sim_input input = { false, false, false, false, GESTURE_NONE, Location(0, 0) };
+            
+            input.is_right_down = (tick / (fps * 3)) % 2 == 0;
+            input.is_left_down = !input.is_right_down;
+            input.is_up_down = (tick / (fps * 2)) % 2 == 0;
+            input.is_down_down = !input.is_up_down;
+            
+            return input;
+        }
+        
+        // Returns the name of a result, the whole tick and then the phases (TickPhase).
+        static const char* get_phase_name(int index) { return (index == 0) ? "tick" : Simulation::get_phase_name(index - 1); }
+        
+        // Returns the settings of the run as json members, the ticks and the scenarios (see BenchmarkResults::save_json()).
+        string get_json_settings()
+        {
+            char line[256];
+            
+            snprintf(line, sizeof(line), "    \"ticks\": %d,\n    \"scenarios\": [\n", ticks_amount);
+            string settings = line;
+            
+            for (int i = 0; i < SCENARIOS_AMOUNT; i++)
             {
-                Rectangle frame = fish[i] -> get_updated_collision_frame();
-                DrawRectangle(frame.x,frame.y, frame.width, frame.height, RED);
+                snprintf(line, sizeof(line), "        {\"name\": \"%s\", \"fish\": %d, \"restarts\": %d}%s\n", scenarios[i].name, fish_amounts[i], restarts[i], i + 1 < SCENARIOS_AMOUNT ? "," : "");
+                settings += line;
             }
+            
+            return settings + "    ],\n";
         }
 };
 
-// ----- Technical Classes -----
 
-class Save
+class MicroBenchmark
 {
     /*
-        Reads the file with the game progress data. Attributes are public.
+        Measures the functions which run for every fish on every tick, each on its own (see MicroCase): the grid, the collisions, eating,
+        the moves of my fish and of the wandering fish, releasing new fish, and the legacy save.
+        
+        Notes:
+            - The world is world 3 (its fish and the jelly fish), read from its pack with its population, its grid and its size (see
+              BenchmarkWorlds, no window and no audio device). The fish are released as on setup, spread over the world, with a fixed seed.
+            - A repetition runs a function a number of times, calibrated once so a repetition takes at least min_repetition_time. Warmup
+              repetitions run first, until warmup_time passed, then the measured repetitions.
+            - A round runs a function once for every fish (or every line of the save), only the calls are timed. Whatever a round changed
+              (the scale, the location, the grid) is restored after it, untimed, so every round starts from the same fish.
+            - Cell::remove_entity() is measured on its worst case, all the fish in one cell (as the fish piled in the margins, see MacroBenchmark).
+            - There is no encryption of the legacy save anymore (progress is written as a record), its lines are encoded here in the legacy
+              protocol to be decrypted. The checksum of the record is measured instead of the encryption.
+            - The results are in nanoseconds an operation, the statistics of the repetitions (see BenchmarkResults). A function regressed if
+              its median grew by more than the tolerance and more than twice the noise (of the run or of the baseline).
+            - The fish which left before a FishNetwork::load_available_fish() round are freed, untimed (no snapshot refers to them here, unlike
+              the fish which leave the game), so the allocator reuses their memory in the next rounds.
+            - The results of the functions are summed to results_sum, so the compiler can't drop the calls.
     */
-    public:
+    
+    private:
         
-        // The path to the saving file.
-        string file_path;
+        // The measured world.
+        static const int WORLD_NUMBER = 3;
         
-        // The path to the template save file in the resources directory.
-        string resources_file_path;
+        // The screen around my fish, where it is sent to (the touch).
+        static const int SCREEN_WIDTH = 1920;
+        static const int SCREEN_HEIGHT = 1080;
         
-        // The file handler.
-        fstream save_file;
+        // The seed of the fish.
+        static const int SEED = 1;
         
-        // To what world the user has reached.
-        int world_checkpoint;
+        // The measured repetitions of a function, and the most rounds a repetition can have.
+        static const int REPETITIONS = 31;
+        static const int MAX_ROUNDS = 1 << 20;
+        
+        // The lines of the legacy save and the save records.
+        static const int LEGACY_LINES_AMOUNT = 16;
+        static const int RECORDS_AMOUNT = 64;
+        
+        // The game properties, and the population of the world.
+        int fps;
+        int population;
+        
+        // How long the warmup of a function is, and how long a repetition is at least (seconds).
+        double warmup_time;
+        double min_repetition_time;
+        
+        // The world (NULL if its pack could not be read).
+        BenchmarkWorlds worlds;
+        GameWorld* game_world;
+        Grid* grid;
+        MyFish* my_fish;
+        FishNetwork* fish_network;
+        
+        // The states every round starts from.
+        wander_fish_state* fish_states;
+        my_fish_state my_fish_start_state;
+        
+        // The cell of Cell::remove_entity(), and the order the fish are removed from it.
+        Cell* crowded_cell;
+        int* removal_order;
+        
+        // Where my fish is sent to.
+        Location* destinations;
+        
+        // The encoded lines of the legacy save, and the save records.
+        string* legacy_lines;
+        save_record* records;
         
-        // The current content of the file.
-        string current_file_content;
+        // The results, and the sum of the results of the functions.
+        BenchmarkResults results;
+        double results_sum;
     
     public:
-    
-        Save(string new_file_path, string new_resources_file_path)
+        
+        // Constructor.
+        MicroBenchmark(string source_directory, string compiled_directory, const char* my_fish_path, int new_fps, float eat_grow_ratio, int x_coord_offset) : worlds(source_directory, compiled_directory, my_fish_path, x_coord_offset), results("Micro benchmark", "ns", 1e9, MICRO_CASES_AMOUNT, 0.1, 0, true)
         {
-            // Save the path of the save file.
-            file_path = new_file_path;
-            resources_file_path = new_resources_file_path;
-
-            //TraceLog(1, ("file path: " + file_path + "\n").c_str());
-            //TraceLog(1, ("resourecs file path: " + resources_file_path + "\n").c_str());
-
-            // If the file path is not the resources path.
-            if (file_path != resources_file_path)
+            fps = new_fps;
+            population = 0;
+            
+            warmup_time = 0.2;
+            min_repetition_time = 0.005;
+            results_sum = 0;
+            
+            // The world, as the game plays it (with the zoom of the game).
+            WorldPack* pack = worlds.get_pack(WORLD_NUMBER);
+            WorldCatalog* catalog = (pack != NULL) ? worlds.make_catalog(pack, fps, eat_grow_ratio, x_coord_offset, SCREEN_WIDTH, SCREEN_HEIGHT, 0.7) : NULL;
+            
+            srand(SEED);
+            game_world = (catalog != NULL) ? catalog -> get_world(1) : NULL;
+            if (game_world == NULL) { TraceLog(LOG_ERROR, "Micro benchmark: world %d could not be read", WORLD_NUMBER); return; }
+            
+            game_world -> resume();
+            grid = game_world -> get_grid();
+            my_fish = game_world -> get_my_fish();
+            fish_network = game_world -> get_fish_network();
+            population = pack -> get_population();
+            
+            my_fish -> update_boundaries(75, grid -> get_width_pixels() - 75, 54, grid -> get_height_pixels() - 54, false);
+            
+            fish_states = new wander_fish_state[population];
+            fish_network -> save_states(fish_states, population);
+            my_fish -> save_state(&my_fish_start_state);
+            
+            // The crowded cell, the fish are removed from it in a random order.
+            crowded_cell = new Cell(population, new GridEntity*[population]);
+            removal_order = new int[population];
+            Random random(SEED);
+            for (int i = 0; i < population; i++) { removal_order[i] = i; }
+            for (int i = population - 1; i > 0; i--) { swap(removal_order[i], removal_order[random.next() % (i + 1)]); }
+            
+            // The touches, anywhere on the screen around my fish.
+            destinations = new Location[population];
+            for (int i = 0; i < population; i++)
             {
-                //TraceLog(1, "different.\n");
-
-                // Try to access the file.
-                std::ifstream f(file_path.c_str());
-                
-                // If the save file does not exist yet, create it with the template from the resources directory.
-                if (!f.good())
-                {
-                    //TraceLog(1, "not good.\n");
-                    
-                    // Copy the template file.
-                    
-                    ofstream outfile (file_path);
-
-                    outfile << "hello";
-
-                    outfile.close();
-                }
+                destinations[i] = Location(my_fish -> get_location().x - SCREEN_WIDTH / 2 + random.next() % SCREEN_WIDTH, my_fish -> get_location().y - SCREEN_HEIGHT / 2 + random.next() % SCREEN_HEIGHT);
             }
             
-            // Open the file.
-            save_file.open(file_path, ios::in | ios::out | ios::app | ios::binary);
+            // The legacy save lines, and the records of the worlds.
+            legacy_lines = new string[LEGACY_LINES_AMOUNT];
+            for (int i = 0; i < LEGACY_LINES_AMOUNT; i++)
+            {
+                char line[64];
+                snprintf(line, sizeof(line), "world checkpoint: %02d", i % 3 + 1);
+                legacy_lines[i] = encode_legacy(line);
+            }
             
-            // Default values.
-            world_checkpoint = 1;
+            records = new save_record[RECORDS_AMOUNT];
+            memset(records, 0, sizeof(save_record) * RECORDS_AMOUNT);
+            for (int i = 0; i < RECORDS_AMOUNT; i++)
+            {
+                memcpy(records[i].magic, "FSAV", 4);
+                records[i].version = 1;
+                records[i].world_checkpoint = i % 3 + 1;
+            }
+        }
+        
+        // The function measures all the functions and writes their results, then compares them with the baseline if there is one.
+        // Returns false if the world could not be read or a function regressed.
+        bool run(string results_path, string baseline_path)
+        {
+            if (game_world == NULL) { return false; }
             
-            // - Read the file -
-            //TraceLog(1, "Trying to load..");
-            if (!save_file) { return; }
-            //TraceLog(1, "Loaded!");
-            // The current line read from the file.
-            string current_line;
+            TraceLog(LOG_INFO, "Micro benchmark, %d functions, %d fish, %d repetitions", MICRO_CASES_AMOUNT, fish_network -> get_fish_amount(), REPETITIONS);
+            
+            for (int i = 0; i < MICRO_CASES_AMOUNT; i++) { run_case(i); }
+            
+            results.report();
+            TraceLog(LOG_DEBUG, "Micro benchmark: the sum of the results %f", results_sum);
+            
+            char settings[128];
+            snprintf(settings, sizeof(settings), "    \"fish\": %d,\n    \"repetitions\": %d,\n", population, REPETITIONS);
+            results.save_json(results_path, settings);
+            
+            return results.compare(baseline_path);
+        }
+    
+    private:
+        
+        // The function calibrates, warms up and measures a function, and keeps its statistics.
+        void run_case(int micro_case)
+        {
+            // Double the rounds until a repetition is long enough.
+            int rounds = 1;
+            while (rounds < MAX_ROUNDS && run_repetition(micro_case, rounds) < min_repetition_time) { rounds *= 2; }
+            
+            double warmup_start_time = monotonic_time();
+            while (monotonic_time() - warmup_start_time < warmup_time) { run_repetition(micro_case, rounds); }
+            
+            // The repetitions.
+            double times[REPETITIONS];
+            for (int i = 0; i < REPETITIONS; i++) { times[i] = run_repetition(micro_case, rounds); }
+            
+            benchmark_result* result = results.add(get_case_name(micro_case), rounds * get_round_operations(micro_case), times, REPETITIONS);
+            
+            TraceLog(LOG_INFO, "Micro benchmark: %s, %.1f ns, noise %.1f%%", result -> name, result -> median, BenchmarkResults::get_noise(result) * 100);
+        }
+        
+        // The function runs the rounds of a function, returns how long its calls took (seconds).
+        double run_repetition(int micro_case, int rounds)
+        {
+            double time = 0;
+            for (int i = 0; i < rounds; i++) { time += run_round(micro_case); }
+            
+            return time;
+        }
+        
+        // Returns how many times a round calls the function.
+        int get_round_operations(int micro_case)
+        {
+            if (micro_case == MICRO_SAVE_DECRYPT) { return LEGACY_LINES_AMOUNT; }
+            if (micro_case == MICRO_SAVE_CHECKSUM) { return RECORDS_AMOUNT; }
+            
+            return population;
+        }
+        
+        // The function calls the function once for every fish (or line of the save), returns how long the calls took (seconds). The fish are restored after it.
+        double run_round(int micro_case)
+        {
+            int fish_amount = fish_network -> get_fish_amount();
+            double start_time;
+            double time;
             
-            // Do not read more than 100 lines from the file.
-            int count = 100;
-            string temp;
-            //TraceLog(1, "is eof?\n");
-            // Iterate over the lines of the file.
-            while (!save_file.eof() && count > 0)
+            switch (micro_case)
             {
-                getline(save_file, current_line);
+                case MICRO_GRID_ADD_ENTITY:
+                    for (int i = 0; i < fish_amount; i++) { grid -> remove_entity(fish_network -> get_fish(i)); }
+                    
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++) { grid -> add_entity(fish_network -> get_fish(i)); }
+                    return monotonic_time() - start_time;
                 
-                for (int i=0; i<100; i++)
-                {
-                    temp = current_line[i];
-                    //TraceLog(1, temp.c_str());
-                }
+                case MICRO_GRID_REFRESH_ENTITY:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++) { grid -> refresh_entity(fish_network -> get_fish(i)); }
+                    return monotonic_time() - start_time;
                 
-                // Decrypt the current line.
-                current_line = decrypt(current_line);
-                //TraceLog(1, ("current line:" + current_line).c_str());
-                // Add the line to the file content.
-                current_file_content += current_line + "\n";
-
-                // Analyze the line to get required data.
+                case MICRO_CELL_REMOVE_ENTITY:
+                    for (int i = 0; i < fish_amount; i++)
+                    {
+                        grid -> remove_entity(fish_network -> get_fish(i));
+                        crowded_cell -> add_entity(fish_network -> get_fish(i));
+                    }
+                    
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++) { crowded_cell -> remove_entity(fish_network -> get_fish(removal_order[i])); }
+                    time = monotonic_time() - start_time;
+                    
+                    for (int i = 0; i < fish_amount; i++)
+                    {
+                        fish_network -> get_fish(i) -> reset_cells_within();
+                        grid -> add_entity(fish_network -> get_fish(i));
+                    }
+                    
+                    return time;
                 
-                // Read world checkpoint.
-                if (current_line.rfind("world checkpoint: ", 0) == 0)
-                {
-                    int world_checkpoint_length = ((string) ("world checkpoint: ")).length();
-                    if ((int) current_line.length() >= (int) world_checkpoint_length + 2 && isdigit(current_line[world_checkpoint_length]) && isdigit(current_line[world_checkpoint_length + 1])) 
+                case MICRO_COLLISION_FRAME:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++) { Rectangle collision_frame = fish_network -> get_fish(i) -> get_updated_collision_frame(); results_sum += collision_frame.x + collision_frame.width; }
+                    return monotonic_time() - start_time;
+                
+                // Every fish collides with the next one: the same species, a jelly fish, or one which eats the other.
+                case MICRO_HANDLE_COLLISION:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++) { fish_network -> get_fish(i) -> handle_collision(fish_network -> get_fish((i + 1) % fish_amount)); }
+                    time = monotonic_time() - start_time;
+                    
+                    restore_fish();
+                    
+                    return time;
+                
+                // Every fish eats the next one.
+                case MICRO_EAT:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++)
                     {
-                        string number = current_line.substr(world_checkpoint_length, 2);
-                        world_checkpoint = stoi(number); 
+                        WanderFish* other_fish = fish_network -> get_fish((i + 1) % fish_amount);
+                        results_sum += fish_network -> get_fish(i) -> eat((int) floor(other_fish -> get_size().width * other_fish -> get_size().height * other_fish -> get_scale()));
                     }
-                }
+                    time = monotonic_time() - start_time;
+                    
+                    restore_fish();
+                    
+                    return time;
+                
+                case MICRO_MOVE_TOWARDS:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < population; i++) { my_fish -> move_towards(destinations[i]); }
+                    time = monotonic_time() - start_time;
+                    
+                    my_fish -> load_state(&my_fish_start_state);
+                    
+                    return time;
+                
+                case MICRO_WANDER_MOVE:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < fish_amount; i++) { fish_network -> get_fish(i) -> move(); }
+                    time = monotonic_time() - start_time;
+                    
+                    restore_fish();
+                    
+                    return time;
+                
+                // All the fish left and are freed, the network is filled again (the new fish are the fish of the next rounds).
+                case MICRO_LOAD_AVAILABLE_FISH:
+                    while (fish_network -> get_fish_amount() > 0)
+                    {
+                        WanderFish* left_fish = fish_network -> get_fish(fish_network -> get_fish_amount() - 1);
+                        fish_network -> delete_fish(left_fish);
+                        FishNetwork::free_fish(left_fish);
+                    }
+                    
+                    start_time = monotonic_time();
+                    fish_network -> load_available_fish(false);
+                    time = monotonic_time() - start_time;
+                    
+                    fish_network -> save_states(fish_states, population);
+                    
+                    return time;
+                
+                case MICRO_SAVE_DECRYPT:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < LEGACY_LINES_AMOUNT; i++) { results_sum += Save::decrypt(legacy_lines[i]).length(); }
+                    return monotonic_time() - start_time;
                 
-                // Count one more line.
-                count--;
+                case MICRO_SAVE_CHECKSUM:
+                    start_time = monotonic_time();
+                    for (int i = 0; i < RECORDS_AMOUNT; i++) { results_sum += Save::checksum((const unsigned char*) &records[i], offsetof(save_record, checksum)); }
+                    return monotonic_time() - start_time;
+            }
+            
+            return 0;
+        }
+        
+        // The function puts the fish back in the states the rounds start from.
+        void restore_fish()
+        {
+            for (int i = 0; i < fish_network -> get_fish_amount(); i++)
+            {
+                fish_network -> get_fish(i) -> load_state(&fish_states[i]);
+                grid -> refresh_entity(fish_network -> get_fish(i));
+            }
+        }
+        
+        // The function returns a line encoded in the protocol of the legacy save (see Save::decrypt()).
+        static string encode_legacy(const char* line)
+        {
+            string encoded;
+            
+            for (int i = 0; line[i] != '\0'; i++)
+            {
+                char number[16];
+                snprintf(number, sizeof(number), "%d_", (unsigned char) line[i] * (i + 4) + 7);
+                encoded += number;
+            }
+            
+            return encoded;
+        }
+        
+        // Returns the name of a function (MicroCase).
+        static const char* get_case_name(int micro_case)
+        {
+            const char* names[] = {"Grid::add_entity", "Grid::refresh_entity", "Cell::remove_entity", "GridEntity::get_updated_collision_frame", "Fish::handle_collision", "Fish::eat", "MyFish::move_towards", "WanderFish::move", "FishNetwork::load_available_fish", "Save::decrypt", "Save::checksum"};
+            
+            return names[micro_case];
+        }
+};
+
+
+class SceneMachine
+{
+    /*
+        Switches between the scenes of the game (Scene), and owns the resources of the current scene.
+        
+        Notes:
+            - Every scene has a profile, its asset bundles and its music. Entering a scene loads its bundles and crossfades to its music,
+              leaving it unloads the bundles the next scene doesn't need (AssetLoader::unload_bundles()).
+            - The resident bundles are never unloaded. World 1 is the background of the menus, so it is only suspended while another world is played.
+            - A scene can acquire more bundles while it runs (the map prefetches the worlds), they are released with the scene unless the change keeps them.
+            - The state of the screens (the fish, the windows) stays in the main loop. A change is made between the frames, while the simulation is idle.
+            - Measures the cost of the frames of every scene (the update and the drawing of the main thread, without waiting for the display).
+            - Measures the CPU of the whole game (all the threads) on every scene, apart for the idle windows of the scene (see set_idle()).
+    */
+    
+    private:
+    
+        // Loads the bundles, and plays the music.
+        AssetLoader* asset_loader;
+        MusicPlayer* music_player;
+        
+        // The profiles of the scenes, in the order of Scene.
+        scene_profile* profiles;
+        
+        // The bundles which are never unloaded.
+        unsigned int resident_bundles;
+        
+        // The current scene, and the bundles it holds (its profile, and the ones it acquired).
+        int scene;
+        unsigned int held_bundles;
+        
+        // Measurements of every scene, in seconds.
+        double frame_start_time;
+        long* frames_amounts;
+        long* enters_amounts;
+        double* total_frame_times;
+        double* max_frame_times;
+        
+        // The CPU time and the real time of every scene, while active and while idle (seconds).
+        double last_cpu_time;
+        int measured_scene;
+        bool is_measured_idle;
+        double* active_cpu_times;
+        double* active_times;
+        double* idle_cpu_times;
+        double* idle_times;
+    
+    public:
+    
+        // Constructor, starts loading the bundles of the first scene (its music is started by play_music()).
+        SceneMachine(AssetLoader* new_asset_loader, MusicPlayer* new_music_player, scene_profile* new_profiles, unsigned int new_resident_bundles, int first_scene)
+        {
+            asset_loader = new_asset_loader;
+            music_player = new_music_player;
+            profiles = new_profiles;
+            resident_bundles = new_resident_bundles;
+            
+            // Create the measurements arrays.
+            frames_amounts = new long[SCENES_AMOUNT];
+            enters_amounts = new long[SCENES_AMOUNT];
+            total_frame_times = new double[SCENES_AMOUNT];
+            max_frame_times = new double[SCENES_AMOUNT];
+            active_cpu_times = new double[SCENES_AMOUNT];
+            active_times = new double[SCENES_AMOUNT];
+            idle_cpu_times = new double[SCENES_AMOUNT];
+            idle_times = new double[SCENES_AMOUNT];
+            
+            for (int i = 0; i < SCENES_AMOUNT; i++)
+            {
+                frames_amounts[i] = 0;
+                enters_amounts[i] = 0;
+                total_frame_times[i] = 0;
+                max_frame_times[i] = 0;
+                active_cpu_times[i] = 0;
+                active_times[i] = 0;
+                idle_cpu_times[i] = 0;
+                idle_times[i] = 0;
             }
-            //TraceLog(1, "was it?\n");
-            //TraceLog(1, "final content:\n");
-            //TraceLog(1, current_file_content.c_str());
             
-            // Make the file ready to write.
-            save_file.clear();
+            frame_start_time = monotonic_time();
+            last_cpu_time = get_cpu_time();
+            measured_scene = first_scene;
+            is_measured_idle = false;
+            
+            // Enter the first scene.
+            scene = first_scene;
+            held_bundles = profiles[scene].bundles;
+            enters_amounts[scene]++;
+            asset_loader -> load_bundles(held_bundles);
         }
         
-        // The function updates the world checkpoint in the file and in the world_checkpoint variable.
-        void update_world_checkpoint(int new_checkpoint)
+        // The function leaves the current scene and enters the new one (main thread, not while the simulation runs).
+        // The kept bundles are not unloaded even if the new scene doesn't need them.
+        void change(int new_scene, unsigned int kept_bundles)
         {
-            //TraceLog(1, ("updating world checkpoint to:" + to_string(new_checkpoint) + ".\n").c_str());
-            // Update the value of world checkpoint.
-            world_checkpoint = new_checkpoint;
+            // Exit, release what the new scene doesn't need.
+            unsigned int needed_bundles = profiles[new_scene].bundles | kept_bundles | resident_bundles;
+            unsigned int released_bundles = held_bundles & ~needed_bundles;
             
-            // Create the world checkpoint string.
-            string world_checkpoint_string = "";
-            if (world_checkpoint >= 10) { world_checkpoint_string = to_string(world_checkpoint); }
-            else { world_checkpoint_string = "0" + to_string(world_checkpoint); }
-            
-            // Variables for the following loop.
-            string current_line;
-            int current_index = 0;
-            int world_checkpoint_length = ((string) "world checkpoint: ").length();
-
-            // Iterate over the content of the file.
-            while (current_index < (int) current_file_content.length())
+            if (released_bundles != 0)
             {
-                // This is the end of the current line.
-                if (current_file_content[current_index] == '\\' && current_index + 1 < (int) (current_file_content.length()) && current_file_content[current_index + 1] == 'n') { current_line = ""; continue; }
-                
-                // Add the next character of the line.
-                current_line += current_file_content[current_index];
-                
-                // Make the check.
-                if (current_line.substr(0, world_checkpoint_length) == "world checkpoint: " && (int) current_line.length() == world_checkpoint_length + 2)
-                {
-                    current_file_content[current_index - 1] = world_checkpoint_string[0];
-                    current_file_content[current_index] = world_checkpoint_string[1];
-                    break;
-                }
-                
-                // Move to the next index.
-                current_index++;
+                int unloaded_amount = asset_loader -> unload_bundles(released_bundles, needed_bundles);
+                TraceLog(LOG_INFO, "Scene %s: released %d assets (bundles 0x%x)", profiles[scene].name, unloaded_amount, released_bundles);
             }
-            //TraceLog(1, "before calling to update:\n");
-            //TraceLog(1, current_file_content.c_str());
-            // Update the new content of the file.
-            update_file_content();
+            
+            // Enter.
+            scene = new_scene;
+            held_bundles = profiles[scene].bundles | (held_bundles & kept_bundles);
+            enters_amounts[scene]++;
+            asset_loader -> load_bundles(profiles[scene].bundles);
+            play_music();
         }
         
-        // The function rewrites the file with the current file content value.
-        void update_file_content()
+        // The function loads more bundles for the current scene, they are released when it is left.
+        void acquire(unsigned int bundles)
         {
-            // Close the file to write its new content.
-            save_file.close();
-            
-            // Open the file and clear its current content.
-            fstream save_file(file_path, ios::out | ios::trunc | ios::binary);
-            
-            // Write the updated content.
-            save_file << encrypt(current_file_content);
-            //TraceLog(1, "in update:\n");
-            //TraceLog(1, current_file_content.c_str());
-            // Close the file.
-            save_file.close();
-            
-            // And open it for reading again.
-            save_file.open(file_path, ios::in | ios::out | ios::app | ios::binary);
+            held_bundles |= bundles;
+            asset_loader -> load_bundles(bundles);
         }
         
-        // The function receives a string and encrypts it.
-        string encrypt(string to_encrypt)
+        // The function crossfades to the music of the current scene.
+        void play_music() { music_player -> play(profiles[scene].music_track); }
+        
+        // Getters.
+        int get_scene() { return scene; }
+        const char* get_name() { return profiles[scene].name; }
+        bool is_world() { return scene >= SCENE_WORLD1; }
+        
+        // The function starts measuring a frame. The time since the previous frame belongs to the scene which was shown (with the wait for the display or the input).
+        void begin_frame()
         {
-            // The final encrypted string.
-            string encrypted = "";
+            double current_time = monotonic_time();
+            double current_cpu_time = get_cpu_time();
             
-            // Iterate over the received string.
-            for (int i = 0; i < (int) to_encrypt.length(); i++)
+            if (is_measured_idle)
             {
-                // Keep on the lines structure.
-                if (to_encrypt[i] == '\\' && i + 1 < (int) (to_encrypt.length()) && to_encrypt[i + 1] == 'n') { to_encrypt[i] = '\\'; to_encrypt[i + 1] = 'n'; i += 1; continue; }
-
-                // Encrypt the current char.
-                encrypted += to_string(int(to_encrypt[i]) * (i + 4) + 7) + "_";
+                idle_cpu_times[measured_scene] += current_cpu_time - last_cpu_time;
+                idle_times[measured_scene] += current_time - frame_start_time;
+            }
+            else
+            {
+                active_cpu_times[measured_scene] += current_cpu_time - last_cpu_time;
+                active_times[measured_scene] += current_time - frame_start_time;
             }
             
-            // Return the new encrypted string.
-            return encrypted;
+            frame_start_time = current_time;
+            last_cpu_time = current_cpu_time;
+            measured_scene = scene;
+            is_measured_idle = false;
         }
         
-        // The function recieves an encrypted string, decrypts it and returns the decrypted string.
-        string decrypt(string to_decrypt)
+        // The function marks the current frame as the frame of an idle window (it is measured apart).
+        void set_idle(bool is_idle) { is_measured_idle = is_idle; }
+        
+        // The function ends the measured frame, before it is shown (the time waiting for the display is not counted).
+        void end_frame()
         {
-            // The decrypted string will be here at the end.
-            string decrypted = "";
-            
-            // the current decrypted character.
-            string current = "";
+            double frame_time = monotonic_time() - frame_start_time;
             
-            // The index of the received string.
-            int index = 0;
-            
-            // The current char index.
-            int char_index = 0;
-            //TraceLog(1, ("to decrypt: " + to_decrypt + "\n").c_str());
-            // Iterate over the received string.
-            while (index < (int) to_decrypt.length())
+            frames_amounts[scene]++;
+            total_frame_times[scene] += frame_time;
+            max_frame_times[scene] = max(max_frame_times[scene], frame_time);
+        }
+        
+        // The function logs the cost of the frames of every scene.
+        void report()
+        {
+            for (int i = 0; i < SCENES_AMOUNT; i++)
             {
-                // Is the current decrypted character fully loaded?
-                if (to_decrypt[index] == '_')
-                {
-                    // Decrypt the current char (get it's ascii value).
-                    decrypted += char((stoi(current) - 7) / (char_index + 4));
-                    
-                    // Reset the current decrypted char.
-                    current = "";
-                    
-                    // Count another decrypted character.
-                    char_index++;
-                }
+                if (frames_amounts[i] == 0) { continue; }
                 
-                // Keep loading the current decrypted character.
-                else 
-                {
-                    // This is not a number, the received string was not encrypted according to the protocol. Return an empty string.
-                    //if (!isdigit(to_decrypt[index])) { ; return ""; }
-                    
-                    // Update the current decrypted character.
-                    current += to_decrypt[index]; 
-                }
+                TraceLog(LOG_INFO, "Scene %s: entered %ld times, %ld frames, mean %.2f ms a frame (max %.2f ms)", profiles[i].name, enters_amounts[i], frames_amounts[i], total_frame_times[i] / frames_amounts[i] * 1000, max_frame_times[i] * 1000);
                 
-                // Move to the next character in the received string.
-                index++;
+                // The CPU is in percents of a single core (100% is a busy core).
+                if (active_times[i] > 0) { TraceLog(LOG_INFO, "Scene %s: CPU %.1f%% for %.1f seconds", profiles[i].name, active_cpu_times[i] / active_times[i] * 100, active_times[i]); }
+                if (idle_times[i] > 0) { TraceLog(LOG_INFO, "Scene %s: CPU %.1f%% for %.1f seconds on the idle windows", profiles[i].name, idle_cpu_times[i] / idle_times[i] * 100, idle_times[i]); }
             }
-            //TraceLog(1, ("decrypted: " + decrypted + "\n").c_str());
-            // Return the decrypted string.
-            return decrypted;
         }
-        
-        // Close the game progress file.
-        void quit()
+    
+    private:
+    
+        // Returns the CPU time of the process, all its threads (seconds, 0 where unknown).
+        static double get_cpu_time()
         {
-            save_file.close();
+            #if !defined(_WIN32)
+            
+                struct timespec cpu_time;
+                if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_time) == 0) { return cpu_time.tv_sec + cpu_time.tv_nsec / 1e9; }
+                
+            #endif
+            
+            return 0;
         }
 };
 
@@ -2311,107 +10640,168 @@ class Save
 // ----- Functions -----
 
 
-// The images loading function.
-static void* load_images_thread(void *images_argument)
+// The function returns true if the user did something on the last input events (the idle screens are only drawn again then).
+static bool is_input_event()
 {
-    // Cast the images argument to images struct.
-    struct images_refrences *images = (struct images_refrences *)images_argument;
-    
-    images -> my_fish_image = LoadImageAnim(images -> path_my_fish, &images -> my_fish_image_frames_amount);
-    data_progress++;
-    
-    images -> fish1_image = LoadImageAnim(images -> path_fish1, &images -> fish1_image_frames_amount);
-    data_progress++;
-    
-    images -> fish2_image = LoadImageAnim(images -> path_fish2, &images -> fish2_image_frames_amount);
-    data_progress++;
-    
-    images -> fish3_image = LoadImageAnim(images -> path_fish3, &images -> fish3_image_frames_amount);
-    data_progress++;
-    
-    images -> fish4_image = LoadImageAnim(images -> path_fish4, &images -> fish4_image_frames_amount);
-    data_progress++;
-    
-    images -> fish5_image = LoadImageAnim(images -> path_fish5, &images -> fish5_image_frames_amount);
-    data_progress++;
-    
-    images -> fish6_image = LoadImageAnim(images -> path_fish6, &images -> fish6_image_frames_amount);
-    data_progress++;
+    Vector2 mouse_delta = GetMouseDelta();
     
-    images -> fish7_image = LoadImageAnim(images -> path_fish7, &images -> fish7_image_frames_amount);
-    data_progress++;
+    if (mouse_delta.x != 0 || mouse_delta.y != 0) { return true; }
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) { return true; }
+    if (GetTouchPointCount() > 0 || GetKeyPressed() != 0) { return true; }
     
-    images -> fish8_image = LoadImageAnim(images -> path_fish8, &images -> fish8_image_frames_amount);
-    data_progress++;
-    
-    images -> fish9_image = LoadImageAnim(images -> path_fish9, &images -> fish9_image_frames_amount);
-    data_progress++;
-    
-    images -> fish10_image = LoadImageAnim(images -> path_fish10, &images -> fish10_image_frames_amount);
-    data_progress++;
-    
-    images -> fish11_image = LoadImageAnim(images -> path_fish11, &images -> fish11_image_frames_amount);
-    data_progress++;
-    
-    images -> crab1_image = LoadImageAnim(images -> path_crab1, &images -> crab1_image_frames_amount);
-    data_progress++;
-    
-    images -> crab2_image = LoadImageAnim(images -> path_crab2, &images -> crab2_image_frames_amount);
-    data_progress++;
+    return IsWindowResized();
+}
+
+
+// The function reads the input of the frame: the mouse (or the touch), the keys and the gesture.
+static void read_frame_input(frame_input* input)
+{
+    input -> mouse_point = GetMousePosition();
+    input -> is_mouse_pressed = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+    input -> is_mouse_released = IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
     
-    images -> jelly_fish1_image = LoadImageAnim(images -> path_jelly_fish1, &images -> jeflly_fish1_image_frames_amount);
-    data_progress++;
+    input -> is_right_down = IsKeyDown(KEY_RIGHT);
+    input -> is_left_down = IsKeyDown(KEY_LEFT);
+    input -> is_up_down = IsKeyDown(KEY_UP);
+    input -> is_down_down = IsKeyDown(KEY_DOWN);
+    input -> is_rewind_down = IsKeyDown(KEY_R);
     
-    images -> jelly_fish2_image = LoadImageAnim(images -> path_jelly_fish2, &images -> jeflly_fish2_image_frames_amount);
-    data_progress++;
+    input -> gesture = GetGestureDetected();
+    input -> touch_location = Location(GetTouchPosition(0).x, GetTouchPosition(0).y);
+    input -> touch_count = GetTouchPointCount();
     
-    // Images loading finished. Notify the main thread.
-    atomic_store(&images_loaded, true);
+    input -> is_focused = IsWindowFocused();
+    input -> is_input_event = is_input_event();
     
-    return NULL;
+    input -> is_profiler_toggled = IsKeyPressed(KEY_F3);
 }
 
 
-// The audio loading function.
-static void* load_audio_thread(void *audio_argument)
+// The function returns the peak resident memory of the game in kilobytes, since the start or since reset_peak_rss() (0 if unknown).
+static long get_peak_rss()
 {
-    // Cast the images argument to images struct.
-    struct audio_refrences *audio = (struct audio_refrences *)audio_argument;
+    long peak_rss = 0;
     
-    // Load music.
-    audio -> music_main_theme = LoadSound(audio -> path_music_main_theme);
-    data_progress++;
+    #if !defined(_WIN32)
     
-    audio -> music_world1 = LoadSound(audio -> path_music_world1);
-    data_progress++;
+        FILE* status_file = fopen("/proc/self/status", "r");
+        if (status_file == NULL) { return 0; }
+        
+        char line[128];
+        while (fgets(line, sizeof(line), status_file) != NULL)
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0) { peak_rss = atol(line + 6); break; }
+        }
+        
+        fclose(status_file);
+        
+    #endif
     
-    audio -> music_world2 = LoadSound(audio -> path_music_world2);
-    data_progress++;
+    return peak_rss;
+}
+
+
+// The function resets the peak resident memory to the current one (linux and android, elsewhere the peak stays since the start).
+static void reset_peak_rss()
+{
+    #if !defined(_WIN32)
     
-    audio -> music_world3 = LoadSound(audio -> path_music_world3);
-    data_progress++;
+        FILE* clear_refs_file = fopen("/proc/self/clear_refs", "w");
+        if (clear_refs_file == NULL) { return; }
+        
+        fputs("5", clear_refs_file);
+        fclose(clear_refs_file);
+        
+    #endif
+}
+
+
+// The function returns the current time in seconds, from a monotonic clock (unlike GetTime(), valid before the window is created and on any thread).
+static double monotonic_time()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// The function decodes every gif under the textures folder with LoadImageAnim and with the GifDecoder, and logs the times.
+static void benchmark_gif_decoder(const char* textures_path, WorkerPool* pool)
+{
+    FilePathList gifs = LoadDirectoryFilesEx(textures_path, ".gif", true);
+    double total_raylib_time = 0, total_decoder_time = 0;
     
-    // Load sound.
-    audio -> sound_eat = LoadSound(audio -> path_sound_eat);
+    TraceLog(LOG_INFO, "GIF decoder benchmark, %d gifs, %d workers", gifs.count, pool -> get_workers_amount());
     
-    audio -> sound_eat_lower = LoadSound(audio -> path_sound_eat_lower);
+    for (unsigned int i = 0; i < gifs.count; i++)
+    {
+        int raylib_frames_amount = 0, decoder_frames_amount = 0;
+        
+        // Decode with raylib.
+        double start_time = GetTime();
+        Image raylib_image = LoadImageAnim(gifs.paths[i], &raylib_frames_amount);
+        double raylib_time = GetTime() - start_time;
+        
+        // Decode with the game decoder.
+        start_time = GetTime();
+        Image decoder_image = GifDecoder::load(gifs.paths[i], &decoder_frames_amount, pool);
+        double decoder_time = GetTime() - start_time;
+        
+        // Count the pixels which are not the same.
+        int different_pixels = -1;
+        
+        if (raylib_frames_amount == decoder_frames_amount && raylib_image.width == decoder_image.width && raylib_image.height == decoder_image.height && raylib_image.data != NULL && decoder_image.data != NULL)
+        {
+            different_pixels = 0;
+            int* raylib_pixels = (int*) raylib_image.data;
+            int* decoder_pixels = (int*) decoder_image.data;
+            
+            for (long j = 0; j < (long) raylib_image.width * raylib_image.height * raylib_frames_amount; j++)
+            {
+                if (raylib_pixels[j] != decoder_pixels[j]) { different_pixels++; }
+            }
+        }
+        
+        TraceLog(LOG_INFO, "    %-40s frames %3d  LoadImageAnim %8.2f ms  GifDecoder %8.2f ms  x%.2f  different pixels %d", GetFileName(gifs.paths[i]), decoder_frames_amount, raylib_time * 1000, decoder_time * 1000, raylib_time / max(decoder_time, 0.000001), different_pixels);
+        
+        total_raylib_time += raylib_time;
+        total_decoder_time += decoder_time;
+        
+        UnloadImage(raylib_image);
+        UnloadImage(decoder_image);
+    }
     
-    audio -> sound_sting1 = LoadSound(audio -> path_sound_sting1);
+    TraceLog(LOG_INFO, "    Total  LoadImageAnim %.2f ms  GifDecoder %.2f ms  x%.2f", total_raylib_time * 1000, total_decoder_time * 1000, total_raylib_time / max(total_decoder_time, 0.000001));
     
-    audio -> sound_sting1_lower = LoadSound(audio -> path_sound_sting1_lower);
-    data_progress++;
+    UnloadDirectoryFiles(gifs);
+}
+
+
+// The function writes the sources of synthetic worlds of growing populations (a fixed seed), made from the fish, crabs and jelly fish of world 3.
+static void write_synthetic_worlds(WorldCatalog* world_catalog, AssetLoader* asset_loader, string directory)
+{
+    const int POPULATIONS[] = {50, 500, 5000, 50000, 100000};
     
-    // Images loading finished. Notify the main thread.
-    atomic_store(&audio_loaded, true);
+    // Only the sizes of the images are needed.
+    asset_loader -> read_sizes(BUNDLE_WORLD3);
+    WorldPack* base_pack = world_catalog -> get_pack(3);
+    if (base_pack == NULL) { return; }
     
-    return NULL;
+    for (int i = 0; i < 5; i++)
+    {
+        synthetic_world_settings settings = WorldGenerator::get_settings(base_pack, POPULATIONS[i], 1);
+        string path = directory + "Synthetic " + to_string(POPULATIONS[i]) + ".txt";
+        
+        if (WorldGenerator::write(WorldGenerator::generate(base_pack, settings), path.c_str()))
+        {
+            TraceLog(LOG_INFO, "Synthetic world: %s, %dx%d, grid %dx%d, %d species", path.c_str(), settings.width, settings.height, settings.grid_columns, settings.grid_rows, settings.species_amount);
+        }
+    }
 }
 
 
 // ----- Main Code -----
 
 
-int main()
+int main(int argc, char** argv)
 {
 	// ##### --- Initialization --- #####
 	
@@ -2425,7 +10815,8 @@ int main()
 	int SCREEN_WIDTH = 0;
 	int SCREEN_HEIGHT = 0;
 	const char* SCREEN_TITLE = "The Fish";
-	const int FPS = 30;
+	const int TICKS_PER_SECOND = 30;
+	const int RENDER_FPS = 60;
     
     // - Graphics Paths
     const char* PATH_MAIN_MENU = "resources/Textures/Menus/Main Menu/Main Menu.png";
@@ -2481,26 +10872,116 @@ int main()
     const char* PATH_MUSIC_WORLD2 = "resources/Music/World 2.mp3";
     const char* PATH_MUSIC_WORLD3 = "resources/Music/World 3.mp3";
     const char* PATH_SOUND_EAT = "resources/Music/Sounds/Eat.mp3";
-    const char* PATH_SOUND_EAT_LOWER = "resources/Music/Sounds/Eat Lower.mp3";
     const char* PATH_SOUND_STING1 = "resources/Music/Sounds/Sting 1.mp3";
-    const char* PATH_SOUND_STING1_LOWER = "resources/Music/Sounds/Sting 1 Lower.mp3";
     
     // - Other Paths
     string path_game_progress_file;
-    string path_resources_save_file = "resources/save.txt";
-    
-    if (IS_ANDROID) { path_game_progress_file = "/data/data/" + PACKAGE_NAME + "/files/save.txt"; }
-    //if (IS_ANDROID) { path_game_progress_file = "C:/The Fish/save.txt"; }
-    else { path_game_progress_file = path_resources_save_file; }
+    string path_legacy_game_progress_file;
+    string path_asset_pack;
+    string path_startup_trace;
+    string path_world_state;
+    string path_world_sources;
+    string path_world_packs;
+    string path_benchmark_results;
+    string path_benchmark_baseline;
+    string path_micro_benchmark_results;
+    string path_micro_benchmark_baseline;
+    string path_input_recording;
+    string path_frame_profile;
+    
+    if (IS_ANDROID) { path_game_progress_file = "/data/data/" + PACKAGE_NAME + "/files/save.bin"; }
+    //if (IS_ANDROID) { path_game_progress_file = "C:/The Fish/save.bin"; }
+    else { path_game_progress_file = "resources/save.bin"; }
+    
+    // The text save of the previous versions, migrated to the save record once.
+    if (IS_ANDROID) { path_legacy_game_progress_file = "/data/data/" + PACKAGE_NAME + "/files/save.txt"; }
+    else { path_legacy_game_progress_file = "resources/save.txt"; }
+    
+    // The pre-decoded textures are built on the first launch, the apk assets are read only.
+    if (IS_ANDROID) { path_asset_pack = "/data/data/" + PACKAGE_NAME + "/files/textures.pack"; }
+    else { path_asset_pack = "resources/textures.pack"; }
+    
+    // Where the startup times of the last launch are written.
+    if (IS_ANDROID) { path_startup_trace = "/data/data/" + PACKAGE_NAME + "/files/startup_trace.json"; }
+    else { path_startup_trace = "resources/startup_trace.json"; }
+    
+    // The world which was left in the middle, continued on the next launch.
+    if (IS_ANDROID) { path_world_state = "/data/data/" + PACKAGE_NAME + "/files/world.state"; }
+    else { path_world_state = "resources/world.state"; }
+    
+    // The worlds are described by text sources, compiled to packs on the first launch (and whenever a source was changed).
+    path_world_sources = "resources/Worlds/";
+    if (IS_ANDROID) { path_world_packs = "/data/data/" + PACKAGE_NAME + "/files/"; }
+    else { path_world_packs = "resources/Worlds/"; }
+    
+    // The results of the macro benchmark, and the results of a previous run to compare them with.
+    if (IS_ANDROID) { path_benchmark_results = "/data/data/" + PACKAGE_NAME + "/files/benchmark.json"; }
+    else { path_benchmark_results = "resources/benchmark.json"; }
+    if (IS_ANDROID) { path_benchmark_baseline = "/data/data/" + PACKAGE_NAME + "/files/benchmark_baseline.json"; }
+    else { path_benchmark_baseline = "resources/benchmark_baseline.json"; }
+    
+    // The results of the micro benchmark, and the results of a previous run to compare them with.
+    if (IS_ANDROID) { path_micro_benchmark_results = "/data/data/" + PACKAGE_NAME + "/files/micro_benchmark.json"; }
+    else { path_micro_benchmark_results = "resources/micro_benchmark.json"; }
+    if (IS_ANDROID) { path_micro_benchmark_baseline = "/data/data/" + PACKAGE_NAME + "/files/micro_benchmark_baseline.json"; }
+    else { path_micro_benchmark_baseline = "resources/micro_benchmark_baseline.json"; }
+    
+    // The recorded input of the last recorded run, replayed by a replay run.
+    if (IS_ANDROID) { path_input_recording = "/data/data/" + PACKAGE_NAME + "/files/input.rec"; }
+    else { path_input_recording = "resources/input.rec"; }
+    
+    // The frames measured by the frame profiler.
+    if (IS_ANDROID) { path_frame_profile = "/data/data/" + PACKAGE_NAME + "/files/frame_profile.csv"; }
+    else { path_frame_profile = "resources/frame_profile.csv"; }
     
     // - Game Properties
     const int FISH_POPULATION = 50;
+    const int BACKDROP_POPULATION = 20;
+    const int BACKDROP_STEP_TICKS = 3;
     const int GRID_ROWS = 3;
     const int GRID_COLS = 8;
     float EAT_GROW_RATIO = 0.5;
     const int X_COORD_OFFSET = 1000;
     bool debug = false;
     bool debug_camera = false;
+    bool benchmark_gif = false;
+    bool generate_synthetic_worlds = false;
+    bool benchmark_scenarios = false;
+    bool benchmark_functions = false;
+    bool record_input = false;
+    bool replay_input = false;
+    bool profile_frames = false;
+    
+    // The benchmarks are switched on from the command line (--benchmark-scenarios, --benchmark-functions), a benchmark build runs the scenarios
+    // instead of the game unless the functions are asked for (see the Makefile). --benchmark-gif measures the gif decoder instead of the game.
+    // --generate-worlds writes the synthetic worlds of the scaling benchmarks instead of playing.
+    // The input is recorded or replayed with --record-input and --replay-input, each optionally followed by the path of the recording.
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--benchmark-scenarios") == 0) { benchmark_scenarios = true; }
+        if (strcmp(argv[i], "--benchmark-functions") == 0) { benchmark_functions = true; }
+        if (strcmp(argv[i], "--benchmark-gif") == 0) { benchmark_gif = true; }
+        if (strcmp(argv[i], "--generate-worlds") == 0) { generate_synthetic_worlds = true; }
+        if (strcmp(argv[i], "--record-input") == 0) { record_input = true; }
+        if (strcmp(argv[i], "--replay-input") == 0) { replay_input = true; }
+        
+        // A path which follows an input switch is the recording.
+        if ((strcmp(argv[i], "--record-input") == 0 || strcmp(argv[i], "--replay-input") == 0) && i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+        {
+            path_input_recording = argv[i + 1];
+            i++;
+        }
+    }
+    
+    #if defined(BENCHMARK_BUILD)
+        if (!benchmark_functions) { benchmark_scenarios = true; }
+    #endif
+    
+    // If true, the ticks of a frame are simulated while the previous frame is drawn (false to measure the serial loop).
+    bool pipeline_simulation = true;
+    
+    // If true, the windows which cover the world (pause, victory, defeat, about and campain) stop the world, and are only drawn again on input (false to measure the CPU without it).
+    bool idle_rendering = true;
     
     SetTraceLogLevel(1);
     
@@ -2541,74 +11022,163 @@ int main()
       return EXIT_FAILURE;
     }
     */
+    // Run the gameplay scenarios headless (10 seconds each) and compare them with the baseline, instead of playing (no window, no audio device and no save).
+    if (benchmark_scenarios)
+    {
+        MacroBenchmark macro_benchmark(path_world_sources, path_world_packs, PATH_MY_FISH, TICKS_PER_SECOND, TICKS_PER_SECOND * 10, EAT_GROW_RATIO, X_COORD_OFFSET);
+        return macro_benchmark.run(path_benchmark_results, path_benchmark_baseline) ? 0 : 1;
+    }
+    
+    // Measure the functions which run for every fish on every tick, each on its own, and compare them with the baseline, instead of playing.
+    if (benchmark_functions)
+    {
+        MicroBenchmark micro_benchmark(path_world_sources, path_world_packs, PATH_MY_FISH, TICKS_PER_SECOND, EAT_GROW_RATIO, X_COORD_OFFSET);
+        return micro_benchmark.run(path_micro_benchmark_results, path_micro_benchmark_baseline) ? 0 : 1;
+    }
+    
+    // Measure every part of the startup, until the main menu is shown.
+    StartupTracer startup_tracer = StartupTracer(256);
+    double phase_start_time = monotonic_time();
+    
     // Load game progress data.
-    Save game_save = Save(path_game_progress_file, path_resources_save_file);
-
+    Save game_save(path_game_progress_file, path_legacy_game_progress_file);
+    startup_tracer.record("Load game progress", "phase", phase_start_time, 0);
+    
 	// ### --- GUI Initialization --- ###
 	
     // Screen set-up.
+    phase_start_time = monotonic_time();
 	InitWindow(0, 0, SCREEN_TITLE);
+    startup_tracer.record("InitWindow", "phase", phase_start_time, 0);
     
     // Audio set-up.
+    phase_start_time = monotonic_time();
     InitAudioDevice();
+    startup_tracer.record("InitAudioDevice", "phase", phase_start_time, 0);
+    
+    // The sound effects, kept compressed and decoded on 8 voices while they play.
+    SfxStore sfx_store(16, 8);
+    
+    // The sound effects mixer, up to 32 different sounds requested per frame.
+    SfxMixer sfx_mixer(&sfx_store, 32);
+    
+    // The background music player, ring buffers of two halves of 8192 frames (~0.2 seconds each) per track and a second crossfade.
+    MusicPlayer music_player(8, 8192, 1);
 	
-	// Fps declaration.
-	SetTargetFPS(FPS);
+	// Fps declaration (the game itself runs in TICKS_PER_SECOND ticks, see FrameClock).
+	SetTargetFPS(RENDER_FPS);
     
     // Save the screen size.
     SCREEN_WIDTH = GetScreenWidth();
     SCREEN_HEIGHT = GetScreenHeight();
     
-    // Defines the current screen in the main loop.
-    string current_screen = "Main Menu";
+    // Record the input of the frames, or replay the recorded input instead of the user (seeds rand() before the fish networks are created).
+    InputRecorder input_recorder(path_input_recording, replay_input ? RECORDER_REPLAY : (record_input ? RECORDER_RECORD : RECORDER_OFF), FISH_POPULATION, GRID_ROWS * GRID_COLS);
+    input_recorder.start(&game_save.world_checkpoint, SCREEN_WIDTH, SCREEN_HEIGHT);
+    
+    // Startup time is measured from here, to compare launches with and without a valid asset pack.
+    double startup_start_time = GetTime();
     
-    // The current world.
-    int current_world = 1;
+    // The world which was selected on the map, entered once its bundle is loaded (0 if none).
+    int selected_world = 0;
+    
+    // The screen the peak memory is currently measured for.
+    string memory_screen = "Loading";
     
     // # ----- Load Data ----- #
     
     // The images and audio loading process is the only heavy loading part in the game.
     // Load as thread, and display loading bar to the user.
     
-    // Declare the threads.
-    pthread_t images_thread;
-    pthread_t audio_thread;
+    // Map the pre-decoded textures of the previous launches. Compressed on android, where storage is small and slow.
+    phase_start_time = monotonic_time();
+    AssetPack asset_pack = AssetPack(path_asset_pack, 64, IS_ANDROID);
+    startup_tracer.record("Map the asset pack", "phase", phase_start_time, 0);
+    
+    // Decode on all the cores, the main thread only uploads the decoded assets.
+    phase_start_time = monotonic_time();
+    WorkerPool worker_pool = WorkerPool(WorkerPool::get_cores_amount(), 64);
+    AssetLoader asset_loader(&asset_pack, &worker_pool, &startup_tracer, &sfx_store, 64);
+    startup_tracer.record("Start the workers", "phase", phase_start_time, 0);
+    
+    // Compare the gif decoder with LoadImageAnim, instead of playing.
+    if (benchmark_gif) { benchmark_gif_decoder("resources/Textures", &worker_pool); worker_pool.quit(); CloseWindow(); return 0; }
 
     // Create the structs.
     struct images_refrences images;
     struct audio_refrences audio;
-    
-    // Save the images paths.
-    images.path_my_fish = PATH_MY_FISH;
-    images.path_fish1 = PATH_FISH1;
-    images.path_fish2 = PATH_FISH2;
-    images.path_fish3 = PATH_FISH3;
-    images.path_fish4 = PATH_FISH4;
-    images.path_fish5 = PATH_FISH5;
-    images.path_fish6 = PATH_FISH6;
-    images.path_fish7 = PATH_FISH7;
-    images.path_fish8 = PATH_FISH8;
-    images.path_fish9 = PATH_FISH9;
-    images.path_fish10 = PATH_FISH10;
-    images.path_fish11 = PATH_FISH11;
-    images.path_crab1 = PATH_CRAB1;
-    images.path_crab2 = PATH_CRAB2;
-    images.path_jelly_fish1 = PATH_JEFLLY_FISH1;
-    images.path_jelly_fish2 = PATH_JEFLLY_FISH2;
-    
-    // Save the audio paths.
-    audio.path_music_main_theme = PATH_MUSIC_MAIN_THEME;
-    audio.path_music_world1 = PATH_MUSIC_WORLD1;
-    audio.path_music_world2 = PATH_MUSIC_WORLD2;
-    audio.path_music_world3 = PATH_MUSIC_WORLD3;
-    audio.path_sound_eat = PATH_SOUND_EAT;
-    audio.path_sound_eat_lower = PATH_SOUND_EAT_LOWER;
-    audio.path_sound_sting1 = PATH_SOUND_STING1;
-    audio.path_sound_sting1_lower = PATH_SOUND_STING1_LOWER;
-    
-    // Start the threads.
-    if (pthread_create(&images_thread, NULL, &load_images_thread, (void *)&images) != 0) {TraceLog(LOG_ERROR, "Error creating loading images thread"); CloseWindow(); return 0;}
-    if (pthread_create(&audio_thread, NULL, &load_audio_thread, (void *)&audio) != 0) {TraceLog(LOG_ERROR, "Error creating loading audio thread"); CloseWindow(); return 0;}
+    struct textures_refrences textures;
+    
+    // Add the animations.
+    asset_loader.add_animation(PATH_MY_FISH, &images.my_fish_image, &images.my_fish_image_frames_amount, BUNDLE_CORE);
+    asset_loader.add_animation(PATH_FISH1, &images.fish1_image, &images.fish1_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_FISH2, &images.fish2_image, &images.fish2_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_FISH3, &images.fish3_image, &images.fish3_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_FISH4, &images.fish4_image, &images.fish4_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2 | BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_FISH5, &images.fish5_image, &images.fish5_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_FISH6, &images.fish6_image, &images.fish6_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2 | BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_FISH7, &images.fish7_image, &images.fish7_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_FISH8, &images.fish8_image, &images.fish8_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2 | BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_FISH9, &images.fish9_image, &images.fish9_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_FISH10, &images.fish10_image, &images.fish10_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2 | BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_FISH11, &images.fish11_image, &images.fish11_image_frames_amount, BUNDLE_WORLD1 | BUNDLE_WORLD2);
+    asset_loader.add_animation(PATH_CRAB1, &images.crab1_image, &images.crab1_image_frames_amount, BUNDLE_WORLD2 | BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_CRAB2, &images.crab2_image, &images.crab2_image_frames_amount, BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_JEFLLY_FISH1, &images.jelly_fish1_image, &images.jeflly_fish1_image_frames_amount, BUNDLE_WORLD3);
+    asset_loader.add_animation(PATH_JEFLLY_FISH2, &images.jelly_fish2_image, &images.jeflly_fish2_image_frames_amount, BUNDLE_WORLD3);
+    
+    // Add the textures.
+    asset_loader.add_texture(PATH_MAIN_MENU, &textures.main_menu, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_CAMPAIN_BUTTON, &textures.campain_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_ABOUT_BUTTON, &textures.about_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_ABOUT_WINDOW, &textures.about_window, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_CLOSE_BUTTON, &textures.about_close_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME1, &textures.campain_welcome_window1, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME2, &textures.campain_welcome_window2, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME3, &textures.campain_welcome_window3, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME4, &textures.campain_welcome_window4, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME5, &textures.campain_welcome_window5, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME6, &textures.campain_welcome_window6, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_CAMPAIN_WELCOME7, &textures.campain_welcome_window7, BUNDLE_CAMPAIN_INTRO);
+    asset_loader.add_texture(PATH_MAP, &textures.map, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_WORLD1_BUTTON, &textures.world1_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_WORLD2_BUTTON, &textures.world2_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_WORLD3_BUTTON, &textures.world3_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_VICTORY, &textures.victory, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_DEFEAT, &textures.defeat, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_MAP_BUTTON, &textures.back_to_map_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_EXIT_WELCOME_WINDOW_BUTTON, &textures.exit_welcome_window_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_PAUSE_WINDOW, &textures.pause_window, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_RESUME_BUTTON, &textures.resume_game_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_PAUSE_BUTTON, &textures.pause_button, BUNDLE_CORE);
+    asset_loader.add_texture(PATH_WORLD1, &textures.world1, BUNDLE_WORLD1);
+    asset_loader.add_texture(PATH_WORLD1_WELCOME_WINDOW, &textures.world1_welcome_window, BUNDLE_WORLD1);
+    asset_loader.add_texture(PATH_WORLD2, &textures.world2, BUNDLE_WORLD2);
+    asset_loader.add_texture(PATH_WORLD2_WELCOME_WINDOW, &textures.world2_welcome_window, BUNDLE_WORLD2);
+    asset_loader.add_texture(PATH_WORLD3, &textures.world3, BUNDLE_WORLD3);
+    asset_loader.add_texture(PATH_WORLD3_WELCOME_WINDOW, &textures.world3_welcome_window, BUNDLE_WORLD3);
+    
+    // Add the sounds.
+    asset_loader.add_sound(PATH_SOUND_EAT, &audio.sound_eat, BUNDLE_CORE);
+    asset_loader.add_sound(PATH_SOUND_STING1, &audio.sound_sting1, BUNDLE_CORE);
+    
+    // The music is streamed, a track is opened when it is first played.
+    audio.music_main_theme = music_player.add_track(PATH_MUSIC_MAIN_THEME);
+    audio.music_world1 = music_player.add_track(PATH_MUSIC_WORLD1);
+    audio.music_world2 = music_player.add_track(PATH_MUSIC_WORLD2);
+    audio.music_world3 = music_player.add_track(PATH_MUSIC_WORLD3);
+    
+    // The scenes, with the bundles they need and their music (in the order of Scene).
+    scene_profile scene_profiles[] = {
+        {"Main Menu", BUNDLE_CORE | BUNDLE_WORLD1, audio.music_main_theme},
+        {"Map", BUNDLE_CORE | BUNDLE_WORLD1, audio.music_main_theme},
+        {"World 1", BUNDLE_CORE | BUNDLE_WORLD1, audio.music_world1},
+        {"World 2", BUNDLE_CORE | BUNDLE_WORLD2, audio.music_world2},
+        {"World 3", BUNDLE_CORE | BUNDLE_WORLD3, audio.music_world3}};
+    
+    // Start decoding what the main menu needs, the rest is loaded when needed (world 1 is the background of the menus, it is never unloaded).
+    phase_start_time = monotonic_time();
+    SceneMachine scene_machine = SceneMachine(&asset_loader, &music_player, scene_profiles, BUNDLE_CORE | BUNDLE_WORLD1, SCENE_MAIN_MENU);
     
     // If remains true after the loop, the user tries to exit.
     bool is_user_exit = true;
@@ -2616,8 +11186,11 @@ int main()
     // Keep iterating until data loaded.
     while (!WindowShouldClose())
     {
-        // All the images were loaded.
-        if (atomic_load(&images_loaded) && atomic_load(&audio_loaded)) { is_user_exit = false; break; }
+        // Upload what was decoded since the last frame.
+        asset_loader.process_completed();
+        
+        // All the assets were loaded.
+        if (asset_loader.is_loaded(BUNDLE_CORE | BUNDLE_WORLD1)) { is_user_exit = false; break; }
         
         // Draw the progress bar.
         BeginDrawing();
@@ -2626,7 +11199,7 @@ int main()
 
             DrawRectangle((int) floor(SCREEN_WIDTH / 2) - 250, (int) floor(SCREEN_HEIGHT / 2) - 30, 500, 60, WHITE);
 
-            DrawRectangle((int) floor(SCREEN_WIDTH / 2) - 250, (int) floor(SCREEN_HEIGHT / 2) - 30, (int) floor(data_progress * (500 / (images.count + audio.count))), 60, DARKGRAY);
+            DrawRectangle((int) floor(SCREEN_WIDTH / 2) - 250, (int) floor(SCREEN_HEIGHT / 2) - 30, (int) floor(asset_loader.get_progress() * 500), 60, DARKGRAY);
             
             DrawText("Loading...", (int) floor(SCREEN_WIDTH / 2) - 70, (int) floor(SCREEN_HEIGHT / 2) - 20, 40, BLACK);
 
@@ -2636,6 +11209,14 @@ int main()
     // The user tried to exit.
     if (is_user_exit) { CloseWindow(); return 0; }
     
+    startup_tracer.record("Loading screen (core and world 1)", "phase", phase_start_time, 0);
+    
+    // Log the memory and the quality of the sound effects.
+    sfx_store.report();
+    
+    // A new player starts with the campain intro, load it in the background.
+    if (game_save.world_checkpoint == 1) { scene_machine.acquire(BUNDLE_CAMPAIN_INTRO); }
+    
     // Tell the user we are about to finish loading.
     else
     {
@@ -2644,7 +11225,7 @@ int main()
 
             ClearBackground(SKYBLUE);
 
-            DrawRectangle((int) floor(SCREEN_WIDTH / 2) - 250, (int) floor(SCREEN_HEIGHT / 2) - 30, (int) floor(data_progress * (500 / (images.count + audio.count))), 60, DARKGRAY);
+            DrawRectangle((int) floor(SCREEN_WIDTH / 2) - 250, (int) floor(SCREEN_HEIGHT / 2) - 30, (int) floor(asset_loader.get_progress() * 500), 60, DARKGRAY);
             
             DrawText("Let's Go!", (int) floor(SCREEN_WIDTH / 2) - 100, (int) floor(SCREEN_HEIGHT / 2) - 20, 40, WHITE);
 
@@ -2654,58 +11235,45 @@ int main()
     // # ----- Variables -----
     
     bool pause = false;
-	Texture2D world;
-    MyFish my_fish;
-    FishNetwork fish_network;
-    Grid grid;
-    Camera2D camera;
-    int camera_pos_x = 0, camera_pos_y = 0;
-    int current_cell_entities_amount;
-    Cell*** grid_cells;
-	int my_fish_current_width, my_fish_current_height;
-    int camera_current_height = 0, camera_current_width = 0;
     bool is_world_welcome_window = false;
     Texture2D current_world_welcome_window;
-    int current_gesture = GESTURE_NONE;
     Location current_touch_location;
     Location first_touch_location, second_touch_location, previous_second_touch_location;
-    Location destination;
-    bool is_camera_dispatch_x = false, is_camera_dispatch_y = false, is_camera_dispatch_x_left = false, is_camera_dispatch_x_right = false, is_camera_dispatch_y_top = false, is_camera_dispatch_y_bottom = false;
     
     // # ----- Main Menu ----- #
     
     // Load the main menu texture.
-    Texture2D main_menu = LoadTexture(PATH_MAIN_MENU);
+    Texture2D& main_menu = textures.main_menu;
     
     // Load the campain button.
-    Texture2D campain_button = LoadTexture(PATH_CAMPAIN_BUTTON); 
+    Texture2D& campain_button = textures.campain_button; 
     
     // Define frame rectangle for drawing.
     Rectangle campain_button_frame = { (float) floor (SCREEN_WIDTH / 2 - campain_button.width / 2), (float) floor(SCREEN_HEIGHT / 2 - main_menu.height / 2) + 400, (float) campain_button.width, (float) campain_button.height };
     
     // Load the about button.
-    Texture2D about_button = LoadTexture(PATH_ABOUT_BUTTON);
+    Texture2D& about_button = textures.about_button;
     
     // Define frame rectangle for drawing.
     Rectangle about_button_frame = { (float) floor (SCREEN_WIDTH / 2 - about_button.width / 2), (float) floor(SCREEN_HEIGHT / 2 - about_button.height / 2) + 100, (float) about_button.width, (float) about_button.height };
     
     // Load the main menu texture.
-    Texture2D about_window = LoadTexture(PATH_ABOUT_WINDOW);
+    Texture2D& about_window = textures.about_window;
     
     // Load the campain button.
-    Texture2D about_close_button = LoadTexture(PATH_CLOSE_BUTTON); 
+    Texture2D& about_close_button = textures.about_close_button; 
     
     // Define frame rectangle for drawing.
     Rectangle about_close_button_frame = { (float) floor (SCREEN_WIDTH / 2 + about_window.width / 2 - about_close_button.width / 2 - 80), (float) floor(SCREEN_HEIGHT / 2 - about_window.height / 2 + about_close_button.height / 2 + 25), (float) about_close_button.width, (float) about_close_button.height };
     
     // Load the campain welcome window.
-    Texture2D campain_welcome_window1 = LoadTexture(PATH_CAMPAIN_WELCOME1);
-    Texture2D campain_welcome_window2 = LoadTexture(PATH_CAMPAIN_WELCOME2);
-    Texture2D campain_welcome_window3 = LoadTexture(PATH_CAMPAIN_WELCOME3);
-    Texture2D campain_welcome_window4 = LoadTexture(PATH_CAMPAIN_WELCOME4);
-    Texture2D campain_welcome_window5 = LoadTexture(PATH_CAMPAIN_WELCOME5);
-    Texture2D campain_welcome_window6 = LoadTexture(PATH_CAMPAIN_WELCOME6);
-    Texture2D campain_welcome_window7 = LoadTexture(PATH_CAMPAIN_WELCOME7);
+    Texture2D& campain_welcome_window1 = textures.campain_welcome_window1;
+    Texture2D& campain_welcome_window2 = textures.campain_welcome_window2;
+    Texture2D& campain_welcome_window3 = textures.campain_welcome_window3;
+    Texture2D& campain_welcome_window4 = textures.campain_welcome_window4;
+    Texture2D& campain_welcome_window5 = textures.campain_welcome_window5;
+    Texture2D& campain_welcome_window6 = textures.campain_welcome_window6;
+    Texture2D& campain_welcome_window7 = textures.campain_welcome_window7;
     
     // If true, show the campain welcome window.
     bool is_campain_welcome_window = false;
@@ -2713,795 +11281,279 @@ int main()
     // If true, show the about window.
     bool is_about_window = false;
     
-    // The current campain window.
-    int current_campain_welcome_window = 1;
-    
-    // The current mouse point location.
-    Vector2 mouse_point = { 0, 0 };
-    
-    // # ----- Map ----- #
-    
-    // Load the map texture.
-    Texture2D map = LoadTexture(PATH_MAP);
-    
-    // Load the worlds buttons.
-    Texture2D world1_button = LoadTexture(PATH_WORLD1_BUTTON);
-    Texture2D world2_button = LoadTexture(PATH_WORLD2_BUTTON);
-    Texture2D world3_button = LoadTexture(PATH_WORLD3_BUTTON);
-    
-    // Define frame rectangle for drawing.
-    Rectangle world1_button_frame = { 100, 100, (float) world1_button.width, (float) world1_button.height };
-    Rectangle world2_button_frame = { 300, 250, (float) world2_button.width, (float) world2_button.height };
-    Rectangle world3_button_frame = { 500, 400, (float) world3_button.width, (float) world3_button.height };
-    
-    // # ----- Windows ----- #
-    
-    // The victory window.
-    Texture2D victory = LoadTexture(PATH_VICTORY);
-    
-    // The defeat window.
-    Texture2D defeat = LoadTexture(PATH_DEFEAT);
-    
-    // The back to map button.
-    Texture2D back_to_map_button = LoadTexture(PATH_MAP_BUTTON);
-    
-    // The frame of the back to map button.
-    Rectangle back_to_map_button_frame = {(float) floor(SCREEN_WIDTH / 2 - back_to_map_button.width / 2), (float) floor(SCREEN_HEIGHT / 2) + 250, (float) back_to_map_button.width, (float) back_to_map_button.height};
-    
-    // True if victory/defeat.
-    bool is_victory = false, is_defeat = false;
-    
-    // Load the exit_welcome_window button.
-    Texture2D exit_welcome_window_button = LoadTexture(PATH_EXIT_WELCOME_WINDOW_BUTTON); 
-    
-    // Define frame rectangle for drawing.
-    Rectangle exit_welcome_window_button_frame = { (float) floor (SCREEN_WIDTH / 2 - exit_welcome_window_button.width / 2), (float) floor(SCREEN_HEIGHT / 2) + 300, (float) exit_welcome_window_button.width, (float) exit_welcome_window_button.height };
-    
-    // The pause window.
-    Texture2D pause_window = LoadTexture(PATH_PAUSE_WINDOW);
-    
-    // The back to map button.
-    Texture2D resume_game_button = LoadTexture(PATH_RESUME_BUTTON);
-    
-    // The frame of the resume button.
-    Rectangle resume_button_frame = {(float) floor(SCREEN_WIDTH / 2 - resume_game_button.width / 2), (float) floor(SCREEN_HEIGHT / 2) + 250, (float) resume_game_button.width, (float) resume_game_button.height};
-    
-    // The pause button.
-    Texture2D pause_button = LoadTexture(PATH_PAUSE_BUTTON);
-    
-    // The frame of the resume button.
-    Rectangle pause_button_frame = {(float) (20), (float) (25), (float) pause_button.width, (float) pause_button.height};
-    
-    // Define the turbo button.
-    //Texture2D turbo_button = LoadTexture(PATH_TURBO_BUTTON);
-    //Rectangle turbo_button_frame = { (float) SCREEN_WIDTH - turbo_button.width - 15, (float) floor( SCREEN_HEIGHT - turbo_button.height) - 30, (float) turbo_button.width, (float) turbo_button.height };
-    
-    // # ----- World 1 ----- #
-    
-    // Load Textures.
-    Texture2D world1 = LoadTexture(PATH_WORLD1);
-    
-    // Load the welcome window.
-    Texture2D world1_welcome_window = LoadTexture(PATH_WORLD1_WELCOME_WINDOW);
-    
-    // Create the grid.
-    Grid world1_grid = Grid(GRID_COLS, GRID_ROWS, FISH_POPULATION, world1.width, world1.height);
-
-    // ----- Create Entities -----
-    
-    // --- my fish ---
-    
-    Cell** world1_cells_within_my_fish = new Cell*[GRID_ROWS * GRID_COLS];
-    frame world1_my_fish_collision_frame = {-54, -4, 549, 439};
-    MyFish world1_my_fish = MyFish(FPS, images.my_fish_image, &images.my_fish_image_frames_amount, world1_my_fish_collision_frame, false, Location(world1.width / 2, world1.height / 2), Size(150, 107), 23, 23, 0, 0, 0, 0, 1, 15, EAT_GROW_RATIO, 1.2, 10000, 0, true, FISH_POPULATION, world1_cells_within_my_fish, Location(100, SCREEN_HEIGHT - 75), Size(150, 20), 1, 2, FPS * 2, FPS * 5, Location(350, SCREEN_HEIGHT - 75), Size(150, 20), 1, audio.sound_eat, audio.sound_sting1);
-
-    // --- Fish Network ---
-   
-    // -- Fish Profiles --
-    
-    // - Fish 1 -
-    
-    // Right.
-    fish_path world1_fish1_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish1_wander_right_paths[] = {world1_fish1_path_wander_right};
-    paths_stack world1_fish1_paths_stack_wander_right = {Location(), 0, 1, world1_fish1_wander_right_paths, false, false, false, false, true};
-    
-    // Left.
-    fish_path world1_fish1_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish1_wander_left_paths[] = {world1_fish1_path_wander_left};
-    paths_stack world1_fish1_paths_stack_wander_left = {Location(), 0, 1, world1_fish1_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish1_paths_stacks[] = {world1_fish1_paths_stack_wander_right, world1_fish1_paths_stack_wander_left};
-    frame world1_fish1_collision_frame = {0, 0, 641, 362};
-    fish_profile world1_fish1 = {images.fish1_image, &images.fish1_image_frames_amount, "fish 1", world1_fish1_collision_frame, false, true, Size(130, 73), 1.5, 4, 20, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish1_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-    
-    // - Fish 2 -
-    
-    // Right
-    fish_path world1_fish2_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish2_wander_right_paths[] = {world1_fish2_path_wander_right};
-    paths_stack world1_fish2_paths_stack_wander_right = {Location(), 0, 1, world1_fish2_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish2_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish2_wander_left_paths[] = {world1_fish2_path_wander_left};
-    paths_stack world1_fish2_paths_stack_wander_left = {Location(), 0, 1, world1_fish2_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish2_paths_stacks[] = {world1_fish2_paths_stack_wander_right, world1_fish2_paths_stack_wander_left};
-    frame world1_fish2_collision_frame = {0, 17, 640, 404};
-    fish_profile world1_fish2 = {images.fish2_image, &images.fish2_image_frames_amount, "fish 2", world1_fish2_collision_frame, false, false, Size(130, 112), 1.75, 6, 15, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish2_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.6};
-    
-    // - Fish 3 -
-    
-    // Right
-    fish_path world1_fish3_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish3_wander_right_paths[] = {world1_fish3_path_wander_right};
-    paths_stack world1_fish3_paths_stack_wander_right = {Location(), 0, 1, world1_fish3_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish3_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish3_wander_left_paths[] = {world1_fish3_path_wander_left};
-    paths_stack world1_fish3_paths_stack_wander_left = {Location(), 0, 1, world1_fish3_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish3_paths_stacks[] = {world1_fish3_paths_stack_wander_right, world1_fish3_paths_stack_wander_left};
-    frame world1_fish3_collision_frame = {-62, 16, 516, 430};
-    fish_profile world1_fish3 = {images.fish3_image, &images.fish3_image_frames_amount, "fish 3", world1_fish3_collision_frame, false, true, Size(170, 150), 3, 3, 10, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish3_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-    
-    // - Fish 4 -
-    
-    // Right
-    fish_path world1_fish4_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish4_wander_right_paths[] = {world1_fish4_path_wander_right};
-    paths_stack world1_fish4_paths_stack_wander_right = {Location(), 0, 1, world1_fish4_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish4_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish4_wander_left_paths[] = {world1_fish4_path_wander_left};
-    paths_stack world1_fish4_paths_stack_wander_left = {Location(), 0, 1, world1_fish4_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish4_paths_stacks[] = {world1_fish4_paths_stack_wander_right, world1_fish4_paths_stack_wander_left};
-    frame world1_fish4_collision_frame = {0, 0, 616, 686};
-    fish_profile world1_fish4 = {images.fish4_image, &images.fish4_image_frames_amount, "fish 4", world1_fish4_collision_frame, true, true, Size(90, 100), 1.2, 15, 35, 0, 3, 30, 300, 1.2, 2, true, 2, world1_fish4_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1.5};
-    
-    // - Fish 5 -
-    
-    // Right
-    fish_path world1_fish5_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish5_wander_right_paths[] = {world1_fish5_path_wander_right};
-    paths_stack world1_fish5_paths_stack_wander_right = {Location(), 0, 1, world1_fish5_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish5_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish5_wander_left_paths[] = {world1_fish5_path_wander_left};
-    paths_stack world1_fish5_paths_stack_wander_left = {Location(), 0, 1, world1_fish5_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish5_paths_stacks[] = {world1_fish5_paths_stack_wander_right, world1_fish5_paths_stack_wander_left};
-    frame world1_fish5_collision_frame = {-49, 4, 542, 356};
-    fish_profile world1_fish5 = {images.fish5_image, &images.fish5_image_frames_amount, "fish 5", world1_fish5_collision_frame, false, true, Size(130, 94), 1.5, 6, 18, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish5_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.1};
-    
-    // - Fish 6 -
-    
-    // Right
-    fish_path world1_fish6_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish6_wander_right_paths[] = {world1_fish6_path_wander_right};
-    paths_stack world1_fish6_paths_stack_wander_right = {Location(), 0, 1, world1_fish6_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish6_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish6_wander_left_paths[] = {world1_fish6_path_wander_left};
-    paths_stack world1_fish6_paths_stack_wander_left = {Location(), 0, 1, world1_fish6_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish6_paths_stacks[] = {world1_fish6_paths_stack_wander_right, world1_fish6_paths_stack_wander_left};
-    frame world1_fish6_collision_frame = {22, -4, 467, 431};
-    fish_profile world1_fish6 = {images.fish6_image, &images.fish6_image_frames_amount, "fish 6", world1_fish6_collision_frame, true, false, Size(150, 122), 1.75, 6, 18, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish6_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.1};
-    
-    // - Fish 7 -
-    
-    // Right
-    fish_path world1_fish7_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish7_wander_right_paths[] = {world1_fish7_path_wander_right};
-    paths_stack world1_fish7_paths_stack_wander_right = {Location(), 0, 1, world1_fish7_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish7_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish7_wander_left_paths[] = {world1_fish7_path_wander_left};
-    paths_stack world1_fish7_paths_stack_wander_left = {Location(), 0, 1, world1_fish7_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish7_paths_stacks[] = {world1_fish7_paths_stack_wander_right, world1_fish7_paths_stack_wander_left};
-    frame world1_fish7_collision_frame = {-43, -20, 546, 375};
-    fish_profile world1_fish7 = {images.fish7_image, &images.fish7_image_frames_amount, "fish 7", world1_fish7_collision_frame, false, true, Size(250, 202), 1.75, 4, 10, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish7_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.1};
-    
-    // - Fish 8 -
-    
-    // Right
-    fish_path world1_fish8_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish8_wander_right_paths[] = {world1_fish8_path_wander_right};
-    paths_stack world1_fish8_paths_stack_wander_right = {Location(), 0, 1, world1_fish8_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish8_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish8_wander_left_paths[] = {world1_fish8_path_wander_left};
-    paths_stack world1_fish8_paths_stack_wander_left = {Location(), 0, 1, world1_fish8_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish8_paths_stacks[] = {world1_fish8_paths_stack_wander_right, world1_fish8_paths_stack_wander_left};
-    frame world1_fish8_collision_frame = {0, 0, 640, 576};
-    fish_profile world1_fish8 = {images.fish8_image, &images.fish8_image_frames_amount, "fish 8", world1_fish8_collision_frame, true, true, Size(90, 81), 1.2, 15, 35, 0, 3, 30, 300, 1.2, 2, true, 2, world1_fish8_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1.5};
-    
-    // - Fish 9 -
-    
-    // Right
-    fish_path world1_fish9_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish9_wander_right_paths[] = {world1_fish9_path_wander_right};
-    paths_stack world1_fish9_paths_stack_wander_right = {Location(), 0, 1, world1_fish9_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish9_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish9_wander_left_paths[] = {world1_fish9_path_wander_left};
-    paths_stack world1_fish9_paths_stack_wander_left = {Location(), 0, 1, world1_fish9_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish9_paths_stacks[] = {world1_fish9_paths_stack_wander_right, world1_fish9_paths_stack_wander_left};
-    frame world1_fish9_collision_frame = {0, 0, 658, 540};
-    fish_profile world1_fish9 = {images.fish9_image, &images.fish9_image_frames_amount, "fish 9", world1_fish9_collision_frame, false, true, Size(150, 123), 3, 6, 13, 0, 2, 30, 300, 1.2, 2, true, 2, world1_fish9_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.2};
-    
-    // - Fish 10 -
-    
-    // Right
-    fish_path world1_fish10_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish10_wander_right_paths[] = {world1_fish10_path_wander_right};
-    paths_stack world1_fish10_paths_stack_wander_right = {Location(), 0, 1, world1_fish10_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish10_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish10_wander_left_paths[] = {world1_fish10_path_wander_left};
-    paths_stack world1_fish10_paths_stack_wander_left = {Location(), 0, 1, world1_fish10_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish10_paths_stacks[] = {world1_fish10_paths_stack_wander_right, world1_fish10_paths_stack_wander_left};
-    frame world1_fish10_collision_frame = {16, 13, 396, 375};
-    fish_profile world1_fish10 = {images.fish10_image, &images.fish10_image_frames_amount, "fish 10", world1_fish10_collision_frame, true, false, Size(300, 287), 2, 1, 6, 0, 2, 30, 300, 1.2, 2, false, 2, world1_fish10_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.05};
-    
-    // - Fish 11 -
-    
-    // Right
-    fish_path world1_fish11_path_wander_right = {10, 0, true, true, 100};
-    fish_path world1_fish11_wander_right_paths[] = {world1_fish11_path_wander_right};
-    paths_stack world1_fish11_paths_stack_wander_right = {Location(), 0, 1, world1_fish11_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world1_fish11_path_wander_left = {10, 0, false, true, 100};
-    fish_path world1_fish11_wander_left_paths[] = {world1_fish11_path_wander_left};
-    paths_stack world1_fish11_paths_stack_wander_left = {Location(), 0, 1, world1_fish11_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world1_fish11_paths_stacks[] = {world1_fish11_paths_stack_wander_right, world1_fish11_paths_stack_wander_left};
-    frame world1_fish11_collision_frame = {-56, 59, 413, 341};
-    fish_profile world1_fish11 = {images.fish11_image, &images.fish11_image_frames_amount, "fish 11", world1_fish11_collision_frame, false, true, Size(300, 255), 2, 1, 6, 0, 2, 30, 300, 1.2, 2, false, 2, world1_fish11_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.05};
-    
-    // -- Setup --
-    
-    fish_profile world1_fish_profiles_on_startup[] = {};
-    fish_profile world1_available_fish[] = {world1_fish1, world1_fish2, world1_fish3, world1_fish4, world1_fish5, world1_fish6, world1_fish7, world1_fish8, world1_fish9, world1_fish10, world1_fish11};
-    FishNetwork world1_fish_network = FishNetwork(FPS, FISH_POPULATION, EAT_GROW_RATIO, &world1_grid, world1_fish_profiles_on_startup, 0, world1_available_fish, 11, X_COORD_OFFSET, world1_my_fish.get_updated_rectangular_frame_triple_size());
-    world1_fish_network.update_boundaries(-X_COORD_OFFSET, world1.width + X_COORD_OFFSET, 0, world1.height, true);
-
-    // ----- Final Set-ups World1 -----
-
-    // Create and set-up the camera.
-    Camera2D world1_camera = { 0 };
-    world1_camera.target = (Vector2) { (float) world1_my_fish.get_location().x, (float) world1_my_fish.get_location().y };
-    world1_camera.offset = (Vector2) { (float) SCREEN_WIDTH / 2, (float) SCREEN_HEIGHT / 2 };
-    world1_camera.rotation = 0;
-    
-    if (debug_camera) { world1_camera.zoom = 0.15; }
-    else { world1_camera.zoom = 0.7; }
-    
-    // # ----- World 2 ----- #
-    
-    // Load Textures.
-    Texture2D world2 = LoadTexture(PATH_WORLD2);
-    
-    // Load the welcome window.
-    Texture2D world2_welcome_window = LoadTexture(PATH_WORLD2_WELCOME_WINDOW);
-    
-    // Create the grid.
-    Grid world2_grid = Grid(GRID_COLS, GRID_ROWS, FISH_POPULATION, world2.width, world2.height);
-
-    // ----- Create Entities -----
-    
-    // --- my fish ---
-    
-    Cell** world2_cells_within_my_fish = new Cell*[GRID_ROWS * GRID_COLS];
-    frame world2_my_fish_collision_frame = {-54, -4, 549, 439};
-    MyFish world2_my_fish = MyFish(FPS, images.my_fish_image, &images.my_fish_image_frames_amount, world2_my_fish_collision_frame, false, Location(world2.width / 2, world2.height / 2), Size(150, 107), 23, 23, 0, 0, 0, 0, 1, 15, EAT_GROW_RATIO, 1.2, 10000, 0, true, FISH_POPULATION, world2_cells_within_my_fish, Location(100, SCREEN_HEIGHT - 75), Size(150, 20), 1, 2, FPS * 2, FPS * 5, Location(350, SCREEN_HEIGHT - 75), Size(150, 20), 1, audio.sound_eat, audio.sound_sting1);
-
-    // --- Fish Network ---
-   
-    // -- Fish Profiles --
-    
-    // - Fish 1 -
-    
-    // Right.
-    fish_path world2_fish1_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish1_wander_right_paths[] = {world2_fish1_path_wander_right};
-    paths_stack world2_fish1_paths_stack_wander_right = {Location(), 0, 1, world2_fish1_wander_right_paths, false, false, false, false, true};
-    
-    // Left.
-    fish_path world2_fish1_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish1_wander_left_paths[] = {world2_fish1_path_wander_left};
-    paths_stack world2_fish1_paths_stack_wander_left = {Location(), 0, 1, world2_fish1_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish1_paths_stacks[] = {world2_fish1_paths_stack_wander_right, world2_fish1_paths_stack_wander_left};
-    frame world2_fish1_collision_frame = {0, 0, 641, 362};
-    fish_profile world2_fish1 = {images.fish1_image, &images.fish1_image_frames_amount, "fish 1", world2_fish1_collision_frame, false, true, Size(130, 73), 1.5, 4, 20, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish1_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.8};
-    
-    // - Fish 2 -
-    
-    // Right
-    fish_path world2_fish2_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish2_wander_right_paths[] = {world2_fish2_path_wander_right};
-    paths_stack world2_fish2_paths_stack_wander_right = {Location(), 0, 1, world2_fish2_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish2_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish2_wander_left_paths[] = {world2_fish2_path_wander_left};
-    paths_stack world2_fish2_paths_stack_wander_left = {Location(), 0, 1, world2_fish2_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish2_paths_stacks[] = {world2_fish2_paths_stack_wander_right, world2_fish2_paths_stack_wander_left};
-    frame world2_fish2_collision_frame = {0, 17, 640, 404};
-    fish_profile world2_fish2 = {images.fish2_image, &images.fish2_image_frames_amount, "fish 2", world2_fish2_collision_frame, false, false, Size(130, 112), 1.75, 6, 15, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish2_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.8};
-    
-    // - Fish 3 -
-    
-    // Right
-    fish_path world2_fish3_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish3_wander_right_paths[] = {world2_fish3_path_wander_right};
-    paths_stack world2_fish3_paths_stack_wander_right = {Location(), 0, 1, world2_fish3_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish3_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish3_wander_left_paths[] = {world2_fish3_path_wander_left};
-    paths_stack world2_fish3_paths_stack_wander_left = {Location(), 0, 1, world2_fish3_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish3_paths_stacks[] = {world2_fish3_paths_stack_wander_right, world2_fish3_paths_stack_wander_left};
-    frame world2_fish3_collision_frame = {-62, 16, 516, 430};
-    fish_profile world2_fish3 = {images.fish3_image, &images.fish3_image_frames_amount, "fish 3", world2_fish3_collision_frame, false, true, Size(170, 150), 3, 3, 10, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish3_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-    
-    // - Fish 4 -
-    
-    // Right
-    fish_path world2_fish4_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish4_wander_right_paths[] = {world2_fish4_path_wander_right};
-    paths_stack world2_fish4_paths_stack_wander_right = {Location(), 0, 1, world2_fish4_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish4_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish4_wander_left_paths[] = {world2_fish4_path_wander_left};
-    paths_stack world2_fish4_paths_stack_wander_left = {Location(), 0, 1, world2_fish4_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish4_paths_stacks[] = {world2_fish4_paths_stack_wander_right, world2_fish4_paths_stack_wander_left};
-    frame world2_fish4_collision_frame = {0, 0, 616, 686};
-    fish_profile world2_fish4 = {images.fish4_image, &images.fish4_image_frames_amount, "fish 4", world2_fish4_collision_frame, true, true, Size(90, 100), 1.2, 15, 35, 0, 3, 30, 300, 1.2, 2, true, 2, world2_fish4_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-    
-    // - Fish 5 -
-    
-    // Right
-    fish_path world2_fish5_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish5_wander_right_paths[] = {world2_fish5_path_wander_right};
-    paths_stack world2_fish5_paths_stack_wander_right = {Location(), 0, 1, world2_fish5_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish5_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish5_wander_left_paths[] = {world2_fish5_path_wander_left};
-    paths_stack world2_fish5_paths_stack_wander_left = {Location(), 0, 1, world2_fish5_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish5_paths_stacks[] = {world2_fish5_paths_stack_wander_right, world2_fish5_paths_stack_wander_left};
-    frame world2_fish5_collision_frame = {-49, 4, 542, 356};
-    fish_profile world2_fish5 = {images.fish5_image, &images.fish5_image_frames_amount, "fish 5", world2_fish5_collision_frame, false, true, Size(130, 94), 1.5, 6, 18, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish5_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.8};
-    
-    // - Fish 6 -
-    
-    // Right
-    fish_path world2_fish6_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish6_wander_right_paths[] = {world2_fish6_path_wander_right};
-    paths_stack world2_fish6_paths_stack_wander_right = {Location(), 0, 1, world2_fish6_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish6_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish6_wander_left_paths[] = {world2_fish6_path_wander_left};
-    paths_stack world2_fish6_paths_stack_wander_left = {Location(), 0, 1, world2_fish6_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish6_paths_stacks[] = {world2_fish6_paths_stack_wander_right, world2_fish6_paths_stack_wander_left};
-    frame world2_fish6_collision_frame = {22, -4, 467, 431};
-    fish_profile world2_fish6 = {images.fish6_image, &images.fish6_image_frames_amount, "fish 6", world2_fish6_collision_frame, true, false, Size(150, 122), 1.75, 6, 18, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish6_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.6};
-    
-    // - Fish 7 -
-    
-    // Right
-    fish_path world2_fish7_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish7_wander_right_paths[] = {world2_fish7_path_wander_right};
-    paths_stack world2_fish7_paths_stack_wander_right = {Location(), 0, 1, world2_fish7_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish7_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish7_wander_left_paths[] = {world2_fish7_path_wander_left};
-    paths_stack world2_fish7_paths_stack_wander_left = {Location(), 0, 1, world2_fish7_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish7_paths_stacks[] = {world2_fish7_paths_stack_wander_right, world2_fish7_paths_stack_wander_left};
-    frame world2_fish7_collision_frame = {-43, -20, 546, 375};
-    fish_profile world2_fish7 = {images.fish7_image, &images.fish7_image_frames_amount, "fish 7", world2_fish7_collision_frame, false, true, Size(250, 202), 1.75, 4, 10, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish7_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.8};
-    
-    // - Fish 8 -
-    
-    // Right
-    fish_path world2_fish8_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish8_wander_right_paths[] = {world2_fish8_path_wander_right};
-    paths_stack world2_fish8_paths_stack_wander_right = {Location(), 0, 1, world2_fish8_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish8_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish8_wander_left_paths[] = {world2_fish8_path_wander_left};
-    paths_stack world2_fish8_paths_stack_wander_left = {Location(), 0, 1, world2_fish8_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish8_paths_stacks[] = {world2_fish8_paths_stack_wander_right, world2_fish8_paths_stack_wander_left};
-    frame world2_fish8_collision_frame = {0, 0, 640, 576};
-    fish_profile world2_fish8 = {images.fish8_image, &images.fish8_image_frames_amount, "fish 8", world2_fish8_collision_frame, true, true, Size(90, 81), 1.2, 15, 35, 0, 3, 30, 300, 1.2, 2, true, 2, world2_fish8_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.7};
-    
-    // - Fish 9 -
-    
-    // Right
-    fish_path world2_fish9_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish9_wander_right_paths[] = {world2_fish9_path_wander_right};
-    paths_stack world2_fish9_paths_stack_wander_right = {Location(), 0, 1, world2_fish9_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish9_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish9_wander_left_paths[] = {world2_fish9_path_wander_left};
-    paths_stack world2_fish9_paths_stack_wander_left = {Location(), 0, 1, world2_fish9_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish9_paths_stacks[] = {world2_fish9_paths_stack_wander_right, world2_fish9_paths_stack_wander_left};
-    frame world2_fish9_collision_frame = {0, 0, 658, 540};
-    fish_profile world2_fish9 = {images.fish9_image, &images.fish9_image_frames_amount, "fish 9", world2_fish9_collision_frame, false, true, Size(150, 123), 3, 12, 20, 0, 2, 30, 300, 1.2, 2, true, 2, world2_fish9_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.33};
-    
-    // - Fish 10 -
-    
-    // Right
-    fish_path world2_fish10_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish10_wander_right_paths[] = {world2_fish10_path_wander_right};
-    paths_stack world2_fish10_paths_stack_wander_right = {Location(), 0, 1, world2_fish10_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish10_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish10_wander_left_paths[] = {world2_fish10_path_wander_left};
-    paths_stack world2_fish10_paths_stack_wander_left = {Location(), 0, 1, world2_fish10_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish10_paths_stacks[] = {world2_fish10_paths_stack_wander_right, world2_fish10_paths_stack_wander_left};
-    frame world2_fish10_collision_frame = {16, 13, 396, 375};
-    fish_profile world2_fish10 = {images.fish10_image, &images.fish10_image_frames_amount, "fish 10", world2_fish10_collision_frame, true, false, Size(480, 459), 2, 8, 25, 0, 2, 30, 300, 1.2, 2, false, 2, world2_fish10_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.3};
-    
-    // - Fish 11 -
-    
-    // Right
-    fish_path world2_fish11_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_fish11_wander_right_paths[] = {world2_fish11_path_wander_right};
-    paths_stack world2_fish11_paths_stack_wander_right = {Location(), 0, 1, world2_fish11_wander_right_paths, false, false, false, false, true};
-    
-    // Left
-    fish_path world2_fish11_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_fish11_wander_left_paths[] = {world2_fish11_path_wander_left};
-    paths_stack world2_fish11_paths_stack_wander_left = {Location(), 0, 1, world2_fish11_wander_left_paths, false, false, false, false, false};
-    
-    // Fish profile.
-    paths_stack world2_fish11_paths_stacks[] = {world2_fish11_paths_stack_wander_right, world2_fish11_paths_stack_wander_left};
-    frame world2_fish11_collision_frame = {-56, 59, 413, 341};
-    fish_profile world2_fish11 = {images.fish11_image, &images.fish11_image_frames_amount, "fish 11", world2_fish11_collision_frame, false, true, Size(600, 510), 2, 1, 10, 0, 2, 30, 300, 1.2, 2, false, 2, world2_fish11_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.2};
-    
-    // - Crab 1 -
-    
-    // Right
-    fish_path world2_crab1_path_wander_right = {10, 0, true, true, 100};
-    fish_path world2_crab1_wander_right_paths[] = {world2_crab1_path_wander_right};
-    paths_stack world2_crab1_paths_stack_wander_right = {Location(- X_COORD_OFFSET, world2.height - 50), world2.height - 50, 1, world2_crab1_wander_right_paths, false, false, true, false, true};
-    
-    // Left
-    fish_path world2_crab1_path_wander_left = {10, 0, false, true, 100};
-    fish_path world2_crab1_wander_left_paths[] = {world2_crab1_path_wander_left};
-    paths_stack world2_crab1_paths_stack_wander_left = {Location(world2.width + X_COORD_OFFSET, world2.height - 50), world2.height - 50, 1, world2_crab1_wander_left_paths, false, false, true, false, false};
-    
-    // Fish profile.
-    paths_stack world2_crab1_paths_stacks[] = {world2_crab1_paths_stack_wander_right, world2_crab1_paths_stack_wander_left};
-    frame world2_crab1_collision_frame = {0, 0, 790, 790};
-    fish_profile world2_crab1 = {images.crab1_image, &images.crab1_image_frames_amount, "crab 1", world2_crab1_collision_frame, true, true, Size(75, 75), 1, 1, 10, 0, 0, 30, 300, 10, 1, false, 2, world2_crab1_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-    
-    // -- Setup --
-    
-    fish_profile world2_fish_profiles_on_startup[] = {};
-    fish_profile world2_available_fish[] = {world2_fish1, world2_fish2, world2_fish3, world2_fish4, world2_fish5, world2_fish6, world2_fish7, world2_fish8, world2_fish9, world2_fish10, world2_fish11, world2_crab1};
-    FishNetwork world2_fish_network = FishNetwork(FPS, FISH_POPULATION, EAT_GROW_RATIO, &world2_grid, world2_fish_profiles_on_startup, 0, world2_available_fish, 12, X_COORD_OFFSET, world2_my_fish.get_updated_rectangular_frame_triple_size());
-    world2_fish_network.update_boundaries(-X_COORD_OFFSET, world2.width + X_COORD_OFFSET, 0, world2.height, true);
-
-    // ----- Final Set-ups World2 -----
-
-    // Create and set-up the camera.
-    Camera2D world2_camera = { 0 };
-    world2_camera.target = (Vector2) { (float) world2_my_fish.get_location().x, (float) world2_my_fish.get_location().y };
-    world2_camera.offset = (Vector2) { (float) SCREEN_WIDTH / 2, (float) SCREEN_HEIGHT / 2 };
-    world2_camera.rotation = 0;
-    
-    if (debug_camera) { world2_camera.zoom = 0.15; }
-    else { world2_camera.zoom = 0.7; }
-    
-    // # ----- World 3 ----- #
+    // The current campain window.
+    int current_campain_welcome_window = 1;
     
-    // Load Textures.
-    Texture2D world3 = LoadTexture(PATH_WORLD3);
+    // The current mouse point location.
+    Vector2 mouse_point = { 0, 0 };
     
-    // Load the welcome window.
-    Texture2D world3_welcome_window = LoadTexture(PATH_WORLD3_WELCOME_WINDOW);
+    // The input of the current frame.
+    frame_input user_input;
     
-    // Create the grid.
-    Grid world3_grid = Grid(GRID_COLS, GRID_ROWS, FISH_POPULATION, world3.width, world3.height);
-
-    // ----- Create Entities -----
+    // # ----- Map ----- #
     
-    // --- my fish ---
+    // Load the map texture.
+    Texture2D& map = textures.map;
     
-    Cell** world3_cells_within_my_fish = new Cell*[GRID_ROWS * GRID_COLS];
-    frame world3_my_fish_collision_frame = {-54, -4, 549, 439};
-    MyFish world3_my_fish = MyFish(FPS, images.my_fish_image, &images.my_fish_image_frames_amount, world3_my_fish_collision_frame, false, Location(world3.width / 2, world3.height / 2), Size(150, 107), 23, 23, 0, 0, 0, 0, 1, 15, EAT_GROW_RATIO, 1.2, 10000, 0, true, FISH_POPULATION, world3_cells_within_my_fish, Location(100, SCREEN_HEIGHT - 75), Size(150, 20), 1, 2, FPS * 2, FPS * 5, Location(350, SCREEN_HEIGHT - 75), Size(150, 20), 1, audio.sound_eat, audio.sound_sting1);
-
-    // --- Fish Network ---
-
-    // -- Fish Profiles --
+    // Load the worlds buttons.
+    Texture2D& world1_button = textures.world1_button;
+    Texture2D& world2_button = textures.world2_button;
+    Texture2D& world3_button = textures.world3_button;
     
-    // - Fish 4 -
+    // Define frame rectangle for drawing.
+    Rectangle world1_button_frame = { 100, 100, (float) world1_button.width, (float) world1_button.height };
+    Rectangle world2_button_frame = { 300, 250, (float) world2_button.width, (float) world2_button.height };
+    Rectangle world3_button_frame = { 500, 400, (float) world3_button.width, (float) world3_button.height };
     
-    // Right
-    fish_path world3_fish4_path_wander_right = {10, 0, true, true, 100};
-    fish_path world3_fish4_wander_right_paths[] = {world3_fish4_path_wander_right};
-    paths_stack world3_fish4_paths_stack_wander_right = {Location(), 0, 1, world3_fish4_wander_right_paths, false, false, false, false, true};
+    // # ----- Windows ----- #
     
-    // Left
-    fish_path world3_fish4_path_wander_left = {10, 0, false, true, 100};
-    fish_path world3_fish4_wander_left_paths[] = {world3_fish4_path_wander_left};
-    paths_stack world3_fish4_paths_stack_wander_left = {Location(), 0, 1, world3_fish4_wander_left_paths, false, false, false, false, false};
+    // The victory window.
+    Texture2D& victory = textures.victory;
     
-    // Fish profile.
-    paths_stack world3_fish4_paths_stacks[] = {world3_fish4_paths_stack_wander_right, world3_fish4_paths_stack_wander_left};
-    frame world3_fish4_collision_frame = {0, 0, 616, 686};
-    fish_profile world3_fish4 = {images.fish4_image, &images.fish4_image_frames_amount, "fish 4", world3_fish4_collision_frame, true, true, Size(90, 100), 1.2, 15, 35, 0, 3, 30, 300, 1.2, 2, true, 2, world3_fish4_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 2.5};
+    // The defeat window.
+    Texture2D& defeat = textures.defeat;
     
-    // - Fish 6 -
+    // The back to map button.
+    Texture2D& back_to_map_button = textures.back_to_map_button;
     
-    // Right
-    fish_path world3_fish6_path_wander_right = {10, 0, true, true, 100};
-    fish_path world3_fish6_wander_right_paths[] = {world3_fish6_path_wander_right};
-    paths_stack world3_fish6_paths_stack_wander_right = {Location(), 0, 1, world3_fish6_wander_right_paths, false, false, false, false, true};
+    // The frame of the back to map button.
+    Rectangle back_to_map_button_frame = {(float) floor(SCREEN_WIDTH / 2 - back_to_map_button.width / 2), (float) floor(SCREEN_HEIGHT / 2) + 250, (float) back_to_map_button.width, (float) back_to_map_button.height};
     
-    // Left
-    fish_path world3_fish6_path_wander_left = {10, 0, false, true, 100};
-    fish_path world3_fish6_wander_left_paths[] = {world3_fish6_path_wander_left};
-    paths_stack world3_fish6_paths_stack_wander_left = {Location(), 0, 1, world3_fish6_wander_left_paths, false, false, false, false, false};
+    // True if victory/defeat.
+    bool is_victory = false, is_defeat = false;
     
-    // Fish profile.
-    paths_stack world3_fish6_paths_stacks[] = {world3_fish6_paths_stack_wander_right, world3_fish6_paths_stack_wander_left};
-    frame world3_fish6_collision_frame = {22, -4, 467, 431};
-    fish_profile world3_fish6 = {images.fish6_image, &images.fish6_image_frames_amount, "fish 6", world3_fish6_collision_frame, true, false, Size(150, 122), 2, 6, 18, 0, 2, 30, 300, 1.2, 2, true, 2, world3_fish6_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.8};
+    // Load the exit_welcome_window button.
+    Texture2D& exit_welcome_window_button = textures.exit_welcome_window_button; 
     
-    // - Fish 8 -
+    // Define frame rectangle for drawing.
+    Rectangle exit_welcome_window_button_frame = { (float) floor (SCREEN_WIDTH / 2 - exit_welcome_window_button.width / 2), (float) floor(SCREEN_HEIGHT / 2) + 300, (float) exit_welcome_window_button.width, (float) exit_welcome_window_button.height };
     
-    // Right
-    fish_path world3_fish8_path_wander_right = {10, 0, true, true, 100};
-    fish_path world3_fish8_wander_right_paths[] = {world3_fish8_path_wander_right};
-    paths_stack world3_fish8_paths_stack_wander_right = {Location(), 0, 1, world3_fish8_wander_right_paths, false, false, false, false, true};
+    // The pause window.
+    Texture2D& pause_window = textures.pause_window;
     
-    // Left
-    fish_path world3_fish8_path_wander_left = {10, 0, false, true, 100};
-    fish_path world3_fish8_wander_left_paths[] = {world3_fish8_path_wander_left};
-    paths_stack world3_fish8_paths_stack_wander_left = {Location(), 0, 1, world3_fish8_wander_left_paths, false, false, false, false, false};
+    // The back to map button.
+    Texture2D& resume_game_button = textures.resume_game_button;
     
-    // Fish profile.
-    paths_stack world3_fish8_paths_stacks[] = {world3_fish8_paths_stack_wander_right, world3_fish8_paths_stack_wander_left};
-    frame world3_fish8_collision_frame = {0, 0, 640, 576};
-    fish_profile world3_fish8 = {images.fish8_image, &images.fish8_image_frames_amount, "fish 8", world3_fish8_collision_frame, true, true, Size(90, 81), 1.2, 15, 35, 0, 3, 30, 300, 1.2, 2, true, 2, world3_fish8_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 2.5};
+    // The frame of the resume button.
+    Rectangle resume_button_frame = {(float) floor(SCREEN_WIDTH / 2 - resume_game_button.width / 2), (float) floor(SCREEN_HEIGHT / 2) + 250, (float) resume_game_button.width, (float) resume_game_button.height};
     
-    // - Fish 10 -
+    // The pause button.
+    Texture2D& pause_button = textures.pause_button;
     
-    // Right
-    fish_path world3_fish10_path_wander_right = {10, 0, true, true, 100};
-    fish_path world3_fish10_wander_right_paths[] = {world3_fish10_path_wander_right};
-    paths_stack world3_fish10_paths_stack_wander_right = {Location(), 0, 1, world3_fish10_wander_right_paths, false, false, false, false, true};
+    // The frame of the resume button.
+    Rectangle pause_button_frame = {(float) (20), (float) (25), (float) pause_button.width, (float) pause_button.height};
     
-    // Left
-    fish_path world3_fish10_path_wander_left = {10, 0, false, true, 100};
-    fish_path world3_fish10_wander_left_paths[] = {world3_fish10_path_wander_left};
-    paths_stack world3_fish10_paths_stack_wander_left = {Location(), 0, 1, world3_fish10_wander_left_paths, false, false, false, false, false};
+    // Define the turbo button.
+    //Texture2D turbo_button = LoadTexture(PATH_TURBO_BUTTON);
+    //Rectangle turbo_button_frame = { (float) SCREEN_WIDTH - turbo_button.width - 15, (float) floor( SCREEN_HEIGHT - turbo_button.height) - 30, (float) turbo_button.width, (float) turbo_button.height };
     
-    // Fish profile.
-    paths_stack world3_fish10_paths_stacks[] = {world3_fish10_paths_stack_wander_right, world3_fish10_paths_stack_wander_left};
-    frame world3_fish10_collision_frame = {16, 13, 396, 375};
-    fish_profile world3_fish10 = {images.fish10_image, &images.fish10_image_frames_amount, "fish 10", world3_fish10_collision_frame, true, false, Size(480, 459), 2, 8, 25, 0, 2, 30, 300, 1.2, 2, false, 2, world3_fish10_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 0.07};
+    // # ----- Sound Variants ----- #
     
-    // - Crab 1 -
+    // My fish plays the sounds as they are, the other fish play them quieter (matches the old "Lower" sound files).
+    sound_variant sound_eat = {audio.sound_eat, 1, 1};
+    sound_variant sound_eat_lower = {audio.sound_eat, 1, 0.2};
+    sound_variant sound_sting1 = {audio.sound_sting1, 1, 1};
+    sound_variant sound_sting1_lower = {audio.sound_sting1, 1, 0.5};
     
-    // Right
-    fish_path world3_crab1_path_wander_right = {10, 0, true, true, 100};
-    fish_path world3_crab1_wander_right_paths[] = {world3_crab1_path_wander_right};
-    paths_stack world3_crab1_paths_stack_wander_right = {Location(- X_COORD_OFFSET, world3.height - 50), world3.height - 50, 1, world3_crab1_wander_right_paths, false, false, true, false, true};
+    // # ----- Worlds ----- #
     
-    // Left
-    fish_path world3_crab1_path_wander_left = {10, 0, false, true, 100};
-    fish_path world3_crab1_wander_left_paths[] = {world3_crab1_path_wander_left};
-    paths_stack world3_crab1_paths_stack_wander_left = {Location(world3.width + X_COORD_OFFSET, world3.height - 50), world3.height - 50, 1, world3_crab1_wander_left_paths, false, false, true, false, false};
+    // The worlds are described by their packs, a world is created when it is first played (after its bundle was loaded).
+    // The packs refer to the sounds by these names.
+    const char* world_sound_names[] = {"eat", "eat_lower", "sting1", "sting1_lower"};
+    sound_variant world_sounds[] = {sound_eat, sound_eat_lower, sound_sting1, sound_sting1_lower};
+    WorldCatalog world_catalog = WorldCatalog(3, path_world_sources, path_world_packs, &asset_loader, &sfx_mixer, world_sound_names, world_sounds, 4, TICKS_PER_SECOND, FISH_POPULATION, GRID_COLS, GRID_ROWS, EAT_GROW_RATIO, X_COORD_OFFSET, SCREEN_WIDTH, SCREEN_HEIGHT, debug_camera ? 0.15 : 0.7, &images.my_fish_image, &images.my_fish_image_frames_amount, sound_eat, sound_sting1);
     
-    // Fish profile.
-    paths_stack world3_crab1_paths_stacks[] = {world3_crab1_paths_stack_wander_right, world3_crab1_paths_stack_wander_left};
-    frame world3_crab1_collision_frame = {0, 0, 790, 790};
-    fish_profile world3_crab1 = {images.crab1_image, &images.crab1_image_frames_amount, "crab 1", world3_crab1_collision_frame, true, true, Size(75, 75), 1, 1, 10, 0, 0, 30, 300, 10, 1, false, 2, world3_crab1_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-
-    // - Crab 2 -
+    // Write the synthetic worlds for the scaling tests, instead of playing.
+    if (generate_synthetic_worlds) { write_synthetic_worlds(&world_catalog, &asset_loader, path_world_packs); worker_pool.quit(); CloseWindow(); return 0; }
     
-    // Right
-    fish_path world3_crab2_path_wander_right = {10, 0, true, true, 100};
-    fish_path world3_crab2_wander_right_paths[] = {world3_crab2_path_wander_right};
-    paths_stack world3_crab2_paths_stack_wander_right = {Location(- X_COORD_OFFSET, world3.height - 50), world3.height - 50, 1, world3_crab2_wander_right_paths, false, false, true, false, true};
+    // --- Asset Pack ---
     
-    // Left
-    fish_path world3_crab2_path_wander_left = {10, 0, false, true, 100};
-    fish_path world3_crab2_wander_left_paths[] = {world3_crab2_path_wander_left};
-    paths_stack world3_crab2_paths_stack_wander_left = {Location(world3.width + X_COORD_OFFSET, world3.height - 50), world3.height - 50, 1, world3_crab2_wander_left_paths, false, false, true, false, false};
+    // Report the startup time, with how many images were found in the pack.
+    TraceLog(LOG_INFO, "Startup took %.3f seconds (asset pack hits: %d, misses: %d)", GetTime() - startup_start_time, asset_pack.get_hits(), asset_pack.get_misses());
     
-    // Fish profile.
-    paths_stack world3_crab2_paths_stacks[] = {world3_crab2_paths_stack_wander_right, world3_crab2_paths_stack_wander_left};
-    frame world3_crab2_collision_frame = {0, 0, 790, 790};
-    fish_profile world3_crab2 = {images.crab2_image, &images.crab2_image_frames_amount, "crab 2", world3_crab2_collision_frame, false, true, Size(75, 75), 1, 1, 10, 0, 0, 30, 300, 10, 1, false, 2, world3_crab2_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1};
-
-    // - Jelly Fish 1 -
-    
-    // Falling down paths.
-    fish_path world3_jeflly_fish1_falling_down1 = {4, 40, true, false, 40};
-    fish_path world3_jeflly_fish1_falling_down2 = {5, 60, true, false, 40};
-    fish_path world3_jeflly_fish1_falling_down3 = {20, 35, true, false, 40};
-    fish_path world3_jeflly_fish1_moving_right = {13, 1, true, false, 50};
-    
-    fish_path world3_jelly_fish1_paths1[] = {world3_jeflly_fish1_falling_down1, world3_jeflly_fish1_moving_right};
-    fish_path world3_jelly_fish1_paths2[] = {world3_jeflly_fish1_falling_down2, world3_jeflly_fish1_moving_right};
-    fish_path world3_jelly_fish1_paths3[] = {world3_jeflly_fish1_falling_down3, world3_jeflly_fish1_moving_right};
-    
-    paths_stack world3_jelly_fish1_paths_stack_fall_down1 = {Location(), - images.jelly_fish1_image.height - 10, 2, world3_jelly_fish1_paths1, false, false, true, true, false};
-    paths_stack world3_jelly_fish1_paths_stack_fall_down2 = {Location(), - images.jelly_fish1_image.height - 10, 2, world3_jelly_fish1_paths2, false, false, true, true, false};
-    paths_stack world3_jelly_fish1_paths_stack_fall_down3 = {Location(), - images.jelly_fish1_image.height - 10, 2, world3_jelly_fish1_paths3, false, false, true, true, false};
-    
-    // Fish profile.
-    paths_stack world3_jelly_fish1_paths_stacks[] = {world3_jelly_fish1_paths_stack_fall_down1, world3_jelly_fish1_paths_stack_fall_down2, world3_jelly_fish1_paths_stack_fall_down3};
-    frame world3_jeflly_fish1_collision_frame = {-8, -9, 384, 528};
-    fish_profile world3_jeflly_fish1 = {images.jelly_fish1_image, &images.jeflly_fish1_image_frames_amount, "Jelly Fish", world3_jeflly_fish1_collision_frame, true, false, Size(170, 204), 1.3, 3, 20, 0, 7, 30, 300, 1.2, 2, true, 3, world3_jelly_fish1_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1.3};
-    
-    // - Jelly Fish 2 -
-    
-    // Falling down paths.
-    fish_path world3_jeflly_fish2_falling_down1 = {4, 40, true, false, 40};
-    fish_path world3_jeflly_fish2_falling_down2 = {5, 60, true, false, 40};
-    fish_path world3_jeflly_fish2_falling_down3 = {20, 35, true, false, 40};
-    fish_path world3_jeflly_fish2_moving_right = {13, 1, true, false, 50};
-    
-    fish_path world3_jelly_fish2_paths1[] = {world3_jeflly_fish2_falling_down1, world3_jeflly_fish2_moving_right};
-    fish_path world3_jelly_fish2_paths2[] = {world3_jeflly_fish2_falling_down2, world3_jeflly_fish2_moving_right};
-    fish_path world3_jelly_fish2_paths3[] = {world3_jeflly_fish2_falling_down3, world3_jeflly_fish2_moving_right};
-    
-    paths_stack world3_jelly_fish2_paths_stack_fall_down1 = {Location(), - images.jelly_fish2_image.height - 10, 2, world3_jelly_fish2_paths1, false, false, true, true, false};
-    paths_stack world3_jelly_fish2_paths_stack_fall_down2 = {Location(), - images.jelly_fish2_image.height - 10, 2, world3_jelly_fish2_paths2, false, false, true, true, false};
-    paths_stack world3_jelly_fish2_paths_stack_fall_down3 = {Location(), - images.jelly_fish2_image.height - 10, 2, world3_jelly_fish2_paths3, false, false, true, true, false};
-    
-    // Fish profile.
-    paths_stack world3_jelly_fish2_paths_stacks[] = {world3_jelly_fish2_paths_stack_fall_down1, world3_jelly_fish2_paths_stack_fall_down2, world3_jelly_fish2_paths_stack_fall_down3};
-    frame world3_jeflly_fish2_collision_frame = {-4, -8, 323, 544};
-    fish_profile world3_jeflly_fish2 = {images.jelly_fish2_image, &images.jeflly_fish2_image_frames_amount, "Jelly Fish", world3_jeflly_fish2_collision_frame, true, false, Size(150, 227), 1.3, 3, 20, 0, 3, 30, 300, 1.2, 2, true, 3, world3_jelly_fish2_paths_stacks, audio.sound_eat_lower, audio.sound_sting1_lower, 1.2};
+    // Some images were decoded on this launch (first launch, or changed resources). Rebuild the pack for the next launches.
+    if (asset_pack.is_dirty())
+    {
+        double pack_start_time = GetTime();
+        phase_start_time = monotonic_time();
+        asset_pack.save();
+        startup_tracer.record("Rebuild the asset pack", "phase", phase_start_time, 0);
+        TraceLog(LOG_INFO, "Asset pack rebuilt in %.3f seconds", GetTime() - pack_start_time);
+    }
     
-    // -- Setup --
+    // --- Load the world background to the main menu and map ---
     
-    fish_profile world3_fish_profiles_on_startup[] = {};
-    fish_profile world3_available_fish[] = {world3_fish4, world3_fish6, world3_fish8, world3_fish10, world3_crab1, world3_crab2, world3_jeflly_fish1, world3_jeflly_fish2};
-    FishNetwork world3_fish_network = FishNetwork(FPS, FISH_POPULATION, EAT_GROW_RATIO, &world3_grid, world3_fish_profiles_on_startup, 0, world3_available_fish, 8, X_COORD_OFFSET, world3_my_fish.get_updated_rectangular_frame_triple_size());
-    world3_fish_network.update_boundaries(-X_COORD_OFFSET, world3.width + X_COORD_OFFSET, 0, world3.height, true);
-
-    // ----- Final Set-ups World3 -----
-
-    // Create and set-up the camera.
-    Camera2D world3_camera = { 0 };
-    world3_camera.target = (Vector2) { (float) world3_my_fish.get_location().x, (float) world3_my_fish.get_location().y };
-    world3_camera.offset = (Vector2) { (float) SCREEN_WIDTH / 2, (float) SCREEN_HEIGHT / 2 };
-    world3_camera.rotation = 0;
-    
-    if (debug_camera) { world3_camera.zoom = 0.15; }
-    else { world3_camera.zoom = 0.7; }
+    phase_start_time = monotonic_time();
     
-    // --- Load the world background to the main menu and map ---
+    // The pack of world 1 is read on startup, it is the background of the menus.
+    WorldPack* backdrop_pack = world_catalog.get_pack(1);
+    if (backdrop_pack == NULL) { CloseWindow(); return 0; }
+    Texture2D& world1 = *backdrop_pack -> get_background();
     
     // Create the camera.
     Camera2D camera_main_menu_map = { 0 };
     camera_main_menu_map.offset = (Vector2) { (float) SCREEN_WIDTH / 2, (float) SCREEN_HEIGHT / 2 };
     camera_main_menu_map.target = (Vector2) { (float) floor(world1.width / 2), (float) floor(world1.height / 2) };
     camera_main_menu_map.zoom = 0.45;
-    current_world = 1;
-    world = world1;
-    fish_network = world1_fish_network;
-    grid = world1_grid;
-    camera = camera_main_menu_map;
-    fish_network.setup();
+    
+    // The backdrop is an instance of world 1 of its own, without my fish. It is suspended while a world is played, and resumed as it was left.
+    // It is only decoration: a smaller population, moved once in BACKDROP_STEP_TICKS ticks, and no grid or collisions.
+    Grid backdrop_grid = Grid(GRID_COLS, GRID_ROWS, BACKDROP_POPULATION, world1.width, world1.height);
+    Rectangle backdrop_exclude_setup_location_frame = {0, 0, 0, 0};
+    FishNetwork backdrop_fish_network = FishNetwork(TICKS_PER_SECOND, BACKDROP_POPULATION, EAT_GROW_RATIO, &backdrop_grid, backdrop_pack -> get_profiles_on_startup(), backdrop_pack -> get_profiles_on_startup_amount(), backdrop_pack -> get_available_fish(), backdrop_pack -> get_available_fish_amount(), X_COORD_OFFSET, backdrop_exclude_setup_location_frame, &sfx_mixer);
+    backdrop_fish_network.set_backdrop(BACKDROP_STEP_TICKS);
+    backdrop_fish_network.update_boundaries(-X_COORD_OFFSET, world1.width + X_COORD_OFFSET, 0, world1.height, true);
+    GameWorld backdrop_instance = GameWorld(0, &world1, NULL, NULL, &backdrop_fish_network, &backdrop_grid, camera_main_menu_map);
+    
+    // The current world instance.
+    GameWorld* game_world = &backdrop_instance;
+    game_world -> resume();
+    
+    startup_tracer.record("Main menu background set-up", "phase", phase_start_time, 0);
     
     // Play the main theme music.
-    Sound current_music = audio.music_main_theme;
-    PlaySound(current_music);
+    scene_machine.play_music();
+    
+    // The startup is over, report where the time went.
+    startup_tracer.finish();
+    startup_tracer.report();
+    startup_tracer.save_json(path_startup_trace);
+    
+    // The simulation runs in fixed ticks (at most 4 on a frame), the pacing of the last 600 frames is measured.
+    FrameClock frame_clock = FrameClock(TICKS_PER_SECOND, 4, 600);
+    int ticks_to_run = 0;
+    
+    // The last REWIND_SECONDS of the played world are kept (within REWIND_MEMORY bytes), holding R or two fingers rolls it back.
+    const int REWIND_SECONDS = 5;
+    const int REWIND_KEYFRAME_TICKS = TICKS_PER_SECOND;
+    const size_t REWIND_MEMORY = 1024 * 1024;
+    Rewind rewind(TICKS_PER_SECOND, REWIND_SECONDS, REWIND_KEYFRAME_TICKS, REWIND_MEMORY, FISH_POPULATION, GRID_ROWS * GRID_COLS);
+    bool is_rewinding = false;
+    
+    // The ticks run on the simulation thread, while the main thread draws the ticks of the previous frame.
+    Simulation simulation(game_world, SCREEN_WIDTH, SCREEN_HEIGHT, X_COORD_OFFSET, debug_camera, FISH_POPULATION + 1, GRID_ROWS * GRID_COLS, pipeline_simulation, &rewind);
+    int sim_mode = SIM_MODE_BACKGROUND;
+    sim_input input = { false, false, false, false, GESTURE_NONE, Location(0, 0) };
+    int sim_event;
+    
+    // The scene which was simulated on the previous frame, and the snapshot and camera which are drawn.
+    int simulated_scene = -1;
+    WorldSnapshot* snapshot;
+    Camera2D drawn_camera;
+    
+    // Holds the frame time within the budget of the target fps, by lowering the load which doesn't change the game.
+    QualityGovernor quality_governor = QualityGovernor(1.0 / RENDER_FPS);
+    
+    // Measures the phases of the frames (toggled by F3, on from the start when profiling).
+    FrameProfiler frame_profiler = FrameProfiler(RENDER_FPS * 30, path_frame_profile);
+    if (profile_frames) { frame_profiler.toggle(); simulation.measure_phases(frame_profiler.get_tick_phases_times()); }
+    
+    // True while an idle window is shown (see idle_rendering), and if it was drawn since the last input.
+    bool is_idle_screen = false;
+    bool is_idle_drawn = false;
+    
+    // The state of the played world is saved when it is paused, and once in WORLD_STATE_INTERVAL seconds (the game might be killed in the background).
+    // A world which was left in the middle is continued when it is played again.
+    const double WORLD_STATE_INTERVAL = 10;
+    WorldState world_state(path_world_state, FISH_POPULATION, GRID_ROWS * GRID_COLS);
+    world_state.read();
+    double world_state_time = 0;
+    bool is_world_state_paused = false;
+    
+    // A recorded (or replayed) run plays the worlds from their start, and doesn't touch the saved state.
+    bool is_world_state_kept = !input_recorder.is_active();
    
 	// ----- Game Loop -----
 
 	// As long as the Esc button or exit button were not pressed, continue to the next frame.
 	while (!WindowShouldClose())
 	{
-        // --- Update Music ---
+        // Measure the frame of the current scene, and its phases.
+        scene_machine.begin_frame();
+        quality_governor.begin_frame();
+        frame_profiler.begin_frame();
+        
+        // --- Update Assets ---
+        
+        // Upload the assets which were loaded in the background.
+        asset_loader.process_completed();
+        
+        // A bundle loaded in the background had new images, pack them for the next launches (never while playing, it takes a while).
+        if (asset_loader.is_idle() && asset_pack.is_dirty() && !scene_machine.is_world()) { asset_pack.save(); }
         
-        // Play the current background music in loop.
-        if (!IsSoundPlaying(current_music)) { PlaySound(current_music); }
+        // Report the peak memory of the previous screen, and start measuring the new one.
+        if (memory_screen != scene_machine.get_name())
+        {
+            TraceLog(LOG_INFO, "Peak RSS on %s: %.1f MB", memory_screen.c_str(), get_peak_rss() / 1024.0);
+            reset_peak_rss();
+            memory_screen = scene_machine.get_name();
+        }
+        
+        // --- Input ---
+        
+        // The input is read once a frame (or replayed, the replay is over with the recording).
+        frame_profiler.begin_phase(PROFILE_PHASE_INPUT);
+        read_frame_input(&user_input);
+        if (!input_recorder.next_frame(game_world, &user_input)) { break; }
+        frame_profiler.begin_phase(PROFILE_PHASE_UPDATE);
+        
+        // --- Fixed Ticks ---
+        
+        // How many ticks of simulation fit in the time since the previous frame (nothing is simulated behind an idle window).
+        if (is_idle_screen) { frame_clock.skip_frame(); ticks_to_run = 0; }
+        else { ticks_to_run = frame_clock.begin_frame(); }
+        ticks_to_run = input_recorder.sync_ticks(ticks_to_run);
         
         // --- Game Pause Check ---
         
         // Check if need to puase the game.
-        if (current_screen == "World")
+        if (scene_machine.is_world())
         {
             // Get the current position of the mouse.
-            mouse_point = GetMousePosition();
+            mouse_point = user_input.mouse_point;
                 
             // Check if pause button pressed.
-            if (CheckCollisionPointRec(mouse_point, pause_button_frame) && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            if (CheckCollisionPointRec(mouse_point, pause_button_frame) && user_input.is_mouse_pressed)
             {
                 // pause the game.
                 pause = true;
             }
+            
+            // The game went to the background, pause it.
+            if (!user_input.is_focused) { pause = true; }
+            
+            // Save the state of the world when it was paused now, and once in a while while it is played (the simulation is idle here).
+            if (is_world_state_kept && !is_victory && !is_defeat && ((pause && !is_world_state_paused) || GetTime() - world_state_time >= WORLD_STATE_INTERVAL))
+            {
+                world_state.capture(game_world);
+                world_state.write_async();
+                world_state_time = GetTime();
+            }
+            
+            is_world_state_paused = pause;
         }
         
         // --- Update Data ---
         
-        if (current_screen == "Main Menu" || current_screen == "Map")
+        if (!scene_machine.is_world())
         {
             // Create the world background for the main menu and map.
-            fish_network.update_boundaries(-X_COORD_OFFSET, world.width + X_COORD_OFFSET, 0, world.height, true);
-            fish_network.load_available_fish(false);
-            fish_network.move();
-            fish_network.set_next_frame();
+            sim_mode = SIM_MODE_BACKGROUND;
         }
         
-        if (current_screen == "Main Menu")
+        if (scene_machine.get_scene() == SCENE_MAIN_MENU)
         {
             // Get the current position of the mouse.
-            mouse_point = GetMousePosition();
+            mouse_point = user_input.mouse_point;
             
             // If currently showing the campain welcome window.
             if (is_campain_welcome_window)
             {
                 // Check if the user finished reading.
-                if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) 
+                if (user_input.is_mouse_released) 
                 {
                     // This is the last window, move to the map.
-                    if (current_campain_welcome_window >= 7) { current_screen = "Map"; is_campain_welcome_window = false; current_campain_welcome_window = 1; }
+                    if (current_campain_welcome_window >= 7) { scene_machine.change(SCENE_MAP, 0); is_campain_welcome_window = false; current_campain_welcome_window = 1; }
                     
                     // Move to the next window.
                     else { current_campain_welcome_window++; }
@@ -3512,7 +11564,7 @@ int main()
             else if (is_about_window)
             {
                 // Check if the close button is pressed.
-                if (CheckCollisionPointRec(mouse_point, about_close_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+                if (CheckCollisionPointRec(mouse_point, about_close_button_frame) && user_input.is_mouse_released)
                 {
                     // Close the about window.
                     is_about_window = false;
@@ -3520,106 +11572,67 @@ int main()
             }
             
             // The campain button was pressed.
-            else if (CheckCollisionPointRec(mouse_point, campain_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            else if (CheckCollisionPointRec(mouse_point, campain_button_frame) && user_input.is_mouse_released)
             {
                 // If currently on the first world.
-                if (game_save.world_checkpoint == 1) { is_campain_welcome_window = true; }
-                else { current_screen = "Map"; }
+                if (game_save.world_checkpoint == 1) { asset_loader.wait_loaded(BUNDLE_CAMPAIN_INTRO); is_campain_welcome_window = true; }
+                else { scene_machine.change(SCENE_MAP, 0); }
             }
             
             // The about button was pressed.
-            else if (CheckCollisionPointRec(mouse_point, about_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            else if (CheckCollisionPointRec(mouse_point, about_button_frame) && user_input.is_mouse_released)
             {
                 // Set the about window.
                 is_about_window = true;
             }
         }
         
-        else if (current_screen == "Map")
+        else if (scene_machine.get_scene() == SCENE_MAP)
         {
             // Get the current position of the mouse.
-            mouse_point = GetMousePosition();
+            mouse_point = user_input.mouse_point;
+            
+            // Prefetch the last unlocked world, it is most likely the next one to be played.
+            scene_machine.acquire(BUNDLE_WORLD1 << (min(game_save.world_checkpoint, 3) - 1));
+            
+            // Prefetch the world under the mouse (or finger), so it is ready when the button is released.
+            if (CheckCollisionPointRec(mouse_point, world1_button_frame)) { scene_machine.acquire(BUNDLE_WORLD1); }
+            if (game_save.world_checkpoint >= 2 && CheckCollisionPointRec(mouse_point, world2_button_frame)) { scene_machine.acquire(BUNDLE_WORLD2); }
+            if (game_save.world_checkpoint >= 3 && CheckCollisionPointRec(mouse_point, world3_button_frame)) { scene_machine.acquire(BUNDLE_WORLD3); }
+            
+            // Select the pressed world.
+            if (CheckCollisionPointRec(mouse_point, world1_button_frame) && user_input.is_mouse_released) { selected_world = 1; }
+            if (game_save.world_checkpoint >= 2 && CheckCollisionPointRec(mouse_point, world2_button_frame) && user_input.is_mouse_released) { selected_world = 2; }
+            if (game_save.world_checkpoint >= 3 && CheckCollisionPointRec(mouse_point, world3_button_frame) && user_input.is_mouse_released) { selected_world = 3; }
 
-            // World 1 was pressed.
-            if (CheckCollisionPointRec(mouse_point, world1_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            // The selected world was loaded (a replay waits for it, on the frame it was loaded when recorded).
+            bool is_selected_world_loaded = input_recorder.sync_world_loaded(selected_world != 0 && asset_loader.is_loaded(BUNDLE_WORLD1 << (selected_world - 1)));
+            if (is_selected_world_loaded) { asset_loader.wait_loaded(BUNDLE_WORLD1 << (selected_world - 1)); }
+            
+            // It is created the first time (a world without a valid pack is not played).
+            if (is_selected_world_loaded && world_catalog.get_world(selected_world) == NULL) { selected_world = 0; }
+            
+            if (selected_world != 0 && is_selected_world_loaded)
             {
-                // Clear the background of the map and main menu.
-                world1_fish_network.reset();
-                world1_grid.reset();
-                
-                // Set the current world to world 1.
-                current_screen = "World";
+                // Set the current scene to the world (crossfades to its music).
+                scene_machine.change(SCENE_WORLD1 + selected_world - 1, 0);
                 is_world_welcome_window = true;
-                current_world_welcome_window = world1_welcome_window;
-                current_world = 1;
-                world = world1;
-                my_fish = world1_my_fish;
-                fish_network = world1_fish_network;
-                grid = world1_grid;
-                camera = world1_camera;
-                grid.refresh_entity(&my_fish);
-                fish_network.setup();
-                
-                // Play the music of world 1.
-                StopSound(current_music);
-                current_music = audio.music_world1;
-                PlaySound(current_music);
+                current_world_welcome_window = *world_catalog.get_world(selected_world) -> get_welcome_window();
                 
-                continue;
-            }
-            
-            // World 2 was pressed.
-            if (game_save.world_checkpoint >= 2 && CheckCollisionPointRec(mouse_point, world2_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
-            {
-                // Clear the background of the map and main menu.
-                world1_fish_network.reset();
-                world1_grid.reset();
+                // Freeze the backdrop, and play the world.
+                game_world -> suspend();
+                game_world = world_catalog.get_world(selected_world);
                 
-                // Set the current world to world 2.
-                current_screen = "World";
-                is_world_welcome_window = true;
-                current_world_welcome_window = world2_welcome_window;
-                current_world = 2;
-                world = world2;
-                my_fish = world2_my_fish;
-                fish_network = world2_fish_network;
-                grid = world2_grid;
-                camera = world2_camera;
-                grid.refresh_entity(&my_fish);
-                fish_network.setup();
-                
-                // Play the music of world 2.
-                StopSound(current_music);
-                current_music = audio.music_world2;
-                PlaySound(current_music);
+                // The world was left in the middle the last time, continue from there (paused).
+                if (is_world_state_kept && world_state.restore(game_world)) { is_world_welcome_window = false; pause = true; }
+                else { game_world -> resume(); }
                 
-                continue;
-            }
-            
-            // World 3 was pressed.
-            if (game_save.world_checkpoint >= 3 && CheckCollisionPointRec(mouse_point, world3_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
-            {
-                // Clear the background of the map and main menu.
-                world1_fish_network.reset();
-                world1_grid.reset();
-
-                // Set the current world to world 3.
-                current_screen = "World";
-                is_world_welcome_window = true;
-                current_world_welcome_window = world3_welcome_window;
-                current_world = 3;
-                world = world3;
-                my_fish = world3_my_fish;
-                fish_network = world3_fish_network;
-                grid = world3_grid;
-                camera = world3_camera;
-                grid.refresh_entity(&my_fish);
-                fish_network.setup();
-                
-                // Play the music of world 3.
-                StopSound(current_music);
-                current_music = audio.music_world3;
-                PlaySound(current_music);
+                simulation.set_world(game_world);
+                rewind.clear();
+                world_state_time = GetTime();
+                is_world_state_paused = pause;
+                
+                selected_world = 0;
                 
                 continue;
             }
@@ -3628,88 +11641,29 @@ int main()
         else if (is_victory || is_defeat)
         {
             // Keep playing the gifs in the background.
-            my_fish.set_next_frame();
-            fish_network.set_next_frame();
+            sim_mode = SIM_MODE_ANIMATE;
             
             // Get the current position of the mouse.
-            mouse_point = GetMousePosition();
+            mouse_point = user_input.mouse_point;
 
             // The back to map button was pressed.
-            if (CheckCollisionPointRec(mouse_point, back_to_map_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            if (CheckCollisionPointRec(mouse_point, back_to_map_button_frame) && user_input.is_mouse_released)
             {
-                // Reset the world.
-                if (current_world == 1)
-                {
-                    // Reset my fish.
-                    world1_my_fish.reset();
-                    
-                    // Reset the fish network.
-                    world1_fish_network.reset();
-
-                    // Reset the grid.
-                    world1_grid.reset();
-                    
-                    // Reset the camera.
-                    world1_camera.target = (Vector2) { (float) world1_my_fish.get_location().x, (float) world1_my_fish.get_location().y };
-                    
-                    // Stop the music.
-                    StopSound(current_music);
-                }
-                
-                // Reset the world.
-                if (current_world == 2)
-                {
-                    // Reset my fish.
-                    world2_my_fish.reset();
-                    
-                    // Reset the fish network.
-                    world2_fish_network.reset();
-
-                    // Reset the grid.
-                    world2_grid.reset();
-                    
-                    // Reset the camera.
-                    world2_camera.target = (Vector2) { (float) world2_my_fish.get_location().x, (float) world2_my_fish.get_location().y };
-                    
-                    // Stop the music.
-                    StopSound(current_music);
-                }
-                
-                // Reset the world.
-                if (current_world == 3)
-                {
-                    // Reset my fish.
-                    world3_my_fish.reset();
-                    
-                    // Reset the fish network.
-                    world3_fish_network.reset();
-
-                    // Reset the grid.
-                    world3_grid.reset();
-                    
-                    // Reset the camera.
-                    world3_camera.target = (Vector2) { (float) world3_my_fish.get_location().x, (float) world3_my_fish.get_location().y };
-                    
-                    // Stop the music.
-                    StopSound(current_music);
-                }
+                // Start the world over, for the next time it is played.
+                game_world -> restart();
                 
-                // Change to the map, and reset the victory and defeat flags.
-                current_screen = "Map";
+                // Change to the map (keep the world it prefetches), and reset the victory and defeat flags.
+                scene_machine.change(SCENE_MAP, BUNDLE_WORLD1 << (min(game_save.world_checkpoint, 3) - 1));
                 is_victory = false;
                 is_defeat = false;
                 
-                // Reset the map background.
-                current_world = 1;
-                world = world1;
-                fish_network = world1_fish_network;
-                grid = world1_grid;
-                camera = camera_main_menu_map;
-                fish_network.setup();
+                // Back to the backdrop, as it was left.
+                game_world = &backdrop_instance;
+                game_world -> resume();
+                simulation.set_world(game_world);
                 
-                // Change the music back to the theme.
-                current_music = audio.music_main_theme;
-                PlaySound(current_music);
+                // Stop the sound effects of the world.
+                sfx_mixer.stop_all();
             }
         }
         
@@ -3717,79 +11671,55 @@ int main()
         {
             // Check if the welcome window need to be closed.
             // Get the current position of the mouse.
-            mouse_point = GetMousePosition();
+            mouse_point = user_input.mouse_point;
 
             // The exit welcome window button was pressed.
-            if (CheckCollisionPointRec(mouse_point, exit_welcome_window_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            if (CheckCollisionPointRec(mouse_point, exit_welcome_window_button_frame) && user_input.is_mouse_released)
             {
                 is_world_welcome_window = false;
             }
             
             // Keep the fish moving in the background.
-            fish_network.set_next_frame();
-            my_fish.set_next_frame();
+            sim_mode = SIM_MODE_ANIMATE;
         }
         
         else if (pause)
         {
             // Get the current position of the mouse.
-            mouse_point = GetMousePosition();
+            mouse_point = user_input.mouse_point;
             
-            if (CheckCollisionPointRec(mouse_point, resume_button_frame) && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            if (CheckCollisionPointRec(mouse_point, resume_button_frame) && user_input.is_mouse_released)
             {
                 // resume the game.
                 pause = false;
             }
             
-            // Prepare all the fish to their next gif frame.
-            my_fish.set_next_frame();        
-            fish_network.set_next_frame();
+            // Prepare all the fish to their next gif frame (they stay in place).
+            sim_mode = SIM_MODE_ANIMATE;
         }
         
-        else if(current_screen == "World")
+        else if(scene_machine.is_world())
         {
-            // ----- Handle world -----
-
-            // - Boundaries Management -
-
-            // Set the relevant boundaries for all the fish (its scaling considartions occurs within the fish update boundaries calls).
-            // Needs to be updated each frame becuase the scaling of the fish can be changed.
-            
-            // Update my fish.
-            my_fish_current_width = (int) ceil(sqrt(my_fish.get_scale()) * my_fish.get_size().width);
-            my_fish_current_height = (int) ceil(sqrt(my_fish.get_scale()) * my_fish.get_size().height);
-            my_fish.update_boundaries(ceil(my_fish_current_width / 2), world.width - ceil(my_fish_current_width / 2), ceil(my_fish_current_height / 2), world.height - ceil(my_fish_current_height / 2), false);
-        
-            // Update the fish network.
-            fish_network.update_boundaries(-X_COORD_OFFSET, world.width + X_COORD_OFFSET, 0, world.height, true);
-            
-            // True if needs to dispatch the camera due to getting close to the boundaries.
-            is_camera_dispatch_x_right = my_fish.get_location().x + ceil(camera_current_width / 2) >= world.width;
-            is_camera_dispatch_x_left = my_fish.get_location().x - ceil(camera_current_width / 2) <= 0;
-            is_camera_dispatch_x =  is_camera_dispatch_x_left || is_camera_dispatch_x_right;
-            
-            is_camera_dispatch_y_top = my_fish.get_location().y - ceil(camera_current_height / 2) <= 0;
-            is_camera_dispatch_y_bottom = my_fish.get_location().y + ceil(camera_current_height / 2) >= world.height;
-            is_camera_dispatch_y = is_camera_dispatch_y_top || is_camera_dispatch_y_bottom;
-            
-            // - Turbo.
-            my_fish.update_turbo();
-            
-            // - Stunt.
-            my_fish.update_stunt();
+            // Simulate the ticks of this frame (see FrameClock and Simulation).
+            sim_mode = SIM_MODE_WORLD;
             
             // --- User Input Management ---
             
+            // The input is read once a frame, every tick of the frame gets it.
+            
             // - Keyboard -
             
             // Handle the space bar.
             //if (IsKeyPressed(KEY_SPACE)) { my_fish.apply_turbo(); }
             
             // Handle arrow keys strokes. They move the fish in the world.
-            if (IsKeyDown(KEY_RIGHT)) { my_fish.move_right(1); grid.refresh_entity(&my_fish); }
-            if (IsKeyDown(KEY_LEFT)) { my_fish.move_left(1); grid.refresh_entity(&my_fish); }
-            if (IsKeyDown(KEY_UP)) { my_fish.move_up(1); grid.refresh_entity(&my_fish); }
-            if (IsKeyDown(KEY_DOWN)) { my_fish.move_down(1); grid.refresh_entity(&my_fish); }
+            input.is_right_down = user_input.is_right_down;
+            input.is_left_down = user_input.is_left_down;
+            input.is_up_down = user_input.is_up_down;
+            input.is_down_down = user_input.is_down_down;
+            
+            // Holding R rolls the world back (see Rewind), as holding two fingers on the screen.
+            is_rewinding = user_input.is_rewind_down || user_input.touch_count >= 2;
             
             // - Touch Screen -
             
@@ -3882,23 +11812,9 @@ int main()
             }
             */
             
-            // Get the current gesture.
-            current_gesture = GetGestureDetected();
-            
-            current_touch_location = Location(GetTouchPosition(0).x, GetTouchPosition(0).y);
-            
-            // He is indeed trying to move the fish towards the touch.
-            if (current_gesture != GESTURE_NONE)
-            {
-                // Calculate the touch as a point in the wolrd and not on the screen.
-                destination = Location(camera.target.x - (int)floor(SCREEN_WIDTH * (1 / camera.zoom) / 2) + current_touch_location.x * (1 / camera.zoom), camera.target.y - (int)floor(SCREEN_HEIGHT * (1 / camera.zoom) / 2) + current_touch_location.y * (1 / camera.zoom));
-                
-                // Move the fish towards the destination.
-                my_fish.move_towards(destination);
-                
-                // And update the grid.
-                grid.refresh_entity(&my_fish);
-            }
+            // Get the current gesture, and where the touch is (the simulation moves the fish towards it).
+            input.gesture = user_input.gesture;
+            input.touch_location = user_input.touch_location;
             
             // Update the previous second touch.
             //previous_second_touch_location.set_location(second_touch_location);
@@ -3959,119 +11875,74 @@ int main()
             }
             TraceLog(1, "");
             */
+        }
+        
+        // --- Idle Screens ---
+        
+        // A window covers the world and nothing moves behind it, so the same frame is not drawn again until the user does something.
+        bool was_idle_screen = is_idle_screen;
+        is_idle_screen = idle_rendering && ((scene_machine.get_scene() == SCENE_MAIN_MENU && (is_campain_welcome_window || is_about_window)) || (scene_machine.is_world() && (pause || is_victory || is_defeat)));
+        scene_machine.set_idle(is_idle_screen);
+        
+        // Block in EndDrawing() until the next input event, instead of drawing at the target fps (a replay has no events, it keeps drawing).
+        if (is_idle_screen != was_idle_screen)
+        {
+            if (is_idle_screen && !input_recorder.is_replaying()) { EnableEventWaiting(); }
+            else { DisableEventWaiting(); }
             
-            // --- Entities Calculations ---
-            
-            // Remove all the eaten fish from the previous frame.
-            fish_network.handle_eaten();
-            
-            // Release available fish.
-            fish_network.load_available_fish(false);
-            
-            // Move all the fish in the fish network.
-            fish_network.move();
-            
-            // --- Handle Collisions ---
-            
-            // A reference to the cells array.
-            grid_cells = grid.get_cells();
-            
-            // The entities array of the current cell.
-            GridEntity** entities_in_cell;
-            
-            // The rectangular frame of the two entities in the loop.
-            Rectangle first_entity_rectangle;
-            Rectangle second_entity_rectangle;    
-
-            // Iterate over the cells of the grid.
-            for (int row_index = 0; row_index < grid.get_rows_amount(); row_index++)
-            {
-                for (int col_index = 0; col_index < grid.get_columns_amount(); col_index++)
-                {
-                    // Save the amount of entities in the current cell.
-                    current_cell_entities_amount = grid_cells[row_index][col_index] -> get_entities_counter();
-
-                    // Get the array of entities in the cell.
-                    entities_in_cell = grid_cells[row_index][col_index] -> get_entities();
-                    
-                    // Iterate over all the possible entities pairs in the current cell.
-                    for (int first_entity_index = 0; first_entity_index < current_cell_entities_amount; first_entity_index++)
-                    {
-                        for (int second_entity_index = first_entity_index + 1; second_entity_index < current_cell_entities_amount; second_entity_index++)
-                        {
-                            // Get the rectangle frame of the two entities.
-                            first_entity_rectangle = entities_in_cell[first_entity_index] -> get_updated_collision_frame();
-                            second_entity_rectangle = entities_in_cell[second_entity_index] -> get_updated_collision_frame();
-                            
-                            // Check if the two current entities are overlapping.
-                            if (CheckCollisionRecs(first_entity_rectangle, second_entity_rectangle))
-                            {
-                                // Tell the first entity it collided with the second entity.
-                                entities_in_cell[first_entity_index] -> handle_collision(entities_in_cell[second_entity_index]);
-                            }
-                        }
-                    }
-                }
-            }
-
-            // --- Camera ---
-            
-            // Calculate the width and height of the camera screen (changed due to camera.zoom).
-            camera_current_width = (1 / camera.zoom) * SCREEN_WIDTH;
-            camera_current_height = (1 / camera.zoom) * SCREEN_HEIGHT;
-            
-            // Camera follows my fish movement.
-            
-            // If the fish is not close to the boundaries.
-            if (!is_camera_dispatch_x) { camera_pos_x = max((int)ceil(camera_current_width / 2), min(my_fish.get_location().x, (int)(world.width - ceil(camera_current_width / 2)))); }
-            
-            if (!is_camera_dispatch_y) { camera_pos_y = max((int)ceil(camera_current_height / 2), min(my_fish.get_location().y, (int)(world.height - ceil(camera_current_height / 2)))); }
-
-            // Update the camera position.
-            if (!debug_camera) { camera.target = (Vector2){ (float) camera_pos_x, (float) camera_pos_y }; }
-
-            // --- Prepare Gifs for drawing ---
-            
-            // Prepare all the fish to their next gif frame.
-            my_fish.set_next_frame();        
-            fish_network.set_next_frame();
+            is_idle_drawn = false;
+        }
+        
+        // Already drawn, and no input since. Raylib waits for the next event on the desktop, on android it only polls them (sleep for a frame).
+        if (is_idle_screen && is_idle_drawn && !user_input.is_input_event)
+        {
+            PollInputEvents();
+            if (IS_ANDROID) { WaitTime(1.0 / RENDER_FPS); }
             
-            // Check if the game is over.
-            if (!my_fish.is_alive())
-            {
-                is_defeat = true;
-            }
+            continue;
+        }
+        
+        // --- Simulation ---
+        
+        // Simulate the ticks of this frame on the simulation thread, while the ticks of the previous frame are drawn (a new screen is simulated first).
+        // An idle window draws the last snapshot again.
+        if (!is_idle_screen)
+        {
+            // The world is rolled back by the ticks of this frame instead of moving on (it belongs to the main thread until start()).
+            // It jumped back, so it is simulated as a new screen (not drawn moving there).
+            bool is_rewound = false;
+            if (sim_mode == SIM_MODE_WORLD && is_rewinding) { is_rewound = rewind.step_back(game_world, ticks_to_run); ticks_to_run = 0; }
             
-            // Check if the fish has reached the required size.
-            if (my_fish.is_victory())
-            {
-                // Update game status.
-                is_victory = true;
-                
-                // Check if unlocked new world.
-                if (game_save.world_checkpoint == current_world) { game_save.update_world_checkpoint(current_world + 1); }
-            }
+            simulation.start(sim_mode, ticks_to_run, input, frame_clock.get_alpha(), is_rewound || scene_machine.get_scene() != simulated_scene);
+            simulated_scene = scene_machine.get_scene();
         }
-
+        
+        // Draw the snapshot of the last finished ticks, between their last two ticks.
+        snapshot = simulation.get_snapshot();
+        drawn_camera = snapshot -> get_drawn_camera();
+        
         // ----- Draw -----
         
+        quality_governor.begin_phase(FRAME_PHASE_DRAW);
+        frame_profiler.begin_phase(PROFILE_PHASE_DRAW);
+        
         BeginDrawing();
             
-            if (current_screen == "Main Menu" || current_screen == "Map")
+            if (!scene_machine.is_world())
             {
                 // Clear the background.
                 ClearBackground(RAYWHITE);
                 
-                BeginMode2D(camera);
+                BeginMode2D(drawn_camera);
                     
                     // Draw the world in the background.
-                    DrawTexture(world, 0, 0, WHITE);
-                    fish_network.draw_next_frame();
+                    DrawTexture(*game_world -> get_texture(), 0, 0, WHITE);
+                    snapshot -> draw_gifs();
                     
                 EndMode2D();
             }
             
-            if (current_screen == "Main Menu")
+            if (scene_machine.get_scene() == SCENE_MAIN_MENU)
             {
                 // If we are on the campain welcome window.
                 if (is_campain_welcome_window) 
@@ -4128,7 +11999,7 @@ int main()
                 }               
             }
                     
-            else if (current_screen == "Map")
+            else if (scene_machine.get_scene() == SCENE_MAP)
             {
                 // Draw the map image.
                 DrawTexture(map, (int) floor (SCREEN_WIDTH / 2 - map.width / 2), (int) floor(SCREEN_HEIGHT / 2 - map.height / 2), WHITE);
@@ -4137,6 +12008,9 @@ int main()
                 DrawTexture(world1_button, world1_button_frame.x, world1_button_frame.y, WHITE);
                 if (game_save.world_checkpoint >= 2) { DrawTexture(world2_button, world2_button_frame.x, world2_button_frame.y, WHITE); }
                 if (game_save.world_checkpoint >= 3) { DrawTexture(world3_button, world3_button_frame.x, world3_button_frame.y, WHITE); }
+                
+                // The selected world is still loading.
+                if (selected_world != 0) { DrawText("Loading...", (int) floor(SCREEN_WIDTH / 2) - 70, SCREEN_HEIGHT - 80, 40, BLACK); }
             }
             
             else if (is_world_welcome_window)
@@ -4146,14 +12020,13 @@ int main()
                 
                 // Everything inside this scope, is being manipulated by the camera.
                 // Every drawing outside this scope, will show up on the screen without being transformed by the camera.
-                BeginMode2D(camera);
+                BeginMode2D(drawn_camera);
                     
                     // Draw the background.
-                    DrawTexture(world, 0, 0, WHITE);
+                    DrawTexture(*game_world -> get_texture(), 0, 0, WHITE);
 
                     // Draw the next gif frame of the fish.
-                    fish_network.draw_next_frame();
-                    my_fish.draw_next_frame();
+                    snapshot -> draw_gifs();
 
                 // The end of the drawings affected by the camera.
                 EndMode2D();
@@ -4165,55 +12038,47 @@ int main()
                 DrawTexture(exit_welcome_window_button, exit_welcome_window_button_frame.x, exit_welcome_window_button_frame.y, WHITE);
                 
                 // Draw the current scale widget.
-                my_fish.draw_scale_widget();
+                game_world -> get_my_fish() -> draw_scale_widget(snapshot -> get_my_fish_scale());
                 
                 // Draw the current turbo widget.
-                my_fish.draw_turbo_widget();
+                game_world -> get_my_fish() -> draw_turbo_widget();
             }
             
-            else if (current_screen == "World")
+            else if (scene_machine.is_world())
             {
                 // Clear the background.
                 ClearBackground(RAYWHITE);
                 
                 // Everything inside this scope, is being manipulated by the camera.
                 // Every drawing outside this scope, will show up on the screen without being transformed by the camera.
-                BeginMode2D(camera);
+                BeginMode2D(drawn_camera);
                     
                     // Draw the background.
-                    DrawTexture(world, 0, 0, WHITE);
+                    DrawTexture(*game_world -> get_texture(), 0, 0, WHITE);
                     
                     // Debug, print the grid.
-                    if (debug)
-                    {
-                        for (int row_index = 0; row_index < grid.get_rows_amount(); row_index++)
-                        {
-                            for (int col_index = 0; col_index < grid.get_columns_amount(); col_index++)
-                            {
-                                current_cell_entities_amount = grid.get_cells()[row_index][col_index] -> get_entities_counter();
-                                if (current_cell_entities_amount > 0) { DrawRectangle(col_index * grid.get_cell_width_pixels(), row_index * grid.get_cell_height_pixels(), grid.get_cell_width_pixels(), grid.get_cell_height_pixels(), GRAY); }
-                                else { DrawRectangle(col_index * grid.get_cell_width_pixels(), row_index * grid.get_cell_height_pixels(), grid.get_cell_width_pixels(), grid.get_cell_height_pixels(), LIGHTGRAY); }
-                            }
-                        }
-                    }
+                    if (debug) { snapshot -> draw_grid(); }
                     
                     // Debug, print the fish frames.
-                    if (debug)
-                    {
-                        fish_network.print_frames();
-                        Rectangle frame = my_fish.get_updated_collision_frame();
-                        DrawRectangle(frame.x,frame.y, frame.width, frame.height, RED);
-                    }
+                    if (debug) { snapshot -> draw_collision_frames(); }
                     
                     // Draw the next gif frame of the fish.
-                    fish_network.draw_next_frame();
-                    my_fish.draw_next_frame();
+                    snapshot -> draw_gifs();
 
                 // The end of the drawings affected by the camera.
                 EndMode2D();
 
                 // Draw the current scale widget.
-                my_fish.draw_scale_widget();
+                game_world -> get_my_fish() -> draw_scale_widget(snapshot -> get_my_fish_scale());
+                
+                // Debug, print the sound effects counters.
+                if (debug) { DrawText(TextFormat("SFX requested: %ld played: %ld (this frame: %d)", sfx_mixer.get_total_requested(), sfx_mixer.get_total_played(), sfx_mixer.get_frame_played()), 10, 10, 20, BLACK); }
+                
+                // Debug, print the frame pacing, and the simulation time.
+                if (debug) { frame_clock.draw_stats(10, 35); }
+                if (debug) { simulation.draw_stats(10, 60); }
+                if (debug) { quality_governor.draw_stats(10, 85); }
+                if (debug) { rewind.draw_stats(10, 110); }
                 
                 // If paused, draw the pause window.
                 if (pause)
@@ -4225,7 +12090,6 @@ int main()
                 // Draw the pause button.
                 else
                 {
-                    cout << "drawing pause button: " << pause_button_frame.x << ", " << pause_button_frame.y << "\n";
                     DrawTexture(pause_button, pause_button_frame.x, pause_button_frame.y, WHITE);
                 }
                 
@@ -4249,29 +12113,115 @@ int main()
                 DrawTexture(back_to_map_button, back_to_map_button_frame.x, back_to_map_button_frame.y, WHITE);
             }
             
+            // The phases of the last frames, on top of everything.
+            frame_profiler.draw_overlay(SCREEN_WIDTH - 600, 10);
+            
+            // The frame is measured without waiting for the display.
+            scene_machine.end_frame();
+            quality_governor.begin_phase(FRAME_PHASE_DISPLAY);
+            frame_profiler.begin_phase(PROFILE_PHASE_DISPLAY);
+            
         EndDrawing();
+        
+        // --- Simulation Results ---
+        
+        // The idle window is on the screen.
+        if (is_idle_screen) { is_idle_drawn = true; }
+        
+        // Wait for the ticks of this frame, their snapshot is drawn on the next frame.
+        quality_governor.begin_phase(FRAME_PHASE_SIMULATION_WAIT);
+        frame_profiler.begin_phase(PROFILE_PHASE_SIMULATION_WAIT);
+        simulation.wait();
+        frame_profiler.begin_phase(PROFILE_PHASE_UPDATE);
+        
+        // The fish which were removed by the ticks are not drawn anymore.
+        simulation.unload_retired_gifs();
+        
+        // Handle the events of the ticks.
+        while (simulation.pop_event(&sim_event))
+        {
+            // Check if the game is over (the world won't be continued).
+            if (sim_event == SIM_EVENT_DEFEAT) { is_defeat = true; if (is_world_state_kept) { world_state.discard(); } }
+            
+            // Check if the fish has reached the required size.
+            if (sim_event == SIM_EVENT_VICTORY)
+            {
+                // Update game status.
+                is_victory = true;
+                if (is_world_state_kept) { world_state.discard(); }
+                
+                // Check if unlocked new world (a replay doesn't save it).
+                if (game_save.world_checkpoint == game_world -> get_number())
+                {
+                    if (input_recorder.is_replaying()) { game_save.world_checkpoint++; }
+                    else { game_save.update_world_checkpoint(game_world -> get_number() + 1); }
+                }
+            }
+        }
+        
+        // --- Sound Effects ---
+        
+        // Hear the fish around the camera (a little beyond the screen), and play the sounds requested by the ticks.
+        sfx_mixer.set_listener(simulation.get_snapshot() -> get_listener(), simulation.get_snapshot() -> get_hearing_distance());
+        sfx_mixer.play_requests();
+        
+        // --- Quality ---
+        
+        // Lower (or raise) the load of the next frames, to hold the frame time.
+        quality_governor.end_frame();
+        simulation.set_quality(input_recorder.sync_quality(quality_governor.get_quality()));
+        
+        // --- Profiler ---
+        
+        // Keep the phases of the frame, and turn the profiler on or off (the simulation is idle, the ticks are measured from the next frame).
+        frame_profiler.end_frame();
+        if (user_input.is_profiler_toggled) { frame_profiler.toggle(); simulation.measure_phases(frame_profiler.get_tick_phases_times()); }
 	}
 	
 	// ----- Close Game -----
 	
-    my_fish.delete_gif();
-    fish_network.delete_network();
+    // Report the peak memory of the last screen.
+    TraceLog(LOG_INFO, "Peak RSS on %s: %.1f MB", memory_screen.c_str(), get_peak_rss() / 1024.0);
+    
+    // Stop the simulation thread, the world belongs to the main thread.
+    simulation.quit();
+    
+    // Check the world of the last frame, and close the recording.
+    input_recorder.quit(game_world);
+    
+    // The game was closed in the middle of a world, save it to be continued.
+    if (is_world_state_kept && scene_machine.is_world() && !is_victory && !is_defeat) { world_state.capture(game_world); world_state.write_async(); }
+    world_state.quit();
+    world_state.report();
+    
+    // Unload the textures of the gifs of all the worlds.
+    backdrop_instance.suspend();
+    world_catalog.suspend_all();
 
     // Close all the musics.
-    UnloadSound(audio.music_main_theme);
-    UnloadSound(audio.music_world1);
-    UnloadSound(audio.music_world2);
-    UnloadSound(audio.music_world3);
-    UnloadSound(audio.sound_eat);
-    UnloadSound(audio.sound_eat_lower);
-    UnloadSound(audio.sound_sting1);
-    UnloadSound(audio.sound_sting1_lower);
+    music_player.quit();
+    
+    // Log how many of the requested sound effects were played, and how steady the frames were.
+    sfx_mixer.report();
+    frame_clock.report();
+    simulation.report();
+    rewind.report();
+    quality_governor.report();
+    frame_profiler.quit();
+    scene_machine.report();
+    sfx_store.unload();
     
     CloseAudioDevice();
     
 	// Close the game screen.
 	CloseWindow();
 
-    // Close the game progress file.
+    // Write the game progress which is still pending.
     game_save.quit();
+    
+    // Stop the workers.
+    worker_pool.quit();
+    
+    // Unmap the asset pack (the textures are already on the GPU).
+    asset_pack.close_pack();
 }
\ No newline at end of file